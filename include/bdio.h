@@ -128,6 +128,22 @@
  *  @brief record format for XML data
  */
 #define BDIO_ASC_XML     0x0B
+/** @def BDIO_BIN_F16BE
+ *  @brief record format for IEEE half precision floating point numbers with big endian byte ordering
+ */
+#define BDIO_BIN_F16BE   0x0C
+/** @def BDIO_BIN_F16LE
+ *  @brief record format for IEEE half precision floating point numbers with little endian byte ordering
+ */
+#define BDIO_BIN_F16LE   0x0D
+/** @def BDIO_BIN_BF16BE
+ *  @brief record format for bfloat16 floating point numbers with big endian byte ordering
+ */
+#define BDIO_BIN_BF16BE  0x0E
+/** @def BDIO_BIN_BF16LE
+ *  @brief record format for bfloat16 floating point numbers with little endian byte ordering
+ */
+#define BDIO_BIN_BF16LE  0x0F
 
 /** @def BDIO_BIN_INT32
  *  @brief record format 32bit integers with unspecified byte order, which is determined automatically
@@ -145,6 +161,42 @@
  *  @brief record format double precision floating point numbers with unspecified byte order, which is determined automatically
  */
 #define BDIO_BIN_F64     0xF3
+/** @def BDIO_BIN_F16
+ *  @brief record format IEEE half precision floating point numbers with unspecified byte order, which is determined automatically
+ */
+#define BDIO_BIN_F16     0xF4
+/** @def BDIO_BIN_BF16
+ *  @brief record format bfloat16 floating point numbers with unspecified byte order, which is determined automatically
+ */
+#define BDIO_BIN_BF16    0xF5
+
+/* complex formats, stored as generic records with a marker at the start
+ * of their payload that holds the f32 or f64 format of their parts (see
+ * bdio_is_complex_record) */
+/** @def BDIO_BIN_C64BE
+ *  @brief record format for complex numbers of two single precision floats with big endian byte ordering
+ */
+#define BDIO_BIN_C64BE   0x16
+/** @def BDIO_BIN_C64LE
+ *  @brief record format for complex numbers of two single precision floats with little endian byte ordering
+ */
+#define BDIO_BIN_C64LE   0x17
+/** @def BDIO_BIN_C128BE
+ *  @brief record format for complex numbers of two double precision floats with big endian byte ordering
+ */
+#define BDIO_BIN_C128BE  0x18
+/** @def BDIO_BIN_C128LE
+ *  @brief record format for complex numbers of two double precision floats with little endian byte ordering
+ */
+#define BDIO_BIN_C128LE  0x19
+/** @def BDIO_BIN_C64
+ *  @brief record format complex numbers of two single precision floats with unspecified byte order, which is determined automatically
+ */
+#define BDIO_BIN_C64     0xF6
+/** @def BDIO_BIN_C128
+ *  @brief record format complex numbers of two double precision floats with unspecified byte order, which is determined automatically
+ */
+#define BDIO_BIN_C128    0xF7
 
 /* I/O modes 'r','w','a' */
 /** @def BDIO_R_MODE
@@ -209,6 +261,40 @@
  *  @brief chain mode
  */
 #define BDIO_HASH_CHAIN 1
+/** @def BDIO_HASH_TREE
+ *  @brief tree mode: checksums of fixed-size chunks and of their list
+ */
+#define BDIO_HASH_TREE  2
+/** @def BDIO_HASH_TREE_CHUNK
+ *  @brief default chunk size of tree-hash records in bytes
+ */
+#define BDIO_HASH_TREE_CHUNK 1048576
+
+/** @def BDIO_CODEC_NONE
+ *  @brief records are stored as written
+ */
+#define BDIO_CODEC_NONE 0
+/** @def BDIO_CODEC_LZ
+ *  @brief records are compressed by the bundled LZ codec (LZ4 block format)
+ */
+#define BDIO_CODEC_LZ   1
+/** @def BDIO_CODEC_PACK
+ *  @brief integer records are stored as bit packed differences
+ */
+#define BDIO_CODEC_PACK 2
+
+/** @def BDIO_FILTER_NONE
+ *  @brief data is compressed as it is
+ */
+#define BDIO_FILTER_NONE    0
+/** @def BDIO_FILTER_SHUFFLE
+ *  @brief bytes of the numbers in a record are grouped by significance
+ */
+#define BDIO_FILTER_SHUFFLE 1
+/** @def BDIO_FILTER_XOR
+ *  @brief numbers are replaced by their XOR with the preceding one
+ */
+#define BDIO_FILTER_XOR     2
 
 /** @def BDIO_HASH_MAGIC_S
  *  @brief magic number for hash records in single mode
@@ -218,6 +304,85 @@
  *  @brief magic number for hash records in chain mode
  */
 #define BDIO_HASH_MAGIC_C 1515784846
+/** @def BDIO_HASH_MAGIC_CRC32C_S
+ *  @brief magic number for CRC32C hash records in single mode
+ */
+#define BDIO_HASH_MAGIC_CRC32C_S 1515784847
+/** @def BDIO_HASH_MAGIC_CRC32C_C
+ *  @brief magic number for CRC32C hash records in chain mode
+ */
+#define BDIO_HASH_MAGIC_CRC32C_C 1515784848
+/** @def BDIO_HASH_MAGIC_XXH64_S
+ *  @brief magic number for XXH64 hash records in single mode
+ */
+#define BDIO_HASH_MAGIC_XXH64_S 1515784849
+/** @def BDIO_HASH_MAGIC_XXH64_C
+ *  @brief magic number for XXH64 hash records in chain mode
+ */
+#define BDIO_HASH_MAGIC_XXH64_C 1515784850
+/** @def BDIO_HASH_MAGIC_TREE
+ *  @brief magic number for tree-hash records
+ */
+#define BDIO_HASH_MAGIC_TREE 1515784851
+/** @def BDIO_LARGE_MAGIC
+ *  @brief magic number for records describing a large object
+ */
+#define BDIO_LARGE_MAGIC 1515784852
+/** @def BDIO_ARRAY_MAGIC
+ *  @brief magic number for records describing an array
+ */
+#define BDIO_ARRAY_MAGIC 1515784853
+/** @def BDIO_INDEX_MAGIC
+ *  @brief magic number for the record of names and offsets at the end of a
+ *  file
+ */
+#define BDIO_INDEX_MAGIC 1515784854
+/** @def BDIO_TABLE_MAGIC
+ *  @brief magic number for the records holding the record table while a
+ *  file is written
+ */
+#define BDIO_TABLE_MAGIC 1515784855
+
+/** @def BDIO_FOLLOW_POLL
+ *  @brief milliseconds between checks of a file followed by bdio_follow
+ */
+#define BDIO_FOLLOW_POLL 100
+
+/** @def BDIO_MAX_NDIM
+ *  @brief maximal number of dimensions of an array record
+ */
+#define BDIO_MAX_NDIM 8
+
+/** @def BDIO_MATCH_ALL
+ *  @brief mask of bdio_seek_next_matching matching every format or user info
+ */
+#define BDIO_MATCH_ALL 0xffff
+
+/* flags of datasets */
+/** @def BDIO_DSET_VERIFY
+ *  @brief checksums of the files of a dataset are verified while reading,
+ *  see bdio_verify_on_read
+ */
+#define BDIO_DSET_VERIFY 1
+/** @def BDIO_DSET_LAZY
+ *  @brief the files of a dataset are read with lazy headers,
+ *  see bdio_lazy_headers
+ */
+#define BDIO_DSET_LAZY   2
+
+/* hash algorithms */
+/** @def BDIO_HASH_MD5
+ *  @brief MD5 checksums (default)
+ */
+#define BDIO_HASH_MD5    1
+/** @def BDIO_HASH_CRC32C
+ *  @brief CRC32C checksums (hardware accelerated where available)
+ */
+#define BDIO_HASH_CRC32C 2
+/** @def BDIO_HASH_XXH64
+ *  @brief 64 bit xxHash checksums
+ */
+#define BDIO_HASH_XXH64  3
 
 
 
@@ -225,6 +390,32 @@
 #include <stdio.h>
 /* for MD5 checksums */
 #include <md5.h>
+/* for CRC32C and XXH64 checksums */
+#include <crc32c.h>
+#include <xxhash.h>
+
+/** @union BDIO_HASH_CTX bdio.h
+ *  @brief state of a running checksum computation of any supported type
+ */
+typedef union
+{
+   MD5_CTX md5;       /**< state for BDIO_HASH_MD5 */
+   CRC32C_CTX crc32c; /**< state for BDIO_HASH_CRC32C */
+   XXH64_CTX xxh64;   /**< state for BDIO_HASH_XXH64 */
+} BDIO_HASH_CTX;
+
+/** @struct BDIO_HCAT bdio.h
+ *  @brief entry of the header catalogue, see bdio_header_catalogue
+ */
+typedef struct
+{
+   uint64_t hstart; /**< offset of the header in the file */
+   uint64_t rstart; /**< offset of the first record following the header */
+   uint64_t end;    /**< offset of the next header or the end of the file */
+   int rcnt;        /**< number of records preceding the header */
+   int nrec;        /**< number of records between the header and the next
+                         header or the end of the file */
+} BDIO_HCAT;
 
 /* data types */
 /** @struct BDIO bdio.h
@@ -243,6 +434,8 @@ typedef struct
                        BDIO_R_MODE,
                        BDIO_W_MODE or
                        BDIO_A_MODE */
+   char upd;      /**< 1 if the file was opened in update mode "u", which
+                       is read mode with bdio_update_record */
    int endian;    /**< native byte ordering of the machine
                        BDIO_LEND or BDIO_BEND */
    FILE *fp;      /**< file pointer to the bdio file */
@@ -275,6 +468,11 @@ typedef struct
    char *hpinfo;   /**< protocol-info | schema | generator | spec of the last header */
    int hssize;     /**< combined length of user/host/pinfo strings of the last header */
    uint64_t hstart;/**< starting position of last header record */
+   uint64_t hend;  /**< position of the first byte after the last header */
+   int hrcnt;      /**< number of records before the last header */
+   char hlazy;     /**< 1 if the strings of headers are only read when they
+                        are asked for, see bdio_lazy_headers */
+   char hstrings;  /**< 1 if the strings of the last header have been read */
 
    /* information about current record */
    uint64_t rstart;/**< start position of current record or header */
@@ -288,6 +486,13 @@ typedef struct
    int ruinfo;    /**< user info of current record */
    int rdsize;    /**< size of a data-item in the current record e.g int32 -> 4 */
    char rswap;    /**< 1/0 = records data has/has not to be byte-swapped */
+   char renc;     /**< 1/0 = payload of current record is/is not encoded */
+   char rcplx;    /**< 1/0 = current record holds/does not hold complex
+                       numbers */
+   char rhash;    /**< 1/0 = checksum of current record is/is not computed
+                       while it is written */
+   char rhide;    /**< 1/0 = record being written is/is not hidden from
+                       readers, like the index record */
 
    /* information about the buffer */
    uint64_t bufstart; /**< offset in record where the buffer starts */
@@ -301,22 +506,98 @@ typedef struct
                            Default: BDIO_NO_HASH */
    int hash_mode;     /**< If mode is BDIO_HASH_CHAIN the hashe of 
                            a record is initialized with the hash of the 
-                           previous record. 
+                           previous record. If mode is BDIO_HASH_TREE,
+                           tree-hash records are written. 
                            Default: BDIO_HASH_SINGL */
+   int hash_type;     /**< Checksum algorithm used for new hash records:
+                           BDIO_HASH_MD5, BDIO_HASH_CRC32C or
+                           BDIO_HASH_XXH64. Default: BDIO_HASH_MD5 */
    unsigned char prev_digest[16]; /**< If hash mode is BDIO_HASH_CHAIN, this 
                                        stores the previous record's hash.*/
-   MD5_CTX *hash;    /**< The current hash ??? */
+   char hash_first;   /**< 1 until the first record of a chain, started by
+                           bdio_hash_chain, has its hash record */
+   BDIO_HASH_CTX *hash; /**< state of the checksum of the current record */
+   struct bdio_hash_tree *htree; /**< chunk checksums of the current record
+                                      in tree mode */
+   struct bdio_hash_pipe *hpipe; /**< worker thread computing checksums,
+                                      NULL if checksums are computed by
+                                      the writing thread */
+   struct bdio_vread *vread;     /**< checksum of the record being read,
+                                      NULL unless bdio_verify_on_read
+                                      was called */
+   int follow;                   /**< milliseconds bdio_seek_record waits
+                                      for new records, see bdio_follow.
+                                      Default: 0 */
+   int follow_fd;                /**< inotify descriptor of the followed
+                                      file, -1 if there is none */
+
+   /* encoding of records */
+   int codec;                    /**< codec of new records, see
+                                      bdio_set_codec.
+                                      Default: BDIO_CODEC_NONE */
+   int filter;                   /**< filters applied to new records before
+                                      compression, see bdio_set_filter.
+                                      Default: BDIO_FILTER_NONE */
+   int align;                    /**< alignment of the payload of new
+                                      records, see bdio_set_alignment.
+                                      Default: 0 */
+   uint64_t lchunk;              /**< length of the chunks written by
+                                      bdio_write_large.
+                                      Default: 2^28-16 */
+   int andim;                    /**< number of dimensions of the array
+                                      record last read by
+                                      bdio_read_hyperslab */
+   int arcnt;                    /**< record number of this array record */
+   uint64_t adims[BDIO_MAX_NDIM];/**< extents of this array record */
+   struct bdio_codec *enc;       /**< encoder or decoder of the current
+                                      record */
+   struct bdio_index *index;     /**< names of records, see
+                                      bdio_write_named */
 } BDIO;
 
+/** @struct BDIO_DSET_FILE bdio.h
+ *  @brief a file of a dataset, see bdio_dataset_open
+ */
+typedef struct
+{
+   char *path;    /**< path of the file */
+   uint64_t size; /**< length of the file in bytes */
+   int hcnt;      /**< number of headers in the file */
+   int nrec;      /**< number of records in the file */
+   int first;     /**< number of records in the preceding files. The records
+                       of the file have the global numbers first+1 to
+                       first+nrec */
+} BDIO_DSET_FILE;
+
+/** @struct BDIO_DSET bdio.h
+ *  @brief several bdio files read as one stream of records
+ *  @details Only one file is open at a time, see bdio_dataset_open.
+ */
+typedef struct
+{
+   int n;                 /**< number of files */
+   BDIO_DSET_FILE *files; /**< the files in the order they were given */
+   int nrec;              /**< number of records in all files */
+   int flags;             /**< BDIO_DSET_VERIFY and/or BDIO_DSET_LAZY */
+   int cur;               /**< index of the current file, -1 before the
+                               first */
+   BDIO *fh;              /**< handle of the current file, NULL if no file
+                               is open */
+} BDIO_DSET;
+
 
 
 /* prototypes */
 /** @fn int bdio_is_hash_record(unsigned char digest[16], BDIO *fh)
-    @brief Checks, whether a record is a MD5 hash record
-    @detail Must be called before reading anything from the record
-    @param[out] digest the checksum stored in this MD5 hash record
+    @brief Checks, whether a record is a hash record
+    @detail Must be called before reading anything from the record.
+            Shorter checksums (CRC32C, XXH64) are stored in the first bytes
+            of digest, the remaining bytes are 0. For a tree-hash record,
+            digest is its root.
+    @param[out] digest the checksum stored in this hash record
     @param[in] fh pointer to a BDIO file descriptor structure
-    @return true if the current record is a MD5 record, false otherwise
+    @return BDIO_HASH_MD5, BDIO_HASH_CRC32C or BDIO_HASH_XXH64 (i.e. true)
+            if the current record is a hash record, 0 (false) otherwise
     @author Alberto Ramos, Tomasz Korzec
  */
 int bdio_is_hash_record(unsigned char digest[16], BDIO *fh);
@@ -324,6 +605,12 @@ int bdio_is_hash_record(unsigned char digest[16], BDIO *fh);
 
 /** @fn void bdio_hash_auto(BDIO *fh)
     @brief Enables the automatic computation of MD5 checksums of records.
+    @details Unless the library is compiled with _NO_POSIX_LIBS, the
+    checksums are computed by a worker thread of fh: bdio_write copies the
+    data into one of two staging buffers while the worker hashes the other.
+    The hash record is written by bdio_flush_record once the worker is done.
+    If the worker can not be started, the checksums are computed by the
+    writing thread.
     @param[in] fh pointer to a BDIO file descriptor structure
     @author Alberto Ramos
  */
@@ -332,12 +619,214 @@ void bdio_hash_auto(BDIO *fh);
 /** @fn void bdio_hash_chain(BDIO *fh);
     @brief Enables the chain mode for checksum calculation
     @detail When turned on, hashes of records are initialized with previous
-            record's hash.
+            record's hash. Every call starts a new chain: a record that is
+            still open is completed first, and the first record of the
+            chain gets a hash record in single mode, which marks the start
+            of the chain for the verifiers. Chains never continue across
+            headers.
     @param[in] fh pointer to a BDIO file descriptor structure
     @author Alberto Ramos
  */
 void bdio_hash_chain(BDIO *fh);
 
+/** @fn int bdio_hash_tree(int chunk, BDIO *fh)
+    @brief Enables the tree mode for checksum calculation
+    @details In tree mode, a record is split into chunks of chunk bytes and
+    the checksum of every chunk (a leaf) is computed. The following hash
+    record stores the list of leaves and its checksum (the root). MD5 leaves
+    of consecutive chunks are computed at once by the multi-buffer engine.
+    Parts of a record can be checked with bdio_verify_range without reading
+    the rest of it.<p>
+    A record that is still open is completed in the previous mode. Fails if
+    fh is invalid, bdio_hash_auto was not called or chunk is negative.
+    @param[in] chunk chunk size in bytes, 0 selects BDIO_HASH_TREE_CHUNK
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_hash_tree(int chunk, BDIO *fh);
+
+/** @fn int bdio_hash_type(int type, BDIO *fh)
+    @brief Select the checksum algorithm for automatic hash records
+    @details Affects all records started after the call. MD5 is the default;
+    CRC32C (computed with the SSE4.2 crc32 instruction where available) and
+    XXH64 are much cheaper and suited for integrity checks of large data.
+    Each algorithm has its own magic numbers, so readers can tell the
+    hash records apart.<p>
+    Fails if fh is invalid or type is not a supported algorithm.
+    @return Upon success 0 is returned, otherwise EOF is returned.
+    @param[in] type BDIO_HASH_MD5, BDIO_HASH_CRC32C or BDIO_HASH_XXH64
+    @param[in] fh pointer to a BDIO file descriptor structure
+ */
+int bdio_hash_type(int type, BDIO *fh);
+
+/** @fn int bdio_set_codec(int codec, BDIO *fh)
+    @brief Select the compression of records
+    @details Affects all records started after the call. Compressed records
+    are written and read with the usual functions: bdio_write and its typed
+    variants compress the data in blocks of 64 KiB as they are passed, and
+    bdio_read decompresses them again. bdio_get_rlen returns the
+    uncompressed length. A block that does not shrink is stored as it is.
+    The record header of a compressed record has the format
+    BDIO_BIN_GENERIC, so that readers which do not decode it do not take it
+    for numbers, and a spare bit marks it as encoded. The format of the
+    data is kept with the codec in the record and returned by
+    bdio_get_rfmt. Records with user info 7 and hash records are never
+    compressed, and the checksums of hash records are those of the
+    compressed record as stored in the file.
+    Compressed records can not be continued by bdio_append_record.<p>
+    BDIO_CODEC_PACK is meant for slowly varying integers such as indices:
+    the differences of successive numbers are zigzag coded and bit packed
+    in groups of 128 with the width of the largest one, so that a monotonic
+    int64 sequence takes about 1/60 of its size. It applies to int32 and
+    int64 records only, records of other formats are stored uncompressed.
+    <p>
+    Fails if fh is invalid or codec is unknown.
+    @param[in] codec BDIO_CODEC_NONE, BDIO_CODEC_LZ or BDIO_CODEC_PACK
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_set_codec(int codec, BDIO *fh);
+
+/** @fn int bdio_set_filter(int filter, BDIO *fh)
+    @brief Select filters applied to records before they are compressed
+    @details Affects all compressed records with 4 or 8 byte numbers
+    (int32, int64, f32, f64) started after the call. BDIO_FILTER_XOR replaces
+    every number by its XOR with the preceding one, so that the leading bits
+    of slowly varying data become 0. BDIO_FILTER_SHUFFLE then groups byte k
+    of all numbers of a block together, which turns the sign and exponent
+    bytes of floating point data into long runs (SSE2 is used on x86-64).
+    Both filters can be combined with |. The filters are recorded in the
+    record and undone by bdio_read and its typed variants. Without a codec
+    (see bdio_set_codec) nothing is filtered.<p>
+    Fails if fh is invalid or filter is unknown.
+    @param[in] filter BDIO_FILTER_NONE or a combination of
+    BDIO_FILTER_SHUFFLE and BDIO_FILTER_XOR
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_set_filter(int filter, BDIO *fh);
+
+/** @fn int bdio_set_alignment(int align, BDIO *fh)
+    @brief Align the payload of new records in the file
+    @details Records started after the call get a long (8 byte) header and
+    are preceded by a padding record if needed, so that their payload starts
+    at an offset in the file which is a multiple of align. This allows to
+    map records into memory or to read them with O_DIRECT. Padding records
+    are skipped by bdio_seek_record and are invisible to readers of this
+    library version; they are generic records with user info 7 and the
+    encoded bit set. Hash records are not aligned. align=0 switches the
+    alignment off.<p>
+    Fails if fh is invalid or align is neither 0 nor a power of 2 between 8
+    and 65536.
+    @param[in] align 0 or the alignment in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_set_alignment(int align, BDIO *fh);
+
+/** @fn int bdio_index_records(BDIO *fh)
+    @brief Keep a table of the offsets of all records written
+    @details Records started after the call are entered in a table, which
+    bdio_close appends to the file in the index record of bdio_write_named.
+    With it bdio_seek_prev_record and bdio_open_tail position the stream
+    with a single fseek. While the file is written, the new part of the
+    table is also written every 1024 records, or 32 MiB, as a generic
+    record with user info 7 (magic BDIO_TABLE_MAGIC), which readers use as
+    long as the index record is missing. Like the index record these table
+    blocks are hidden from bdio_seek_record and bdio_get_rcnt. In append
+    mode the table is continued automatically if the file ends with one. It
+    takes 32 bytes per record.
+    <p>
+    Fails if fh is invalid or not in write or append mode.
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_index_records(BDIO *fh);
+
+/** @fn int bdio_verify(int nthreads, FILE *report, BDIO *fh)
+    @brief Verify the checksums of all records followed by a hash record
+    @details Starting at the current position, every record that is followed
+    by a hash record is read and its checksum is recomputed and compared with
+    the stored one. Records without a hash record are skipped. Afterwards the
+    file is positioned at its end.<p>
+    The checksums are computed by nthreads threads, while the calling thread
+    reads the file. In chain mode, the checksum a record starts with is read
+    from the preceding hash record, so chained records are verified in
+    parallel as well. A chain starts after a header or at a hash record in
+    single mode (see bdio_hash_chain), so a chained record that was moved
+    or copied from elsewhere is a mismatch. With nthreads<=1, or if the library is compiled with
+    _NO_POSIX_LIBS, everything is done by the calling thread.<p>
+    For each mismatch a line is printed to report, followed by a summary.
+    Nothing is printed if report is NULL.<p>
+    Fails if fh is invalid, not in read mode, or if reading fails.
+    @param[in] nthreads number of threads computing checksums
+    @param[in] report stream for the verification report or NULL
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success the number of records with wrong checksums is
+    returned, otherwise EOF is returned.
+ */
+int bdio_verify(int nthreads, FILE *report, BDIO *fh);
+
+/** @fn int bdio_verify_on_read(int flag, BDIO *fh)
+    @brief Verify checksums while records are read
+    @details If flag is non-zero, bdio_seek_record looks up the hash record
+    following every record it lands on, and the bytes returned by
+    bdio_read and its typed variants are hashed as they pass. When
+    bdio_seek_record then lands on the hash record and the record was read
+    to completion, the checksums are compared and a mismatch is reported by
+    an error ("... Checksum mismatch in record n."), i.e. it is counted in
+    fh->nerror and shown by bdio_perror. Records that were skipped or
+    only partially read are not checked. Chain and tree-hash records are
+    supported. With flag=0 the verification is switched off.<p>
+    Fails if fh is invalid or not in read mode.
+    @param[in] flag 1 to switch the verification on, 0 to switch it off
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_verify_on_read(int flag, BDIO *fh);
+
+/** @fn int bdio_follow(int timeout, BDIO *fh)
+    @brief Wait for new records of a file that is still being written
+    @details If timeout is non-zero, bdio_seek_record and
+    bdio_seek_next_matching do not return EOF at the end of the file, but
+    wait up to timeout milliseconds, or forever if timeout is negative, for
+    the next record to be complete. Writers mark a record as incomplete in
+    its header until bdio_flush_record has written its final length, so
+    that a record becomes visible only once it is completely in the file.
+    Headers are passed as they appear. On Linux the file is watched with
+    inotify, otherwise and in addition it is checked every
+    BDIO_FOLLOW_POLL milliseconds. Without follow mode, bdio_seek_record
+    stops with EOF at an incomplete record and continues with it when it
+    is called again. Records continued by bdio_append_record can not be
+    followed. Writers make records visible early with fflush(fh->fp).
+    With bdio_verify_on_read a record is only checked if its hash record
+    was written when bdio_seek_record landed on it.<p>
+    Fails if fh is invalid or not in read mode, or if it was compiled with
+    _NO_POSIX_LIBS.
+    @param[in] timeout milliseconds to wait, 0 to switch follow mode off,
+    a negative number to wait forever
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_follow(int timeout, BDIO *fh);
+
+/** @fn int bdio_verify_range(uint64_t offset, uint64_t nb, BDIO *fh)
+    @brief Verify a part of the current record against its tree-hash record
+    @details Only the chunks overlapping the bytes offset...offset+nb-1 of
+    the payload of the current record are read and compared with the leaves
+    of the following tree-hash record. The leaves themselves are checked
+    against the root. The file position is not changed.<p>
+    Fails if fh is invalid, not in read mode, not in a record, if the range
+    exceeds the record, if the record is not followed by a tree-hash record
+    or if reading fails.
+    @param[in] offset first byte of the range
+    @param[in] nb length of the range in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return 0 if the range is intact, 1 if a checksum does not match and EOF
+    upon failure.
+ */
+int bdio_verify_range(uint64_t offset, uint64_t nb, BDIO *fh);
+
 /** @fn void bdio_perror(const char *s, BDIO *fh)
     @brief Print an error string to BDIO.msg
     @details Print the string pointed to by s followed by the description of the
@@ -364,7 +853,8 @@ void bdio_perror(const char *s, BDIO *fh);
 void bdio_pferror(const char *s, BDIO *fh);
 
 /** @fn BDIO *bdio_open(const char* file, const char* mode, char* protocol_info)
-    @brief Open a bdio file in mode 'r' (read), 'w' (write) or 'a' (append).
+    @brief Open a bdio file in mode 'r' (read), 'w' (write), 'a' (append)
+    or 'u' (update).
     @details In read mode, the header record is read and checked. The stream
     remains positioned in the header record, therefore bdio_seek_record
     must be called to enter the next record.
@@ -381,9 +871,16 @@ void bdio_pferror(const char *s, BDIO *fh);
     therefore bdio_start_record or bdio_append_record
     (only possible if the last item was a record)  must be called to
     start a new record.
+    A record that its writer did not finish, e.g. because it crashed, is
+    cut off the end of the file. Without POSIX libraries such files cannot
+    be appended to.
     If the file is not empty, protocol_info may be NULL - if not NULL it must
     match the one of the last header.
     If the file is empty, protocol_info must be a 0-terminated string.<p>
+
+    Update mode is read mode on a file opened for reading and writing, in
+    which the payload of existing records can be changed with
+    bdio_update_record.<p>
    
    The maximal length protocol_info may have is: XXXX TODO <-- <p>
    
@@ -398,12 +895,33 @@ void bdio_pferror(const char *s, BDIO *fh);
    @return Upon successful completion bdio_open returns a pointer to a bdio file
     structure.  Otherwise, NULL is returned
    @param[in] file 0-terminated string specifying the file name
-   @param[in] mode a bdio file mode, can be BDIO_R_MODE, BDIO_W_MODE or BDIO_A_MODE
+   @param[in] mode "r", "w", "a" or "u"
    @param[in] protocol_info 0-terminated string specifying the protocol-info
  */
 BDIO *bdio_open(const char* file, const char* mode, char* protocol_info);
 
 
+/** @fn BDIO *bdio_open_tail(const char *file, int k)
+    @brief Open a bdio file for reading at its last k records
+    @details Opens file as bdio_open in mode "r" and positions the stream so
+    that bdio_seek_record lands on the k-th last record. Checksum records
+    count as records, the hidden index record does not. If
+    the file ends with a record table (see bdio_index_records) no record is
+    read. If its writer has not closed it yet, the record headers after the
+    last block of the table in the last 64 MiB are read. Otherwise the
+    record headers are read once, skipping the payloads.
+    Files with fewer than k records are positioned at their start.
+    bdio_get_hcnt and bdio_get_rcnt count as if the file had been read from
+    the start.<p>
+    Fails as bdio_open, if k<1 or if the file cannot be read.
+    @param[in] file 0-terminated string specifying the file name
+    @param[in] k number of records to be read
+    @return Upon success a pointer to a bdio file structure is returned,
+    otherwise NULL.
+ */
+BDIO *bdio_open_tail(const char *file, int k);
+
+
 /** @fn int bdio_close(BDIO *fh)
     @brief Close a bdio file.
     @details If the file has been opened in write or append mode
@@ -539,6 +1057,32 @@ int bdio_get_hcdate(BDIO *fh);
  */
 int bdio_get_hmdate(BDIO *fh);
 
+
+/** @fn int bdio_get_hdirinfo1(BDIO *fh)
+    @brief Get the minimal number of records following the last header
+    @details The number counts the records up to the next header or the end
+    of the file. It is written by bdio_close and saturates at 1023. Files
+    written by older versions of the library, or not closed properly,
+    carry 0. Fails if fh is invalid or in error state
+    @return Upon success the number of records is returned. Upon failure EOF
+    is returned.
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_get_hdirinfo1(BDIO *fh);
+
+
+/** @fn int bdio_get_hdirinfo2(BDIO *fh)
+    @brief Get the minimal number of bytes following the last header
+    @details The number counts the bytes of all records up to the next header
+    or the end of the file. It is written by bdio_close and saturates at
+    4194303. Below that it is exact, see bdio_seek_header. Fails if fh is
+    invalid or in error state
+    @return Upon success the number of bytes is returned. Upon failure EOF
+    is returned.
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_get_hdirinfo2(BDIO *fh);
+
 /** @fn int bdio_get_ruinfo(BDIO *fh)
     @brief Get the user info of the current record
     @details Fails if fh is invalid or in error state
@@ -580,7 +1124,8 @@ int bdio_get_rfmt(BDIO *fh);
 
 /** @fn uint64_t bdio_get_rlen(BDIO *fh)
     @brief Get length of data content of current record (written or read).
-    @details Fails if fh if is a null pointer
+    @details For a compressed record the uncompressed length is returned.
+    Fails if fh if is a null pointer
     or if fh is in state BDIO_E_STATE
     @return Upon success the length is returned. Upon failure EOF is
     returned.<br>
@@ -589,6 +1134,20 @@ int bdio_get_rfmt(BDIO *fh);
  */
 uint64_t bdio_get_rlen(BDIO *fh);
 
+/** @fn uint64_t bdio_get_rstart(BDIO *fh)
+    @brief Get the offset in the file of the payload of the current record
+    @details The payload follows the 4 or 8 byte record header. For an
+    encoded record (see bdio_set_codec) it is the start of the encoded data,
+    for a complex record without codec the start of the numbers after their
+    4 byte marker.
+    Together with bdio_get_rlen it allows to map uncompressed records into
+    memory. Fails if fh is a null pointer or if fh is not in a record.
+    @return Upon success the offset is returned. Upon failure EOF is
+    returned.
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+uint64_t bdio_get_rstart(BDIO *fh);
+
 
 
 /** @fn int bdio_get_rcnt(BDIO *fh)
@@ -634,6 +1193,140 @@ int bdio_is_in_header(BDIO *fh);
 int bdio_seek_record(BDIO *fh);
 
 
+/** @fn int bdio_seek_next_matching(int fmt_mask, int uinfo_mask, BDIO *fh)
+    @brief Position bdio stream at the next record with a format and user
+    info selected by the masks
+    @details A record matches if bit rfmt of fmt_mask and bit ruinfo of
+    uinfo_mask are set, e.g. fmt_mask=(1<<BDIO_BIN_F64LE)|(1<<BDIO_BIN_F64BE)
+    and uinfo_mask=(1<<3) select float64 records with user info 3.
+    BDIO_MATCH_ALL matches every format or user info. Complex records match
+    the format of their real and imaginary parts. Other records are skipped
+    after reading their record header; they are not decoded and, with
+    bdio_verify_on_read, not checked. If the file has a record table (see
+    bdio_index_records), the next matching record is looked up in it and
+    reached with a single fseek, unless bdio_verify_on_read or bdio_follow
+    is in effect. Fails as bdio_seek_record.
+    @param[in] fmt_mask bit mask of the formats 0..15
+    @param[in] uinfo_mask bit mask of the user infos 0..15
+    @param[in] fh pointer to a BDIO file descriptor structure.
+    @return Upon success 0 is returned, otherwise EOF is returned. If no
+            further record matches, EOF is returned.
+ */
+int bdio_seek_next_matching(int fmt_mask, int uinfo_mask, BDIO *fh);
+
+
+/** @fn int bdio_seek_header(BDIO *fh)
+    @brief Skip the remaining records of the last header and position fh at
+    the first record following the next header.
+    @details If the directory fields of the last header are not saturated
+    (see bdio_get_hdirinfo1 and bdio_get_hdirinfo2), the records are
+    skipped with a single fseek, otherwise they are walked as with
+    bdio_seek_record. bdio_get_rcnt counts the skipped records in both
+    cases. Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - fh is not in read mode
+    - fseek or fread fail
+    @return Upon success 0 is returned, otherwise EOF is returned. If there
+            is no further header, EOF is returned.
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_seek_header(BDIO *fh);
+
+
+/** @fn int bdio_lazy_headers(int flag, BDIO *fh)
+    @brief Read the strings of headers only when they are asked for
+    @details If flag is non-zero, bdio_seek_record and bdio_seek_header read
+    only the fixed-length fields of the headers they pass (version, dates
+    and directory fields) and skip the user, host and protocol strings.
+    The strings of the last header are read from the file when one of
+    bdio_get_hcuser, bdio_get_hmuser, bdio_get_hchost, bdio_get_hmhost or
+    bdio_get_hpinfo is called. This saves time when reading files that were
+    concatenated from many bdio files. The first header is always read by
+    bdio_open. With flag=0 the strings are read with every header.<p>
+    Fails if fh is invalid or not in read mode.
+    @param[in] flag 1 to switch lazy headers on, 0 to switch them off
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF.
+ */
+int bdio_lazy_headers(int flag, BDIO *fh);
+
+
+/** @fn int bdio_header_catalogue(BDIO_HCAT *cat, int nmax, BDIO *fh)
+    @brief List the headers of a file with the extent of their records
+    @details Scans the file from the start, skipping header sections with
+    bdio_seek_header, and stores the offsets and record counts of the first
+    nmax headers in cat. Calling it with nmax=0 counts the headers, so that
+    cat can be allocated. Afterwards fh is positioned at the end of the
+    first header as after bdio_open.<p>
+    Fails if fh is invalid or not in read mode, or if the file cannot be
+    read.
+    @param[out] cat array of at least nmax entries, may be NULL if nmax is 0
+    @param[in] nmax maximal number of entries to store
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success the number of headers in the file is returned,
+    otherwise EOF.
+ */
+int bdio_header_catalogue(BDIO_HCAT *cat, int nmax, BDIO *fh);
+
+
+/** @fn int bdio_goto_header(const BDIO_HCAT *cat, int k, BDIO *fh)
+    @brief Position fh at header k of a header catalogue
+    @details cat must have been filled by bdio_header_catalogue for the same
+    file and k counts from 0. Afterwards fh is in the header, so that
+    bdio_seek_record lands on the first record following it. bdio_get_hcnt
+    and bdio_get_rcnt count as if the file had been read from the start.<p>
+    Fails if fh is invalid or not in read mode, or if there is no header at
+    cat[k].hstart.
+    @param[in] cat header catalogue
+    @param[in] k index of the header in cat
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF.
+ */
+int bdio_goto_header(const BDIO_HCAT *cat, int k, BDIO *fh);
+
+
+/** @fn int bdio_seek_named(const char *name, BDIO *fh)
+    @brief Position fh at the record labelled by name
+    @details Looks up name in the index written by bdio_write_named, which
+    is read from the end of the file at the first call, and jumps to the
+    tag record with a single fseek. The tag is checked and fh is left at
+    the data record following it, as after bdio_seek_record; bdio_get_hcnt
+    and bdio_get_rcnt count as if the file had been read from the start.
+    If a name was written several times, the first record is found. Files
+    without an index are searched from the start for an ASCII record
+    holding exactly name. With bdio_verify_on_read in chain mode the tag
+    record is not checked.<p>
+    Fails if fh is invalid or not in read mode, or if the tag record does
+    not match the index.
+    @param[in] name 0-terminated name
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF. If there is no record
+    of that name, EOF is returned.
+ */
+int bdio_seek_named(const char *name, BDIO *fh);
+
+
+/** @fn int bdio_seek_prev_record(BDIO *fh)
+    @brief Position bdio stream at the record before the current one
+    @details Goes back to record bdio_get_rcnt-1, or to the last record
+    passed if fh is not in a record, e.g. after bdio_seek_record returned
+    EOF. fh is left as after bdio_seek_record landed on that record. Files
+    with a record table (see bdio_index_records) jump there at once. For
+    others the record headers up to the record are read once, from the
+    start of the file, and kept, so that going back further jumps there at
+    once. With
+    bdio_verify_on_read in chain mode records reached this way are not
+    checked.<p>
+    Fails if fh is invalid or not in read mode, or if the file cannot be
+    read.
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF. At the first record,
+    EOF is returned.
+ */
+int bdio_seek_prev_record(BDIO *fh);
+
+
 /** @fn size_t bdio_read(void *buf, size_t nb, BDIO *fh)
     @brief Read nb bytes from fh into buf.
     @details Independent of the endiannes of the machine and the record type, exactly
@@ -655,6 +1348,54 @@ int bdio_seek_record(BDIO *fh);
  */
 size_t bdio_read(void *buf, size_t nb, BDIO *fh);
 
+/** @fn int bdio_seek_in_record(int64_t offset, int whence, BDIO *fh)
+    @brief Move the position of the next bdio_read within the current record
+    @details offset is counted in bytes of the (decoded) payload from the
+    start of the record (whence=SEEK_SET), from the current position
+    (SEEK_CUR) or from the end of the record (SEEK_END). Only the file
+    position is changed for plain records. For encoded records (see
+    bdio_set_codec) the blocks in front of the new position are skipped
+    without decoding them; moving backwards starts over at the first block.
+    After a move, the checksum of the record is not checked by
+    bdio_verify_on_read.<p>
+    Fails if fh is invalid, not in read mode or not in a record, or if the
+    new position is outside of the record or not a multiple of the size of
+    the numbers in the record.
+    @return Upon success 0 is returned, otherwise EOF is returned.
+    @param[in] offset offset in bytes
+    @param[in] whence SEEK_SET, SEEK_CUR or SEEK_END
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_seek_in_record(int64_t offset, int whence, BDIO *fh);
+
+/** @fn int bdio_update_record(int recno, uint64_t offset, const void *data,
+                               size_t nb, BDIO *fh)
+    @brief Overwrite part of the payload of an existing record
+    @details The nb bytes at data replace the bytes at offset in the
+    payload of record recno (counted as by bdio_get_rcnt), without changing
+    its length, so the rest of the file stays in place. The bytes are
+    stored as they are, i.e. without byte-swapping. If the record is
+    followed by a hash record, its checksum is recomputed from the new
+    payload. In chain mode the checksums of the following records depend
+    on it, so their hash records are recomputed as well, as long as their
+    chain continues. The record is found through the record table (see
+    bdio_index_records) like by bdio_seek_prev_record, so in files without
+    one the records up to recno are read once.<p>
+    Afterwards fh is positioned at the beginning of the last record whose
+    checksum was recomputed, or of record recno.<p>
+    Fails if fh was not opened in mode "u", if there is no record recno, if
+    it is encoded (see bdio_set_codec) or a hash record, or if the bytes
+    exceed the payload.
+    @return Upon success 0 is returned, otherwise EOF is returned.
+    @param[in] recno number of the record
+    @param[in] offset offset of the first byte in the payload
+    @param[in] data nb bytes
+    @param[in] nb number of bytes
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_update_record(int recno, uint64_t offset, const void *data,
+                       size_t nb, BDIO *fh);
+
 
 /** @fn size_t bdio_read_f32(float *buf, size_t nb, BDIO *fh)
     @brief brief Read nb bytes from fh into buf. nb must be a multiple of 4.
@@ -737,6 +1478,221 @@ size_t bdio_read_int32(int32_t *buf, size_t nb, BDIO *fh);
 size_t bdio_read_int64(int64_t *buf, size_t nb, BDIO *fh);
 
 
+/** @fn size_t bdio_read_as_f64(double *buf, size_t n, BDIO *fh)
+    @brief Read n numbers from a record of any numeric format as doubles
+    @details Unlike bdio_read_f64, the record may have any of the formats
+    int32, int64, f16, bf16, f32 and f64 in either byte order. The data is read in
+    pieces of 8 KiB, swapped and converted while it is in the cache, so no
+    temporary copy of the record is needed. int64 numbers beyond 2^53 are
+    rounded.<p>
+    Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - the record is not numeric
+    - bdio_read fails
+    @return Returns the number of numbers read, which is smaller than n if
+    an error occurs or the end of the record is reached.
+    @param[in] buf pointer to a location for n doubles
+    @param[in] n number of numbers (not bytes) to be read
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_as_f64(double *buf, size_t n, BDIO *fh);
+
+
+/** @fn size_t bdio_read_as_f32(float *buf, size_t n, BDIO *fh)
+    @brief Read n numbers from a record of any numeric format as floats
+    @details Like bdio_read_as_f64, but converting to float.
+    @return Returns the number of numbers read.
+    @param[in] buf pointer to a location for n floats
+    @param[in] n number of numbers (not bytes) to be read
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_as_f32(float *buf, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_read_strided_f64(double *dst, uint64_t first,
+                                     size_t count, size_t stride, BDIO *fh)
+    @brief Read every stride-th number of the current record
+    @details Reads the numbers with index first+i*stride, 0<=i<count, of
+    the current record into dst, e.g. one component of interleaved
+    multi-component data. Spans of up to 8 KiB are read at once and the
+    numbers are picked from them, larger gaps are skipped with
+    bdio_seek_in_record, so only a fraction of a sparse record is read.
+    The byte order is swapped if necessary. The position of the next
+    bdio_read is after the last number read.<p>
+    Fails if the numbers of the record are not 8 bytes long, or if the last
+    index is beyond the end of the record.
+    @return Returns the number of numbers read.
+    @param[out] dst location for count doubles
+    @param[in] first index of the first number
+    @param[in] count number of numbers to be read
+    @param[in] stride distance of the indices
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_strided_f64(double *dst, uint64_t first, size_t count,
+                             size_t stride, BDIO *fh);
+
+/** @fn size_t bdio_read_strided_f32(float *dst, uint64_t first,
+                                     size_t count, size_t stride, BDIO *fh)
+    @brief As bdio_read_strided_f64, for records of 4 byte numbers
+ */
+size_t bdio_read_strided_f32(float *dst, uint64_t first, size_t count,
+                             size_t stride, BDIO *fh);
+
+/** @fn size_t bdio_read_strided_int64(int64_t *dst, uint64_t first,
+                                       size_t count, size_t stride, BDIO *fh)
+    @brief As bdio_read_strided_f64, for records of 64 bit integers
+ */
+size_t bdio_read_strided_int64(int64_t *dst, uint64_t first, size_t count,
+                               size_t stride, BDIO *fh);
+
+/** @fn size_t bdio_read_strided_int32(int32_t *dst, uint64_t first,
+                                       size_t count, size_t stride, BDIO *fh)
+    @brief As bdio_read_strided_f64, for records of 32 bit integers
+ */
+size_t bdio_read_strided_int32(int32_t *dst, uint64_t first, size_t count,
+                               size_t stride, BDIO *fh);
+
+
+/** @fn size_t bdio_read_f16_as_f32(float *buf, size_t n, BDIO *fh)
+    @brief Read n numbers from a f16 or bf16 record as floats
+    @details The 16 bit numbers are converted while they are read, with the
+    F16C instructions if the library is compiled for them. The conversion
+    is exact.<p>
+    Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - the record has neither of the formats f16 and bf16
+    - bdio_read fails
+    @return Returns the number of numbers read, which is smaller than n if
+    an error occurs or the end of the record is reached.
+    @param[in] buf pointer to a location for n floats
+    @param[in] n number of numbers (not bytes) to be read
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_f16_as_f32(float *buf, size_t n, BDIO *fh);
+
+
+/** @fn int bdio_is_complex_record(BDIO *fh)
+    @brief Checks whether the current record holds complex numbers
+    @details Complex records have the format of their real and imaginary
+    parts (f32 or f64), and their parts can also be read with bdio_read_f32
+    or bdio_read_f64.
+    @return 1 for complex records, 0 for other records, EOF if fh is not in
+    a record.
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_is_complex_record(BDIO *fh);
+
+
+/** @fn size_t bdio_read_c128(double *buf, size_t n, BDIO *fh)
+    @brief Read n complex numbers from a double precision complex record
+    @details Real and imaginary parts are stored alternately in buf, in the
+    byte order of the machine.<p>
+    Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - the record does not hold double precision complex numbers
+    - bdio_read fails
+    @return Returns the number of complex numbers read, which is smaller
+    than n if an error occurs or the end of the record is reached.
+    @param[in] buf pointer to a location for 2n doubles
+    @param[in] n number of complex numbers (not bytes) to be read
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_c128(double *buf, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_read_c64(float *buf, size_t n, BDIO *fh)
+    @brief As bdio_read_c128, for single precision complex records
+ */
+size_t bdio_read_c64(float *buf, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_read_c128_split(double *re, double *im, size_t n,
+                                    BDIO *fh)
+    @brief Read n complex numbers into separate arrays of real and imaginary
+    parts
+    @details The parts are separated while the data is read in pieces of 8
+    KiB, as needed by vectorised code working on structures of arrays.
+    @return Returns the number of complex numbers read.
+    @param[out] re location for n real parts
+    @param[out] im location for n imaginary parts
+    @param[in] n number of complex numbers
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_c128_split(double *re, double *im, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_read_c64_split(float *re, float *im, size_t n, BDIO *fh)
+    @brief As bdio_read_c128_split, for single precision complex records
+ */
+size_t bdio_read_c64_split(float *re, float *im, size_t n, BDIO *fh);
+
+/** @fn uint64_t bdio_get_large_len(BDIO *fh)
+    @brief Get the length of the large object described by the current
+    record
+    @details See bdio_write_large. The record is not consumed.
+    @return The length of the object in bytes, or 0 if the current record
+    does not describe a large object (or has been read from already).
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+uint64_t bdio_get_large_len(BDIO *fh);
+
+/** @fn size_t bdio_read_large(void *ptr, size_t nmax, BDIO *fh)
+    @brief Read a large object written by bdio_write_large
+    @details The current record must be the record describing the object,
+    i.e. bdio_seek_record has just returned it and bdio_get_large_len is
+    positive. The following chunk records are read into ptr one after the
+    other, hash records between them are skipped. Numbers are byte-swapped
+    as by the typed read functions. Afterwards fh is positioned on the last
+    chunk.<p>
+    Fails if the current record does not describe a large object, if the
+    object is larger than nmax bytes, or if a chunk is missing or does not
+    match the description.
+    @return The number of bytes read. A number smaller than the length of
+    the object indicates an error.
+    @param[out] ptr location for at least bdio_get_large_len(fh) bytes
+    @param[in] nmax size of the buffer at ptr in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_large(void *ptr, size_t nmax, BDIO *fh);
+
+/** @fn int bdio_get_array_shape(uint64_t *dims, BDIO *fh)
+    @brief Get the shape of the array described by the current record
+    @details See bdio_start_array. The current record is either the record
+    describing the array, which is not consumed, or the data record of an
+    array read by bdio_read_hyperslab.
+    @return The number of dimensions, or 0 if the current record is not
+    part of an array.
+    @param[out] dims location for BDIO_MAX_NDIM extents
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_get_array_shape(uint64_t *dims, BDIO *fh);
+
+/** @fn size_t bdio_read_hyperslab(const uint64_t *start,
+                                   const uint64_t *count,
+                                   const uint64_t *stride, void *dst,
+                                   BDIO *fh)
+    @brief Read a rectangular part of an array record
+    @details Reads the elements with index start[k]+i[k]*stride[k],
+    0<=i[k]<count[k], in every dimension k into dst, where they are stored
+    in row-major order without gaps. If the current record describes an
+    array, fh moves to its data record first; further hyperslabs of the
+    same array can then be read directly. The innermost dimensions with
+    stride 1 are merged into contiguous pieces, and only these pieces are
+    read from the file (see bdio_seek_in_record). Numbers are byte-swapped
+    as by the typed read functions.<p>
+    Fails if fh is not positioned on an array, or if the hyperslab exceeds
+    the array.
+    @return The number of bytes read.
+    @param[in] start first index in every dimension
+    @param[in] count number of indices in every dimension
+    @param[in] stride distance of the indices in every dimension, NULL
+    for 1
+    @param[out] dst location for the product of all counts elements
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_read_hyperslab(const uint64_t *start, const uint64_t *count,
+                           const uint64_t *stride, void *dst, BDIO *fh);
+
+
 /** @fn int bdio_start_record(int fmt, int uinfo, BDIO *fh)
     @brief Position bdio stream after the current record and start writing a new record with specified format and uinfo.
     @details Fails if
@@ -763,10 +1719,29 @@ size_t bdio_read_int64(int64_t *buf, size_t nb, BDIO *fh);
     BDIO_BIN_F32LE         |  for little endian single precision floats
     BDIO_BIN_F64BE         |  for big endian double precision floats
     BDIO_BIN_F64LE         |  for little endian double precision floats
+    BDIO_BIN_F16BE         |  for big endian half precision floats
+    BDIO_BIN_F16LE         |  for little endian half precision floats
+    BDIO_BIN_BF16BE        |  for big endian bfloat16 numbers
+    BDIO_BIN_BF16LE        |  for little endian bfloat16 numbers
     BDIO_BIN_INT32         |  for 32 bit integers stored in machine endianness
     BDIO_BIN_INT64         |  for 64 bit integers stored in machine endianness
     BDIO_BIN_F32           |  for single precision floats in machine endianness
     BDIO_BIN_F64           |  for double precision floats in machine endianness
+    BDIO_BIN_F16           |  for half precision floats in machine endianness
+    BDIO_BIN_BF16          |  for bfloat16 numbers in machine endianness
+    BDIO_BIN_C64BE         |  for big endian single precision complex numbers
+    BDIO_BIN_C64LE         |  for little endian single precision complex numbers
+    BDIO_BIN_C128BE        |  for big endian double precision complex numbers
+    BDIO_BIN_C128LE        |  for little endian double precision complex numbers
+    BDIO_BIN_C64           |  for single precision complex numbers in machine endianness
+    BDIO_BIN_C128          |  for double precision complex numbers in machine endianness
+
+    Complex records are stored as encoded generic records, so that readers
+    which do not know the marker do not take it for a number. The marker
+    at the start of their payload (see bdio_is_complex_record) holds the
+    f32 or f64 format of their parts, which bdio_get_rfmt reports. Without
+    codec the interleaved numbers follow the 4 byte marker as they are.
+    Complex records can not have user info 7.
   
     @param[in] uinfo is a number between 0 and 15 specified by the user.
     @param[in] fh pointer to a BDIO file descriptor structure.
@@ -800,10 +1775,16 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh);
     BDIO_BIN_F32LE      | for little endian single precision floats
     BDIO_BIN_F64BE      | for big endian double precision floats
     BDIO_BIN_F64LE      | for little endian double precision floats
+    BDIO_BIN_F16BE      | for big endian half precision floats
+    BDIO_BIN_F16LE      | for little endian half precision floats
+    BDIO_BIN_BF16BE     | for big endian bfloat16 numbers
+    BDIO_BIN_BF16LE     | for little endian bfloat16 numbers
     BDIO_BIN_INT32      | for 32 bit integers stored in last record's endianness
     BDIO_BIN_INT64      | for 64 bit integers stored in last record's endianness
     BDIO_BIN_F32        | for single precision floats in last record's endianness
     BDIO_BIN_F64        | for double precision floats in last record's endianness
+    BDIO_BIN_F16        | for half precision floats in last record's endianness
+    BDIO_BIN_BF16       | for bfloat16 numbers in last record's endianness
    @param[in] uinfo is a number between 0 and 15 specified by the user.
    @param[in] fh pointer to a BDIO file descriptor structure.
   */
@@ -920,6 +1901,182 @@ size_t bdio_write_int32(int32_t *ptr, size_t nb, BDIO *fh);
   */
 size_t bdio_write_int64(int64_t *ptr, size_t nb, BDIO *fh);
 
+/** @fn size_t bdio_write_f32_as_f16(float *ptr, size_t n, BDIO *fh)
+    @brief Write n floats to a f16 or bf16 record
+    @details The numbers are rounded to the format of the current record
+    (nearest even, infinite beyond the range of f16) and written in the
+    byte order of the record. The F16C instructions are used if the library
+    is compiled for them.<p>
+    Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - the record has neither of the formats f16 and bf16
+    - bdio_write fails
+    @return Returns the number of numbers written, which is smaller than n
+    if an error occurs.
+    @param[in] ptr pointer to n floats
+    @param[in] n number of numbers (not bytes) to be written
+    @param[in] fh pointer to a BDIO file descriptor structure.
+  */
+size_t bdio_write_f32_as_f16(float *ptr, size_t n, BDIO *fh);
+
+
+/** @fn size_t bdio_write_c128(double *ptr, size_t n, BDIO *fh)
+    @brief Write n complex numbers to a record started with a complex format
+    @details ptr holds real and imaginary parts alternately. Each part is
+    brought into the byte order of the record while the data is copied in
+    pieces of 8 KiB, so ptr is not modified.<p>
+    Fails if
+    - fh is a null pointer
+    - fh is in state BDIO_E_STATE
+    - the record has not the format BDIO_BIN_C128*
+    - bdio_write fails
+    @return Returns the number of complex numbers written, which is smaller
+    than n if an error occurs.
+    @param[in] ptr pointer to 2n doubles
+    @param[in] n number of complex numbers (not bytes) to be written
+    @param[in] fh pointer to a BDIO file descriptor structure.
+  */
+size_t bdio_write_c128(double *ptr, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_write_c64(float *ptr, size_t n, BDIO *fh)
+    @brief Write n complex numbers to a BDIO_BIN_C64* record
+    @details As bdio_write_c128, for single precision parts.
+    @return Returns the number of complex numbers written.
+  */
+size_t bdio_write_c64(float *ptr, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_write_c128_split(double *re, double *im, size_t n,
+                                     BDIO *fh)
+    @brief Write n complex numbers given by separate arrays of real and
+    imaginary parts
+    @details The parts are interleaved while they are written, so the
+    record is the same as with bdio_write_c128.
+    @return Returns the number of complex numbers written.
+    @param[in] re pointer to n real parts
+    @param[in] im pointer to n imaginary parts
+    @param[in] n number of complex numbers
+    @param[in] fh pointer to a BDIO file descriptor structure.
+  */
+size_t bdio_write_c128_split(double *re, double *im, size_t n, BDIO *fh);
+
+/** @fn size_t bdio_write_c64_split(float *re, float *im, size_t n,
+                                    BDIO *fh)
+    @brief As bdio_write_c128_split, for BDIO_BIN_C64* records
+  */
+size_t bdio_write_c64_split(float *re, float *im, size_t n, BDIO *fh);
+
+/** @fn int bdio_set_large_chunk(uint64_t chunk, BDIO *fh)
+    @brief Set the length of the chunks written by bdio_write_large
+    @details The default is the largest multiple of 16 that fits into a
+    long record, 2^28-16 bytes.<p>
+    Fails if fh is invalid or chunk is not a positive multiple of 16 smaller
+    than 2^28.
+    @param[in] chunk length of a chunk in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure
+    @return Upon success 0 is returned, otherwise EOF is returned.
+ */
+int bdio_set_large_chunk(uint64_t chunk, BDIO *fh);
+
+/** @fn size_t bdio_write_large(void *ptr, size_t nb, int fmt, int uinfo,
+                                BDIO *fh)
+    @brief Write an object that may exceed the length of a long record
+    @details The object is split into chunks of the length set by
+    bdio_set_large_chunk, which are written as consecutive records with
+    format fmt and user info uinfo. They are preceded by a generic record
+    with user info 7 describing the object (magic BDIO_LARGE_MAGIC, format,
+    user info, length and chunk length, little endian), so that chunk k
+    can be located and read as an ordinary record without reading the
+    others, e.g. by several processes in parallel. Numbers are byte-swapped
+    as by the typed write functions. All records are flushed on return.
+    Complex formats and generic records with user info 7 are not supported.
+    @return The number of bytes written. A number smaller than nb indicates
+    an error.
+    @param[in] ptr pointer to nb bytes. They are swapped in place while
+    they are written if the byte order of the file differs.
+    @param[in] nb length of the object in bytes
+    @param[in] fmt format of the chunks, as for bdio_start_record
+    @param[in] uinfo user info of the chunks
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_write_large(void *ptr, size_t nb, int fmt, int uinfo, BDIO *fh);
+
+/** @fn size_t bdio_write_named(const char *name, int fmt, int uinfo,
+                                void *ptr, size_t nb, BDIO *fh)
+    @brief Write a record labelled by a name
+    @details Writes an ASCII record (BDIO_ASC_GENERIC) holding name, without
+    the terminating 0, followed by a record with format fmt and user info
+    uinfo holding the nb bytes at ptr, so that the pair reads as the usual
+    tag record and data record. The name is also kept in an index, which
+    bdio_close appends to the file as a generic record with user info 7
+    (magic BDIO_INDEX_MAGIC) and which bdio_seek_named uses to find the
+    record. The index record is marked like padding records, so that
+    bdio_seek_record skips it and bdio_get_rcnt does not count it. In
+    append mode the names of the index at the end of the file are kept and
+    the old index record stays hidden in the middle of the file. Numbers
+    are byte-swapped as by the typed write functions and the data record
+    is flushed on return. Complex formats and generic records with user
+    info 7 are not supported.
+    @return The number of bytes written to the data record. A number
+    smaller than nb indicates an error.
+    @param[in] name 0-terminated name, not empty
+    @param[in] fmt format of the data record, as for bdio_start_record
+    @param[in] uinfo user info of both records
+    @param[in] ptr pointer to nb bytes. They are swapped in place while
+    they are written if the byte order of the file differs.
+    @param[in] nb length of the data in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+size_t bdio_write_named(const char *name, int fmt, int uinfo, void *ptr,
+                        size_t nb, BDIO *fh);
+
+/** @fn int bdio_start_array(int fmt, int uinfo, int ndim,
+                             const uint64_t *dims, BDIO *fh)
+    @brief Start a record holding a multi-dimensional array
+    @details Writes a generic record with user info 7 describing the array
+    (magic BDIO_ARRAY_MAGIC, format, ndim and the extents, little endian)
+    and starts the data record with format fmt and user info uinfo, like
+    bdio_start_record. The elements are then written in row-major order,
+    i.e. the last index varies fastest, with the usual write functions. The
+    data record should hold exactly the product of the extents elements.
+    Parts of the array can be read with bdio_read_hyperslab.<p>
+    Fails if ndim is not between 1 and BDIO_MAX_NDIM, for generic records
+    with user info 7 and if bdio_start_record fails.
+    @return Upon success 0 is returned, otherwise EOF is returned.
+    @param[in] fmt format of the data record, as for bdio_start_record
+    @param[in] uinfo user info of the data record
+    @param[in] ndim number of dimensions
+    @param[in] dims ndim extents
+    @param[in] fh pointer to a BDIO file descriptor structure.
+ */
+int bdio_start_array(int fmt, int uinfo, int ndim, const uint64_t *dims,
+                     BDIO *fh);
+
+/** @fn int bdio_write_records(int n, int fmt, int uinfo, void **ptr,
+                               size_t *nb, BDIO *fh)
+    @brief Write n complete records at once
+    @details Record i is started with format fmt and user info uinfo,
+    receives the nb[i] bytes at ptr[i] as with bdio_write and is flushed.
+    The data is not byte-swapped. A record that is still open is flushed
+    first.<p>
+    If automatic hashing is enabled in single mode with MD5, the checksums
+    of up to 16 records are computed at once by the multi-buffer MD5 engine
+    (md5mb.h). The hash records are identical to those written by
+    bdio_write.<p>
+    Fails if fh is invalid, or if bdio_start_record, bdio_write or
+    bdio_flush_record fail for one of the records.
+    @return The number of records written completely. A number smaller
+    than n indicates an error.
+    @param[in] n number of records
+    @param[in] fmt format of the records
+    @param[in] uinfo user info of the records (0..15)
+    @param[in] ptr array of n pointers to the data of the records
+    @param[in] nb array of n record lengths in bytes
+    @param[in] fh pointer to a BDIO file descriptor structure.
+  */
+int bdio_write_records(int n, int fmt, int uinfo, void **ptr, size_t *nb,
+                       BDIO *fh);
+
 
 
 
@@ -947,4 +2104,100 @@ size_t bdio_write_int64(int64_t *ptr, size_t nb, BDIO *fh);
   */
 int bdio_flush_record( BDIO *fh);
 
+
+/** @fn BDIO_DSET *bdio_dataset_open(char *const *paths, int n, int flags)
+    @brief Open n bdio files for reading as one stream of records
+    @details The files are scanned in parallel with lazy headers and
+    bdio_seek_header to count their headers and records. Afterwards they are
+    closed again, only the file that is currently read is kept open, so that
+    the memory needed does not grow with the number of files. The records
+    are numbered globally, starting with 1 for the first record of the first
+    file; ds->files holds the number of records and headers of each file.
+    flags is 0 or a combination of BDIO_DSET_VERIFY and BDIO_DSET_LAZY,
+    applied to every file when it is opened.<p>
+    Fails if n is not positive, if flags are unknown or if a file cannot be
+    opened or scanned. The errors of the files are reported as for
+    bdio_open.
+    @param[in] paths array of n file names
+    @param[in] n number of files
+    @param[in] flags 0, BDIO_DSET_VERIFY, BDIO_DSET_LAZY or both
+    @return Upon success a pointer to a new dataset is returned, otherwise
+    NULL.
+ */
+BDIO_DSET *bdio_dataset_open(char *const *paths, int n, int flags);
+
+
+/** @fn int bdio_dataset_close(BDIO_DSET *ds)
+    @brief Close the current file of a dataset and free the dataset
+    @param[in] ds pointer to a dataset
+    @return Upon success 0 is returned, otherwise EOF.
+ */
+int bdio_dataset_close(BDIO_DSET *ds);
+
+
+/** @fn int bdio_dataset_seek_record(BDIO_DSET *ds)
+    @brief Position a dataset at the next record, continuing with the next
+    file at the end of a file.
+    @details The record is read with the bdio_read functions on the handle
+    returned by bdio_dataset_member.
+    @param[in] ds pointer to a dataset
+    @return Upon success 0 is returned. At the end of the last file, or if
+    a file cannot be read, EOF is returned.
+ */
+int bdio_dataset_seek_record(BDIO_DSET *ds);
+
+
+/** @fn int bdio_dataset_goto_record(int grec, BDIO_DSET *ds)
+    @brief Position a dataset at the record with global number grec
+    @details The file holding the record is opened if necessary. Records of
+    that file are walked from the current record, or from the start of the
+    file if grec lies behind.
+    @param[in] grec global number of the record, from 1 to ds->nrec
+    @param[in] ds pointer to a dataset
+    @return Upon success 0 is returned, otherwise EOF.
+ */
+int bdio_dataset_goto_record(int grec, BDIO_DSET *ds);
+
+
+/** @fn BDIO *bdio_dataset_member(BDIO_DSET *ds)
+    @brief Get the handle of the current file of a dataset
+    @details All functions for reading can be applied to the handle, it
+    stays valid until the dataset moves to another file. It must not be
+    closed by the caller.
+    @param[in] ds pointer to a dataset
+    @return The handle, or NULL if no file is open.
+ */
+BDIO *bdio_dataset_member(BDIO_DSET *ds);
+
+
+/** @fn int bdio_dataset_rcnt(BDIO_DSET *ds)
+    @brief Get the global number of the current record of a dataset
+    @param[in] ds pointer to a dataset
+    @return The global number, or EOF if no file is open.
+ */
+int bdio_dataset_rcnt(BDIO_DSET *ds);
+
+
+/** @fn int bdio_dataset_for_each(int (*fn)(BDIO *fh, int grec, void *arg),
+                                  void *arg, int nthreads, BDIO_DSET *ds)
+    @brief Call fn for every record of a dataset
+    @details The files are distributed over nthreads threads. Each file is
+    opened by one thread with a handle of its own, and fn is called with the
+    handle positioned at each record of the file in turn, with the global
+    record number and arg. Files are processed in parallel, so fn must be
+    thread-safe if nthreads>1 and must not rely on the order of the files.
+    The current file of ds is not affected. If fn returns non-zero, the
+    remaining records of the file are skipped and no further files are
+    started.
+    @param[in] fn function called for every record
+    @param[in] arg passed to fn
+    @param[in] nthreads number of threads, 0 or 1 for the calling thread
+    @param[in] ds pointer to a dataset
+    @return 0 if all records were passed to fn, EOF if fn returned non-zero,
+    if a file could not be read or if a checksum did not match with
+    BDIO_DSET_VERIFY.
+ */
+int bdio_dataset_for_each(int (*fn)(BDIO *fh, int grec, void *arg), void *arg,
+                          int nthreads, BDIO_DSET *ds);
+
 #endif
@@ -0,0 +1,24 @@
+/** @file crc32c.h
+ *  @brief CRC32C (Castagnoli) checksums for the bdio-library
+ *  @details The interface mirrors the one of the bundled md5.h. On x86-64
+ *           the SSE4.2 crc32 instruction is used if the CPU supports it,
+ *           otherwise a portable slicing-by-8 implementation is used.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_CRC32C
+#define H_CRC32C 1
+
+#include <stdint.h>
+
+typedef struct {
+   uint32_t crc;
+} CRC32C_CTX;
+
+extern void CRC32C_Init(CRC32C_CTX *ctx);
+extern void CRC32C_Update(CRC32C_CTX *ctx, const void *data,
+                          unsigned long size);
+extern void CRC32C_Final(unsigned char *result, CRC32C_CTX *ctx);
+
+#endif
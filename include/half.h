@@ -0,0 +1,23 @@
+/** @file half.h
+ *  @brief Half precision conversions for the bdio-library
+ *  @details Conversions between float and the 16 bit formats IEEE binary16
+ *           (f16) and bfloat16 (bf16). Rounding is to nearest even, values
+ *           beyond the range of f16 become infinite, and NaNs stay NaNs.
+ *           The F16C instructions are used if the compiler targets them
+ *           (e.g. -mf16c or -march=native), portable code otherwise.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_HALF
+#define H_HALF 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+extern void HALF_F32ToF16(const float *src, uint16_t *dst, size_t n);
+extern void HALF_F16ToF32(const uint16_t *src, float *dst, size_t n);
+extern void HALF_F32ToBF16(const float *src, uint16_t *dst, size_t n);
+extern void HALF_BF16ToF32(const uint16_t *src, float *dst, size_t n);
+
+#endif
@@ -0,0 +1,25 @@
+/** @file intpack.h
+ *  @brief Integer packing for the bdio-library
+ *  @details Codec for arrays of 4 or 8 byte integers that change slowly,
+ *           such as indices and trajectory numbers. Every element is
+ *           replaced by the zigzag coded difference to its predecessor, and
+ *           groups of 128 differences are bit packed with the width of the
+ *           largest one (frame of reference). A monotonic sequence with
+ *           step 1 takes 17 bytes per 128 elements.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_INTPACK
+#define H_INTPACK 1
+
+/* n is the number of bytes of src, holding elements of size bytes each in
+ * little (bigend=0) or big endian byte order. IPK_Pack returns the packed
+ * size or 0 if it exceeds cap, IPK_Unpack returns 0 or -1 if src is
+ * malformed. */
+extern int IPK_Pack(const unsigned char *src, int n, int size, int bigend,
+                    unsigned char *dst, int cap);
+extern int IPK_Unpack(const unsigned char *src, int m, unsigned char *dst,
+                      int n, int size, int bigend);
+
+#endif
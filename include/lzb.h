@@ -0,0 +1,23 @@
+/** @file lzb.h
+ *  @brief Block compression for the bdio-library
+ *  @details A small LZ77 codec producing the LZ4 block format: sequences
+ *           of literals followed by matches within the last 64 KiB.
+ *           Compression is greedy and single pass, decompression checks all
+ *           bounds, so corrupted input is detected instead of overrunning
+ *           the output.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_LZB
+#define H_LZB 1
+
+/* size of the output buffer that always suffices for n input bytes */
+#define LZB_BOUND(n) ((n) + (n)/255 + 16)
+
+extern int LZB_Compress(const unsigned char *src, int n,
+                        unsigned char *dst, int cap);
+extern int LZB_Decompress(const unsigned char *src, int n,
+                          unsigned char *dst, int cap);
+
+#endif
@@ -0,0 +1,27 @@
+/** @file md5mb.h
+ *  @brief Multi-buffer MD5 checksums for the bdio-library
+ *  @details Computes the MD5 digests of several independent messages at
+ *           once, one message per SIMD lane. On x86-64 AVX-512 (16 lanes),
+ *           AVX2 (8 lanes) or SSE2 (4 lanes) is selected at run time, other
+ *           GCC targets use 4 lanes of the generic vector extension.
+ *           The digests are identical to those of the bundled md5.c.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_MD5MB
+#define H_MD5MB 1
+
+/* a message to be hashed: the concatenation of prefix and data */
+typedef struct {
+   const unsigned char *prefix;  /* may be NULL if plen==0 */
+   unsigned long plen;
+   const unsigned char *data;
+   unsigned long size;
+   unsigned char *digest;        /* 16 bytes of output */
+} MD5_MB_JOB;
+
+extern int MD5_MB_Lanes(void);
+extern void MD5_MB_Hash(MD5_MB_JOB *jobs, int n);
+
+#endif
@@ -0,0 +1,24 @@
+/** @file shuffle.h
+ *  @brief Byte-shuffle and XOR-delta filters for the bdio-library
+ *  @details Filters applied to arrays of 4 or 8 byte numbers before they
+ *           are compressed. The shuffle groups byte k of all elements
+ *           together (SSE2 on x86-64, portable code elsewhere), so that the
+ *           slowly varying sign and exponent bytes of floating point data
+ *           form long runs. The XOR-delta replaces every element by its XOR
+ *           with the preceding one.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_SHUFFLE
+#define H_SHUFFLE 1
+
+/* n is the number of elements of size bytes each */
+extern void SHUF_Shuffle(const unsigned char *src, unsigned char *dst,
+                         int n, int size);
+extern void SHUF_Unshuffle(const unsigned char *src, unsigned char *dst,
+                           int n, int size);
+extern void SHUF_XorDelta(unsigned char *p, int n, int size);
+extern void SHUF_XorUndelta(unsigned char *p, int n, int size);
+
+#endif
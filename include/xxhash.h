@@ -0,0 +1,26 @@
+/** @file xxhash.h
+ *  @brief XXH64 checksums for the bdio-library
+ *  @details Streaming implementation of the 64 bit xxHash algorithm
+ *           (XXH64, seed 0). The interface mirrors the one of the bundled
+ *           md5.h.
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+#ifndef H_XXHASH
+#define H_XXHASH 1
+
+#include <stdint.h>
+
+typedef struct {
+   uint64_t total;
+   uint64_t v[4];
+   unsigned char mem[32];
+   unsigned int memsize;
+} XXH64_CTX;
+
+extern void XXH64_Init(XXH64_CTX *ctx);
+extern void XXH64_Update(XXH64_CTX *ctx, const void *data, unsigned long size);
+extern void XXH64_Final(unsigned char *result, XXH64_CTX *ctx);
+
+#endif
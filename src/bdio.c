@@ -43,12 +43,26 @@
    #include <sys/types.h>
    #include <pwd.h>
 
+   /* for parallel checksum verification */
+   #include <pthread.h>
+
+   /* for following files that are still being written */
+   #include <poll.h>
+   #ifdef __linux__
+      #include <sys/inotify.h>
+   #endif
+
 #endif
 
 /* for time stamps */
 #include <time.h>
 
 #include <bdio.h>
+#include <md5mb.h>
+#include <lzb.h>
+#include <shuffle.h>
+#include <intpack.h>
+#include <half.h>
 
 /******************************************************************************/
 /* private preprocessor scripts                                               */
@@ -85,6 +99,61 @@
          | (((len)-4) <<12)                           /* record length */ \
   )
 
+/* bit of the record header marking an encoded payload */
+#define HEADER_ENC 0x2
+
+/* bit of the record header marking a record whose length is not final */
+#define HEADER_OPEN 0x4
+
+/* bit of the method of an encoded record marking complex numbers */
+#define ENC_COMPLEX 0x1000000
+
+/* bit of the method marking numbers stored as they are after the method
+ * word, without blocks. Used for complex records without codec. */
+#define ENC_PLAIN 0x2000000
+
+/* format of the decoded data, in bits 28..31 of the method. The record
+ * header of an encoded or complex record has the generic binary format. */
+#define ENC_FMT_SHIFT 28
+
+/* number of bytes per block of encoded records written, and accepted */
+#define BDIO_ENC_BLOCK 65536
+#define BDIO_ENC_MAX_BLOCK 16777216
+
+/* length of the payload of a record describing a large object */
+#define BDIO_LARGE_LEN 28
+
+/* number of bytes converted at a time by bdio_read_as_f64/f32 */
+#define BDIO_CVT_CHUNK 8192
+
+/* number of bytes per entry of the index record, see load_index */
+#define BDIO_INDEX_ENTRY 32
+
+/* a table block is written once this many records, or records starting
+ * this many bytes apart, are in the record table without one. Readers look
+ * for the last block in twice as many bytes at the end of the file. */
+#define BDIO_TABLE_BLOCK 1024
+#define BDIO_TABLE_BYTES 33554432
+
+/* number of records in flight per thread during bdio_verify */
+#define BDIO_VERIFY_DEPTH 4
+
+/* maximal number of records hashed at once by the multi-buffer MD5 */
+#define BDIO_VERIFY_BATCH 16
+
+/* maximal number of bytes of complete chunks collected in tree mode before
+ * they are hashed by the multi-buffer MD5, see tree_update */
+#define BDIO_TREE_STAGE 16777216
+
+/* number of threads scanning the files of a dataset in bdio_dataset_open */
+#define BDIO_DSET_THREADS 8
+
+/* states of a verification job */
+#define VJOB_FREE   0
+#define VJOB_QUEUED 1
+#define VJOB_BUSY   2
+#define VJOB_DONE   3
+
 #define HEADER_INT_LONG(fmt, uinfo, len) \
   (        0x0000000000000001                         /* magic=1       */ \
          | 0x0000000000000008                         /* long rec      */ \
@@ -93,6 +162,163 @@
          | (((uint64_t)(len)-8) <<12)                 /* record length */ \
   )
 
+/******************************************************************************/
+/* private data types                                                         */
+/******************************************************************************/
+
+/* a record whose checksum is to be verified */
+typedef struct
+{
+   unsigned char *data;      /* payload of the record */
+   uint64_t size;            /* allocated size of data */
+   uint64_t len;             /* length of the payload */
+   int rcnt;                 /* record number */
+   int type;                 /* hash algorithm */
+   int chain;                /* 1 for chain mode, 0 for single mode */
+   unsigned char prefix[16]; /* checksum the chain-mode hash starts with */
+   unsigned char digest[16]; /* checksum stored in the hash record */
+   unsigned char *tree;      /* payload of a tree-hash record */
+   uint64_t tsize;           /* allocated size of tree */
+   uint64_t tlen;            /* length of tree, 0 if not in tree mode */
+   int state;                /* VJOB_FREE, VJOB_QUEUED, VJOB_BUSY, VJOB_DONE */
+   int ok;                   /* 1 if the checksum matches, 0 otherwise */
+} vjob;
+
+/* chunk checksums of a record in tree mode */
+struct bdio_hash_tree
+{
+   int type;                 /* hash algorithm */
+   uint32_t chunk;           /* chunk size in bytes */
+   uint64_t len;             /* number of bytes hashed so far */
+   uint32_t fill;            /* number of bytes in the current chunk */
+   BDIO_HASH_CTX ctx;        /* checksum of the current chunk */
+   unsigned char *leaves;    /* 16 byte checksums of the completed chunks */
+   int nleaves;              /* number of completed chunks */
+   int maxleaves;            /* number of allocated leaves */
+   int err;                  /* 1 if leaves could not be allocated */
+   unsigned char *stage;     /* chunks waiting for the multi-buffer MD5 */
+   size_t slen;              /* number of bytes in stage */
+   size_t smax;              /* allocated size of stage */
+};
+
+/* checksum pipeline of a writer: bdio_write copies the data into one
+ * staging buffer while the worker hashes the other */
+struct bdio_hash_pipe
+{
+   unsigned char *buf[2];    /* staging buffers of BDIO_BUF_SIZE bytes */
+   size_t len[2];            /* number of bytes in the staging buffers */
+   int cur;                  /* buffer currently filled by bdio_write */
+   int pending;              /* 1 while buf[!cur] waits for or is hashed */
+   int quit;                 /* 1 if the worker has to terminate */
+   int type;                 /* hash algorithm */
+   BDIO_HASH_CTX *ctx;       /* state of the checksum */
+   struct bdio_hash_tree *tree; /* chunk checksums in tree mode or NULL */
+#ifndef _NO_POSIX_LIBS
+   pthread_t thread;
+   pthread_mutex_t lock;
+   pthread_cond_t cond;      /* signalled whenever pending or quit change */
+#endif
+};
+
+/* checksum of the record being read, see bdio_verify_on_read */
+struct bdio_vread
+{
+   int type;                 /* hash algorithm, 0 if nothing is checked */
+   int chain;                /* 1 for chain mode, 0 otherwise */
+   int rcnt;                 /* record being checked */
+   uint64_t len;             /* number of bytes hashed so far */
+   uint64_t rlen;            /* length of the payload */
+   int intree;               /* 1 if the record has a tree-hash record */
+   BDIO_HASH_CTX ctx;        /* checksum of the record, unless in tree */
+   struct bdio_hash_tree tree;  /* chunk checksums of a tree-hash record */
+   unsigned char *tbuf;      /* payload of the tree-hash record */
+   uint64_t tsize;           /* allocated size of tbuf */
+   unsigned char digest[16]; /* checksum stored in the hash record */
+   unsigned char last[16];   /* checksum of the last hash record passed */
+   int lost;                 /* 1 after a jump, until last is known again */
+};
+
+/* encoder or decoder of the current record */
+struct bdio_codec
+{
+   uint32_t method;          /* method of the record, 0 before it is read */
+   uint32_t block;           /* maximal number of bytes per block */
+   unsigned char *raw;       /* decoded block */
+   unsigned char *flt;       /* filtered block, follows raw */
+   unsigned char *buf;       /* compressed block, follows flt */
+   int esize;                /* size of the filtered elements, 0 if none */
+   uint32_t size;            /* allocated size of raw */
+   uint32_t fill;            /* number of bytes in raw */
+   uint32_t pos;             /* number of bytes of raw returned by bdio_read */
+   uint64_t llen;            /* length of the decoded payload */
+   uint64_t lidx;            /* number of decoded bytes returned so far */
+};
+
+/* tag record of a named record, see bdio_write_named, or a record of the
+ * record table, see bdio_index_records */
+struct bdio_iname
+{
+   uint64_t off;             /* offset of the record */
+   uint64_t hoff;            /* offset of the header before it */
+   int rcnt;                 /* number of the record */
+   int hrcnt;                /* number of records before that header */
+   int hcnt;                 /* number of that header */
+   int info;                 /* fmt+16*uinfo of a record of the table */
+   size_t pos;               /* position of the name in the pool */
+   const char *name;         /* pool+pos, set by index_sort */
+};
+
+/* names and offsets of records, read from or to be written to the end of
+ * the file */
+struct bdio_index
+{
+   struct bdio_iname *e;     /* names, sorted once read from the file */
+   int n;                    /* number of names */
+   int nmax;                 /* allocated number of names */
+   char *pool;               /* 0-terminated names */
+   size_t plen;              /* used length of pool */
+   size_t psize;             /* allocated length of pool */
+   struct bdio_iname *r;     /* record table, in the order of the file */
+   int nr;                   /* number of records in the table */
+   int nrmax;                /* allocated number of records */
+   int records;              /* 1 if written records enter the table */
+   int loaded;               /* 1 once the end of the file was looked at */
+   int dirty;                /* 1 if names were added by bdio_write_named */
+   int rcnt;                 /* number of records when the index was read */
+   int nblk;                 /* number of records already in a table block */
+   int walk;                 /* 1 if the table ends before the file */
+   uint64_t blk;             /* offset of the last table block or index
+                                record with a table, 0 if none */
+   uint64_t prev;            /* offset of the last block not loaded yet */
+};
+
+/* ring of verification jobs shared between bdio_verify and its threads */
+typedef struct
+{
+   vjob *jobs;               /* the ring */
+   int njobs;                /* size of the ring */
+   int take;                 /* next job to be taken by a thread */
+   int batch;                /* maximal number of jobs taken at once */
+   int quit;                 /* 1 once no further jobs will be queued */
+#ifndef _NO_POSIX_LIBS
+   pthread_mutex_t lock;
+   pthread_cond_t cond;      /* signalled whenever a job changes its state */
+#endif
+} vpool;
+
+typedef struct
+{
+   BDIO_DSET *ds;
+   int (*fn)(BDIO*, int, void*); /* called for every record, NULL while the
+                                    files are scanned by bdio_dataset_open */
+   void *arg;
+   int next;                 /* next file to be taken by a thread */
+   int err;                  /* 1 once a file failed or fn returned non-zero */
+#ifndef _NO_POSIX_LIBS
+   pthread_mutex_t lock;
+#endif
+} dpool;
+
 /******************************************************************************/
 /* private global variables                                                   */
 /******************************************************************************/
@@ -140,6 +366,20 @@ static void swap64(void *R, long N)
 }
 
 
+static void swap16(void *R, long N)
+{
+  register unsigned char *j;
+  unsigned char swap;
+  unsigned char *max;
+
+  max = (unsigned char*)R+N-1;
+  for(j=R;j<max;j+=2)
+  {
+    swap = j[0]; j[0] = j[1]; j[1] = swap;
+  }
+}
+
+
 static void swap32(void *R, long N)
 {
   register unsigned char *j,*k;
@@ -157,6 +397,18 @@ static void swap32(void *R, long N)
   }
 }
 
+
+static void swap_data(void *p, size_t nb, int size)
+{
+   if( size==2 )
+      swap16(p, nb);
+   else if( size==4 )
+      swap32(p, nb);
+   else if( size==8 )
+      swap64(p, nb);
+}
+
+
 static int is_valid_bdio(const char *caller, BDIO *fh)
 {
    /* returns  1 if fh is a pointer to a valid bdio structure 
@@ -317,11 +569,9 @@ static void bdio_error(int syserr, char *errmsg, BDIO *fh)
 }
 
 
-static void buf2head(BDIO *fh, unsigned char *buf)
+static void buf2fields(BDIO *fh)
 {
-   int bufpos=0;
-   int len,totlen;
-   int maxLen=128;
+   /* the fixed-length fields in the first 20 bytes of a header */
    uint32_t hdr[5];
    memcpy(hdr,fh->buf,20);
    if( fh->endian==BDIO_BEND )
@@ -332,6 +582,16 @@ static void buf2head(BDIO *fh, unsigned char *buf)
    fh->hdirinfo2 = (hdr[2] & 0x003fffff);
    fh->hcdate = hdr[3];
    fh->hmdate = hdr[4];
+}
+
+
+static void buf2head(BDIO *fh, unsigned char *buf)
+{
+   int bufpos=0;
+   int len,totlen;
+   int maxLen=128;
+   buf2fields(fh);
+   fh->hstrings = 1;
    bufpos=20;
    len = strlen((char*)buf+bufpos)+1;
    totlen=len;
@@ -417,7 +677,7 @@ static int write_header(BDIO *fh,char *protocol_info)
    {
       len = BDIO_MAX_PINFO_LENGTH;
    }
-   strncpy((char*)&(fh->buf[fh->bufidx]),protocol_info,len);
+   memcpy(&(fh->buf[fh->bufidx]),protocol_info,len);
    fh->bufidx+=len;
    fh->buf[fh->bufidx-1]='\0'; /* make sure it's 0-terminated */
    minpadding += (4-(fh->bufidx+minpadding)%4)%4;  /* header ends at 4b bndry*/
@@ -466,6 +726,8 @@ static int write_header(BDIO *fh,char *protocol_info)
    buf2head(fh,fh->buf);
    /* set the remaining  header fields */
    fh->hcnt++;
+   fh->hend = fh->hstart+fh->bufidx;
+   fh->hrcnt = fh->rcnt;
    fh->state = BDIO_H_STATE;
    fh->ridx = fh->bufidx;
    fh->rlen = fh->bufidx;
@@ -575,6 +837,102 @@ static int update_header(BDIO *fh)
    return 0;
 }
 
+static int write_dirinfo(BDIO *fh)
+{
+   /* back-patches the number of records and bytes following the last header
+    * at the end of writing, saturated at the widths of the fields */
+   uint32_t hdr;
+   uint64_t dir1, dir2;
+   long end;
+
+   if( fseek(fh->fp, 0, SEEK_END)==-1 || (end = ftell(fh->fp))==-1 )
+   {
+      bdio_error(1,"Error in write_dirinfo. fseek fails with",fh);
+      return EOF;
+   }
+   dir1 = fh->rcnt-fh->hrcnt;
+   dir2 = (uint64_t) end-fh->hend;
+   if( dir1>0x3ff )
+      dir1 = 0x3ff;
+   if( dir2>0x3fffff )
+      dir2 = 0x3fffff;
+   hdr =  ( (dir1 & 0x3ff) << 22 )
+         |(  dir2 & 0x3fffff );
+   if(fh->endian == BDIO_BEND)
+      swap32(&hdr,4);
+   if( fseek(fh->fp, fh->hstart+8, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in write_dirinfo. fseek fails with",fh);
+      return EOF;
+   }
+   if( fwrite(&hdr,4,1,fh->fp)!=1 )
+   {
+      bdio_error(1,"Error in write_dirinfo. fwrite fails with",fh);
+      return EOF;
+   }
+   fh->hdirinfo1 = (int) dir1;
+   fh->hdirinfo2 = (int) dir2;
+   return 0;
+}
+
+
+static int head_strings(int len, BDIO *fh)
+{
+   /* parses the strings of a header of length len+8 held in fh->buf */
+
+   /* allocate memory for header information*/
+   if( fh->hcuser==NULL )
+   {
+      fh->hcuser = (char*) malloc((len-12) * sizeof(char));
+      if( fh->hcuser == NULL)
+      {
+         bdio_error(1,"Error in read header. malloc fails with",fh);
+         return EOF;
+      }
+      fh->hssize=len-12;
+   }
+   else if( fh->hssize < len-12 )
+   {
+      fh->hcuser = (char*) realloc(fh->hcuser, (len-12) * sizeof(char));
+      if( fh->hcuser == NULL)
+      {
+         bdio_error(1,"Error in read header. realloc fails with",fh);
+         return EOF;
+      }
+      fh->hssize=len-12;
+   }
+
+   buf2head(fh,fh->buf);
+   return 0;
+}
+
+static int load_head_strings(BDIO *fh)
+{
+   /* reads the strings of a header that was skipped in lazy mode, see
+    * bdio_lazy_headers */
+   long fpos;
+   int len;
+
+   if( fh->hstrings )
+      return 0;
+   len = (int) (fh->hend-fh->hstart)-8;
+   if( (fpos = ftell(fh->fp))==-1 || fseek(fh->fp, fh->hstart, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in load_head_strings. fseek fails with",fh);
+      return EOF;
+   }
+   if( fread(fh->buf, 1, len+8, fh->fp)!=len+8 )
+   {
+      bdio_error(1,"Error in load_head_strings. fread fails with",fh);
+      return EOF;
+   }
+   if( fseek(fh->fp, fpos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in load_head_strings. fseek fails with",fh);
+      return EOF;
+   }
+   return head_strings(len, fh);
+}
 
 static int read_header(BDIO *fh)
 {
@@ -612,8 +970,9 @@ static int read_header(BDIO *fh)
    fh->hversion = (hdr[1] & 0xffff0000)>>16;
    len          =  hdr[1] & 0x00000fff;
 
-   wr = fread( fh->buf+8, 1, len, fh->fp );
-   if ( wr != len )
+   /* in lazy mode the strings are only read by the bdio_get_h* functions */
+   wr = fread( fh->buf+8, 1, fh->hlazy ? 12 : len, fh->fp );
+   if ( wr != (fh->hlazy ? 12 : len) )
    {
       if( feof( fh->fp ) )
          bdio_error(0,"Error in read_header. Unexpected EOF.",fh);
@@ -622,34 +981,24 @@ static int read_header(BDIO *fh)
       return EOF;
    }
 
-   /* allocate memory for header information*/
-   if( fh->hcuser==NULL )
-   {
-      fh->hcuser = (char*) malloc((len-12) * sizeof(char));
-      if( fh->hcuser == NULL)
-      {
-         bdio_error(1,"Error in read header. malloc fails with",fh);
-         return EOF;
-      }
-      fh->hssize=len-12;
-   }
-   else if( fh->hssize < len-12 )
+   if( fh->hlazy )
    {
-      fh->hcuser = (char*) realloc(fh->hcuser, (len-12) * sizeof(char));
-      if( fh->hcuser == NULL)
+      if( fseek(fh->fp, len-12, SEEK_CUR)==-1 )
       {
-         bdio_error(1,"Error in read header. realloc fails with",fh);
+         bdio_error(1,"Error in read_header. fseek fails with",fh);
          return EOF;
       }
-      fh->hssize=len-12;
-   }
-
-   buf2head(fh,fh->buf);
+      buf2fields(fh);
+      fh->hstrings = 0;
+   }else if( head_strings(len, fh)!=0 )
+      return EOF;
 
    /* set the remaining  header fields */
    fh->hcnt++;
    fh->state = BDIO_H_STATE;
    fh->hstart = fh->rstart;
+   fh->hend = fh->rstart+len+8;
+   fh->hrcnt = fh->rcnt;
    fh->rlen = len+8;
    fh->ridx = len+8;
    fh->rlongrec = 0;
@@ -705,1088 +1054,5745 @@ static int buf_write(unsigned char *dat, int n, BDIO *fh)
 }
 
 
-static size_t bdio_write_hash(BDIO *fh)
+static void hash_init(int type, BDIO_HASH_CTX *ctx)
 {
-   int nb, i;
-   uint32_t magic[1];
-   unsigned char digest[16];
-
-   if (fh->hash_auto==BDIO_NO_HASH)
+   switch( type )
    {
-      bdio_error(1,"Error in bdio_write_hash: HASH_AUTO not set",fh);
-      fh->state=BDIO_E_STATE;
-      return -1;
+      case BDIO_HASH_CRC32C: CRC32C_Init(&(ctx->crc32c));
+                             break;
+      case BDIO_HASH_XXH64:  XXH64_Init(&(ctx->xxh64));
+                             break;
+      default:               MD5_Init(&(ctx->md5));
    }
-   
-   printf("fh->state=%i\n",fh->state);
-   MD5_Final(digest,fh->hash);
-   for (i=0;i<16;i++)
-      fh->prev_digest[i] = digest[i];
+}
 
-   if (fh->hash_mode==BDIO_HASH_CHAIN)
+static void hash_update(int type, BDIO_HASH_CTX *ctx, void *data,
+                        unsigned long size)
+{
+   switch( type )
    {
-      magic[0] = BDIO_HASH_MAGIC_C;
-   } else {
-      magic[0] = BDIO_HASH_MAGIC_S;
+      case BDIO_HASH_CRC32C: CRC32C_Update(&(ctx->crc32c), data, size);
+                             break;
+      case BDIO_HASH_XXH64:  XXH64_Update(&(ctx->xxh64), data, size);
+                             break;
+      default:               MD5_Update(&(ctx->md5), data, size);
    }
-   
-   fh->hash_auto=BDIO_NO_HASH; /* no hash records of hash records of hash records... */
-   bdio_start_record(BDIO_BIN_GENERIC, 7, fh);
+}
 
-   nb  = bdio_write(magic, 4, fh);
-   nb += bdio_write(digest, 16, fh);
+static void hash_final(int type, unsigned char digest[16], BDIO_HASH_CTX *ctx)
+{
+   /* shorter checksums are padded with zeros to 16 bytes */
+   memset(digest, 0, 16);
+   switch( type )
+   {
+      case BDIO_HASH_CRC32C: CRC32C_Final(digest, &(ctx->crc32c));
+                             break;
+      case BDIO_HASH_XXH64:  XXH64_Final(digest, &(ctx->xxh64));
+                             break;
+      default:               MD5_Final(digest, &(ctx->md5));
+   }
+}
 
-   
-   bdio_flush_record(fh);
-   fh->hash_auto=BDIO_AUTO_HASH;
+static void put_uint32(unsigned char *buf, uint32_t x)
+{
+   /* store x in little endian byte order */
+   buf[0] = x & 0xff;
+   buf[1] = (x >> 8) & 0xff;
+   buf[2] = (x >> 16) & 0xff;
+   buf[3] = (x >> 24) & 0xff;
+}
 
-   return nb;
+static uint32_t get_uint32(const unsigned char *buf)
+{
+   return  (uint32_t) buf[0]        | ((uint32_t) buf[1] << 8)
+         | ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
 }
 
-/******************************************************************************/
-/* public functions                                                           */
-/******************************************************************************/
+static void put_uint64(unsigned char *buf, uint64_t x)
+{
+   put_uint32(buf, (uint32_t) (x & 0xffffffff));
+   put_uint32(buf+4, (uint32_t) (x >> 32));
+}
 
-void bdio_hash_auto(BDIO *fh)
+static uint64_t get_uint64(const unsigned char *buf)
 {
-   fh->hash_auto = BDIO_AUTO_HASH;
-   fh->hash_mode = BDIO_HASH_SINGL;
-   if( (fh->hash = malloc(sizeof(MD5_CTX)))==NULL )
-   {
-      fh->state=BDIO_E_STATE;
-      bdio_error(1,"Error in bdio_hash_auto. Out of memory",fh);
-   }
+   return (uint64_t) get_uint32(buf) | ((uint64_t) get_uint32(buf+4) << 32);
 }
 
+static void tree_start(struct bdio_hash_tree *t, int type)
+{
+   t->type = type;
+   t->len = 0;
+   t->fill = 0;
+   t->nleaves = 0;
+   t->err = 0;
+   t->slen = 0;
+   hash_init(type, &(t->ctx));
+}
 
-void bdio_hash_chain(BDIO *fh)
+static unsigned char *tree_leaves(struct bdio_hash_tree *t, int n)
 {
-   int i;
-  
-   if (!fh->hash_auto)
-      bdio_error(0,"Error in bdio_hash_chain. BDIO_HASH_AUTO no set (maybe call bdio_hash_auto first?)",fh);
+   /* returns space for n further leaves, or NULL if realloc fails */
+   unsigned char *p;
+   int m;
 
-   fh->hash_mode = BDIO_HASH_CHAIN;
-   for (i=0;i<16;i++)
+   if( t->nleaves+n > t->maxleaves )
    {
-      fh->prev_digest[i] = (unsigned char)0;
+      m = 2*t->maxleaves;
+      if( m < t->nleaves+n )
+         m = t->nleaves+n+16;
+      if( (p = (unsigned char*) realloc(t->leaves, 16*(size_t) m))==NULL )
+      {
+         t->err = 1;
+         return NULL;
+      }
+      t->leaves = p;
+      t->maxleaves = m;
    }
+   return t->leaves+16*t->nleaves;
 }
 
-
-int bdio_is_hash_record(unsigned char digest[16], BDIO *fh)
+static size_t tree_stage(struct bdio_hash_tree *t)
 {
-   unsigned char d[4];
-   int rb, is_mg;
-   long fpos;
-   
-   if (bdio_get_rlen(fh)!=20)
-      return 0;
+   /* returns the number of bytes of chunks collected in t->stage before
+    * they are hashed at once, or 0 if chunks are hashed one by one */
+   unsigned char *p;
+   size_t k;
 
-   fpos = ftell(fh->fp);
-   rb = fread(d,1,4,fh->fp);
-   is_mg = d[3];
-   is_mg <<=8;
-   is_mg |= d[2];
-   is_mg <<=8;
-   is_mg |= d[1];
-   is_mg <<=8;
-   is_mg |= d[0];
-   
-   rb=0;
-   if ( (is_mg==BDIO_HASH_MAGIC_S)||(is_mg==BDIO_HASH_MAGIC_C) )
+   if( (t->type!=BDIO_HASH_MD5) || (t->chunk>BDIO_TREE_STAGE/2) )
+      return 0;
+   k = BDIO_TREE_STAGE/t->chunk;
+   if( k>BDIO_VERIFY_BATCH )
+      k = BDIO_VERIFY_BATCH;
+   if( t->smax < k*t->chunk )
    {
-      rb=fread(digest,1,16,fh->fp);
+      if( (p = (unsigned char*) realloc(t->stage, k*t->chunk))==NULL )
+         return 0;
+      t->stage = p;
+      t->smax = k*t->chunk;
    }
-   fseek(fh->fp,fpos,SEEK_SET);
-   if(rb==16)
-      return 1;
-   else
-      return 0;
+   return k*t->chunk;
 }
 
-
-void bdio_perror(const char *s, BDIO *fh)
+static void tree_flush(struct bdio_hash_tree *t)
 {
-   if( fh==NULL || fh->nerror==0)
+   /* hashes the chunks in t->stage, of which the last may be incomplete */
+   MD5_MB_JOB mb[BDIO_VERIFY_BATCH];
+   unsigned char *leaf;
+   int j, k;
+
+   if( t->slen==0 )
       return;
-   if( s != NULL )
-      fprintf(fh->msg,"%s%s\n",s,fh->error);
-   else
-      fprintf(fh->msg,"%s\n",fh->error);
-   return;
+   k = (int) ((t->slen+t->chunk-1)/t->chunk);
+   if( (leaf=tree_leaves(t, k))==NULL )
+      return;
+   for( j=0; j<k; j++ )
+   {
+      mb[j].prefix = NULL;
+      mb[j].plen   = 0;
+      mb[j].data   = t->stage+(size_t)j*t->chunk;
+      mb[j].size   = (j<k-1) ? t->chunk : t->slen-(size_t)j*t->chunk;
+      mb[j].digest = leaf+16*j;
+   }
+   MD5_MB_Hash(mb, k);
+   t->nleaves += k;
+   t->slen = 0;
 }
 
-void bdio_pferror(const char *s, BDIO *fh)
+static void tree_update(struct bdio_hash_tree *t, const unsigned char *p,
+                        size_t n)
 {
-   if( fh==NULL || fh->nerror==0)
-      return;
-   if( s != NULL )
-      fprintf(fh->msg,"%s%s\n",s,fh->ferror);
-   else
-      fprintf(fh->msg,"%s\n",fh->ferror);
-   return;
+   /* In MD5 mode, complete chunks are hashed by the multi-buffer engine:
+    * directly if enough of them are passed at once, otherwise after they
+    * have been collected in t->stage, so that the small pieces written by
+    * bdio_write and the checksum pipeline use it as well. */
+   MD5_MB_JOB mb[BDIO_VERIFY_BATCH];
+   unsigned char *leaf;
+   size_t m, ns;
+   int j, k;
+
+   while( (n>0) && !t->err )
+   {
+      if( (t->fill==0) && (t->slen==0) && (t->type==BDIO_HASH_MD5) &&
+          (n>=2*(size_t)t->chunk) )
+      {
+         /* complete chunks are hashed at once by the multi-buffer MD5 */
+         k = (n/t->chunk > BDIO_VERIFY_BATCH) ? BDIO_VERIFY_BATCH
+                                              : (int) (n/t->chunk);
+         if( (leaf=tree_leaves(t, k))==NULL )
+            return;
+         for( j=0; j<k; j++ )
+         {
+            mb[j].prefix = NULL;
+            mb[j].plen   = 0;
+            mb[j].data   = p+(size_t)j*t->chunk;
+            mb[j].size   = t->chunk;
+            mb[j].digest = leaf+16*j;
+         }
+         MD5_MB_Hash(mb, k);
+         t->nleaves += k;
+         t->len += (uint64_t) k*t->chunk;
+         p += (size_t) k*t->chunk;
+         n -= (size_t) k*t->chunk;
+         continue;
+      }
+      if( (t->fill==0) && ((ns=tree_stage(t))>0) )
+      {
+         m = ns-t->slen;
+         if( m>n )
+            m = n;
+         memcpy(t->stage+t->slen, p, m);
+         t->slen += m;
+         t->len  += m;
+         p += m;
+         n -= m;
+         if( t->slen==ns )
+            tree_flush(t);
+         continue;
+      }
+      m = t->chunk-t->fill;
+      if( m>n )
+         m = n;
+      hash_update(t->type, &(t->ctx), (void*) p, m);
+      t->fill += m;
+      t->len  += m;
+      p += m;
+      n -= m;
+      if( t->fill==t->chunk )
+      {
+         if( (leaf=tree_leaves(t, 1))==NULL )
+            return;
+         hash_final(t->type, leaf, &(t->ctx));
+         t->nleaves++;
+         hash_init(t->type, &(t->ctx));
+         t->fill = 0;
+      }
+   }
 }
 
-BDIO *bdio_open(const char* file, const char* mode, char* protocol_info)
+static void tree_final(struct bdio_hash_tree *t, unsigned char root[16])
 {
-   BDIO *fh;
-   int wr;
-   char errormsg[256];
-   int last_hcnt;
-   long fpos;
+   /* the root is the checksum of the list of leaves */
+   BDIO_HASH_CTX ctx;
+   unsigned char *leaf;
 
-   if( default_msg==NULL )
-      default_msg = stderr;
-   
-   fh = (BDIO*) malloc(sizeof(BDIO));
-   if( fh==NULL )
+   tree_flush(t);
+   if( (t->fill>0) && ((leaf=tree_leaves(t, 1))!=NULL) )
    {
-      return NULL;
+      hash_final(t->type, leaf, &(t->ctx));
+      t->nleaves++;
+      t->fill = 0;
    }
+   hash_init(t->type, &ctx);
+   hash_update(t->type, &ctx, t->leaves, 16*(unsigned long) t->nleaves);
+   hash_final(t->type, root, &ctx);
+}
 
+static int tree_payload_ok(const unsigned char *p, uint64_t len)
+{
+   /* checks the first 36 bytes of a tree-hash record of length len */
+   uint64_t nb;
+   uint32_t chunk;
+   int type;
 
-   fh->msg = default_msg;
-   fh->verbose = default_verbosity;
-   fh->nerror = 0;
-   fh->error[0] = 0;
-   fh->ferror[0]= 0;
-   fh->hash_auto=BDIO_NO_HASH;
-   fh->hash_mode=BDIO_HASH_SINGL;
+   if( (len<36) || (get_uint32(p)!=BDIO_HASH_MAGIC_TREE) )
+      return 0;
+   type  = (int) get_uint32(p+20);
+   chunk = get_uint32(p+24);
+   nb    = get_uint64(p+28);
+   if( (type!=BDIO_HASH_MD5) && (type!=BDIO_HASH_CRC32C) &&
+       (type!=BDIO_HASH_XXH64) )
+      return 0;
+   if( chunk==0 )
+      return 0;
+   return len == 36+16*((nb+chunk-1)/chunk);
+}
 
-   /* test the machine for compatibility */
-   if( sizeof(int32_t) != 4 )
-   {
-      bdio_error(0,"Error in bdio_open. sizeof(int32_t) is not 4 bytes.",fh);
-      free(fh);
-      return NULL;
-   }
+static int tree_check(const unsigned char *p, uint64_t len,
+                      const unsigned char *data, uint64_t nb)
+{
+   /* returns 1 if the leaves and root of the tree-hash record p of length
+    * len match the nb bytes of data, and 0 otherwise */
+   struct bdio_hash_tree t;
+   unsigned char root[16];
+   int ok;
 
-   if( sizeof(int64_t) != 8 )
-   {
-      bdio_error(0,"Error in bdio_open. sizeof(int64_t) is not 8 bytes.",fh);
-      free(fh);
-      return NULL;
-   }
+   if( get_uint64(p+28)!=nb )
+      return 0;
+   memset(&t, 0, sizeof(t));
+   t.chunk = get_uint32(p+24);
+   tree_start(&t, (int) get_uint32(p+20));
+   tree_update(&t, data, nb);
+   tree_final(&t, root);
+   ok = !t.err && (36+16*(uint64_t) t.nleaves==len)
+        && (memcmp(root, p+4, 16)==0)
+        && (memcmp(t.leaves, p+36, 16*(size_t) t.nleaves)==0);
+   free(t.leaves);
+   free(t.stage);
+   return ok;
+}
 
-   if( sizeof(float) != 4 )
+static void hash_feed(int type, BDIO_HASH_CTX *ctx, struct bdio_hash_tree *tree,
+                      void *data, size_t nb)
+{
+   if( tree!=NULL )
+      tree_update(tree, (const unsigned char*) data, nb);
+   else
+      hash_update(type, ctx, data, nb);
+}
+
+#ifndef _NO_POSIX_LIBS
+static void *hash_pipe_thread(void *arg)
+{
+   struct bdio_hash_pipe *hp = (struct bdio_hash_pipe*) arg;
+   int b;
+
+   pthread_mutex_lock(&(hp->lock));
+   for(;;)
    {
-      bdio_error(0,"Error in bdio_open. sizeof(float) is not 4 bytes.",fh);
-      free(fh);
-      return NULL;
+      if( hp->pending )
+      {
+         /* the buffer not filled by the writer */
+         b = 1-hp->cur;
+         pthread_mutex_unlock(&(hp->lock));
+         hash_feed(hp->type, hp->ctx, hp->tree, hp->buf[b], hp->len[b]);
+         pthread_mutex_lock(&(hp->lock));
+         hp->len[b] = 0;
+         hp->pending = 0;
+         pthread_cond_broadcast(&(hp->cond));
+      }else if( hp->quit )
+      {
+         break;
+      }else
+      {
+         pthread_cond_wait(&(hp->cond), &(hp->lock));
+      }
    }
+   pthread_mutex_unlock(&(hp->lock));
+   return NULL;
+}
+#endif
 
-   if( sizeof(double) != 8 )
+static void hash_pipe_wait(struct bdio_hash_pipe *hp)
+{
+   /* wait until the worker is idle */
+#ifndef _NO_POSIX_LIBS
+   pthread_mutex_lock(&(hp->lock));
+   while( hp->pending )
+      pthread_cond_wait(&(hp->cond), &(hp->lock));
+   pthread_mutex_unlock(&(hp->lock));
+#endif
+}
+
+static void hash_pipe_submit(struct bdio_hash_pipe *hp)
+{
+   /* hand the current staging buffer to the worker and switch buffers */
+   hash_pipe_wait(hp);
+#ifndef _NO_POSIX_LIBS
+   pthread_mutex_lock(&(hp->lock));
+   hp->cur = 1-hp->cur;
+   hp->pending = 1;
+   pthread_cond_broadcast(&(hp->cond));
+   pthread_mutex_unlock(&(hp->lock));
+#endif
+}
+
+static void hash_pipe_free(BDIO *fh)
+{
+   struct bdio_hash_pipe *hp = fh->hpipe;
+
+   if( hp==NULL )
+      return;
+#ifndef _NO_POSIX_LIBS
+   pthread_mutex_lock(&(hp->lock));
+   hp->quit = 1;
+   pthread_cond_broadcast(&(hp->cond));
+   pthread_mutex_unlock(&(hp->lock));
+   pthread_join(hp->thread, NULL);
+   pthread_mutex_destroy(&(hp->lock));
+   pthread_cond_destroy(&(hp->cond));
+#endif
+   free(hp->buf[0]);
+   free(hp);
+   fh->hpipe = NULL;
+}
+
+static void hash_tree_free(BDIO *fh)
+{
+   if( fh->htree==NULL )
+      return;
+   free(fh->htree->leaves);
+   free(fh->htree->stage);
+   free(fh->htree);
+   fh->htree = NULL;
+}
+
+static void hash_pipe_start(BDIO *fh)
+{
+   /* start the checksum worker of fh. If this is not possible, checksums
+    * are computed by the writing thread. */
+#ifndef _NO_POSIX_LIBS
+   struct bdio_hash_pipe *hp;
+
+   if( fh->hpipe!=NULL )
+      return;
+   if( (hp = (struct bdio_hash_pipe*) calloc(1, sizeof(*hp)))==NULL )
+      return;
+   if( (hp->buf[0] = (unsigned char*) malloc(2*BDIO_BUF_SIZE))==NULL )
    {
-      bdio_error(0,"Error in bdio_open. sizeof(double) is not 8 bytes.",fh);
-      free(fh);
-      return NULL;
+      free(hp);
+      return;
    }
-   
-   switch( *mode )
-   {
-      case 'r': fh->mode = BDIO_R_MODE;
-                break;
-      case 'w': fh->mode = BDIO_W_MODE;
-                break;
-      case 'a': fh->mode = BDIO_A_MODE;
-                break;
-      default:  bdio_error(0,"Error in bdio_open. Unknown mode.",fh);
-                free(fh);
-                return NULL;
+   hp->buf[1] = hp->buf[0]+BDIO_BUF_SIZE;
+   pthread_mutex_init(&(hp->lock), NULL);
+   pthread_cond_init(&(hp->cond), NULL);
+   if( pthread_create(&(hp->thread), NULL, hash_pipe_thread, hp)!=0 )
+   {
+      pthread_mutex_destroy(&(hp->lock));
+      pthread_cond_destroy(&(hp->cond));
+      free(hp->buf[0]);
+      free(hp);
+      return;
    }
+   fh->hpipe = hp;
+#endif
+}
 
-   if( mode[1] != 0 )
+static void hash_write(void *data, size_t nb, BDIO *fh)
+{
+   /* add nb bytes to the checksum of the current record */
+   struct bdio_hash_pipe *hp = fh->hpipe;
+   unsigned char *p = (unsigned char*) data;
+   size_t n;
+
+   if( hp==NULL )
    {
-      /* r+ w+ and a+ modes do not exist in bdio */
-      bdio_error(0,"Error in bdio_open. Unknown mode",fh);
-      free(fh);
-      return NULL;
+      hash_feed(fh->hash_type, fh->hash,
+                (fh->hash_mode==BDIO_HASH_TREE) ? fh->htree : NULL, data, nb);
+      return;
    }
+   while( nb>0 )
+   {
+      n = BDIO_BUF_SIZE-hp->len[hp->cur];
+      if( n>nb )
+         n = nb;
+      memcpy(hp->buf[hp->cur]+hp->len[hp->cur], p, n);
+      hp->len[hp->cur] += n;
+      p  += n;
+      nb -= n;
+      if( hp->len[hp->cur]==BDIO_BUF_SIZE )
+         hash_pipe_submit(hp);
+   }
+}
 
-   /* determine machine endiannes */
-   switch( isBigEndian() )
+static void hash_drain(BDIO *fh)
+{
+   /* wait until all data passed to hash_write is part of the checksum */
+   struct bdio_hash_pipe *hp = fh->hpipe;
+
+   if( hp==NULL )
+      return;
+   if( hp->len[hp->cur]>0 )
+      hash_pipe_submit(hp);
+   hash_pipe_wait(hp);
+}
+
+static void hash_start(BDIO *fh)
+{
+   /* start the checksum of a new record */
+   hash_drain(fh);
+   if( fh->hpipe!=NULL )
    {
-      case 0: fh->endian = BDIO_LEND;
-              break;
-      case 1: fh->endian = BDIO_BEND;
-              break;
-      default:bdio_error(0,"Error in bdio_open. Machine has unknown endianess.",
-                         fh);
-                 free(fh);
-                 return NULL;
+      fh->hpipe->type = fh->hash_type;
+      fh->hpipe->ctx  = fh->hash;
+      fh->hpipe->tree = (fh->hash_mode==BDIO_HASH_TREE) ? fh->htree : NULL;
    }
-
-   fh->buf = (unsigned char*) malloc(sizeof(char)*(BDIO_BUF_SIZE));
-   if( fh==NULL)
+   if (fh->hash_mode==BDIO_HASH_TREE)
    {
-      bdio_error(1,"Error in bdio_open. malloc fails with",fh);
-      free(fh);
-      return NULL;
+      tree_start(fh->htree, fh->hash_type);
+      return;
    }
+   hash_init(fh->hash_type, fh->hash);
+   if (fh->hash_mode==BDIO_HASH_CHAIN && !fh->hash_first)
+      hash_update(fh->hash_type, fh->hash, fh->prev_digest, 16);
+}
 
-   if( fh->mode == BDIO_W_MODE )
-   {
-      if( protocol_info==NULL )
-      {
-         bdio_error(0,"Error in bdio_open. No protocol info supplied.",fh);
-         free(fh->buf);
-         free(fh);
-         return NULL;
-      }
-      if( (fh->fp = fopen(file, "w+"))==NULL )
-      {
-         sprintf(errormsg,
-              "Error in bdio_open. Cannot open %s for writing. fopen fails with"
-                                                                    ,file);
-         bdio_error(1,errormsg,fh);
-         free(fh->buf);
-         free(fh);
-         return NULL;
-      }
+static int head_fmt(BDIO *fh)
+{
+   /* format in the record header: encoded and complex records are stored
+    * as generic binary records, so that readers which do not decode them do
+    * not take the payload for numbers. Their format is in the method word,
+    * or in the marker of complex records without codec. */
+   return (fh->renc || fh->rcplx) ? BDIO_BIN_GENERIC : fh->rfmt;
+}
 
-      fh->hcnt = 0;
-      fh->rcnt = 0;
-      fh->hstart = 0;
-      fh->rstart = 0;
-      fh->bufstart= 0;
-      fh->bufidx = 0;
-      if( write_header(fh, protocol_info) != 0 )
-      {
-         fclose(fh->fp);
-         free(fh->buf);
-         free(fh);
-         return NULL;
-      }
-      return fh;
-   }
-   if (fh->mode == BDIO_R_MODE )
+static uint32_t head_bits(BDIO *fh)
+{
+   /* HEADER_ENC for records whose payload is not plain data: encoded and
+    * complex records, and the index record, which bdio_seek_record skips
+    * like padding records */
+   return (fh->renc || fh->rcplx || fh->rhide) ? HEADER_ENC : 0;
+}
+
+static size_t raw_write(void *ptr, size_t nb, BDIO *fh)
+{
+   /* appends nb bytes, as they are to be stored in the file, to the current
+    * record. Short records are turned into long records when needed. */
+   size_t nw=0;
+   size_t nr;
+   uint64_t lhdr;
+
+   if (fh->rhash)
+      hash_write(ptr, nb, fh);
+
+   if( !(fh->rlongrec) && (fh->ridx+nb)>(BDIO_MAX_RECORD_LENGTH+4) )
    {
-      if( (fh->fp = fopen(file, "r"))==NULL )
-      {
-         sprintf(errormsg,
-              "Error in bdio_open. Cannot open %s for reading. fopen fails with"
-                                                                         ,file);
-         bdio_error(1,errormsg,fh);
-         free(fh->buf);
-         free(fh);
-         return NULL;
-      }
-      /* initialize some  header fields */
-      fh->hcnt = 0;
-      fh->rcnt = 0;
-      fh->rstart= 0;
-      fh->rlen = 0;
-      fh->ridx = 0;
-      fh->bufstart = 0;
-      fh->bufidx = 0;
-      fh->hcuser = NULL;
-      if( read_header(fh) != 0 )
-      {
-         bdio_error(0,"Error in bdio_open. Could not read header.",fh);
-         free(fh->buf);
-         fclose(fh->fp);
-         free(fh);
-         return NULL;
-      }
-      if( protocol_info != NULL )
+      /* a short record must be turned into a long record */
+      if( fh->ridx==4 )
       {
-         if(strcmp(protocol_info,fh->hpinfo)!=0)
+         /* case 1: No data in the record yet. Enlarge header by 4 bytes */
+         fh->rlongrec = 1;
+         fh->ridx += 4;
+         fh->rlen += 4;
+         if( fh->bufstart==0 )
+            fh->bufidx += 4;
+         else
          {
-            bdio_error(0,"Error in bdio_open. protocol_info does not match"
-                          " first header's.",fh);
-            free(fh->buf);
-            free(fh->hcuser);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            /* this happens if one appends to an empty record */
+            if( fseek(fh->fp, -4, SEEK_CUR) == -1)
+            {
+               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
+            }
+            fh->bufstart = 0;
+            fh->bufidx = 8;
          }
-      }
-      return fh;
-   }
-   if (fh->mode == BDIO_A_MODE )
-   {
-      /* apend mode: open file scroll to the end, update last header.
-       *             if the last entry was a record: fh->state= BDIO_R_STATE
-       *             else fh->state = BDIO_H_STATE
-       */
-      /* initialize some  header fields */
-      fh->hcnt = 0;
-      fh->rcnt = 0;
-      fh->rstart= 0;
-      fh->rlen = 0;
-      fh->ridx = 0;
-      fh->bufstart = 0;
-      fh->bufidx = 0;
-      fh->hcuser = NULL;
-
-      if( (fh->fp = fopen(file, "r+"))==NULL )
+      } else
+      if( fh->bufstart == 0 )
       {
-         if( errno!=ENOENT )
+         if( fh->bufidx < BDIO_BUF_SIZE-4 )
          {
-            sprintf(errormsg,
-              "Error in bdio_open. Cannot open %s in r+ mode. fopen fails with"
-                                                                         ,file);
-            bdio_error(1,errormsg,fh);
-            free(fh->buf);
-            free(fh);
-            return NULL;
+            /* case 2: All data is still buffered. Shift buffer by 4 bytes */
+            memmove(&(fh->buf[8]),&(fh->buf[4]),fh->bufidx-4);
+            fh->rlongrec = 1;
+            fh->bufidx += 4;
+            fh->rlen += 4;
+            fh->ridx += 4;
          }else
          {
-            if( (fh->fp = fopen(file, "w+"))==NULL )
+            /* case 3: All data is still buffered. Shift buffer-start by 4 */
+            /* write a header that is up-to-date after this write */
+            lhdr = HEADER_INT_LONG(head_fmt(fh), fh->ruinfo, fh->ridx+nb+4)
+                 | head_bits(fh) | HEADER_OPEN;
+            if (fh->endian == BDIO_BEND)
+               swap64(&lhdr,8);
+            if( fwrite(&lhdr,1,8,fh->fp) != 8 )
             {
-               sprintf(errormsg,
-                "Error in bdio_open. Cannot open %s in w mode. fopen fails with"
-                                                                         ,file);
-               bdio_error(1,errormsg,fh);
-               free(fh->buf);
-               free(fh);
-               return NULL;
+               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
+            }
+            if( fwrite(&(fh->buf[4]),1,fh->bufidx-4,fh->fp) != (fh->bufidx-4) )
+            {
+               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
             }
+            fh->rlongrec = 1;
+            fh->bufstart = fh->bufidx+4;
+            fh->bufidx = 0;
+            fh->ridx += 4;
+            fh->rlen += 4;
          }
-      }
-      /* read in first 4 bytes to decide whether file is empty or not */
-      wr = fread( fh->buf, 1, 4, fh->fp );
-      if ( wr != 4 )
+      } else
       {
-         if( feof(fh->fp))
+         /* case 3: move record-content in the file by 4 bytes */
+         /* write dummy 4 bytes followed by contents of the buffer */
+         if( fwrite(fh->buf,1,4,fh->fp) != 4 )
          {
-            if( wr!=0 )
+               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
+         }
+         if( fwrite(fh->buf,1,fh->bufidx,fh->fp) != fh->bufidx )
+         {
+               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
+         }
+
+         /* shift blocks of data 4 bytes down */
+         while( BDIO_BUF_SIZE < fh->bufstart )
+         {
+            nr = BDIO_BUF_SIZE;
+            if( (fh->bufstart-nr) < 4 )
+               nr-=4;
+            if( fseek(fh->fp, -(nr+4+fh->bufidx), SEEK_CUR) == -1)
             {
-               bdio_error(0,"Error in bdio_open. Unexpected EOF.",fh);
-               free(fh->buf);
-               fclose(fh->fp);
-               free(fh);
-               return NULL;
+               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
             }
-            /* empty file - start new bdio file */
-            /* write new header */
-            if( protocol_info==NULL )
+            if( fread(fh->buf, 1, nr, fh->fp) != nr )
             {
-               bdio_error(0,"Error in bdio_open. No protocol info supplied."
-                                                                           ,fh);
-               fclose(fh->fp);
-               free(fh->buf);
-               free(fh);
-               return NULL;
+               bdio_error(1, "Error in bdio_write. fread failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
             }
-            if( write_header(fh, protocol_info) != 0 )
+            if( fseek(fh->fp, -nr+4, SEEK_CUR) == -1)
             {
-               fclose(fh->fp);
-               free(fh->buf);
-               free(fh);
-               return NULL;
+               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
             }
-            return fh;
-         }
-         else
-         {
-            bdio_error(1,"Error in bdio_open. fread fails with",fh);
-            free(fh->buf);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            if( fwrite(fh->buf, 1, nr, fh->fp) != nr )
+            {
+               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+               fh->state=BDIO_E_STATE;
+               return 0;
+            }
+            fh->bufstart -= nr;
+            fh->bufidx = nr;
          }
-      }else
-      {
-         /* file is not empty */
-         fh->bufidx = 4;
-         fh->ridx = 4;
-         if( read_header(fh) != 0 )
+         /* shift last block 4 bytes down, write new header */
+         nr = fh->bufstart-4;
+         if( fseek(fh->fp, fh->rstart+4, SEEK_SET) == -1)
          {
-            bdio_error(0,"Error in bdio_open. Could not read header.",fh);
-            free(fh->buf);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-
-         fh->mode = BDIO_R_MODE;
-         last_hcnt = fh->hcnt;
-         while( (fh->state == BDIO_R_STATE) || (fh->state == BDIO_H_STATE) )
+         if( fread(fh->buf, 1, nr, fh->fp) != nr )
          {
-            last_hcnt = fh->hcnt;
-            if( bdio_seek_record(fh)==EOF )
-            if( fh->state == BDIO_E_STATE )
-            {
-               free(fh->hcuser);
-               free(fh->buf);
-               fclose(fh->fp);
-               free(fh);
-               return NULL;
-            }
+            bdio_error(1, "Error in bdio_write. fread failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-         if( protocol_info != NULL)
+         if( fseek(fh->fp, fh->rstart, SEEK_SET) == -1)
          {
-            if(strcmp(protocol_info,fh->hpinfo)!=0)
-            {
-               bdio_error(0,"Error in bdio_open. protocol_info does not match"
-                                                          " last header's.",fh);
-               free(fh->buf);
-               free(fh->hcuser);
-               fclose(fh->fp);
-               free(fh);
-               return NULL;
-            }
+            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-         if( last_hcnt < fh->hcnt )
-            fh->state=BDIO_H_STATE;
-         else
-            fh->state=BDIO_N_STATE;
-
-         /* update last header */
-         fpos=fh->rstart+fh->rlen;
-         if( fseek(fh->fp, fh->hstart, SEEK_SET)!=0 )
+         /* write header that is up-to-date after this write */
+         lhdr = HEADER_INT_LONG(head_fmt(fh), fh->ruinfo, fh->ridx+nb+4)
+                 | head_bits(fh) | HEADER_OPEN;
+         if (fh->endian == BDIO_BEND)
+            swap64(&lhdr,8);
+         if( fwrite(&lhdr,1,8,fh->fp) != 8 )
          {
-            bdio_error(1,"Error in bdio_open. fseek fails with",fh);
-            free(fh->buf);
-            free(fh->hcuser);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-
-         if( update_header(fh) != 0 )
+         if( fwrite(fh->buf, 1, nr, fh->fp) != nr )
          {
-            free(fh->buf);
-            free(fh->hcuser);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-         
-         if( fseek(fh->fp, fpos, SEEK_SET)!=0 )
+         if( fseek(fh->fp, 0, SEEK_END) == -1)
          {
-            bdio_error(1,"Error in bdio_open. fseek fails with",fh);
-            free(fh->buf);
-            free(fh->hcuser);
-            fclose(fh->fp);
-            free(fh);
-            return NULL;
+            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
+            fh->state=BDIO_E_STATE;
+            return 0;
          }
-         fh->mode = BDIO_A_MODE;
-         return fh;
+         fh->rlongrec = 1;
+         fh->ridx    += 4;
+         fh->rlen    += 4;
+         fh->bufidx   = 0;
+         fh->bufstart = fh->ridx;
+      }
+   }
+   nw = buf_write(ptr,nb,fh);
+   return nw;
+}
+
+static int codec_alloc(struct bdio_codec *c, uint32_t block)
+{
+   /* provides the buffers for blocks of up to block bytes */
+   if( c->size < block )
+   {
+      free(c->raw);
+      c->size = 0;
+      c->raw = (unsigned char*) malloc(2*(size_t)block + LZB_BOUND(block));
+      if( c->raw==NULL )
+         return EOF;
+      c->size = block;
+   }
+   c->flt = c->raw+c->size;
+   c->buf = c->flt+c->size;
+   return 0;
+}
+
+static int is_bigend_fmt(int fmt)
+{
+   return (fmt==BDIO_BIN_INT32BE || fmt==BDIO_BIN_INT64BE ||
+           fmt==BDIO_BIN_F32BE   || fmt==BDIO_BIN_F64BE   ||
+           fmt==BDIO_BIN_F16BE   || fmt==BDIO_BIN_BF16BE);
+}
+
+static int is_int_fmt(int fmt)
+{
+   return (fmt==BDIO_BIN_INT32BE || fmt==BDIO_BIN_INT32LE ||
+           fmt==BDIO_BIN_INT64BE || fmt==BDIO_BIN_INT64LE);
+}
+
+static int is_complex_fmt(int fmt)
+{
+   return (fmt==BDIO_BIN_C64BE  || fmt==BDIO_BIN_C64LE  ||
+           fmt==BDIO_BIN_C128BE || fmt==BDIO_BIN_C128LE ||
+           fmt==BDIO_BIN_C64    || fmt==BDIO_BIN_C128);
+}
+
+static int data_start(BDIO *fh)
+{
+   /* offset of the data in the current record, which is not encoded:
+    * complex records start with the method word ENC_COMPLEX|ENC_PLAIN and
+    * their format */
+   return (fh->rlongrec ? 8 : 4) + ((fh->rcplx && !fh->renc) ? 4 : 0);
+}
+
+static int resolve_fmt(int fmt, int endian)
+{
+   /* includes the endianness of the file in formats that do not specify it */
+   if( (fmt==BDIO_BIN_INT32) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_INT32LE;
+   if( (fmt==BDIO_BIN_INT32) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_INT32BE;
+   if( (fmt==BDIO_BIN_INT64) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_INT64LE;
+   if( (fmt==BDIO_BIN_INT64) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_INT64BE;
+   if( (fmt==BDIO_BIN_F32) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_F32LE;
+   if( (fmt==BDIO_BIN_F32) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_F32BE;
+   if( (fmt==BDIO_BIN_F64) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_F64LE;
+   if( (fmt==BDIO_BIN_F64) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_F64BE;
+   if( (fmt==BDIO_BIN_F16) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_F16LE;
+   if( (fmt==BDIO_BIN_F16) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_F16BE;
+   if( (fmt==BDIO_BIN_BF16) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_BF16LE;
+   if( (fmt==BDIO_BIN_BF16) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_BF16BE;
+   if( (fmt==BDIO_BIN_C64) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_C64LE;
+   if( (fmt==BDIO_BIN_C64) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_C64BE;
+   if( (fmt==BDIO_BIN_C128) && (endian==BDIO_LEND))
+      fmt=BDIO_BIN_C128LE;
+   if( (fmt==BDIO_BIN_C128) && (endian==BDIO_BEND))
+      fmt=BDIO_BIN_C128BE;
+   return fmt;
+}
+
+static int enc_block(BDIO *fh)
+{
+   /* stores the block collected by the encoder, filtered and compressed if
+    * this saves space, and returns 0 on success */
+   struct bdio_codec *c = fh->enc;
+   unsigned char fr[8];
+   unsigned char *p = c->raw;
+   int n, ne;
+
+   if( c->esize>0 )
+   {
+      ne = (int) c->fill/c->esize;
+      if( c->method & (BDIO_FILTER_XOR << 8) )
+         SHUF_XorDelta(c->raw, ne, c->esize);
+      if( c->method & (BDIO_FILTER_SHUFFLE << 8) )
+      {
+         /* trailing bytes of an incomplete element are kept as they are */
+         SHUF_Shuffle(c->raw, c->flt, ne, c->esize);
+         memcpy(c->flt+ne*c->esize, c->raw+ne*c->esize, c->fill%c->esize);
+         p = c->flt;
       }
    }
-   return fh;
+   if( (c->method & 0xff)==BDIO_CODEC_NONE )
+      n = 0;
+   else if( (c->method & 0xff)==BDIO_CODEC_PACK )
+      n = IPK_Pack(p, (int) c->fill, c->esize, is_bigend_fmt(fh->rfmt),
+                   c->buf, (int) c->fill-1);
+   else
+      n = LZB_Compress(p, (int) c->fill, c->buf, (int) c->fill-1);
+   if( n>0 )
+      p = c->buf;
+   else
+      n = (int) c->fill;
+   put_uint32(fr, c->fill);
+   put_uint32(fr+4, (uint32_t) n);
+   if( raw_write(fr, 8, fh)!=8 || raw_write(p, n, fh)!=n )
+      return EOF;
+   c->fill = 0;
+   return 0;
+}
+
+static int enc_start(BDIO *fh)
+{
+   /* called by bdio_start_record for records to be encoded. The payload of
+    * an encoded record (little endian) is
+    *
+    *  bytes 0..3   method: codec in bits 0..7, filters in bits 8..15, the
+    *               size of the filtered elements in bits 16..23,
+    *               ENC_COMPLEX for complex numbers and the format of the
+    *               decoded data in bits 28..31
+    *  bytes 4..7   maximal number of bytes per block
+    *  blocks       [uint32 raw length][uint32 stored length][stored bytes]
+    *               the block is compressed unless both lengths are equal
+    *  last 8 bytes length of the decoded payload
+    *
+    * and the format in the record header is BDIO_BIN_GENERIC, see head_fmt.
+    * Filters are applied to each block before it is compressed. */
+   struct bdio_codec *c = fh->enc;
+   unsigned char w[8];
+
+   if( c==NULL )
+   {
+      if( (c = (struct bdio_codec*) calloc(1, sizeof(*c)))==NULL )
+      {
+         bdio_error(1,"Error in bdio_start_record. calloc fails with",fh);
+         return EOF;
+      }
+      fh->enc = c;
+   }
+   if( codec_alloc(c, BDIO_ENC_BLOCK)!=0 )
+   {
+      bdio_error(1,"Error in bdio_start_record. malloc fails with",fh);
+      return EOF;
+   }
+   c->method = (uint32_t) fh->codec;
+   if( fh->codec==BDIO_CODEC_PACK && !is_int_fmt(fh->rfmt) )
+      c->method = BDIO_CODEC_NONE;
+   c->esize  = 0;
+   if( c->method==BDIO_CODEC_PACK )
+   {
+      /* the integers are packed as they are */
+      c->esize   = fh->rdsize;
+      c->method |= (uint32_t) c->esize << 16;
+   }else if( c->method==BDIO_CODEC_LZ && fh->filter!=BDIO_FILTER_NONE &&
+             (fh->rdsize==4 || fh->rdsize==8) )
+   {
+      c->esize   = fh->rdsize;
+      c->method |= ((uint32_t) fh->filter << 8) | ((uint32_t) c->esize << 16);
+   }
+   if( fh->rcplx )
+      c->method |= ENC_COMPLEX;
+   c->method |= (uint32_t) fh->rfmt << ENC_FMT_SHIFT;
+   c->block  = BDIO_ENC_BLOCK;
+   c->fill   = 0;
+   c->llen   = 0;
+   put_uint32(w, c->method);
+   put_uint32(w+4, c->block);
+   if( raw_write(w, 8, fh)!=8 )
+      return EOF;
+   return 0;
+}
+
+static size_t enc_write(void *ptr, size_t nb, BDIO *fh)
+{
+   /* collects data for the encoder, full blocks are stored at once */
+   struct bdio_codec *c = fh->enc;
+   unsigned char *p = (unsigned char*) ptr;
+   size_t n, nw=0;
+
+   while( nw<nb )
+   {
+      n = c->block-c->fill;
+      if( n>nb-nw )
+         n = nb-nw;
+      memcpy(c->raw+c->fill, p+nw, n);
+      c->fill += n;
+      c->llen += n;
+      nw += n;
+      if( c->fill==c->block && enc_block(fh)!=0 )
+         return nw-n;
+   }
+   return nw;
+}
+
+static int enc_finish(BDIO *fh)
+{
+   /* stores the last block and the length of the decoded payload */
+   unsigned char t[8];
+
+   if( fh->enc->fill>0 && enc_block(fh)!=0 )
+      return EOF;
+   put_uint64(t, fh->enc->llen);
+   if( raw_write(t, 8, fh)!=8 )
+      return EOF;
+   return 0;
+}
+
+static uint32_t hash_magic(int type, int mode)
+{
+   switch( type )
+   {
+      case BDIO_HASH_CRC32C: return (mode==BDIO_HASH_CHAIN) ?
+                               BDIO_HASH_MAGIC_CRC32C_C : BDIO_HASH_MAGIC_CRC32C_S;
+      case BDIO_HASH_XXH64:  return (mode==BDIO_HASH_CHAIN) ?
+                               BDIO_HASH_MAGIC_XXH64_C : BDIO_HASH_MAGIC_XXH64_S;
+      default:               return (mode==BDIO_HASH_CHAIN) ?
+                               BDIO_HASH_MAGIC_C : BDIO_HASH_MAGIC_S;
+   }
+}
+
+static int hash_type_of_magic(uint32_t magic)
+{
+   /* returns the hash algorithm belonging to a hash-record magic number
+    * or 0 if magic is not the magic number of a hash record */
+   switch( magic )
+   {
+      case BDIO_HASH_MAGIC_S:
+      case BDIO_HASH_MAGIC_C:        return BDIO_HASH_MD5;
+      case BDIO_HASH_MAGIC_CRC32C_S:
+      case BDIO_HASH_MAGIC_CRC32C_C: return BDIO_HASH_CRC32C;
+      case BDIO_HASH_MAGIC_XXH64_S:
+      case BDIO_HASH_MAGIC_XXH64_C:  return BDIO_HASH_XXH64;
+      default:                       return 0;
+   }
+}
+
+static size_t write_hash_record(const unsigned char digest[16], BDIO *fh)
+{
+   int nb, codec, align;
+   uint32_t magic;
+   unsigned char mbuf[4];
+
+   /* the magic number is stored in little endian byte order. The first
+    * record of a chain is hashed without prefix, as in single mode */
+   magic = hash_magic(fh->hash_type,
+                      fh->hash_first ? BDIO_HASH_SINGL : fh->hash_mode);
+   mbuf[0] = magic & 0xff;
+   mbuf[1] = (magic >> 8) & 0xff;
+   mbuf[2] = (magic >> 16) & 0xff;
+   mbuf[3] = (magic >> 24) & 0xff;
+   
+   fh->hash_auto=BDIO_NO_HASH; /* no hash records of hash records of hash records... */
+   codec = fh->codec;
+   align = fh->align;
+   fh->codec = BDIO_CODEC_NONE;
+   fh->align = 0;
+   bdio_start_record(BDIO_BIN_GENERIC, 7, fh);
+
+   nb  = bdio_write(mbuf, 4, fh);
+   nb += bdio_write((void*) digest, 16, fh);
+
+   
+   bdio_flush_record(fh);
+   fh->codec = codec;
+   fh->align = align;
+   fh->hash_auto=BDIO_AUTO_HASH;
+   fh->hash_first=0;
+
+   return nb;
+}
+
+static size_t write_tree_record(unsigned char root[16], BDIO *fh)
+{
+   /* payload of a tree-hash record (little endian):
+    *
+    *  bytes  0..3   BDIO_HASH_MAGIC_TREE
+    *  bytes  4..19  root: checksum of the list of leaves
+    *  bytes 20..23  hash algorithm
+    *  bytes 24..27  chunk size
+    *  bytes 28..35  length of the record in bytes
+    *  bytes 36..    leaves: 16 byte checksums of the chunks
+    */
+   struct bdio_hash_tree *t = fh->htree;
+   unsigned char h[36];
+   size_t nb;
+   int codec, align;
+
+   put_uint32(h, BDIO_HASH_MAGIC_TREE);
+   memcpy(h+4, root, 16);
+   put_uint32(h+20, (uint32_t) t->type);
+   put_uint32(h+24, t->chunk);
+   put_uint64(h+28, t->len);
+
+   fh->hash_auto=BDIO_NO_HASH;
+   codec = fh->codec;
+   align = fh->align;
+   fh->codec = BDIO_CODEC_NONE;
+   fh->align = 0;
+   bdio_start_record(BDIO_BIN_GENERIC, 7, fh);
+   nb  = bdio_write(h, 36, fh);
+   nb += bdio_write(t->leaves, 16*(size_t) t->nleaves, fh);
+   bdio_flush_record(fh);
+   fh->codec = codec;
+   fh->align = align;
+   fh->hash_auto=BDIO_AUTO_HASH;
+
+   return nb;
+}
+
+static int write_padding(size_t hl, BDIO *fh)
+{
+   /* called by bdio_start_record after the previous record is flushed.
+    * Writes a padding record, so that the data of the next record, after
+    * a header and marker of hl bytes, starts at a multiple of fh->align. A padding
+    * record is a generic, encoded record with uinfo 7, which no encoder
+    * produces, and is skipped by bdio_seek_record. */
+   unsigned char zero[256];
+   uint64_t pos = fh->rstart+fh->rlen;
+   uint32_t hdr;
+   size_t d, n;
+
+   d = (fh->align - (pos+hl)%fh->align) % fh->align;
+   if( d==0 )
+      return 0;
+   if( d<4 )
+      d += fh->align;
+   hdr = HEADER_INT(BDIO_BIN_GENERIC, 7, d) | HEADER_ENC;
+   if (fh->endian == BDIO_BEND)
+      swap32(&hdr,4);
+   if( fwrite(&hdr, 1, 4, fh->fp)!=4 )
+   {
+      bdio_error(1,"Error in bdio_start_record. fwrite fails with",fh);
+      return EOF;
+   }
+   memset(zero, 0, sizeof(zero));
+   for( n=4; n<d; n+=sizeof(zero) )
+      if( fwrite(zero, 1, (d-n<sizeof(zero)) ? d-n : sizeof(zero), fh->fp)
+          != ((d-n<sizeof(zero)) ? d-n : sizeof(zero)) )
+      {
+         bdio_error(1,"Error in bdio_start_record. fwrite fails with",fh);
+         return EOF;
+      }
+   fh->rstart = pos;
+   fh->rlen = d;
+   return 0;
+}
+
+static int bdio_write_hash(const unsigned char *given, BDIO *fh)
+{
+   /* writes the hash record of the record just completed, with the
+    * checksum computed while it was written or, if not NULL, given */
+   int i;
+   unsigned char digest[16];
+
+   if (fh->hash_auto==BDIO_NO_HASH)
+   {
+      bdio_error(1,"Error in bdio_write_hash: HASH_AUTO not set",fh);
+      fh->state=BDIO_E_STATE;
+      return EOF;
+   }
+   
+   if( given!=NULL )
+   {
+      memcpy(fh->prev_digest, given, 16);
+      if( write_hash_record(given, fh)!=20 )
+         return EOF;
+      return 0;
+   }
+
+   hash_drain(fh);
+   if (fh->hash_mode==BDIO_HASH_TREE)
+   {
+      tree_final(fh->htree, digest);
+      if( fh->htree->err )
+      {
+         bdio_error(1,"Error in bdio_write_hash. realloc fails with",fh);
+         return EOF;
+      }
+      memcpy(fh->prev_digest, digest, 16);
+      if( write_tree_record(digest, fh)!=36+16*(size_t) fh->htree->nleaves )
+         return EOF;
+      return 0;
+   }
+
+   hash_final(fh->hash_type,digest,fh->hash);
+   for (i=0;i<16;i++)
+      fh->prev_digest[i] = digest[i];
+
+   if( write_hash_record(digest, fh)!=20 )
+      return EOF;
+   return 0;
+}
+
+static int hash_chain_of_magic(uint32_t magic)
+{
+   return (magic==BDIO_HASH_MAGIC_C) || (magic==BDIO_HASH_MAGIC_CRC32C_C)
+        ||(magic==BDIO_HASH_MAGIC_XXH64_C);
+}
+
+static int peek_hash_record(int *chain, unsigned char digest[16],
+                            unsigned char **tree, uint64_t *tsize,
+                            uint64_t *tlen, BDIO *fh)
+{
+   /* returns the hash algorithm if the item following the current record is
+    * a hash record, and 0 otherwise. The payload of a tree-hash record is
+    * read into *tree (reallocated to *tsize bytes if needed) and its length
+    * stored in *tlen, which is 0 for all other hash records. The file
+    * position is not changed. */
+   unsigned char d[44];
+   uint64_t hdr, len;
+   long fpos;
+   int rd, hl, type=0;
+
+   *tlen = 0;
+   fpos = ftell(fh->fp);
+   if( fseek(fh->fp, fh->rlen-fh->ridx, SEEK_CUR)==-1 )
+   {
+      bdio_error(1,"Error in peek_hash_record. fseek fails with",fh);
+      return 0;
+   }
+   rd = fread(d, 1, 44, fh->fp);
+
+   /* record headers are stored in little endian order */
+   hdr = (rd>=4) ? get_uint32(d) : 0;
+   hl = 4;
+   if( (hdr & 0x8) && (rd>=8) )
+   {
+      hdr = get_uint64(d);
+      hl = 8;
+   }
+   len = hdr >> 12;
+   if( ((hdr & 0x1)==0) || (((hdr & 0xf0)>>4)!=BDIO_BIN_GENERIC)
+                        || (((hdr & 0xf00)>>8)!=7) )
+      len = 0;
+
+   if( (len==20) && (rd>=hl+20) )
+   {
+      if( (type=hash_type_of_magic(get_uint32(d+hl)))!=0 )
+      {
+         *chain = hash_chain_of_magic(get_uint32(d+hl));
+         memcpy(digest, d+hl+4, 16);
+      }
+   }else if( (len>=36) && (rd>=hl+36) && tree_payload_ok(d+hl, len) )
+   {
+      *chain = 0;
+      memcpy(digest, d+hl+4, 16);
+      type = (int) get_uint32(d+hl+20);
+      if( tree!=NULL )
+      {
+         if( *tsize < len )
+         {
+            free(*tree);
+            *tsize = 0;
+            if( (*tree = (unsigned char*) malloc(len))==NULL )
+            {
+               bdio_error(1,"Error in peek_hash_record. malloc fails with",fh);
+               type = 0;
+            }else
+               *tsize = len;
+         }
+         if( type!=0 && (fseek(fh->fp, hl-rd, SEEK_CUR)==-1 ||
+                         fread(*tree, 1, len, fh->fp)!=len) )
+            type = 0;
+         if( type!=0 )
+            *tlen = len;
+      }
+   }
+
+   clearerr(fh->fp);
+   if( fseek(fh->fp, fpos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in peek_hash_record. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
+      return 0;
+   }
+   return type;
+}
+
+static void verify_job(vjob *job)
+{
+   unsigned char digest[16];
+   BDIO_HASH_CTX ctx;
+
+   if( job->tlen>0 )
+   {
+      job->ok = tree_check(job->tree, job->tlen, job->data, job->len);
+      return;
+   }
+   hash_init(job->type, &ctx);
+   if( job->chain )
+      hash_update(job->type, &ctx, job->prefix, 16);
+   hash_update(job->type, &ctx, job->data, job->len);
+   hash_final(job->type, digest, &ctx);
+   job->ok = (memcmp(digest, job->digest, 16)==0);
+}
+
+static void verify_batch(vjob **batch, int n)
+{
+   /* MD5 checksums of the records in batch are computed at once by the
+    * multi-buffer engine, the other algorithms one record at a time */
+   MD5_MB_JOB mb[BDIO_VERIFY_BATCH];
+   unsigned char digest[BDIO_VERIFY_BATCH][16];
+   vjob *md5[BDIO_VERIFY_BATCH];
+   int i, nmd5=0;
+
+   for( i=0; i<n; i++ )
+   {
+      if( (batch[i]->type!=BDIO_HASH_MD5) || (batch[i]->tlen>0) )
+      {
+         verify_job(batch[i]);
+         continue;
+      }
+      mb[nmd5].prefix = batch[i]->prefix;
+      mb[nmd5].plen   = batch[i]->chain ? 16 : 0;
+      mb[nmd5].data   = batch[i]->data;
+      mb[nmd5].size   = batch[i]->len;
+      mb[nmd5].digest = digest[nmd5];
+      md5[nmd5++] = batch[i];
+   }
+   MD5_MB_Hash(mb, nmd5);
+   for( i=0; i<nmd5; i++ )
+      md5[i]->ok = (memcmp(digest[i], md5[i]->digest, 16)==0);
+}
+
+static int take_jobs(vpool *pool, int first, vjob **batch)
+{
+   /* marks up to pool->batch consecutive queued jobs starting at first as
+    * busy and returns their number */
+   vjob *job;
+   int n=0;
+
+   while( n<pool->batch )
+   {
+      job = &(pool->jobs[(first+n) % pool->njobs]);
+      if( job->state!=VJOB_QUEUED )
+         break;
+      job->state = VJOB_BUSY;
+      batch[n++] = job;
+   }
+   return n;
+}
+
+#ifndef _NO_POSIX_LIBS
+static void *verify_thread(void *arg)
+{
+   vpool *pool = (vpool*) arg;
+   vjob *batch[BDIO_VERIFY_BATCH];
+   int i, n;
+
+   pthread_mutex_lock(&(pool->lock));
+   for(;;)
+   {
+      if( (n=take_jobs(pool, pool->take, batch))>0 )
+      {
+         pool->take += n;
+         pthread_mutex_unlock(&(pool->lock));
+         verify_batch(batch, n);
+         pthread_mutex_lock(&(pool->lock));
+         for( i=0; i<n; i++ )
+            batch[i]->state = VJOB_DONE;
+         pthread_cond_broadcast(&(pool->cond));
+      }else if( pool->quit )
+      {
+         break;
+      }else
+      {
+         pthread_cond_wait(&(pool->cond), &(pool->lock));
+      }
+   }
+   pthread_mutex_unlock(&(pool->lock));
+   return NULL;
+}
+#endif
+
+static void wait_job(vpool *pool, int idx, int nthreads)
+{
+   /* wait until job idx is neither queued nor being processed */
+   vjob *batch[BDIO_VERIFY_BATCH];
+   vjob *job = &(pool->jobs[idx % pool->njobs]);
+   int i, n;
+
+#ifndef _NO_POSIX_LIBS
+   if( nthreads>0 )
+   {
+      pthread_mutex_lock(&(pool->lock));
+      while( (job->state==VJOB_QUEUED) || (job->state==VJOB_BUSY) )
+         pthread_cond_wait(&(pool->cond), &(pool->lock));
+      pthread_mutex_unlock(&(pool->lock));
+      return;
+   }
+#endif
+   /* without threads, the queued jobs are processed once the oldest one
+    * is needed */
+   if( job->state==VJOB_QUEUED )
+   {
+      n = take_jobs(pool, idx, batch);
+      verify_batch(batch, n);
+      for( i=0; i<n; i++ )
+         batch[i]->state = VJOB_DONE;
+   }
+}
+
+static void queue_job(vpool *pool, vjob *job, int nthreads)
+{
+#ifndef _NO_POSIX_LIBS
+   if( nthreads>0 )
+   {
+      pthread_mutex_lock(&(pool->lock));
+      job->state = VJOB_QUEUED;
+      pthread_cond_broadcast(&(pool->cond));
+      pthread_mutex_unlock(&(pool->lock));
+      return;
+   }
+#endif
+   job->state = VJOB_QUEUED;
+}
+
+static int reap_job(vjob *job, FILE *report)
+{
+   /* returns 1 if job was a failed verification and 0 otherwise */
+   int bad=0;
+   if( job->state==VJOB_DONE )
+   {
+      if( !job->ok )
+      {
+         bad=1;
+         if( report!=NULL )
+            fprintf(report,"record %i: checksum mismatch\n",job->rcnt);
+      }
+      job->state = VJOB_FREE;
+   }
+   return bad;
+}
+
+static void vread_free(BDIO *fh)
+{
+   if( fh->vread==NULL )
+      return;
+   free(fh->vread->tree.leaves);
+   free(fh->vread->tree.stage);
+   free(fh->vread->tbuf);
+   free(fh->vread);
+   fh->vread = NULL;
+}
+
+static void enc_free(BDIO *fh)
+{
+   if( fh->enc==NULL )
+      return;
+   free(fh->enc->raw);
+   free(fh->enc);
+   fh->enc = NULL;
+}
+
+static void index_free(BDIO *fh)
+{
+   if( fh->index==NULL )
+      return;
+   free(fh->index->e);
+   free(fh->index->pool);
+   free(fh->index->r);
+   free(fh->index);
+   fh->index = NULL;
+}
+
+static void follow_stop(BDIO *fh)
+{
+#if !defined(_NO_POSIX_LIBS) && defined(__linux__)
+   if( fh->follow_fd>=0 )
+      close(fh->follow_fd);
+#endif
+   fh->follow_fd = -1;
+}
+
+static int index_new(BDIO *fh)
+{
+   if( fh->index==NULL &&
+       (fh->index = calloc(1, sizeof(struct bdio_index)))==NULL )
+   {
+      bdio_error(1,"Error in index_new. calloc fails with",fh);
+      return EOF;
+   }
+   return 0;
+}
+
+static int index_add(const char *name, const struct bdio_iname *e, BDIO *fh)
+{
+   /* adds the name of the tag record e, fh->index must exist */
+   struct bdio_index *ix = fh->index;
+   struct bdio_iname *ne;
+   size_t len = strlen(name)+1;
+   char *pool;
+
+   if( ix->n==ix->nmax )
+   {
+      ne = realloc(ix->e, (2*ix->nmax+16)*sizeof(struct bdio_iname));
+      if( ne==NULL )
+      {
+         bdio_error(1,"Error in index_add. realloc fails with",fh);
+         return EOF;
+      }
+      ix->e = ne;
+      ix->nmax = 2*ix->nmax+16;
+   }
+   if( ix->plen+len>ix->psize )
+   {
+      pool = realloc(ix->pool, 2*(ix->plen+len));
+      if( pool==NULL )
+      {
+         bdio_error(1,"Error in index_add. realloc fails with",fh);
+         return EOF;
+      }
+      ix->pool = pool;
+      ix->psize = 2*(ix->plen+len);
+   }
+   memcpy(ix->pool+ix->plen, name, len);
+   ix->e[ix->n] = *e;
+   ix->e[ix->n].pos = ix->plen;
+   ix->plen += len;
+   ix->n++;
+   return 0;
+}
+
+static int index_add_record(const struct bdio_iname *e, BDIO *fh)
+{
+   /* adds record e to the record table, fh->index must exist */
+   struct bdio_index *ix = fh->index;
+   struct bdio_iname *nr;
+
+   if( ix->nr==ix->nrmax )
+   {
+      nr = realloc(ix->r, (2*ix->nrmax+64)*sizeof(struct bdio_iname));
+      if( nr==NULL )
+      {
+         bdio_error(1,"Error in index_add_record. realloc fails with",fh);
+         return EOF;
+      }
+      ix->r = nr;
+      ix->nrmax = 2*ix->nrmax+64;
+   }
+   ix->r[ix->nr++] = *e;
+   return 0;
+}
+
+static int index_record(BDIO *fh)
+{
+   /* called by bdio_start_record, see bdio_index_records */
+   struct bdio_iname e;
+
+   e.off = fh->rstart;
+   e.hoff = fh->hstart;
+   e.rcnt = fh->rcnt;
+   e.hrcnt = fh->hrcnt;
+   e.hcnt = fh->hcnt;
+   e.info = fh->rfmt+16*fh->ruinfo;
+   return index_add_record(&e, fh);
+}
+
+static int cmp_iname(const void *a, const void *b)
+{
+   const struct bdio_iname *x = a, *y = b;
+   int c = strcmp(x->name, y->name);
+
+   if( c!=0 )
+      return c;
+   return (x->off>y->off) - (x->off<y->off);
+}
+
+static void index_sort(struct bdio_index *ix)
+{
+   /* by name, records of the same name in the order of the file */
+   int i;
+
+   for( i=0; i<ix->n; i++ )
+      ix->e[i].name = ix->pool+ix->e[i].pos;
+   qsort(ix->e, ix->n, sizeof(struct bdio_iname), cmp_iname);
+}
+
+static int index_names(const unsigned char *p, uint64_t psize,
+                       uint64_t base, uint32_t n)
+{
+   /* returns 1 if the n names of an index payload of psize bytes follow
+    * the entries, which end at base, and fill the space up to the length
+    * at its end, 0 otherwise */
+   uint64_t i, k=0;
+
+   if( base+12>psize )
+      return 0;
+   for( i=base; i<psize-12; i++ )
+      k += (p[i]=='\0');
+   return (k==n) && (n==0 || p[psize-13]=='\0');
+}
+
+static void get_ientry(const unsigned char *q, uint64_t start,
+                       struct bdio_iname *e)
+{
+   e->off   = start-get_uint64(q);
+   e->hoff  = start-get_uint64(q+8);
+   e->rcnt  = (int) get_uint32(q+16);
+   e->hrcnt = (int) get_uint32(q+20);
+   e->hcnt  = (int) get_uint32(q+24);
+   e->info  = (int) get_uint32(q+28);
+}
+
+static int load_block(uint64_t start, uint64_t len, struct bdio_iname **r,
+                      int *nr, uint64_t *prev, BDIO *fh)
+{
+   /* reads the record table of the table block or index record at offset
+    * start into a new array *r of *nr entries. The payload of a table block
+    * is the magic number, the number of entries k, the distance to the
+    * previous block or index record with a table (0 if there is none), k
+    * entries of BDIO_INDEX_ENTRY bytes for the records written since that
+    * one, the length of the record including its header and the magic
+    * number again. *prev is set to the offset of the previous block. If len
+    * is not 0 the record must be len bytes long. Returns 0, 1 if there is
+    * no such record at start, EOF on failure. */
+   unsigned char t[8], *p, *q;
+   uint64_t hl, psize, base;
+   uint32_t magic, k, n, m, i;
+   int ret=0;
+
+   *r = NULL;
+   *nr = 0;
+   *prev = 0;
+   if( fseek(fh->fp, start, SEEK_SET)==-1 || fread(t, 1, 8, fh->fp)!=8 ||
+       (get_uint32(t) & 0xff5)!=0x701 )
+      return 1;
+   hl = (get_uint32(t) & 0x8) ? 8 : 4;
+   psize = (hl==8) ? (get_uint64(t)>>12) : (get_uint32(t)>>12);
+   if( psize<24 || (len!=0 && psize+hl!=len) )
+      return 1;
+   if( (p = malloc(psize))==NULL )
+   {
+      bdio_error(1,"Error in load_block. malloc fails with",fh);
+      return EOF;
+   }
+   if( fseek(fh->fp, start+hl, SEEK_SET)==-1 ||
+       fread(p, 1, psize, fh->fp)!=psize )
+   {
+      free(p);
+      return 1;
+   }
+   magic = get_uint32(p);
+   if( (magic!=BDIO_TABLE_MAGIC && magic!=BDIO_INDEX_MAGIC) ||
+       get_uint32(p+psize-4)!=magic || get_uint64(p+psize-12)!=psize+hl )
+   {
+      free(p);
+      return 1;
+   }
+   if( magic==BDIO_TABLE_MAGIC )
+   {
+      k = get_uint32(p+4);
+      base = 16;
+      if( psize!=28+BDIO_INDEX_ENTRY*(uint64_t)k || get_uint64(p+8)>start )
+      {
+         free(p);
+         return 1;
+      }
+      if( get_uint64(p+8)>0 )
+         *prev = start-get_uint64(p+8);
+   }else
+   {
+      /* see load_index, its own entry is not in the table */
+      n = get_uint32(p+4);
+      m = get_uint32(p+8);
+      if( !index_names(p, psize, 12+BDIO_INDEX_ENTRY*((uint64_t)n+m), n) )
+         m = 0;
+      k = m;
+      base = 12+BDIO_INDEX_ENTRY*(uint64_t)n;
+   }
+   if( k>0 && (*r = malloc(k*sizeof(struct bdio_iname)))==NULL )
+   {
+      bdio_error(1,"Error in load_block. malloc fails with",fh);
+      free(p);
+      return EOF;
+   }
+   for( i=0; i<k; i++ )
+   {
+      q = p+base+BDIO_INDEX_ENTRY*i;
+      if( get_uint64(q)>start || get_uint64(q+8)>start )
+      {
+         bdio_error(0,"Error in load_block. Corrupt record table.",fh);
+         ret = EOF;
+         break;
+      }
+      get_ientry(q, start, (*r)+i);
+      if( i>0 && (*r)[i].rcnt!=(*r)[i-1].rcnt+1 )
+      {
+         bdio_error(0,"Error in load_block. Corrupt record table.",fh);
+         ret = EOF;
+         break;
+      }
+   }
+   free(p);
+   if( ret!=0 )
+   {
+      free(*r);
+      *r = NULL;
+      return ret;
+   }
+   *nr = (int) k;
+   return 0;
+}
+
+static int load_last_block(long end, BDIO *fh)
+{
+   /* looks for the last table block, or index record with a table, in the
+    * last 2*BDIO_TABLE_BYTES bytes before end and makes its table the
+    * record table of fh. Files of a writer that has not called bdio_close
+    * yet end without index record. The records after the block are not in
+    * the table, ix->walk is set. */
+   struct bdio_index *ix = fh->index;
+   unsigned char *buf;
+   uint64_t len, prev;
+   long lo, hi, stop;
+   uint32_t magic;
+   struct bdio_iname *r;
+   int j, nr, ret=1;
+
+   if( (buf = malloc(BDIO_BUF_SIZE))==NULL )
+   {
+      bdio_error(1,"Error in load_last_block. malloc fails with",fh);
+      return EOF;
+   }
+   stop = (end>2L*BDIO_TABLE_BYTES) ? end-2L*BDIO_TABLE_BYTES : 0;
+   hi = end;
+   while( ret==1 && hi-stop>=12 )
+   {
+      /* consecutive windows overlap by the 11 bytes of a trailer that
+       * does not fit */
+      lo = (hi-stop>BDIO_BUF_SIZE) ? hi-BDIO_BUF_SIZE : stop;
+      if( fseek(fh->fp, lo, SEEK_SET)==-1 ||
+          fread(buf, 1, hi-lo, fh->fp)!=(size_t) (hi-lo) )
+      {
+         bdio_error(1,"Error in load_last_block. fread fails with",fh);
+         ret = EOF;
+         break;
+      }
+      for( j=(int) (hi-lo)-4; ret==1 && j>=8; j-- )
+      {
+         magic = get_uint32(buf+j);
+         if( magic!=BDIO_TABLE_MAGIC && magic!=BDIO_INDEX_MAGIC )
+            continue;
+         len = get_uint64(buf+j-8);
+         if( len<28 || len>(uint64_t) (lo+j+4) )
+            continue;
+         ret = load_block(lo+j+4-len, len, &r, &nr, &prev, fh);
+         if( ret==0 && nr==0 )
+            ret = 1;
+         if( ret==0 )
+         {
+            free(ix->r);
+            ix->r = r;
+            ix->nr = nr;
+            ix->nrmax = nr;
+            ix->blk = lo+j+4-len;
+            ix->prev = prev;
+            ix->walk = 1;
+         }
+      }
+      hi = lo+11;
+      if( lo==stop )
+         break;
+   }
+   free(buf);
+   return (ret==EOF) ? EOF : 0;
+}
+
+static int load_index(int blocks, BDIO *fh)
+{
+   /* reads the index record at the end of the file, if there is one. Its
+    * payload is the magic number, the number of names n, the number of
+    * records m, n+m entries of BDIO_INDEX_ENTRY bytes, the 0-terminated
+    * names, the length of the record including its header and the magic
+    * number again. Offsets are stored as distances to the index record.
+    * Index records without record table may lack m, their entries start
+    * at byte 8. Without index record the table of the last table block is
+    * read if blocks is 1, see load_last_block. */
+   unsigned char t[12], *p=NULL, *q;
+   struct bdio_iname e;
+   long fpos, end;
+   uint64_t len, hl, start, psize, npos, base;
+   uint32_t n, m, i;
+   int ret=0, found=0;
+
+   if( index_new(fh)!=0 )
+      return EOF;
+   fh->index->loaded = 1;
+   fh->index->rcnt = fh->rcnt;
+   if( (fpos = ftell(fh->fp))==-1 || fseek(fh->fp, 0, SEEK_END)==-1 ||
+       (end = ftell(fh->fp))==-1 )
+   {
+      bdio_error(1,"Error in load_index. fseek fails with",fh);
+      return EOF;
+   }
+   if( end<12 || fseek(fh->fp, end-12, SEEK_SET)==-1 ||
+       fread(t, 1, 12, fh->fp)!=12 || get_uint32(t+8)!=BDIO_INDEX_MAGIC )
+      goto done;
+   len = get_uint64(t);
+   if( len<24 || len>(uint64_t) end ||
+       fseek(fh->fp, end-len, SEEK_SET)==-1 || fread(t, 1, 8, fh->fp)!=8 )
+      goto done;
+   start = end-len;
+   hl = (get_uint32(t) & 0x8) ? 8 : 4;
+   if( (get_uint32(t) & 0xff5)!=0x701 ||
+       ((hl==8) ? (get_uint64(t)>>12)+8 : (get_uint32(t)>>12)+4)!=len )
+      goto done;
+   psize = len-hl;
+   if( (p = malloc(psize))==NULL )
+   {
+      bdio_error(1,"Error in load_index. malloc fails with",fh);
+      ret = EOF;
+      goto done;
+   }
+   if( fseek(fh->fp, start+hl, SEEK_SET)==-1 ||
+       fread(p, 1, psize, fh->fp)!=psize )
+   {
+      bdio_error(1,"Error in load_index. fread fails with",fh);
+      ret = EOF;
+      goto done;
+   }
+   if( get_uint32(p)!=BDIO_INDEX_MAGIC )
+      goto done;
+   n = get_uint32(p+4);
+   m = get_uint32(p+8);
+   base = 12;
+   if( !index_names(p, psize, 12+BDIO_INDEX_ENTRY*((uint64_t)n+m), n) )
+   {
+      m = 0;
+      base = 8;
+      if( !index_names(p, psize, 8+BDIO_INDEX_ENTRY*(uint64_t)n, n) )
+         goto done;
+   }
+   for( i=0; i<n+m; i++ )
+   {
+      q = p+base+BDIO_INDEX_ENTRY*i;
+      npos = base+BDIO_INDEX_ENTRY*((uint64_t)n+m)+get_uint32(q+28);
+      if( (i<n && npos>=psize-12) || get_uint64(q)>start ||
+          get_uint64(q+8)>start )
+      {
+         bdio_error(0,"Error in load_index. Corrupt index record.",fh);
+         ret = EOF;
+         break;
+      }
+      get_ientry(q, start, &e);
+      if( (i<n) ? index_add((char*) p+npos, &e, fh)!=0 :
+                  index_add_record(&e, fh)!=0 )
+      {
+         ret = EOF;
+         break;
+      }
+   }
+   index_sort(fh->index);
+   /* files with a record table keep it when appended to, the next table
+    * block continues from this record */
+   fh->index->records = (m>0);
+   fh->index->nblk = fh->index->nr;
+   if( m>0 )
+      fh->index->blk = start;
+   found = 1;
+
+done:
+   free(p);
+   if( ret==0 && !found && blocks )
+      ret = load_last_block(end, fh);
+   if( fseek(fh->fp, fpos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in load_index. fseek fails with",fh);
+      ret = EOF;
+   }
+   return ret;
+}
+
+static void put_ientry(unsigned char *q, uint64_t start,
+                       const struct bdio_iname *e, uint32_t last)
+{
+   put_uint64(q, start-e->off);
+   put_uint64(q+8, start-e->hoff);
+   put_uint32(q+16, (uint32_t) e->rcnt);
+   put_uint32(q+20, (uint32_t) e->hrcnt);
+   put_uint32(q+24, (uint32_t) e->hcnt);
+   put_uint32(q+28, last);
+}
+
+static int write_index(BDIO *fh)
+{
+   /* appends the index record at bdio_close, see load_index */
+   struct bdio_index *ix = fh->index;
+   unsigned char *p, *q;
+   uint64_t psize, npos, hl;
+   int i, m, hash_auto, ret=0;
+
+   if( ix==NULL || (ix->n==0 && ix->nr==0) ||
+       (!ix->dirty && ix->rcnt==fh->rcnt) )
+      return 0;
+   index_sort(ix);
+   /* the index record holds the table in full, so that no table block is
+    * written before it */
+   m = ix->nr;
+   ix->nblk = m;
+   psize = 12+BDIO_INDEX_ENTRY*((uint64_t)ix->n+m)+12;
+   for( i=0; i<ix->n; i++ )
+      psize += strlen(ix->e[i].name)+1;
+   if( (p = malloc(psize))==NULL )
+   {
+      bdio_error(1,"Error in write_index. malloc fails with",fh);
+      return EOF;
+   }
+
+   /* the index record is found from the end of the file and hidden from
+    * bdio_seek_record, it gets no checksum record after it */
+   hash_auto = fh->hash_auto;
+   fh->hash_auto = BDIO_NO_HASH;
+   fh->rhide = 1;
+   if( bdio_start_record(BDIO_BIN_GENERIC, 7, fh)!=0 )
+      ret = EOF;
+   else
+   {
+      hl = (fh->rlongrec || psize>BDIO_MAX_RECORD_LENGTH) ? 8 : 4;
+      put_uint32(p, BDIO_INDEX_MAGIC);
+      put_uint32(p+4, (uint32_t) ix->n);
+      put_uint32(p+8, (uint32_t) m);
+      q = p+12;
+      npos = 0;
+      for( i=0; i<ix->n; i++, q+=BDIO_INDEX_ENTRY )
+      {
+         put_ientry(q, fh->rstart, ix->e+i, (uint32_t) npos);
+         strcpy((char*) p+12+BDIO_INDEX_ENTRY*(ix->n+m)+npos, ix->e[i].name);
+         npos += strlen(ix->e[i].name)+1;
+      }
+      for( i=0; i<m; i++, q+=BDIO_INDEX_ENTRY )
+         put_ientry(q, fh->rstart, ix->r+i, (uint32_t) ix->r[i].info);
+      put_uint64(p+psize-12, psize+hl);
+      put_uint32(p+psize-4, BDIO_INDEX_MAGIC);
+      if( bdio_write(p, psize, fh)!=psize || bdio_flush_record(fh)!=0 )
+         ret = EOF;
+   }
+   fh->rhide = 0;
+   fh->hash_auto = hash_auto;
+   free(p);
+   return ret;
+}
+
+static int write_table(BDIO *fh)
+{
+   /* writes a table block with the records entered in the record table
+    * since the last one, see load_block. Called by bdio_start_record. Like
+    * the index record, the block is hidden from bdio_seek_record and not
+    * in the table itself. */
+   struct bdio_index *ix = fh->index;
+   unsigned char *p, *q;
+   uint64_t psize, hl;
+   int i, k, hash_auto, ret=0;
+
+   k = ix->nr-ix->nblk;
+   psize = 16+BDIO_INDEX_ENTRY*(uint64_t)k+12;
+   if( (p = malloc(psize))==NULL )
+   {
+      bdio_error(1,"Error in write_table. malloc fails with",fh);
+      return EOF;
+   }
+   ix->nblk = ix->nr;
+
+   hash_auto = fh->hash_auto;
+   fh->hash_auto = BDIO_NO_HASH;
+   fh->rhide = 1;
+   if( bdio_start_record(BDIO_BIN_GENERIC, 7, fh)!=0 )
+      ret = EOF;
+   else
+   {
+      hl = (fh->rlongrec || psize>BDIO_MAX_RECORD_LENGTH) ? 8 : 4;
+      put_uint32(p, BDIO_TABLE_MAGIC);
+      put_uint32(p+4, (uint32_t) k);
+      put_uint64(p+8, (ix->blk>0) ? fh->rstart-ix->blk : 0);
+      q = p+16;
+      for( i=ix->nr-k; i<ix->nr; i++, q+=BDIO_INDEX_ENTRY )
+         put_ientry(q, fh->rstart, ix->r+i, (uint32_t) ix->r[i].info);
+      put_uint64(p+psize-12, psize+hl);
+      put_uint32(p+psize-4, BDIO_TABLE_MAGIC);
+      ix->blk = fh->rstart;
+      if( bdio_write(p, psize, fh)!=psize || bdio_flush_record(fh)!=0 )
+         ret = EOF;
+   }
+   fh->rhide = 0;
+   fh->hash_auto = hash_auto;
+   free(p);
+   return ret;
+}
+
+static void vread_seek(BDIO *fh)
+{
+   /* called by bdio_seek_record whenever it lands on a record: completes
+    * the check of the previous record and prepares the one of this */
+   struct bdio_vread *vr = fh->vread;
+   unsigned char digest[16];
+   char msg[80];
+   uint64_t tlen;
+   int ok;
+
+   if( vr->type!=0 && vr->rcnt==fh->rcnt-1 && vr->len==vr->rlen )
+   {
+      if( vr->intree )
+      {
+         tree_final(&(vr->tree), digest);
+         ok = !vr->tree.err && (memcmp(digest, vr->digest, 16)==0);
+      }else
+      {
+         hash_final(vr->type, digest, &(vr->ctx));
+         ok = (memcmp(digest, vr->digest, 16)==0);
+      }
+      if( !ok )
+      {
+         sprintf(msg, "Error in bdio_seek_record. Checksum mismatch in "
+                      "record %i.", vr->rcnt);
+         bdio_error(0, msg, fh);
+      }
+   }
+   vr->type = 0;
+
+   /* chains do not continue across headers */
+   if( fh->rcnt==fh->hrcnt+1 )
+   {
+      memset(vr->last, 0, 16);
+      vr->lost = 0;
+   }
+   if( bdio_is_hash_record(digest, fh) )
+   {
+      /* in chain mode the next checksum starts with this one */
+      memcpy(vr->last, digest, 16);
+      vr->lost = 0;
+      return;
+   }
+   vr->type = peek_hash_record(&(vr->chain), vr->digest, &(vr->tbuf),
+                               &(vr->tsize), &tlen, fh);
+   if( vr->chain && vr->lost )
+      vr->type = 0;
+   if( vr->type==0 )
+      return;
+   vr->rcnt = fh->rcnt;
+   vr->len  = 0;
+   vr->rlen = fh->rlen-fh->ridx;
+   vr->intree = (tlen>0);
+   if( vr->intree )
+   {
+      vr->tree.chunk = get_uint32(vr->tbuf+24);
+      tree_start(&(vr->tree), vr->type);
+      return;
+   }
+   hash_init(vr->type, &(vr->ctx));
+   if( vr->chain )
+      hash_update(vr->type, &(vr->ctx), vr->last, 16);
+}
+
+static void vread_update(void *buf, size_t nb, BDIO *fh)
+{
+   /* called by bdio_read before fh->ridx is advanced by nb */
+   struct bdio_vread *vr = fh->vread;
+
+   if( vr->type==0 || vr->rcnt!=fh->rcnt )
+      return;
+   if( fh->ridx-(fh->rlongrec ? 8 : 4) != vr->len )
+   {
+      /* not read sequentially */
+      vr->type = 0;
+      return;
+   }
+   if( vr->intree )
+      tree_update(&(vr->tree), (const unsigned char*) buf, nb);
+   else
+      hash_update(vr->type, &(vr->ctx), buf, nb);
+   vr->len += nb;
+}
+
+static size_t raw_read(void *buf, size_t nb, BDIO *fh)
+{
+   /* reads nb bytes of the current record as they are stored in the file */
+   size_t rd;
+
+   rd =  fread(buf, 1, nb, fh->fp);
+   if( rd<nb )
+   {
+      if ( feof( fh->fp ) )
+         bdio_error(0, "Error in bdio_read. Unexpected EOF.",fh);
+      else
+         bdio_error(1, "Error in bdio_read. fread fails with",fh);
+      /*TODO set error state? */
+   }
+   if( fh->vread!=NULL )
+      vread_update(buf, rd, fh);
+   /* update fh */
+   fh->ridx += rd;
+   return( rd );
+}
+
+static int dec_seek(BDIO *fh)
+{
+   /* called by bdio_seek_record for encoded records: reads the length of
+    * the decoded payload from the end of the record, and whether it holds
+    * complex numbers from its start */
+   struct bdio_codec *c = fh->enc;
+   unsigned char t[8], m[4];
+   long fpos;
+   int rd;
+
+   if( c==NULL )
+   {
+      if( (c = (struct bdio_codec*) calloc(1, sizeof(*c)))==NULL )
+      {
+         bdio_error(1,"Error in bdio_seek_record. calloc fails with",fh);
+         return EOF;
+      }
+      fh->enc = c;
+   }
+   if( fh->rlen-fh->ridx < 4 )
+   {
+      bdio_error(0,"Error in bdio_seek_record. Encoded record too short.",fh);
+      return EOF;
+   }
+   fpos = ftell(fh->fp);
+   if( fread(m, 1, 4, fh->fp)!=4 || fseek(fh->fp, fpos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in bdio_seek_record. Reading fails with",fh);
+      return EOF;
+   }
+   if( (get_uint32(m) & ~(0xfU << ENC_FMT_SHIFT))==(ENC_COMPLEX|ENC_PLAIN) )
+   {
+      /* complex numbers follow the method word as they are */
+      fh->renc  = 0;
+      fh->rcplx = 1;
+      return (raw_read(m, 4, fh)==4) ? 0 : EOF;
+   }
+   if( fh->rlen-fh->ridx < 16 )
+   {
+      bdio_error(0,"Error in bdio_seek_record. Encoded record too short.",fh);
+      return EOF;
+   }
+   if( fseek(fh->fp, fh->rlen-fh->ridx-8, SEEK_CUR)==-1 )
+   {
+      bdio_error(1,"Error in bdio_seek_record. fseek fails with",fh);
+      return EOF;
+   }
+   rd = fread(t, 1, 8, fh->fp);
+   if( fseek(fh->fp, fpos, SEEK_SET)==-1 || rd!=8 )
+   {
+      bdio_error(1,"Error in bdio_seek_record. Reading fails with",fh);
+      return EOF;
+   }
+   c->llen = get_uint64(t);
+   fh->rcplx = (get_uint32(m) & ENC_COMPLEX) ? 1 : 0;
+   c->lidx = 0;
+   c->fill = 0;
+   c->pos  = 0;
+   c->method = 0;
+   return 0;
+}
+
+static int dec_block(BDIO *fh)
+{
+   /* reads the method of the record if not done yet, and the next block */
+   struct bdio_codec *c = fh->enc;
+   unsigned char fr[8];
+   uint32_t n, m, f;
+   unsigned char *p, *q;
+
+   if( c->method==0 )
+   {
+      if( raw_read(fr, 8, fh)!=8 )
+         return EOF;
+      c->method = get_uint32(fr);
+      c->block  = get_uint32(fr+4);
+      c->esize  = (int) ((c->method >> 16) & 0xff);
+      f = (c->method >> 8) & 0xff;
+      if( ((c->method >> 25) & 0x7)!=0 ||
+          (int) (c->method >> ENC_FMT_SHIFT)!=fh->rfmt ||
+          (f & ~(uint32_t) (BDIO_FILTER_SHUFFLE|BDIO_FILTER_XOR))!=0 ||
+          ((c->method & 0xff)==BDIO_CODEC_LZ &&
+           ((f!=0 && c->esize!=4 && c->esize!=8) || (f==0 && c->esize!=0))) ||
+          ((c->method & 0xff)==BDIO_CODEC_PACK &&
+           (f!=0 || c->esize!=fh->rdsize || !is_int_fmt(fh->rfmt))) ||
+          ((c->method & 0xff)==BDIO_CODEC_NONE && (f!=0 || c->esize!=0)) ||
+          ((c->method & 0xff)!=BDIO_CODEC_LZ &&
+           (c->method & 0xff)!=BDIO_CODEC_PACK &&
+           (c->method & 0xff)!=BDIO_CODEC_NONE) ||
+          c->block==0 || c->block>BDIO_ENC_MAX_BLOCK )
+      {
+         bdio_error(0,"Error in bdio_read. Unknown record encoding.",fh);
+         c->method = 0;
+         return EOF;
+      }
+      if( codec_alloc(c, c->block)!=0 )
+      {
+         bdio_error(1,"Error in bdio_read. malloc fails with",fh);
+         c->method = 0;
+         return EOF;
+      }
+   }
+   if( raw_read(fr, 8, fh)!=8 )
+      return EOF;
+   n = get_uint32(fr);
+   m = get_uint32(fr+4);
+   if( n==0 || n>c->block || m>n || m > fh->rlen-fh->ridx-8 ||
+       (m<n && (c->method & 0xff)==BDIO_CODEC_NONE) )
+   {
+      bdio_error(0,"Error in bdio_read. Corrupted encoded record.",fh);
+      return EOF;
+   }
+   /* q receives the block as it was before compression */
+   q = (c->method & (BDIO_FILTER_SHUFFLE << 8)) ? c->flt : c->raw;
+   p = (m==n) ? q : c->buf;
+   if( raw_read(p, m, fh)!=m )
+      return EOF;
+   if( m<n && (c->method & 0xff)==BDIO_CODEC_PACK )
+   {
+      if( IPK_Unpack(c->buf, (int) m, q, (int) n, c->esize,
+                     is_bigend_fmt(fh->rfmt))!=0 )
+      {
+         bdio_error(0,"Error in bdio_read. Corrupted encoded record.",fh);
+         return EOF;
+      }
+   }else if( m<n && LZB_Decompress(c->buf, (int) m, q, (int) n)!=(int) n )
+   {
+      bdio_error(0,"Error in bdio_read. Corrupted encoded record.",fh);
+      return EOF;
+   }
+   if( q==c->flt )
+   {
+      SHUF_Unshuffle(c->flt, c->raw, (int) n/c->esize, c->esize);
+      memcpy(c->raw+n-n%c->esize, c->flt+n-n%c->esize, n%c->esize);
+   }
+   if( c->method & (BDIO_FILTER_XOR << 8) )
+      SHUF_XorUndelta(c->raw, (int) n/c->esize, c->esize);
+   c->fill = n;
+   c->pos  = 0;
+   return 0;
+}
+
+static size_t dec_read(void *buf, size_t nb, BDIO *fh)
+{
+   /* returns decoded data of the current record */
+   struct bdio_codec *c = fh->enc;
+   unsigned char *p = (unsigned char*) buf;
+   unsigned char t[8];
+   size_t n, rd=0;
+
+   while( rd<nb )
+   {
+      if( c->pos==c->fill && dec_block(fh)!=0 )
+         break;
+      n = c->fill-c->pos;
+      if( n>nb-rd )
+         n = nb-rd;
+      memcpy(p+rd, c->raw+c->pos, n);
+      c->pos += n;
+      rd += n;
+   }
+   c->lidx += rd;
+   /* the trailer is read as well, so checksums see the whole record */
+   if( c->lidx==c->llen && fh->rlen-fh->ridx==8 )
+      raw_read(t, 8, fh);
+   return rd;
+}
+
+static int dec_move(uint64_t to, BDIO *fh)
+{
+   /* positions the decoder at the decoded offset to. Blocks before it are
+    * skipped without decoding them, using their stored lengths. */
+   struct bdio_codec *c = fh->enc;
+   unsigned char fr[8];
+   uint64_t base;
+   uint32_t n, m;
+   int hl = fh->rlongrec ? 8 : 4;
+
+   if( to < c->lidx-c->pos )
+   {
+      /* behind the current block: start over */
+      if( fseek(fh->fp, (long) (fh->rstart+hl), SEEK_SET)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_in_record. fseek fails with",fh);
+         return EOF;
+      }
+      fh->ridx = hl;
+      c->method = 0;
+      c->fill = c->pos = 0;
+      c->lidx = 0;
+   }
+   if( c->method==0 )
+   {
+      if( to==0 )
+         return 0;
+      if( dec_block(fh)!=0 )
+         return EOF;
+   }
+   base = c->lidx-c->pos;
+   if( to < base+c->fill )
+   {
+      c->pos  = (uint32_t) (to-base);
+      c->lidx = to;
+      return 0;
+   }
+   base += c->fill;
+   while( fh->rlen-fh->ridx > 8 )
+   {
+      if( raw_read(fr, 8, fh)!=8 )
+         return EOF;
+      n = get_uint32(fr);
+      m = get_uint32(fr+4);
+      if( n==0 || n>c->block || m>n || m > fh->rlen-fh->ridx-8 )
+      {
+         bdio_error(0,"Error in bdio_seek_in_record. Corrupted encoded "
+                      "record.",fh);
+         return EOF;
+      }
+      if( to < base+n )
+      {
+         if( fseek(fh->fp, -8, SEEK_CUR)==-1 )
+         {
+            bdio_error(1,"Error in bdio_seek_in_record. fseek fails with",
+                       fh);
+            return EOF;
+         }
+         fh->ridx -= 8;
+         if( dec_block(fh)!=0 )
+            return EOF;
+         c->pos  = (uint32_t) (to-base);
+         c->lidx = to;
+         return 0;
+      }
+      if( fseek(fh->fp, (long) m, SEEK_CUR)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_in_record. fseek fails with",fh);
+         return EOF;
+      }
+      fh->ridx += m;
+      base += n;
+   }
+   /* at the end of the decoded payload */
+   c->fill = c->pos = 0;
+   c->lidx = to;
+   return 0;
+}
+
+/******************************************************************************/
+/* public functions                                                           */
+/******************************************************************************/
+
+void bdio_hash_auto(BDIO *fh)
+{
+   fh->hash_auto = BDIO_AUTO_HASH;
+   fh->hash_mode = BDIO_HASH_SINGL;
+   if( fh->hash==NULL && (fh->hash = malloc(sizeof(BDIO_HASH_CTX)))==NULL )
+   {
+      fh->state=BDIO_E_STATE;
+      bdio_error(1,"Error in bdio_hash_auto. Out of memory",fh);
+      return;
+   }
+   hash_pipe_start(fh);
+}
+
+
+void bdio_hash_chain(BDIO *fh)
+{
+   int i;
+  
+   if (!fh->hash_auto)
+      bdio_error(0,"Error in bdio_hash_chain. BDIO_HASH_AUTO no set (maybe call bdio_hash_auto first?)",fh);
+
+   /* a record that is still open is completed first */
+   if( fh->state==BDIO_R_STATE &&
+       (fh->mode==BDIO_W_MODE || fh->mode==BDIO_A_MODE) &&
+       bdio_flush_record(fh)!=0 )
+      return;
+   fh->hash_mode = BDIO_HASH_CHAIN;
+   fh->hash_first = 1;
+   for (i=0;i<16;i++)
+   {
+      fh->prev_digest[i] = (unsigned char)0;
+   }
+}
+
+
+int bdio_hash_type(int type, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_hash_type", fh) )
+   {
+      return EOF;
+   }
+   if( (type!=BDIO_HASH_MD5) && (type!=BDIO_HASH_CRC32C) &&
+       (type!=BDIO_HASH_XXH64) )
+   {
+      bdio_error(0,"Error in bdio_hash_type. Unknown hash algorithm.",fh);
+      return EOF;
+   }
+   fh->hash_type = type;
+   return 0;
+}
+
+
+int bdio_is_hash_record(unsigned char digest[16], BDIO *fh)
+{
+   unsigned char d[36];
+   int rb, type=0;
+   uint64_t rlen;
+   long fpos;
+   
+   if( fh->renc )
+      return 0;
+   rlen = bdio_get_rlen(fh);
+   if( (rlen!=20) && (rlen==(uint64_t) EOF || rlen<36 ||
+                      fh->rfmt!=BDIO_BIN_GENERIC || fh->ruinfo!=7) )
+      return 0;
+
+   fpos = ftell(fh->fp);
+   rb = fread(d,1,(rlen==20) ? 20 : 36,fh->fp);
+   fseek(fh->fp,fpos,SEEK_SET);
+
+   /* magic numbers are stored in little endian order */
+   if( rlen==20 && rb==20 )
+      type = hash_type_of_magic(get_uint32(d));
+   else if( rb==36 && tree_payload_ok(d, rlen) )
+      type = (int) get_uint32(d+20);
+   if( type!=0 )
+      memcpy(digest,d+4,16);
+   return type;
+}
+
+
+int bdio_hash_tree(int chunk, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_hash_tree", fh) )
+   {
+      return EOF;
+   }
+   if( !fh->hash_auto )
+   {
+      bdio_error(0,"Error in bdio_hash_tree. BDIO_HASH_AUTO not set (maybe call bdio_hash_auto first?)",fh);
+      return EOF;
+   }
+   if( chunk<0 )
+   {
+      bdio_error(0,"Error in bdio_hash_tree. Negative chunk size.",fh);
+      return EOF;
+   }
+   if( fh->htree==NULL &&
+       (fh->htree = calloc(1, sizeof(struct bdio_hash_tree)))==NULL )
+   {
+      bdio_error(1,"Error in bdio_hash_tree. calloc fails with",fh);
+      return EOF;
+   }
+   /* a record started in another mode is completed first */
+   if( fh->hash_mode!=BDIO_HASH_TREE && fh->state==BDIO_R_STATE &&
+       (fh->mode==BDIO_W_MODE || fh->mode==BDIO_A_MODE) &&
+       bdio_flush_record(fh)!=0 )
+      return EOF;
+   fh->htree->chunk = (chunk==0) ? BDIO_HASH_TREE_CHUNK : (uint32_t) chunk;
+   fh->hash_mode = BDIO_HASH_TREE;
+   return 0;
+}
+
+
+int bdio_set_codec(int codec, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_codec", fh) )
+   {
+      return EOF;
+   }
+   if( (codec!=BDIO_CODEC_NONE) && (codec!=BDIO_CODEC_LZ) &&
+       (codec!=BDIO_CODEC_PACK) )
+   {
+      bdio_error(0,"Error in bdio_set_codec. Unknown codec.",fh);
+      return EOF;
+   }
+   fh->codec = codec;
+   return 0;
+}
+
+
+int bdio_set_alignment(int align, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_alignment", fh) )
+   {
+      return EOF;
+   }
+   if( align!=0 && (align<8 || align>65536 || (align & (align-1))!=0) )
+   {
+      bdio_error(0,"Error in bdio_set_alignment. align must be 0 or a power "
+                   "of 2 between 8 and 65536.",fh);
+      return EOF;
+   }
+   fh->align = align;
+   return 0;
+}
+
+
+int bdio_index_records(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_index_records", fh) )
+   {
+      return EOF;
+   }
+   if( (fh->mode != BDIO_W_MODE) && (fh->mode != BDIO_A_MODE) )
+   {
+      bdio_error(0,"Error in bdio_index_records. Not in write or append "
+                   "mode.",fh);
+      return EOF;
+   }
+   if( index_new(fh)!=0 )
+      return EOF;
+   fh->index->records = 1;
+   return 0;
+}
+
+
+int bdio_set_filter(int filter, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_filter", fh) )
+   {
+      return EOF;
+   }
+   if( (filter & ~(BDIO_FILTER_SHUFFLE|BDIO_FILTER_XOR))!=0 )
+   {
+      bdio_error(0,"Error in bdio_set_filter. Unknown filter.",fh);
+      return EOF;
+   }
+   fh->filter = filter;
+   return 0;
+}
+
+
+int bdio_verify(int nthreads, FILE *report, BDIO *fh)
+{
+   vpool pool;
+   vjob *job;
+   int i, hl, type, chain, nbad=0, nrec=0, ret=0;
+   unsigned char chain_digest[16];
+   unsigned char digest[16];
+   unsigned char *tree=NULL, *tswap;
+   uint64_t tsize=0, tlen;
+#ifndef _NO_POSIX_LIBS
+   pthread_t *threads=NULL;
+#endif
+
+   if( !is_valid_bdio("bdio_verify", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_verify. Not in read mode.",fh);
+      return EOF;
+   }
+
+#ifdef _NO_POSIX_LIBS
+   nthreads=0;
+#else
+   if( nthreads<=1 )
+      nthreads=0;
+#endif
+
+   /* with threads, the records are read by the calling thread and hashed by
+    * the pool, each thread taking up to BDIO_VERIFY_DEPTH records at once.
+    * Without, one batch per multi-buffer MD5 width is read and hashed. */
+   if( nthreads>0 )
+   {
+      pool.njobs = BDIO_VERIFY_DEPTH*nthreads;
+      pool.batch = BDIO_VERIFY_DEPTH;
+   }else
+   {
+      pool.njobs = MD5_MB_Lanes();
+      if( pool.njobs>BDIO_VERIFY_BATCH )
+         pool.njobs = BDIO_VERIFY_BATCH;
+      pool.batch = pool.njobs;
+   }
+   pool.take = 0;
+   pool.quit = 0;
+   pool.jobs = (vjob*) calloc(pool.njobs, sizeof(vjob));
+   if( pool.jobs==NULL )
+   {
+      bdio_error(1,"Error in bdio_verify. calloc fails with",fh);
+      return EOF;
+   }
+   memset(chain_digest, 0, 16);
+
+#ifndef _NO_POSIX_LIBS
+   if( nthreads>0 )
+   {
+      threads = (pthread_t*) malloc(nthreads*sizeof(pthread_t));
+      if( threads==NULL )
+      {
+         bdio_error(1,"Error in bdio_verify. malloc fails with",fh);
+         free(pool.jobs);
+         return EOF;
+      }
+      pthread_mutex_init(&(pool.lock), NULL);
+      pthread_cond_init(&(pool.cond), NULL);
+      for( i=0; i<nthreads; i++ )
+      {
+         if( pthread_create(&(threads[i]), NULL, verify_thread, &pool)!=0 )
+         {
+            bdio_error(0,"Error in bdio_verify. pthread_create fails.",fh);
+            break;
+         }
+      }
+      if( i==0 )
+      {
+         pthread_mutex_destroy(&(pool.lock));
+         pthread_cond_destroy(&(pool.cond));
+         free(threads);
+         threads=NULL;
+         nthreads=0;
+         pool.batch = (pool.njobs<BDIO_VERIFY_BATCH) ?
+                      pool.njobs : BDIO_VERIFY_BATCH;
+      }else
+         nthreads=i;
+   }
+#endif
+
+   i=0;
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( fh->state!=BDIO_R_STATE )
+         continue;
+
+      /* chains do not continue across headers */
+      if( fh->rcnt==fh->hrcnt+1 )
+         memset(chain_digest, 0, 16);
+      if( bdio_is_hash_record(digest, fh) )
+      {
+         /* in chain mode the next checksum starts with this one */
+         memcpy(chain_digest, digest, 16);
+         continue;
+      }
+
+      if( (type=peek_hash_record(&chain, digest, &tree, &tsize, &tlen, fh))==0 )
+      {
+         if( fh->state==BDIO_E_STATE )
+         {
+            ret=EOF;
+            break;
+         }
+         continue;
+      }
+
+      /* oldest job in the ring is reused */
+      job = &(pool.jobs[i % pool.njobs]);
+      wait_job(&pool, i, nthreads);
+      nbad += reap_job(job, report);
+
+      /* checksums are computed from the bytes as stored in the file,
+       * including the marker of complex records */
+      hl = fh->rlongrec ? 8 : 4;
+      if( fh->ridx!=hl )
+      {
+         if( fseek(fh->fp, (long) (fh->rstart+hl), SEEK_SET)==-1 )
+         {
+            bdio_error(1,"Error in bdio_verify. fseek fails with",fh);
+            fh->state = BDIO_E_STATE;
+            ret=EOF;
+            break;
+         }
+         fh->ridx = hl;
+      }
+      job->len = fh->rlen-fh->ridx;
+      if( job->size < job->len )
+      {
+         free(job->data);
+         job->size = job->len;
+         if( (job->data = (unsigned char*) malloc(job->size))==NULL )
+         {
+            bdio_error(1,"Error in bdio_verify. malloc fails with",fh);
+            job->size=0;
+            ret=EOF;
+            break;
+         }
+      }
+      if( fread(job->data, 1, job->len, fh->fp)!=job->len )
+      {
+         bdio_error(1,"Error in bdio_verify. fread fails with",fh);
+         fh->state = BDIO_E_STATE;
+         ret=EOF;
+         break;
+      }
+      fh->ridx += job->len;
+      job->rcnt = fh->rcnt;
+      job->type = type;
+      job->chain = chain;
+      if( chain )
+         memcpy(job->prefix, chain_digest, 16);
+      else
+         memset(job->prefix, 0, 16);
+      memcpy(job->digest, digest, 16);
+      /* the tree-hash record is handed over to the job */
+      job->tlen = tlen;
+      if( tlen>0 )
+      {
+         tswap = job->tree;
+         job->tree = tree;
+         tree = tswap;
+         tlen = job->tsize;
+         job->tsize = tsize;
+         tsize = tlen;
+      }
+      queue_job(&pool, job, nthreads);
+      nrec++;
+      i++;
+   }
+
+   /* collect the remaining results in order */
+   for( type=0; type<pool.njobs; type++ )
+   {
+      job = &(pool.jobs[(i+type) % pool.njobs]);
+      wait_job(&pool, i+type, nthreads);
+      nbad += reap_job(job, report);
+   }
+
+#ifndef _NO_POSIX_LIBS
+   if( nthreads>0 )
+   {
+      pthread_mutex_lock(&(pool.lock));
+      pool.quit=1;
+      pthread_cond_broadcast(&(pool.cond));
+      pthread_mutex_unlock(&(pool.lock));
+      for( type=0; type<nthreads; type++ )
+         pthread_join(threads[type], NULL);
+      pthread_mutex_destroy(&(pool.lock));
+      pthread_cond_destroy(&(pool.cond));
+      free(threads);
+   }
+#endif
+   for( type=0; type<pool.njobs; type++ )
+   {
+      free(pool.jobs[type].data);
+      free(pool.jobs[type].tree);
+   }
+   free(pool.jobs);
+   free(tree);
+
+   if( fh->state==BDIO_E_STATE )
+      ret=EOF;
+   if( report!=NULL )
+      fprintf(report,"%i records verified, %i checksum mismatches\n",
+              nrec, nbad);
+   if( ret==EOF )
+      return EOF;
+   return nbad;
+}
+
+
+int bdio_verify_on_read(int flag, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_verify_on_read", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_verify_on_read. Not in read mode.",fh);
+      return EOF;
+   }
+   if( !flag )
+   {
+      vread_free(fh);
+      return 0;
+   }
+   if( fh->vread!=NULL )
+      return 0;
+   if( (fh->vread = calloc(1, sizeof(struct bdio_vread)))==NULL )
+   {
+      bdio_error(1,"Error in bdio_verify_on_read. calloc fails with",fh);
+      return EOF;
+   }
+   /* records passed before are not known to chains, e.g. after
+    * bdio_open_tail */
+   fh->vread->lost = (fh->rcnt>0);
+   return 0;
+}
+
+
+int bdio_verify_range(uint64_t offset, uint64_t nb, BDIO *fh)
+{
+   unsigned char *tree=NULL, *buf=NULL;
+   unsigned char digest[16], root[16];
+   uint64_t tsize=0, tlen, dlen, mark, c, n;
+   uint32_t chunk;
+   long fpos, dpos;
+   int type, chain, hl, ret=0;
+   BDIO_HASH_CTX ctx;
+
+   if( !is_valid_bdio("bdio_verify_range", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_verify_range. Not in read mode.",fh);
+      return EOF;
+   }
+   if( fh->state != BDIO_R_STATE )
+   {
+      bdio_error(0, "Error in bdio_verify_range. Not in a record.",fh);
+      return EOF;
+   }
+   hl = fh->rlongrec ? 8 : 4;
+   dlen = fh->rlen-hl;
+   /* offsets of complex numbers stored as they are follow their marker */
+   mark = (uint64_t) (data_start(fh)-hl);
+   if( offset>dlen-mark || nb>dlen-mark-offset )
+   {
+      bdio_error(0, "Error in bdio_verify_range. Range exceeds the record.",fh);
+      return EOF;
+   }
+   offset += mark;
+   type = peek_hash_record(&chain, digest, &tree, &tsize, &tlen, fh);
+   if( type==0 || tlen==0 )
+   {
+      if( fh->state!=BDIO_E_STATE )
+         bdio_error(0, "Error in bdio_verify_range. "
+                       "Record is not followed by a tree-hash record.",fh);
+      free(tree);
+      return EOF;
+   }
+
+   /* the leaves must belong to the root and the record */
+   hash_init(type, &ctx);
+   hash_update(type, &ctx, tree+36, tlen-36);
+   hash_final(type, root, &ctx);
+   if( memcmp(root, tree+4, 16)!=0 || get_uint64(tree+28)!=dlen )
+   {
+      free(tree);
+      return 1;
+   }
+   chunk = get_uint32(tree+24);
+   if( nb==0 || (buf = (unsigned char*) malloc(chunk))==NULL )
+   {
+      if( nb!=0 )
+      {
+         bdio_error(1,"Error in bdio_verify_range. malloc fails with",fh);
+         ret = EOF;
+      }
+      free(tree);
+      return ret;
+   }
+
+   /* the chunks covering the range are read and hashed one by one */
+   fpos = ftell(fh->fp);
+   dpos = fpos-(long)(fh->ridx-hl);
+   for( c=offset/chunk; c<=(offset+nb-1)/chunk; c++ )
+   {
+      n = (dlen-c*chunk < chunk) ? dlen-c*chunk : chunk;
+      if( fseek(fh->fp, dpos+(long)(c*chunk), SEEK_SET)==-1 ||
+          fread(buf, 1, n, fh->fp)!=n )
+      {
+         bdio_error(1,"Error in bdio_verify_range. Reading fails with",fh);
+         ret = EOF;
+         break;
+      }
+      hash_init(type, &ctx);
+      hash_update(type, &ctx, buf, n);
+      hash_final(type, digest, &ctx);
+      if( memcmp(digest, tree+36+16*c, 16)!=0 )
+      {
+         ret = 1;
+         break;
+      }
+   }
+   clearerr(fh->fp);
+   if( fseek(fh->fp, fpos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in bdio_verify_range. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
+      ret = EOF;
+   }
+   free(buf);
+   free(tree);
+   return ret;
+}
+
+
+void bdio_perror(const char *s, BDIO *fh)
+{
+   if( fh==NULL || fh->nerror==0)
+      return;
+   if( s != NULL )
+      fprintf(fh->msg,"%s%s\n",s,fh->error);
+   else
+      fprintf(fh->msg,"%s\n",fh->error);
+   return;
+}
+
+void bdio_pferror(const char *s, BDIO *fh)
+{
+   if( fh==NULL || fh->nerror==0)
+      return;
+   if( s != NULL )
+      fprintf(fh->msg,"%s%s\n",s,fh->ferror);
+   else
+      fprintf(fh->msg,"%s\n",fh->ferror);
+   return;
+}
+
+static int cut_open_record(long fpos, BDIO *fh)
+{
+   /* removes what follows the last complete record at fpos before a file
+    * is appended to, i.e. the start of a record that its writer did not
+    * finish. New records would overwrite only part of it. */
+   long end;
+
+   if( fseek(fh->fp, 0, SEEK_END)!=0 || (end = ftell(fh->fp))==-1 )
+   {
+      bdio_error(1,"Error in bdio_open. fseek fails with",fh);
+      return EOF;
+   }
+   if( end<=fpos )
+      return 0;
+#ifndef _NO_POSIX_LIBS
+   if( fflush(fh->fp)!=0 || ftruncate(fileno(fh->fp), (off_t) fpos)!=0 )
+   {
+      bdio_error(1,"Error in bdio_open. ftruncate fails with",fh);
+      return EOF;
+   }
+   return 0;
+#else
+   bdio_error(0,"Error in bdio_open. File ends with an incomplete record.",
+              fh);
+   return EOF;
+#endif
+}
+
+BDIO *bdio_open(const char* file, const char* mode, char* protocol_info)
+{
+   BDIO *fh;
+   int wr;
+   char errormsg[256];
+   int last_hcnt;
+   long fpos;
+
+   if( default_msg==NULL )
+      default_msg = stderr;
+   
+   fh = (BDIO*) malloc(sizeof(BDIO));
+   if( fh==NULL )
+   {
+      return NULL;
+   }
+
+
+   fh->msg = default_msg;
+   fh->verbose = default_verbosity;
+   fh->upd = 0;
+   fh->hlazy = 0;
+   fh->hstrings = 0;
+   fh->follow = 0;
+   fh->follow_fd = -1;
+   fh->index = NULL;
+   fh->nerror = 0;
+   fh->error[0] = 0;
+   fh->ferror[0]= 0;
+   fh->hash_auto=BDIO_NO_HASH;
+   fh->hash_mode=BDIO_HASH_SINGL;
+   fh->hash_type=BDIO_HASH_MD5;
+   fh->hash_first=0;
+   fh->hash=NULL;
+   fh->htree=NULL;
+   fh->hpipe=NULL;
+   fh->vread=NULL;
+   fh->codec=BDIO_CODEC_NONE;
+   fh->filter=BDIO_FILTER_NONE;
+   fh->align=0;
+   fh->lchunk=BDIO_MAX_LONG_RECORD_LENGTH & ~((uint64_t) 15);
+   fh->andim=0;
+   fh->arcnt=-1;
+   fh->renc=0;
+   fh->rcplx=0;
+   fh->rhash=0;
+   fh->rhide=0;
+   fh->enc=NULL;
+
+   /* test the machine for compatibility */
+   if( sizeof(int32_t) != 4 )
+   {
+      bdio_error(0,"Error in bdio_open. sizeof(int32_t) is not 4 bytes.",fh);
+      free(fh);
+      return NULL;
+   }
+
+   if( sizeof(int64_t) != 8 )
+   {
+      bdio_error(0,"Error in bdio_open. sizeof(int64_t) is not 8 bytes.",fh);
+      free(fh);
+      return NULL;
+   }
+
+   if( sizeof(float) != 4 )
+   {
+      bdio_error(0,"Error in bdio_open. sizeof(float) is not 4 bytes.",fh);
+      free(fh);
+      return NULL;
+   }
+
+   if( sizeof(double) != 8 )
+   {
+      bdio_error(0,"Error in bdio_open. sizeof(double) is not 8 bytes.",fh);
+      free(fh);
+      return NULL;
+   }
+   
+   switch( *mode )
+   {
+      case 'r': fh->mode = BDIO_R_MODE;
+                break;
+      case 'w': fh->mode = BDIO_W_MODE;
+                break;
+      case 'a': fh->mode = BDIO_A_MODE;
+                break;
+      case 'u': fh->mode = BDIO_R_MODE;
+                fh->upd  = 1;
+                break;
+      default:  bdio_error(0,"Error in bdio_open. Unknown mode.",fh);
+                free(fh);
+                return NULL;
+   }
+
+   if( mode[1] != 0 )
+   {
+      /* r+ w+ and a+ modes do not exist in bdio */
+      bdio_error(0,"Error in bdio_open. Unknown mode",fh);
+      free(fh);
+      return NULL;
+   }
+
+   /* determine machine endiannes */
+   switch( isBigEndian() )
+   {
+      case 0: fh->endian = BDIO_LEND;
+              break;
+      case 1: fh->endian = BDIO_BEND;
+              break;
+      default:bdio_error(0,"Error in bdio_open. Machine has unknown endianess.",
+                         fh);
+                 free(fh);
+                 return NULL;
+   }
+
+   fh->buf = (unsigned char*) malloc(sizeof(char)*(BDIO_BUF_SIZE));
+   if( fh==NULL)
+   {
+      bdio_error(1,"Error in bdio_open. malloc fails with",fh);
+      free(fh);
+      return NULL;
+   }
+
+   if( fh->mode == BDIO_W_MODE )
+   {
+      if( protocol_info==NULL )
+      {
+         bdio_error(0,"Error in bdio_open. No protocol info supplied.",fh);
+         free(fh->buf);
+         free(fh);
+         return NULL;
+      }
+      if( (fh->fp = fopen(file, "w+"))==NULL )
+      {
+         sprintf(errormsg,
+              "Error in bdio_open. Cannot open %s for writing. fopen fails with"
+                                                                    ,file);
+         bdio_error(1,errormsg,fh);
+         free(fh->buf);
+         free(fh);
+         return NULL;
+      }
+
+      fh->hcnt = 0;
+      fh->rcnt = 0;
+      fh->hstart = 0;
+      fh->rstart = 0;
+      fh->bufstart= 0;
+      fh->bufidx = 0;
+      if( write_header(fh, protocol_info) != 0 )
+      {
+         fclose(fh->fp);
+         free(fh->buf);
+         free(fh);
+         return NULL;
+      }
+      return fh;
+   }
+   if (fh->mode == BDIO_R_MODE )
+   {
+      if( (fh->fp = fopen(file, fh->upd ? "r+" : "r"))==NULL )
+      {
+         sprintf(errormsg,
+              "Error in bdio_open. Cannot open %s for reading. fopen fails with"
+                                                                         ,file);
+         bdio_error(1,errormsg,fh);
+         free(fh->buf);
+         free(fh);
+         return NULL;
+      }
+      /* initialize some  header fields */
+      fh->hcnt = 0;
+      fh->rcnt = 0;
+      fh->rstart= 0;
+      fh->rlen = 0;
+      fh->ridx = 0;
+      fh->bufstart = 0;
+      fh->bufidx = 0;
+      fh->hcuser = NULL;
+      if( read_header(fh) != 0 )
+      {
+         bdio_error(0,"Error in bdio_open. Could not read header.",fh);
+         free(fh->buf);
+         fclose(fh->fp);
+         free(fh);
+         return NULL;
+      }
+      if( protocol_info != NULL )
+      {
+         if(strcmp(protocol_info,fh->hpinfo)!=0)
+         {
+            bdio_error(0,"Error in bdio_open. protocol_info does not match"
+                          " first header's.",fh);
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+      }
+      return fh;
+   }
+   if (fh->mode == BDIO_A_MODE )
+   {
+      /* apend mode: open file scroll to the end, update last header.
+       *             if the last entry was a record: fh->state= BDIO_R_STATE
+       *             else fh->state = BDIO_H_STATE
+       */
+      /* initialize some  header fields */
+      fh->hcnt = 0;
+      fh->rcnt = 0;
+      fh->hstart= 0;
+      fh->rstart= 0;
+      fh->rlen = 0;
+      fh->ridx = 0;
+      fh->bufstart = 0;
+      fh->bufidx = 0;
+      fh->hcuser = NULL;
+
+      if( (fh->fp = fopen(file, "r+"))==NULL )
+      {
+         if( errno!=ENOENT )
+         {
+            sprintf(errormsg,
+              "Error in bdio_open. Cannot open %s in r+ mode. fopen fails with"
+                                                                         ,file);
+            bdio_error(1,errormsg,fh);
+            free(fh->buf);
+            free(fh);
+            return NULL;
+         }else
+         {
+            if( (fh->fp = fopen(file, "w+"))==NULL )
+            {
+               sprintf(errormsg,
+                "Error in bdio_open. Cannot open %s in w mode. fopen fails with"
+                                                                         ,file);
+               bdio_error(1,errormsg,fh);
+               free(fh->buf);
+               free(fh);
+               return NULL;
+            }
+         }
+      }
+      /* read in first 4 bytes to decide whether file is empty or not */
+      wr = fread( fh->buf, 1, 4, fh->fp );
+      if ( wr != 4 )
+      {
+         if( feof(fh->fp))
+         {
+            if( wr!=0 )
+            {
+               bdio_error(0,"Error in bdio_open. Unexpected EOF.",fh);
+               free(fh->buf);
+               fclose(fh->fp);
+               free(fh);
+               return NULL;
+            }
+            /* empty file - start new bdio file */
+            /* write new header */
+            if( protocol_info==NULL )
+            {
+               bdio_error(0,"Error in bdio_open. No protocol info supplied."
+                                                                           ,fh);
+               fclose(fh->fp);
+               free(fh->buf);
+               free(fh);
+               return NULL;
+            }
+            if( write_header(fh, protocol_info) != 0 )
+            {
+               fclose(fh->fp);
+               free(fh->buf);
+               free(fh);
+               return NULL;
+            }
+            return fh;
+         }
+         else
+         {
+            bdio_error(1,"Error in bdio_open. fread fails with",fh);
+            free(fh->buf);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+      }else
+      {
+         /* file is not empty */
+         fh->bufidx = 4;
+         fh->ridx = 4;
+         if( read_header(fh) != 0 )
+         {
+            bdio_error(0,"Error in bdio_open. Could not read header.",fh);
+            free(fh->buf);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+
+         fh->mode = BDIO_R_MODE;
+         last_hcnt = fh->hcnt;
+         while( (fh->state == BDIO_R_STATE) || (fh->state == BDIO_H_STATE) )
+         {
+            last_hcnt = fh->hcnt;
+            if( bdio_seek_record(fh)==EOF )
+            if( fh->state == BDIO_E_STATE )
+            {
+               free(fh->hcuser);
+               free(fh->buf);
+               fclose(fh->fp);
+               free(fh);
+               return NULL;
+            }
+         }
+         if( protocol_info != NULL)
+         {
+            if(strcmp(protocol_info,fh->hpinfo)!=0)
+            {
+               bdio_error(0,"Error in bdio_open. protocol_info does not match"
+                                                          " last header's.",fh);
+               free(fh->buf);
+               free(fh->hcuser);
+               fclose(fh->fp);
+               free(fh);
+               return NULL;
+            }
+         }
+         if( last_hcnt < fh->hcnt )
+            fh->state=BDIO_H_STATE;
+         else
+            fh->state=BDIO_N_STATE;
+
+         /* update last header */
+         fpos=fh->rstart+fh->rlen;
+         if( cut_open_record(fpos, fh)!=0 )
+         {
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+         if( fseek(fh->fp, fh->hstart, SEEK_SET)!=0 )
+         {
+            bdio_error(1,"Error in bdio_open. fseek fails with",fh);
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+
+         if( update_header(fh) != 0 )
+         {
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+         
+         if( fseek(fh->fp, fpos, SEEK_SET)!=0 )
+         {
+            bdio_error(1,"Error in bdio_open. fseek fails with",fh);
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+         /* names and the record table are kept when appending, the index
+          * record at the end stays in the file as a hidden record. The new
+          * one is written at bdio_close. */
+         if( load_index(0, fh)!=0 )
+         {
+            index_free(fh);
+            free(fh->buf);
+            free(fh->hcuser);
+            fclose(fh->fp);
+            free(fh);
+            return NULL;
+         }
+         fh->mode = BDIO_A_MODE;
+         return fh;
+      }
+   }
+   return fh;
+}
+
+
+int bdio_close(BDIO *fh)
+{
+   int ret;
+   if( !is_valid_bdio("bdio_close", fh) )
+   {
+      if( fh==NULL )
+         return EOF;
+      else
+      {
+         bdio_error(0,"Error in bdio_close. Stream is in error state.",fh);
+         ret = fclose( fh->fp );
+         if( ret==EOF )
+            bdio_error(1,"Error in bdio_close. fclose fails with",fh);
+         if( fh->hcuser!=0 )
+            free( fh->hcuser );
+         if( fh->buf!=0 )
+            free( fh->buf );
+         hash_pipe_free( fh );
+         hash_tree_free( fh );
+         vread_free( fh );
+         enc_free( fh );
+         index_free( fh );
+         follow_stop( fh );
+         if( fh->hash!=NULL )
+            free( fh->hash );
+         fh->state = -1;
+         free( fh );
+         return EOF;
+      }
+   }
+   if( (fh->mode == BDIO_W_MODE)  || (fh->mode == BDIO_A_MODE) )
+   {
+      if( bdio_flush_record( fh )!=0 || write_index( fh )!=0 ||
+          write_dirinfo( fh )!=0 )
+      {
+         bdio_error(0,"Error in bdio_close. Could not flush.",fh);
+         ret = fclose( fh->fp );
+         if( ret==EOF )
+            bdio_error(1,"Error in bdio_close. fclose fails with",fh);
+         free( fh->hcuser );
+         free( fh->buf );
+         hash_pipe_free( fh );
+         hash_tree_free( fh );
+         vread_free( fh );
+         enc_free( fh );
+         index_free( fh );
+         follow_stop( fh );
+         free( fh->hash );
+         fh->state = -1;
+         free( fh );
+         return EOF;
+      }
+   }
+   ret = fclose( fh->fp );
+   if( ret==EOF )
+   {
+      bdio_error(1,"Error in bdio_close. fclose fails with",fh);
+      free( fh->hcuser );
+      free( fh->buf );
+      hash_pipe_free( fh );
+      hash_tree_free( fh );
+      vread_free( fh );
+      enc_free( fh );
+      index_free( fh );
+      follow_stop( fh );
+      free( fh->hash );
+      fh->state = -1;
+      free( fh );
+      return EOF;
+   }
+   free( fh->hcuser );
+   free( fh->buf );
+   hash_pipe_free( fh );
+   hash_tree_free( fh );
+   vread_free( fh );
+   enc_free( fh );
+   index_free( fh );
+   follow_stop( fh );
+   free( fh->hash );
+   fh->state = -1;
+   free( fh );
+   return ret;
+}
+
+void bdio_set_user(char* u)
+{
+   int len;
+   len = strlen(u)+1;
+   if( len < BDIO_MAX_USER_LENGTH )
+   {
+      strcpy(user_str,u);
+   }
+   else
+   {
+      strncpy(user_str,u,BDIO_MAX_USER_LENGTH-1);
+      user_str[BDIO_MAX_USER_LENGTH-1]='\0';
+   }
+}
+
+void bdio_set_host(char* u)
+{
+   int len;
+   len = strlen(u)+1;
+   if( len < BDIO_MAX_HOST_LENGTH )
+   {
+      strcpy(host_str,u);
+   }
+   else
+   {
+      strncpy(host_str,u,BDIO_MAX_HOST_LENGTH-1);
+      host_str[BDIO_MAX_HOST_LENGTH-1]='\0';
+   }
+}
+
+
+void bdio_set_dflt_msg(FILE *stream)
+{
+   if( stream != NULL )
+      default_msg = stream;
+}
+
+void bdio_set_dflt_verbose(int v)
+{
+   if( v==0 )
+   {
+      default_verbosity=0;
+   } else
+      default_verbosity=1;
+   return;
+}
+
+int bdio_set_verbose(int v, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_verbose", fh) )
+   {
+      return EOF;
+   }
+   if( v==0 )
+   {
+      fh->verbose = 0;
+      return 0;
+   }
+   if( v>0 )
+   {
+      fh->verbose = 1;
+      return 0;
+   }
+   bdio_error(0,"Error in bdio_set_verbose. Argument out of range",fh);
+   return EOF;
+}
+
+int bdio_set_msg(FILE *stream, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_verbose", fh) )
+   {
+      return EOF;
+   }
+   if( stream != NULL)
+   {
+      fh->msg = stream;
+      return 0;
+   }else
+      bdio_error(0,"Error in bdio_set_msg. NULL is an invalid stream.\n"
+                   "Use set_verbose to turn off error output.",fh);
+   return EOF;
+}
+
+char* bdio_get_hchost(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) || load_head_strings(fh)!=0 )
+   {
+      return NULL;
+   }
+   return fh->hchost;
+}
+
+char* bdio_get_hcuser(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) || load_head_strings(fh)!=0 )
+   {
+      return NULL;
+   }
+   return fh->hcuser;
+}
+
+char* bdio_get_hmhost(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) || load_head_strings(fh)!=0 )
+   {
+      return NULL;
+   }
+   return fh->hmhost;
+}
+
+char* bdio_get_hmuser(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) || load_head_strings(fh)!=0 )
+   {
+      return NULL;
+   }
+   return fh->hmuser;
+}
+
+char* bdio_get_hpinfo(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) || load_head_strings(fh)!=0 )
+   {
+      return NULL;
+   }
+   return fh->hpinfo;
+}
+
+int bdio_get_hversion(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   {
+      return EOF;
+   }
+   return fh->hversion;
+}
+   
+int bdio_get_hcnt(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hcnt", fh) )
+   {
+      return EOF;
+   }
+   return fh->hcnt;
+}
+
+int bdio_get_hcdate(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hcdate", fh) )
+   {
+      return EOF;
+   }
+   return fh->hcdate;
+}
+
+int bdio_get_hmdate(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hmdate", fh) )
+   {
+      return EOF;
+   }
+   return fh->hmdate;
+}
+
+int bdio_get_hdirinfo1(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hdirinfo1", fh) )
+   {
+      return EOF;
+   }
+   return fh->hdirinfo1;
+}
+
+int bdio_get_hdirinfo2(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_hdirinfo2", fh) )
+   {
+      return EOF;
+   }
+   return fh->hdirinfo2;
+}
+
+int bdio_get_ruinfo(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_ruinfo", fh) )
+   {
+      return EOF;
+   }
+   if( fh->state == BDIO_R_STATE )
+      return fh->ruinfo;
+   bdio_error(0, "Error in bdio_get_ruinfo. Currently not in a data record.",fh);
+   return EOF;
+}
+
+int bdio_get_rfmt(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_rtype", fh) )
+   {
+      return EOF;
+   }
+   if( fh->state == BDIO_R_STATE )
+      return fh->rfmt;
+   bdio_error(0, "Error in bdio_get_rfmt. Currently not in a data record.",fh);
+   return EOF;
+}
+
+uint64_t bdio_get_rstart(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_rstart", fh) )
+   {
+      return (uint64_t) EOF;
+   }
+   if( fh->state == BDIO_R_STATE )
+      return fh->rstart + data_start(fh);
+   bdio_error(0, "Error in bdio_get_rstart. Currently not in a data record.",
+              fh);
+   return (uint64_t) EOF;
+}
+
+int bdio_is_complex_record(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_is_complex_record", fh) )
+   {
+      return EOF;
+   }
+   if( fh->state == BDIO_R_STATE )
+      return fh->rcplx;
+   bdio_error(0, "Error in bdio_is_complex_record. Currently not in a data "
+                 "record.",fh);
+   return EOF;
+}
+
+uint64_t bdio_get_rlen(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_rlen", fh) )
+   {
+      return EOF;
+   }
+   if( fh->state == BDIO_R_STATE )
+   {
+      if ( fh->renc )
+         return fh->enc->llen;
+      return fh->rlen-data_start(fh);
+   }
+   return 0;
+}
+   
+int bdio_get_rcnt(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_get_rcnt", fh) )
+   {
+      return EOF;
+   }
+   return fh->rcnt;
+}
+
+int bdio_is_in_record(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_is_in_record", fh) )
+   {
+      return 0;
+   }
+   if( fh->state == BDIO_R_STATE )
+      return 1;
+   else
+      return 0;
+}
+
+int bdio_is_in_header(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_is_in_header", fh) )
+   {
+      return 0;
+   }
+   if( fh->state == BDIO_H_STATE )
+      return 1;
+   else
+      return 0;
+}
+
+
+
+
+int bdio_append_record(int fmt, int uinfo, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_append_record", fh) )
+   {
+      return EOF;
+   }
+
+   if( (fh->mode != BDIO_W_MODE)  && (fh->mode != BDIO_A_MODE) )
+   {
+      bdio_error(0,
+                "Error in bdio_append_record. Not in write or append mode.",fh);
+      return EOF;
+   }
+   
+   if( fh->state != BDIO_N_STATE )
+   {
+      bdio_error(0,"Error in bdio_append_record. Not at the end of file.",fh);
+      return EOF;
+   }
+
+   if( fh->rstart == fh->hstart )
+   {
+      bdio_error(0,"Error in bdio_append_record. Last entry in file is not a"
+                   " record.",fh);
+      return EOF;
+   }
+
+   /* assume that meta-data of last record are still up to date despite of
+    * being in N-state
+    */
+   if( fh->renc || fh->rcplx )
+   {
+      bdio_error(0,"Error in bdio_append_record. Previous record is "
+                   "encoded.",fh);
+      return EOF;
+   }
+   if( fh->ruinfo != uinfo )
+   {
+      bdio_error(0,"Error in bdio_append_record. uinfo does not "
+                   "match previous record's.",fh);
+      return EOF;
+   }
+   /* TODO: typen ohne endianness: check ob sie zur maschine passen */
+   if( fmt != fh->rfmt )
+   {
+      if( ! (  (fmt==BDIO_BIN_INT32 &&
+               ((fh->rfmt==BDIO_BIN_INT32BE)||(fh->rfmt==BDIO_BIN_INT32LE)) )
+             ||(fmt==BDIO_BIN_INT64 &&
+               ((fh->rfmt==BDIO_BIN_INT64BE)||(fh->rfmt==BDIO_BIN_INT64LE)) )
+             ||(fmt==BDIO_BIN_F32 &&
+               ((fh->rfmt==BDIO_BIN_F32BE)||(fh->rfmt==BDIO_BIN_F32LE)) )
+             ||(fmt==BDIO_BIN_F64 &&
+               ((fh->rfmt==BDIO_BIN_F64BE)||(fh->rfmt==BDIO_BIN_F64LE)) )
+             ||(fmt==BDIO_BIN_F16 &&
+               ((fh->rfmt==BDIO_BIN_F16BE)||(fh->rfmt==BDIO_BIN_F16LE)) )
+             ||(fmt==BDIO_BIN_BF16 &&
+               ((fh->rfmt==BDIO_BIN_BF16BE)||(fh->rfmt==BDIO_BIN_BF16LE)) ) )
+        )
+      {
+         bdio_error(0,"Error in bdio_append_record. fmt does not match"
+                      " previous record's.",fh);
+         return EOF;
+      }
+   }
+   fh->state = BDIO_R_STATE;
+   fh->bufstart = fh->rlen;
+   fh->bufidx = 0;
+   return 0;
+}
+
+
+static int seek_head(BDIO *fh)
+{
+   /* the part of bdio_seek_record that only reads the header of the next
+    * record */
+   unsigned char m[4];
+   int rd;
+   uint32_t hdr;
+   uint64_t lhdr;
+
+   if( (fh->state == BDIO_R_STATE) || (fh->state == BDIO_H_STATE))
+   {
+      if( fseek(fh->fp, fh->rlen-fh->ridx, SEEK_CUR)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fseek fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      fh->ridx = fh->rlen;
+   }
+
+   
+   /* read the header of the following record*/
+   rd = fread( fh->buf, 1, 4, fh->fp);
+   if ( feof( fh->fp ) )
+   {
+      /* clean EOF reached */
+      clearerr( fh->fp );
+      fh->state = BDIO_N_STATE;
+      return EOF;
+   }
+   if ( rd != 4 )
+   {
+      bdio_error(1,"Error in bdio_seek_record. fread fails with.",fh);
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   fh->rstart = fh->rstart+fh->rlen;
+   fh->ridx=4;
+   memcpy(&hdr,fh->buf,4);
+   if (fh->endian == BDIO_BEND)
+         swap32(&hdr,4);
+   while( !(hdr & 0x00000001) )
+   {
+      /* must be a header */
+      if( read_header(fh) != 0 )
+      {
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      /* seek next record */
+      if( fseek(fh->fp, fh->rlen-fh->ridx, SEEK_CUR)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fseek failed with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      fh->ridx=fh->rlen;
+      /* read the header of the following record (version 2 in the notes) */
+      rd = fread( fh->buf, 1, 4, fh->fp);
+      if ( feof( fh->fp ) )
+      {
+         /* clean EOF reached */
+         clearerr( fh->fp );
+         fh->state = BDIO_N_STATE;
+         return 0;
+      }
+      if ( rd != 4 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fread fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      memcpy(&hdr,fh->buf,4);
+      if (fh->endian == BDIO_BEND)
+         swap32(&hdr,4);
+      fh->rstart = fh->rstart+fh->rlen;
+      fh->ridx = 4;
+   }
+   /* can only be a data record */
+   if( hdr & HEADER_OPEN )
+   {
+      /* not written completely yet, found again by the next call */
+      if( fseek(fh->fp, fh->rstart, SEEK_SET)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fseek fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      fh->rlen = 0;
+      fh->ridx = 0;
+      fh->state = BDIO_N_STATE;
+      return EOF;
+   }
+   fh->rcnt++;
+   fh->rlongrec = (hdr & 0x00000008)>>3;
+   if (fh->rlongrec )
+   {
+      /* need next 4 bytes to determine length */
+      rd = fread( &(fh->buf[4]), 1, 4, fh->fp);
+      if ( feof( fh->fp ) )
+      {
+         bdio_error(1,"Error in bdio_seek_record. Unexpected EOF.",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      if ( rd != 4 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fread fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      memcpy(&lhdr, fh->buf, 8);
+      if (fh->endian == BDIO_BEND)
+         swap64(&lhdr,8);
+      fh->renc     =  (lhdr & HEADER_ENC) ? 1 : 0;
+      fh->rcplx    =  0;
+      fh->rfmt     =  (int) ((lhdr & 0x00000000000000f0)>>4);
+      fh->ruinfo   =  (int) ((lhdr & 0x0000000000000f00)>>8);
+      fh->rlen     = ((lhdr & 0xfffffffffffff000)>>12) + 8;
+      fh->ridx     = 8;
+   }else
+   {
+      fh->renc     =  (hdr & HEADER_ENC) ? 1 : 0;
+      fh->rcplx    =  0;
+      fh->rfmt     =  (hdr & 0x000000f0)>>4;
+      fh->ruinfo   =  (hdr & 0x00000f00)>>8;
+      fh->rlen     = ((hdr & 0xfffff000)>>12) + 4;
+   }
+   if( fh->renc && fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7 )
+   {
+      /* padding record, see bdio_set_alignment, or index record */
+      fh->rcnt--;
+      fh->state = BDIO_R_STATE;
+      return seek_head(fh);
+   }
+   if( fh->renc && fh->rfmt==BDIO_BIN_GENERIC )
+   {
+      /* the format of an encoded record is in its method word, see
+       * head_fmt */
+      if( fh->rlen-fh->ridx<4 )
+      {
+         bdio_error(0,"Error in bdio_seek_record. Encoded record too short.",
+                    fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      if( fread(m, 1, 4, fh->fp)!=4 || fseek(fh->fp, -4, SEEK_CUR)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_record. Reading fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      fh->rfmt = (int) (get_uint32(m) >> ENC_FMT_SHIFT);
+   }
+
+   /* find out whether on this machine swapping of the byte order will be
+    * necessary after reading from disk
+    */
+   fh->rswap=0;
+   if(  ((fh->rfmt==BDIO_BIN_INT32LE) && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_INT32BE) && (fh->endian==BDIO_LEND))
+      ||((fh->rfmt==BDIO_BIN_F32LE)   && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_F32BE)   && (fh->endian==BDIO_LEND))
+      ||((fh->rfmt==BDIO_BIN_INT64LE) && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_INT64BE) && (fh->endian==BDIO_LEND))
+      ||((fh->rfmt==BDIO_BIN_F64LE)   && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_F64BE)   && (fh->endian==BDIO_LEND))
+      ||((fh->rfmt==BDIO_BIN_F16LE)   && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_F16BE)   && (fh->endian==BDIO_LEND))
+      ||((fh->rfmt==BDIO_BIN_BF16LE)  && (fh->endian==BDIO_BEND))
+      ||((fh->rfmt==BDIO_BIN_BF16BE)  && (fh->endian==BDIO_LEND)) )
+   {
+      fh->rswap=1;
+   }
+   /* find out whether data items will have 1, 2, 4 or 8 bytes */
+   fh->rdsize=1;
+   if(  (fh->rfmt==BDIO_BIN_F16LE)   || (fh->rfmt==BDIO_BIN_F16BE)
+      ||(fh->rfmt==BDIO_BIN_BF16LE)  || (fh->rfmt==BDIO_BIN_BF16BE) )
+   {
+      fh->rdsize=2;
+   }
+   if(  (fh->rfmt==BDIO_BIN_INT32LE) || (fh->rfmt==BDIO_BIN_INT32BE)
+      ||(fh->rfmt==BDIO_BIN_F32LE)   || (fh->rfmt==BDIO_BIN_F32BE) )
+   {
+      fh->rdsize=4;
+   }
+   if(  (fh->rfmt==BDIO_BIN_INT64LE) || (fh->rfmt==BDIO_BIN_INT64BE)
+      ||(fh->rfmt==BDIO_BIN_F64LE)   || (fh->rfmt==BDIO_BIN_F64BE) )
+   {
+      fh->rdsize=8;
+   }
+   fh->state  = BDIO_R_STATE;
+   return 0;
+}
+
+static int record_ready(uint64_t pos, BDIO *fh)
+{
+   /* 1 if a complete record starts at pos, possibly after headers and
+    * padding records, 0 if the file ends before or the record is still
+    * being written. Moves the file position */
+   unsigned char b[8];
+   uint64_t end, len;
+   uint32_t hdr;
+   size_t n;
+   long e;
+
+   if( fseek(fh->fp, 0, SEEK_END)==-1 || (e = ftell(fh->fp))==-1 )
+   {
+      bdio_error(1,"Error in bdio_seek_record. fseek fails with",fh);
+      return EOF;
+   }
+   end = (uint64_t) e;
+   for(;;)
+   {
+      /* record headers have 4 or 8 bytes, headers at least 8 */
+      if( pos+4>end )
+         return 0;
+      n = (pos+8>end) ? 4 : 8;
+      if( fseek(fh->fp, pos, SEEK_SET)==-1 || fread(b, 1, n, fh->fp)!=n )
+      {
+         bdio_error(1,"Error in bdio_seek_record. fread fails with",fh);
+         return EOF;
+      }
+      hdr = get_uint32(b);
+      if( ((hdr & 0x1) && (hdr & HEADER_OPEN)) ||
+          (n==4 && (!(hdr & 0x1) || (hdr & 0x8))) )
+         return 0;
+      if( !(hdr & 0x1) )
+         len = (get_uint32(b+4) & 0xfff)+8;
+      else if( hdr & 0x8 )
+         len = (get_uint64(b)>>12)+8;
+      else
+         len = (hdr>>12)+4;
+      if( pos+len>end )
+         return 0;
+      if( (hdr & 0x1) && (hdr & 0xff3)!=(0x701 | HEADER_ENC) )
+         return 1;
+      pos += len;
+   }
+}
+
+static long follow_clock(void)
+{
+   /* milliseconds of a monotonic clock */
+#ifndef _NO_POSIX_LIBS
+   struct timespec ts;
+
+   if( clock_gettime(CLOCK_MONOTONIC, &ts)==0 )
+      return (long) ts.tv_sec*1000+ts.tv_nsec/1000000;
+#endif
+   return 0;
+}
+
+static void follow_wait(int ms, BDIO *fh)
+{
+   /* waits up to ms milliseconds for the followed file to change */
+#ifndef _NO_POSIX_LIBS
+   struct timespec ts;
+#ifdef __linux__
+   struct pollfd pfd;
+   char ev[4096];
+
+   if( fh->follow_fd>=0 )
+   {
+      pfd.fd = fh->follow_fd;
+      pfd.events = POLLIN;
+      if( poll(&pfd, 1, ms)>0 )
+         while( read(fh->follow_fd, ev, sizeof(ev))>0 );
+      return;
+   }
+#endif
+   ts.tv_sec = ms/1000;
+   ts.tv_nsec = (ms%1000)*1000000L;
+   nanosleep(&ts, NULL);
+#endif
+}
+
+static int follow_head(BDIO *fh)
+{
+   /* seek_head, which waits in follow mode until the next record is
+    * complete, see bdio_follow */
+   uint64_t pos;
+   long t0, left;
+   int ready;
+
+   if( fh->follow==0 )
+      return seek_head(fh);
+   pos = fh->rstart+fh->rlen;
+   t0 = follow_clock();
+   left = fh->follow;
+   while( (ready = record_ready(pos, fh))==0 && (fh->follow<0 || left>0) )
+   {
+      /* inotify misses changes made on other hosts of network file
+       * systems, the file is checked regularly anyway */
+      follow_wait((fh->follow<0 || left>BDIO_FOLLOW_POLL) ?
+                  BDIO_FOLLOW_POLL : (int) left, fh);
+      left = fh->follow-(follow_clock()-t0);
+   }
+   if( ready==EOF || fseek(fh->fp, pos, SEEK_SET)==-1 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   fh->ridx = fh->rlen;
+   if( !ready )
+   {
+      fh->state = BDIO_N_STATE;
+      return EOF;
+   }
+   return seek_head(fh);
+}
+
+static int land_record(BDIO *fh)
+{
+   /* completes bdio_seek_record once seek_head has found a record */
+   if( fh->vread!=NULL )
+      vread_seek(fh);
+   if( fh->renc && dec_seek(fh)!=0 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   return 0;
+}
+
+int bdio_seek_record(BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_seek_record", fh) )
+   {
+      return EOF;
+   }
+
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_seek_record. Not in read mode.",fh);
+      return EOF;
+   }
+
+   if( follow_head(fh)!=0 )
+      return EOF;
+   if( fh->state!=BDIO_R_STATE )
+      return 0;
+   return land_record(fh);
+}
+
+
+int bdio_follow(int timeout, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_follow", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_follow. Not in read mode.",fh);
+      return EOF;
+   }
+#ifdef _NO_POSIX_LIBS
+   if( timeout!=0 )
+   {
+      bdio_error(0, "Error in bdio_follow. Not available without POSIX "
+                    "libraries.",fh);
+      return EOF;
+   }
+#endif
+   fh->follow = timeout;
+   if( timeout==0 )
+   {
+      follow_stop(fh);
+      return 0;
+   }
+#if !defined(_NO_POSIX_LIBS) && defined(__linux__)
+   /* the file is watched through its descriptor, whose name is not kept;
+    * without inotify the file is polled */
+   if( fh->follow_fd<0 )
+   {
+      char path[64];
+
+      sprintf(path, "/proc/self/fd/%i", fileno(fh->fp));
+      fh->follow_fd = inotify_init1(IN_NONBLOCK);
+      if( fh->follow_fd>=0 &&
+          inotify_add_watch(fh->follow_fd, path, IN_MODIFY)<0 )
+         follow_stop(fh);
+   }
+#endif
+   return 0;
+}
+
+
+int bdio_seek_header(BDIO *fh)
+{
+   uint64_t pos, to;
+   uint32_t hdr;
+   size_t rd;
+   int hcnt;
+
+   if( !is_valid_bdio("bdio_seek_header", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_seek_header. Not in read mode.",fh);
+      return EOF;
+   }
+
+   /* the section of the last header is skipped at once if its directory
+    * fields are not saturated and the next header or the end of the file is
+    * found where they point to */
+   pos = fh->rstart+fh->ridx;
+   to  = fh->hend+fh->hdirinfo2;
+   if( (fh->state==BDIO_R_STATE || fh->state==BDIO_H_STATE) &&
+       fh->hdirinfo1<0x3ff && fh->hdirinfo2<0x3fffff && to>=pos )
+   {
+      if( fseek(fh->fp, to, SEEK_SET)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_header. fseek fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      rd = fread(&hdr, 1, 4, fh->fp);
+      if( rd==0 && feof(fh->fp) )
+      {
+         clearerr(fh->fp);
+         fh->rcnt = fh->hrcnt+fh->hdirinfo1;
+         fh->rstart = to;
+         fh->rlen = 0;
+         fh->ridx = 0;
+         fh->state = BDIO_N_STATE;
+         return EOF;
+      }
+      clearerr(fh->fp);
+      if (fh->endian == BDIO_BEND)
+         swap32(&hdr,4);
+      if( fseek(fh->fp, (rd==4 && hdr==BDIO_MAGIC) ? to : pos, SEEK_SET)==-1 )
+      {
+         bdio_error(1,"Error in bdio_seek_header. fseek fails with",fh);
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+      if( rd==4 && hdr==BDIO_MAGIC )
+      {
+         /* bdio_seek_record reads the header from here */
+         fh->rcnt = fh->hrcnt+fh->hdirinfo1;
+         fh->rstart = to;
+         fh->rlen = 0;
+         fh->ridx = 0;
+         fh->renc = 0;
+         fh->rcplx = 0;
+         fh->state = BDIO_N_STATE;
+         if( fh->vread!=NULL )
+            fh->vread->type = 0;
+      }
+   }
+
+   hcnt = fh->hcnt;
+   while( fh->hcnt==hcnt )
+      if( bdio_seek_record(fh)==EOF )
+         return EOF;
+   return 0;
+}
+
+
+size_t bdio_read(void *buf, size_t nb, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_read", fh) )
+   {
+      return 0;
+   }
+   if( fh->state != BDIO_R_STATE )
+   {
+      bdio_error(0, "Error in bdio_read. No record seeked.",fh);
+      return 0;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_read. Not in read mode.",fh);
+      return 0;
+   }
+
+   if(nb%fh->rdsize!=0)
+   {
+      bdio_error(0, "Error in bdio_read. nb is not multiple of data size.",fh);
+      return 0;
+   }
+
+   if( fh->renc )
+   {
+      if( nb > fh->enc->llen-fh->enc->lidx )
+      {
+         bdio_error(0,"Error in bdio_read. nb is larger than remaining data "
+                      "in the record.",fh);
+         return 0;
+      }
+      return dec_read(buf, nb, fh);
+   }
+
+   if( nb > (fh->rlen-fh->ridx) )
+   {
+      bdio_error(0,"Error in bdio_read. nb is larger than remaining data in"
+                   " the record.",fh);
+      return 0;
+      /* TODO: maybe better: read as much as possible? */
+   }
+   
+   return raw_read(buf, nb, fh);
+}
+
+int bdio_seek_in_record(int64_t offset, int whence, BDIO *fh)
+{
+   uint64_t cur, len;
+   int64_t to;
+   int hl, esize;
+
+   if( !is_valid_bdio("bdio_seek_in_record", fh) )
+   {
+      return EOF;
+   }
+   if( fh->state != BDIO_R_STATE || fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_seek_in_record. No record seeked.",fh);
+      return EOF;
+   }
+   hl  = data_start(fh);
+   cur = fh->renc ? fh->enc->lidx : fh->ridx-hl;
+   len = bdio_get_rlen(fh);
+   if( whence==SEEK_SET )
+      to = offset;
+   else if( whence==SEEK_CUR )
+      to = (int64_t) cur+offset;
+   else if( whence==SEEK_END )
+      to = (int64_t) len+offset;
+   else
+   {
+      bdio_error(0, "Error in bdio_seek_in_record. Unknown whence.",fh);
+      return EOF;
+   }
+   esize = fh->rcplx ? 2*fh->rdsize : fh->rdsize;
+   if( to<0 || (uint64_t) to>len || to%esize!=0 )
+   {
+      bdio_error(0, "Error in bdio_seek_in_record. Offset outside of the "
+                    "record or not a multiple of the data size.",fh);
+      return EOF;
+   }
+   if( (uint64_t) to==cur )
+      return 0;
+   /* the checksum of the record can not be checked any more */
+   if( fh->vread!=NULL && fh->vread->rcnt==fh->rcnt )
+      fh->vread->type = 0;
+   if( fh->renc )
+      return dec_move((uint64_t) to, fh);
+   if( fseek(fh->fp, (long) (fh->rstart+hl+to), SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in bdio_seek_in_record. fseek fails with",fh);
+      return EOF;
+   }
+   fh->ridx = hl+to;
+   return 0;
+}
+
+static int goto_header(uint64_t pos, int hcnt, int rcnt, BDIO *fh)
+{
+   /* positions fh at the end of the header at offset pos, which follows hcnt
+    * headers and rcnt records. With pos=0 as after bdio_open */
+   if( fseek(fh->fp, pos, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in goto_header. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   fh->hcnt = hcnt;
+   fh->rcnt = rcnt;
+   fh->rstart = pos;
+   fh->rlen = 0;
+   fh->ridx = 0;
+   fh->bufstart = 0;
+   fh->bufidx = 0;
+   fh->renc = 0;
+   fh->rcplx = 0;
+   if( fh->vread!=NULL )
+   {
+      fh->vread->type = 0;
+      memset(fh->vread->last, 0, 16);
+   }
+   if( read_header(fh)!=0 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   return 0;
+}
+
+static int digest_record(int type, const unsigned char *prefix,
+                         struct bdio_hash_tree *t, unsigned char digest[16],
+                         BDIO *fh)
+{
+   /* computes the checksum of the payload of the current record as stored
+    * in the file, preceded by the 16 bytes at prefix if not NULL. If t is
+    * not NULL, the tree hash with the chunk size t->chunk is computed
+    * instead, and its leaves are left in t. */
+   BDIO_HASH_CTX ctx;
+   uint64_t left;
+   size_t n;
+   int hl = fh->rlongrec ? 8 : 4;
+
+   if( fseek(fh->fp, (long) (fh->rstart+hl), SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in bdio_update_record. fseek fails with",fh);
+      return EOF;
+   }
+   if( t!=NULL )
+      tree_start(t, type);
+   else
+   {
+      hash_init(type, &ctx);
+      if( prefix!=NULL )
+         hash_update(type, &ctx, (void*) prefix, 16);
+   }
+   for( left=fh->rlen-hl; left>0; left-=n )
+   {
+      n = (left<BDIO_BUF_SIZE) ? (size_t) left : BDIO_BUF_SIZE;
+      if( fread(fh->buf, 1, n, fh->fp)!=n )
+      {
+         bdio_error(1,"Error in bdio_update_record. fread fails with",fh);
+         return EOF;
+      }
+      if( t!=NULL )
+         tree_update(t, fh->buf, n);
+      else
+         hash_update(type, &ctx, fh->buf, n);
+   }
+   if( t!=NULL )
+      tree_final(t, digest);
+   else
+      hash_final(type, digest, &ctx);
+   return (t!=NULL && t->err) ? EOF : 0;
+}
+
+static int write_digest(unsigned char digest[16], struct bdio_hash_tree *t,
+                        BDIO *fh)
+{
+   /* stores digest, and the leaves in t if not NULL, in the hash record
+    * following the current record */
+   unsigned char h;
+   long pos = (long) (fh->rstart+fh->rlen);
+
+   if( fseek(fh->fp, pos, SEEK_SET)==-1 || fread(&h, 1, 1, fh->fp)!=1 ||
+       fseek(fh->fp, pos+((h & 0x8) ? 8 : 4)+4, SEEK_SET)==-1 ||
+       fwrite(digest, 1, 16, fh->fp)!=16 ||
+       (t!=NULL && (fseek(fh->fp, 16, SEEK_CUR)==-1 ||
+                    fwrite(t->leaves, 16, t->nleaves, fh->fp)!=t->nleaves)) ||
+       fflush(fh->fp)!=0 )
+   {
+      bdio_error(1,"Error in bdio_update_record. Writing the hash record "
+                   "fails with",fh);
+      return EOF;
+   }
+   return 0;
+}
+
+
+int bdio_lazy_headers(int flag, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_lazy_headers", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_lazy_headers. Not in read mode.",fh);
+      return EOF;
+   }
+   fh->hlazy = (flag!=0);
+   return 0;
+}
+
+
+int bdio_header_catalogue(BDIO_HCAT *cat, int nmax, BDIO *fh)
+{
+   char lazy;
+   int n=0, ret;
+
+   if( !is_valid_bdio("bdio_header_catalogue", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_header_catalogue. Not in read mode.",fh);
+      return EOF;
+   }
+
+   /* the strings of the headers are not needed */
+   lazy = fh->hlazy;
+   fh->hlazy = 1;
+   if( goto_header(0, 0, 0, fh)!=0 )
+   {
+      fh->hlazy = lazy;
+      return EOF;
+   }
+   do
+   {
+      if( n<nmax )
+      {
+         cat[n].hstart = fh->hstart;
+         cat[n].rstart = fh->hend;
+         cat[n].rcnt = fh->hrcnt;
+      }
+      ret = bdio_seek_header(fh);
+      if( fh->state==BDIO_E_STATE )
+      {
+         fh->hlazy = lazy;
+         return EOF;
+      }
+      if( n<nmax )
+      {
+         /* at the end of the file fh is behind the last record */
+         cat[n].end  = (ret==EOF) ? fh->rstart+fh->rlen : fh->hstart;
+         cat[n].nrec = ((ret==EOF) ? fh->rcnt : fh->hrcnt)-cat[n].rcnt;
+      }
+      n++;
+   } while( ret!=EOF );
+
+   fh->hlazy = lazy;
+   if( goto_header(0, 0, 0, fh)!=0 )
+      return EOF;
+   return n;
+}
+
+
+int bdio_goto_header(const BDIO_HCAT *cat, int k, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_goto_header", fh) )
+   {
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_goto_header. Not in read mode.",fh);
+      return EOF;
+   }
+   if( cat==NULL || k<0 )
+   {
+      bdio_error(0, "Error in bdio_goto_header. Invalid header.",fh);
+      return EOF;
+   }
+   return goto_header(cat[k].hstart, k, cat[k].rcnt, fh);
+}
+
+
+static int jump_record(const struct bdio_iname *e, BDIO *fh)
+{
+   /* positions fh in front of record e, so that bdio_seek_record lands on
+    * it. The checksums of chains are unknown until the next checksum
+    * record has been passed */
+   if( (e->hcnt!=fh->hcnt || e->hoff!=fh->hstart) &&
+       goto_header(e->hoff, e->hcnt-1, e->hrcnt, fh)!=0 )
+      return EOF;
+   if( fseek(fh->fp, e->off, SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in jump_record. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   fh->rcnt = e->rcnt-1;
+   fh->rstart = e->off;
+   fh->rlen = 0;
+   fh->ridx = 0;
+   fh->bufstart = 0;
+   fh->bufidx = 0;
+   fh->renc = 0;
+   fh->rcplx = 0;
+   fh->state = BDIO_N_STATE;
+   if( fh->vread!=NULL )
+   {
+      fh->vread->type = 0;
+      fh->vread->lost = 1;
+   }
+   return 0;
+}
+
+static int table_find(int rcnt, const struct bdio_index *ix)
+{
+   /* index of the first entry of the record table with a number not below
+    * rcnt, ix->nr if there is none */
+   int lo, hi, mid;
+
+   lo = 0;
+   hi = ix->nr;
+   while( lo<hi )
+   {
+      mid = lo+(hi-lo)/2;
+      if( ix->r[mid].rcnt<rcnt )
+         lo = mid+1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+static int table_walk(int rcnt, BDIO *fh)
+{
+   /* reads the record headers after the current position and enters the
+    * records into the record table, up to record rcnt or, if rcnt<0, up to
+    * the end of the file */
+   struct bdio_iname e;
+   int hlazy;
+
+   hlazy = fh->hlazy;
+   fh->hlazy = 1;
+   while( (rcnt<0 || fh->rcnt<rcnt) && seek_head(fh)==0 )
+   {
+      if( fh->state!=BDIO_R_STATE )
+         continue;
+      e.off = fh->rstart;
+      e.hoff = fh->hstart;
+      e.rcnt = fh->rcnt;
+      e.hrcnt = fh->hrcnt;
+      e.hcnt = fh->hcnt;
+      e.info = fh->rfmt+16*fh->ruinfo;
+      if( index_add_record(&e, fh)!=0 )
+      {
+         fh->hlazy = hlazy;
+         return EOF;
+      }
+   }
+   fh->hlazy = hlazy;
+   return (fh->state==BDIO_E_STATE) ? EOF : 0;
+}
+
+static int table_prepend(struct bdio_iname *r, int nr, BDIO *fh)
+{
+   /* puts the nr records at r in front of the record table, r is freed */
+   struct bdio_index *ix = fh->index;
+   struct bdio_iname *t;
+
+   if( nr==0 )
+   {
+      free(r);
+      return 0;
+   }
+   if( ix->nr>0 )
+   {
+      if( r[nr-1].rcnt+1!=ix->r[0].rcnt )
+      {
+         bdio_error(0,"Error in table_prepend. Record table does not match "
+                      "the file.",fh);
+         free(r);
+         return EOF;
+      }
+      if( (t = realloc(r, (nr+ix->nr)*sizeof(struct bdio_iname)))==NULL )
+      {
+         bdio_error(1,"Error in table_prepend. realloc fails with",fh);
+         free(r);
+         return EOF;
+      }
+      r = t;
+      memcpy(r+nr, ix->r, ix->nr*sizeof(struct bdio_iname));
+   }
+   free(ix->r);
+   ix->r = r;
+   ix->nr += nr;
+   ix->nrmax = ix->nr;
+   return 0;
+}
+
+static int table_older(BDIO *fh)
+{
+   /* puts the tables of the older table blocks in front of the record
+    * table, all at once */
+   struct bdio_index *ix = fh->index;
+   struct bdio_iname *r, **blk=NULL, **nblk;
+   int *len=NULL, *nlen, nr, tot, i, n=0, ret=0;
+
+   tot = 0;
+   while( ix->prev!=0 )
+   {
+      if( (ret = load_block(ix->prev, 0, &r, &nr, &ix->prev, fh))!=0 )
+         break;
+      if( (n%16)==0 )
+      {
+         nblk = realloc(blk, (n+16)*sizeof(struct bdio_iname*));
+         nlen = realloc(len, (n+16)*sizeof(int));
+         if( nblk!=NULL )
+            blk = nblk;
+         if( nlen!=NULL )
+            len = nlen;
+         if( nblk==NULL || nlen==NULL )
+         {
+            bdio_error(1,"Error in table_older. realloc fails with",fh);
+            free(r);
+            ret = EOF;
+            break;
+         }
+      }
+      blk[n] = r;
+      len[n++] = nr;
+      tot += nr;
+   }
+   /* a block that cannot be read ends the chain, the records before it are
+    * read from the file */
+   if( ret==1 )
+   {
+      ix->prev = 0;
+      ret = 0;
+   }
+   r = NULL;
+   if( ret==0 && tot>0 && (r = malloc(tot*sizeof(struct bdio_iname)))==NULL )
+   {
+      bdio_error(1,"Error in table_older. malloc fails with",fh);
+      ret = EOF;
+   }
+   nr = 0;
+   for( i=n-1; i>=0; i-- )
+   {
+      if( r!=NULL )
+         memcpy(r+nr, blk[i], len[i]*sizeof(struct bdio_iname));
+      nr += len[i];
+      free(blk[i]);
+   }
+   free(blk);
+   free(len);
+   if( ret!=0 )
+   {
+      free(r);
+      return EOF;
+   }
+   return table_prepend(r, tot, fh);
+}
+
+static int table_cover(int rcnt, BDIO *fh)
+{
+   /* extends the record table until it holds record rcnt, if the file has
+    * one. Records in front of the table are taken from older table blocks
+    * or read from the start of the file, later ones from the file. fh is
+    * left at an undefined position. */
+   struct bdio_index *ix = fh->index;
+   struct bdio_iname *r, *head;
+   int nr, nrmax, nhead;
+
+   if( ix->nr>0 && rcnt<ix->r[0].rcnt && ix->prev!=0 && table_older(fh)!=0 )
+      return EOF;
+   if( ix->nr>0 && rcnt>ix->r[ix->nr-1].rcnt )
+   {
+      if( jump_record(ix->r+ix->nr-1, fh)!=0 || seek_head(fh)!=0 )
+         return EOF;
+      return table_walk(rcnt, fh);
+   }
+   if( ix->nr>0 && rcnt>=ix->r[0].rcnt )
+      return 0;
+
+   /* the records before the table enter a new one */
+   r = ix->r;
+   nr = ix->nr;
+   nrmax = ix->nrmax;
+   ix->r = NULL;
+   ix->nr = 0;
+   ix->nrmax = 0;
+   if( goto_header(0, 0, 0, fh)!=0 ||
+       table_walk((nr>0) ? r[0].rcnt-1 : rcnt, fh)!=0 )
+   {
+      free(ix->r);
+      ix->r = r;
+      ix->nr = nr;
+      ix->nrmax = nrmax;
+      return EOF;
+   }
+   /* the old table goes behind them */
+   ix->prev = 0;
+   head = ix->r;
+   nhead = ix->nr;
+   ix->r = r;
+   ix->nr = nr;
+   ix->nrmax = nrmax;
+   return table_prepend(head, nhead, fh);
+}
+
+static int table_skip(int fmt_mask, int uinfo_mask, BDIO *fh)
+{
+   /* positions fh in front of the next record of the record table that
+    * matches the masks or, if there is none, in front of the last record
+    * of the table. fh must be in front of or in a record of the table. */
+   struct bdio_index *ix = fh->index;
+   int lo, info;
+
+   for( lo=table_find(fh->rcnt+1, ix); lo<ix->nr-1; lo++ )
+   {
+      info = ix->r[lo].info;
+      if( ((fmt_mask>>(info & 0xf)) & 1) && ((uinfo_mask>>(info >> 4)) & 1) )
+         break;
+   }
+   return jump_record(ix->r+lo, fh);
+}
+
+int bdio_seek_next_matching(int fmt_mask, int uinfo_mask, BDIO *fh)
+{
+   struct bdio_index *ix;
+
+   if( !is_valid_bdio("bdio_seek_next_matching", fh) )
+   {
+      return EOF;
+   }
+
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_seek_next_matching. Not in read mode.",fh);
+      return EOF;
+   }
+
+   /* the record table of a closed file, see bdio_index_records, holds the
+    * format and user info of its records. Checksum records in between are
+    * needed by bdio_verify_on_read. */
+   ix = NULL;
+   if( fh->vread==NULL && fh->follow==0 )
+   {
+      if( (fh->index==NULL || !fh->index->loaded) && load_index(1, fh)!=0 )
+         return EOF;
+      ix = fh->index;
+   }
+
+   /* other records are skipped after reading their header */
+   for(;;)
+   {
+      if( ix!=NULL && ix->nr>0 && fh->rcnt+1>=ix->r[0].rcnt &&
+          fh->rcnt<ix->r[ix->nr-1].rcnt &&
+          table_skip(fmt_mask, uinfo_mask, fh)!=0 )
+         return EOF;
+      if( follow_head(fh)!=0 )
+         return EOF;
+      if( fh->state!=BDIO_R_STATE )
+         continue;
+      if( ((fmt_mask>>fh->rfmt) & 1) && ((uinfo_mask>>fh->ruinfo) & 1) )
+         return land_record(fh);
+      if( fh->vread!=NULL && fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7 )
+         vread_seek(fh);
+   }
+}
+
+
+static int is_tag(const char *name, BDIO *fh)
+{
+   /* 1 if the record fh has landed on holds exactly name */
+   size_t len = strlen(name);
+   char *buf;
+   int ret;
+
+   if( fh->state!=BDIO_R_STATE || fh->rfmt!=BDIO_ASC_GENERIC ||
+       bdio_get_rlen(fh)!=len )
+      return 0;
+   if( (buf = malloc(len))==NULL )
+   {
+      bdio_error(1,"Error in is_tag. malloc fails with",fh);
+      return EOF;
+   }
+   ret = (bdio_read(buf, len, fh)==len && memcmp(buf, name, len)==0);
+   free(buf);
+   return ret;
 }
 
+static int seek_tagged(BDIO *fh)
+{
+   /* moves from the tag record to the record it labels */
+   do
+   {
+      if( bdio_seek_record(fh)!=0 )
+         return EOF;
+   }
+   while( fh->state!=BDIO_R_STATE ||
+          (fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7) );
+   return 0;
+}
 
-int bdio_close(BDIO *fh)
+int bdio_seek_named(const char *name, BDIO *fh)
 {
-   int ret;
-   if( !is_valid_bdio("bdio_close", fh) )
+   struct bdio_index *ix;
+   struct bdio_iname *e;
+   int lo, hi, mid, ret;
+
+   if( !is_valid_bdio("bdio_seek_named", fh) )
    {
-      if( fh==NULL )
+      return EOF;
+   }
+   if( fh->mode != BDIO_R_MODE )
+   {
+      bdio_error(0, "Error in bdio_seek_named. Not in read mode.",fh);
+      return EOF;
+   }
+   if( name==NULL )
+   {
+      bdio_error(0, "Error in bdio_seek_named. No name given.",fh);
+      return EOF;
+   }
+   if( (fh->index==NULL || !fh->index->loaded) && load_index(1, fh)!=0 )
+      return EOF;
+   ix = fh->index;
+
+   /* files without an index are searched record by record */
+   if( ix->n==0 )
+   {
+      if( goto_header(0, 0, 0, fh)!=0 )
          return EOF;
-      else
+      while( bdio_seek_next_matching(1<<BDIO_ASC_GENERIC, BDIO_MATCH_ALL,
+                                     fh)==0 )
       {
-         bdio_error(0,"Error in bdio_close. Stream is in error state.",fh);
-         ret = fclose( fh->fp );
-         if( ret==EOF )
-            bdio_error(1,"Error in bdio_close. fclose fails with",fh);
-         if( fh->hcuser!=0 )
-            free( fh->hcuser );
-         if( fh->buf!=0 )
-            free( fh->buf );
-         fh->state = -1;
-         free( fh );
-         return EOF;
+         if( (ret = is_tag(name, fh))!=0 )
+            return (ret==1) ? seek_tagged(fh) : EOF;
       }
+      return EOF;
    }
-   if( (fh->mode == BDIO_W_MODE)  || (fh->mode == BDIO_A_MODE) )
+
+   /* first entry of the name */
+   lo = 0;
+   hi = ix->n;
+   while( lo<hi )
    {
-      if( bdio_flush_record( fh )!=0)
-      {
-         bdio_error(0,"Error in bdio_close. Could not flush.",fh);
-         ret = fclose( fh->fp );
-         if( ret==EOF )
-            bdio_error(1,"Error in bdio_close. fclose fails with",fh);
-         free( fh->hcuser );
-         free( fh->buf );
-         fh->state = -1;
-         free( fh );
-         return EOF;
-      }
+      mid = lo+(hi-lo)/2;
+      if( strcmp(ix->e[mid].name, name)<0 )
+         lo = mid+1;
+      else
+         hi = mid;
    }
-   ret = fclose( fh->fp );
-   if( ret==EOF )
+   if( lo==ix->n || strcmp(ix->e[lo].name, name)!=0 )
+      return EOF;
+   e = ix->e+lo;
+
+   if( jump_record(e, fh)!=0 )
+      return EOF;
+   if( bdio_seek_record(fh)!=0 || (ret = is_tag(name, fh))==EOF )
+      return EOF;
+   if( ret==0 )
    {
-      bdio_error(1,"Error in bdio_close. fclose fails with",fh);
-      free( fh->hcuser );
-      free( fh->buf );
-      fh->state = -1;
-      free( fh );
+      bdio_error(0,"Error in bdio_seek_named. Index does not match the "
+                   "tag record.",fh);
       return EOF;
    }
-   free( fh->hcuser );
-   free( fh->buf );
-   fh->state = -1;
-   free( fh );
-   return ret;
+   return seek_tagged(fh);
 }
 
-void bdio_set_user(char* u)
+
+static int goto_record(int rcnt, BDIO *fh)
 {
-   int len;
-   len = strlen(u)+1;
-   if( len < BDIO_MAX_USER_LENGTH )
-   {
-      strcpy(user_str,u);
-   }
-   else
+   /* lands on record rcnt through the record table, EOF if there is none.
+    * Records missing in the table are read once and enter it, so that
+    * going there again jumps at once. */
+   struct bdio_index *ix;
+   int i;
+
+   if( (fh->index==NULL || !fh->index->loaded) && load_index(1, fh)!=0 )
+      return EOF;
+   ix = fh->index;
+   i = table_find(rcnt, ix);
+   if( i==ix->nr || ix->r[i].rcnt!=rcnt )
    {
-      strncpy(user_str,u,BDIO_MAX_USER_LENGTH-1);
-      user_str[BDIO_MAX_USER_LENGTH-1]='\0';
+      if( table_cover(rcnt, fh)!=0 )
+         return EOF;
+      i = table_find(rcnt, ix);
+      if( i==ix->nr || ix->r[i].rcnt!=rcnt )
+         return EOF;
    }
+   if( jump_record(ix->r+i, fh)!=0 )
+      return EOF;
+   return bdio_seek_record(fh);
 }
 
-void bdio_set_host(char* u)
+int bdio_seek_prev_record(BDIO *fh)
 {
-   int len;
-   len = strlen(u)+1;
-   if( len < BDIO_MAX_HOST_LENGTH )
+   int rcnt;
+
+   if( !is_valid_bdio("bdio_seek_prev_record", fh) )
    {
-      strcpy(host_str,u);
+      return EOF;
    }
-   else
+   if( fh->mode != BDIO_R_MODE )
    {
-      strncpy(host_str,u,BDIO_MAX_HOST_LENGTH-1);
-      host_str[BDIO_MAX_HOST_LENGTH-1]='\0';
+      bdio_error(0, "Error in bdio_seek_prev_record. Not in read mode.",fh);
+      return EOF;
    }
+   rcnt = (fh->state==BDIO_R_STATE) ? fh->rcnt-1 : fh->rcnt;
+   if( rcnt<1 )
+      return EOF;
+   return goto_record(rcnt, fh);
 }
 
 
-void bdio_set_dflt_msg(FILE *stream)
+int bdio_update_record(int recno, uint64_t offset, const void *data,
+                       size_t nb, BDIO *fh)
 {
-   if( stream != NULL )
-      default_msg = stream;
-}
+   struct bdio_hash_tree t;
+   unsigned char prev[16], stored[16], dig[16], h[16];
+   unsigned char *tbuf=NULL;
+   uint64_t tsize=0, tlen;
+   int type, chain, hl, k, ret=EOF;
 
-void bdio_set_dflt_verbose(int v)
-{
-   if( v==0 )
+   if( !is_valid_bdio("bdio_update_record", fh) )
    {
-      default_verbosity=0;
-   } else
-      default_verbosity=1;
-   return;
-}
+      return EOF;
+   }
+   if( !fh->upd )
+   {
+      bdio_error(0,"Error in bdio_update_record. Not in update mode.",fh);
+      return EOF;
+   }
 
-int bdio_set_verbose(int v, BDIO *fh)
-{
-   if( !is_valid_bdio("bdio_set_verbose", fh) )
+   /* the record is found through the record table, see goto_record */
+   if( recno<1 || goto_record(recno, fh)!=0 || fh->rcnt!=recno )
    {
+      if( fh->state!=BDIO_E_STATE )
+         bdio_error(0,"Error in bdio_update_record. No such record.",fh);
       return EOF;
    }
-   if( v==0 )
+   hl = data_start(fh);
+   if( fh->renc || (fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7) )
    {
-      fh->verbose = 0;
-      return 0;
+      bdio_error(0,"Error in bdio_update_record. Encoded records and hash "
+                   "records can not be updated.",fh);
+      return EOF;
    }
-   if( v>0 )
+   if( offset+nb > fh->rlen-hl )
    {
-      fh->verbose = 1;
-      return 0;
+      bdio_error(0,"Error in bdio_update_record. Data exceeds the record.",
+                 fh);
+      return EOF;
    }
-   bdio_error(0,"Error in bdio_set_verbose. Argument out of range",fh);
-   return EOF;
-}
 
-int bdio_set_msg(FILE *stream, BDIO *fh)
-{
-   if( !is_valid_bdio("bdio_set_verbose", fh) )
+   type = peek_hash_record(&chain, stored, &tbuf, &tsize, &tlen, fh);
+
+   /* a chain of checksums continues with the one of the last hash record
+    * before the record, chains do not continue across headers */
+   memset(prev, 0, 16);
+   if( type!=0 && chain )
    {
-      return EOF;
+      for( k=recno-1; k>fh->hrcnt; k-- )
+      {
+         if( goto_record(k, fh)!=0 )
+            goto done;
+         if( bdio_is_hash_record(prev, fh)!=0 )
+            break;
+      }
+      if( goto_record(recno, fh)!=0 )
+         goto done;
    }
-   if( stream != NULL)
+
+   if( fseek(fh->fp, (long) (fh->rstart+hl+offset), SEEK_SET)==-1 ||
+       fwrite(data, 1, nb, fh->fp)!=nb || fflush(fh->fp)!=0 )
    {
-      fh->msg = stream;
-      return 0;
-   }else
-      bdio_error(0,"Error in bdio_set_msg. NULL is an invalid stream.\n"
-                   "Use set_verbose to turn off error output.",fh);
-   return EOF;
+      bdio_error(1,"Error in bdio_update_record. fwrite fails with",fh);
+      fh->state = BDIO_E_STATE;
+      goto done;
+   }
+
+   memset(&t, 0, sizeof(t));
+   ret = 0;
+   while( type!=0 )
+   {
+      ret = EOF;
+      if( tlen>0 )
+      {
+         t.chunk = get_uint32(tbuf+24);
+         if( digest_record(type, NULL, &t, dig, fh)!=0 ||
+             36+16*(uint64_t) t.nleaves!=tlen ||
+             write_digest(dig, &t, fh)!=0 )
+            break;
+      }else if( digest_record(type, chain ? prev : NULL, NULL, dig, fh)!=0 ||
+                write_digest(dig, NULL, fh)!=0 )
+         break;
+      ret = 0;
+      if( memcmp(dig, stored, 16)==0 )
+         break;
+
+      /* the chain continues with the next record if its checksum was
+       * computed with the old checksum of this one */
+      memcpy(h, stored, 16);
+      memcpy(prev, dig, 16);
+      if( fseek(fh->fp, (long) (fh->rstart+fh->ridx), SEEK_SET)==-1 )
+      {
+         ret = EOF;
+         break;
+      }
+      while( bdio_seek_record(fh)!=EOF && bdio_is_hash_record(dig, fh) );
+      if( fh->state!=BDIO_R_STATE )
+         break;
+      type = peek_hash_record(&chain, stored, &tbuf, &tsize, &tlen, fh);
+      if( type==0 || !chain )
+         break;
+      if( digest_record(type, h, NULL, dig, fh)!=0 )
+      {
+         ret = EOF;
+         break;
+      }
+      if( memcmp(dig, stored, 16)!=0 )
+         break;
+   }
+   free(t.leaves);
+   free(t.stage);
+
+done:
+   free(tbuf);
+   /* continue reading at the start of the current record */
+   if( fh->state==BDIO_R_STATE &&
+       fseek(fh->fp, (long) (fh->rstart+fh->ridx), SEEK_SET)==-1 )
+   {
+      bdio_error(1,"Error in bdio_update_record. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
+      ret = EOF;
+   }
+   return ret;
 }
 
-char* bdio_get_hchost(BDIO *fh)
+
+BDIO *bdio_open_tail(const char *file, int k)
 {
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   BDIO *fh;
+   struct bdio_index *ix;
+   struct bdio_iname *ring;
+   int n, hlazy, ret;
+
+   if( (fh = bdio_open(file, "r", NULL))==NULL )
+      return NULL;
+   if( k<1 )
    {
+      bdio_error(0,"Error in bdio_open_tail. k must be positive.",fh);
+      bdio_close(fh);
       return NULL;
    }
-   return fh->hchost;
-}
+   if( load_index(1, fh)!=0 )
+   {
+      bdio_close(fh);
+      return NULL;
+   }
+   ix = fh->index;
 
-char* bdio_get_hcuser(BDIO *fh)
-{
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   /* with a record table only the records after it, if it was read from a
+    * table block, and the table blocks before the last k records are read */
+   if( ix->nr>0 )
    {
+      if( ix->walk )
+      {
+         if( jump_record(ix->r+ix->nr-1, fh)!=0 || seek_head(fh)!=0 ||
+             table_walk(-1, fh)!=0 )
+         {
+            bdio_close(fh);
+            return NULL;
+         }
+         ix->walk = 0;
+      }
+      n = ix->r[ix->nr-1].rcnt-k+1;
+      if( n>1 && n<ix->r[0].rcnt && table_cover(n, fh)!=0 )
+      {
+         bdio_close(fh);
+         return NULL;
+      }
+      if( (n>1) ? jump_record(ix->r+table_find(n, ix), fh) :
+                  goto_header(0, 0, 0, fh) )
+      {
+         bdio_close(fh);
+         return NULL;
+      }
+      return fh;
+   }
+
+   /* otherwise the record headers are read and the last k positions kept */
+   if( (ring = malloc(k*sizeof(struct bdio_iname)))==NULL )
+   {
+      bdio_error(1,"Error in bdio_open_tail. malloc fails with",fh);
+      bdio_close(fh);
       return NULL;
    }
-   return fh->hcuser;
+   n = 0;
+   hlazy = fh->hlazy;
+   fh->hlazy = 1;
+   while( (ret = seek_head(fh))==0 )
+   {
+      if( fh->state!=BDIO_R_STATE )
+         continue;
+      ring[n%k].off = fh->rstart;
+      ring[n%k].hoff = fh->hstart;
+      ring[n%k].rcnt = fh->rcnt;
+      ring[n%k].hrcnt = fh->hrcnt;
+      ring[n%k].hcnt = fh->hcnt;
+      n++;
+   }
+   fh->hlazy = hlazy;
+   if( fh->state==BDIO_E_STATE ||
+       ((n>k) ? jump_record(ring+n%k, fh) : goto_header(0, 0, 0, fh))!=0 )
+   {
+      free(ring);
+      bdio_close(fh);
+      return NULL;
+   }
+   free(ring);
+   return fh;
 }
 
-char* bdio_get_hmhost(BDIO *fh)
+size_t bdio_read_f32(float *buf, size_t nb, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   size_t rd;
+   if(   (fh->rfmt != BDIO_BIN_F32BE) && (fh->rfmt != BDIO_BIN_F32LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
    {
-      return NULL;
+      bdio_error(0,"Error in bdio_read_f32. Record has incompatible format",fh);
+      return(0);
    }
-   return fh->hmhost;
+   rd=bdio_read((void*) buf, nb, fh);
+   if( fh->rswap )
+      swap32(buf, rd);
+   return rd;
 }
 
-char* bdio_get_hmuser(BDIO *fh)
+size_t bdio_read_f64(double *buf, size_t nb, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   size_t rd;
+   if(   (fh->rfmt != BDIO_BIN_F64BE) && (fh->rfmt != BDIO_BIN_F64LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
    {
-      return NULL;
+      bdio_error(0,"Error in bdio_read_f64. Record has incompatible format",fh);
+      return(0);
    }
-   return fh->hmuser;
+   rd=bdio_read((void*) buf, nb, fh);
+   if( fh->rswap )
+      swap64(buf, rd);
+   return rd;
 }
 
-char* bdio_get_hpinfo(BDIO *fh)
+size_t bdio_read_int32(int32_t *buf, size_t nb, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   size_t rd;
+   if(   (fh->rfmt != BDIO_BIN_INT32BE) && (fh->rfmt != BDIO_BIN_INT32LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
    {
-      return NULL;
+      bdio_error(0,"Error in bdio_read_i32. Record has incompatible format",fh);
+      return(0);
    }
-   return fh->hpinfo;
+   rd=bdio_read((void*) buf, nb, fh);
+   if( fh->rswap )
+      swap32(buf, rd);
+   return rd;
 }
 
-int bdio_get_hversion(BDIO *fh)
+size_t bdio_read_int64(int64_t *buf, size_t nb, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_hversion", fh) )
+   size_t rd;
+   if(   (fh->rfmt != BDIO_BIN_INT64BE) && (fh->rfmt != BDIO_BIN_INT64LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
    {
-      return EOF;
+      bdio_error(0,"Error in bdio_read_i64. Record has incompatible format",fh);
+      return(0);
    }
-   return fh->hversion;
+   rd=bdio_read((void*) buf, nb, fh);
+   if( fh->rswap )
+      swap64(buf, rd);
+   return rd;
+}
+
+
+/* loaders of the conversion loops, swapping the byte order with shifts
+ * and masks one number at a time */
+static uint32_t load32(const unsigned char *p, int swap)
+{
+   uint32_t x;
+
+   memcpy(&x, p, 4);
+   if( swap )
+      x = (x >> 24) | ((x >> 8) & 0xff00U) | ((x << 8) & 0xff0000U) | (x << 24);
+   return x;
 }
-   
-int bdio_get_hcnt(BDIO *fh)
+
+static uint64_t load64(const unsigned char *p, int swap)
 {
-   if( !is_valid_bdio("bdio_get_hcnt", fh) )
-   {
-      return EOF;
-   }
-   return fh->hcnt;
+   uint64_t x;
+
+   memcpy(&x, p, 8);
+   if( swap )
+      x = ((uint64_t) load32(p, 1) << 32) | load32(p+4, 1);
+   return x;
 }
 
-int bdio_get_hcdate(BDIO *fh)
+static void cvt_to_f64(double *d, const unsigned char *s, size_t n, int fmt,
+                       int swap)
 {
-   if( !is_valid_bdio("bdio_get_hcdate", fh) )
-   {
-      return EOF;
-   }
-   return fh->hcdate;
+   size_t i;
+   uint32_t u;
+   uint64_t v;
+   int32_t k;
+   int64_t l;
+   float f;
+   double g;
+
+   if( fmt==BDIO_BIN_INT32BE || fmt==BDIO_BIN_INT32LE )
+      for( i=0; i<n; i++ )
+      {
+         u = load32(s+4*i, swap);
+         memcpy(&k, &u, 4);
+         d[i] = (double) k;
+      }
+   else if( fmt==BDIO_BIN_F32BE || fmt==BDIO_BIN_F32LE )
+      for( i=0; i<n; i++ )
+      {
+         u = load32(s+4*i, swap);
+         memcpy(&f, &u, 4);
+         d[i] = (double) f;
+      }
+   else if( fmt==BDIO_BIN_INT64BE || fmt==BDIO_BIN_INT64LE )
+      for( i=0; i<n; i++ )
+      {
+         v = load64(s+8*i, swap);
+         memcpy(&l, &v, 8);
+         d[i] = (double) l;
+      }
+   else
+      for( i=0; i<n; i++ )
+      {
+         v = load64(s+8*i, swap);
+         memcpy(&g, &v, 8);
+         d[i] = g;
+      }
 }
 
-int bdio_get_hmdate(BDIO *fh)
+static void cvt_to_f32(float *d, const unsigned char *s, size_t n, int fmt,
+                       int swap)
 {
-   if( !is_valid_bdio("bdio_get_hmdate", fh) )
-   {
-      return EOF;
-   }
-   return fh->hmdate;
+   size_t i;
+   uint32_t u;
+   uint64_t v;
+   int32_t k;
+   int64_t l;
+   float f;
+   double g;
+
+   if( fmt==BDIO_BIN_INT32BE || fmt==BDIO_BIN_INT32LE )
+      for( i=0; i<n; i++ )
+      {
+         u = load32(s+4*i, swap);
+         memcpy(&k, &u, 4);
+         d[i] = (float) k;
+      }
+   else if( fmt==BDIO_BIN_F32BE || fmt==BDIO_BIN_F32LE )
+      for( i=0; i<n; i++ )
+      {
+         u = load32(s+4*i, swap);
+         memcpy(&f, &u, 4);
+         d[i] = f;
+      }
+   else if( fmt==BDIO_BIN_INT64BE || fmt==BDIO_BIN_INT64LE )
+      for( i=0; i<n; i++ )
+      {
+         v = load64(s+8*i, swap);
+         memcpy(&l, &v, 8);
+         d[i] = (float) l;
+      }
+   else
+      for( i=0; i<n; i++ )
+      {
+         v = load64(s+8*i, swap);
+         memcpy(&g, &v, 8);
+         d[i] = (float) g;
+      }
 }
 
-int bdio_get_ruinfo(BDIO *fh)
+static int is_half_fmt(int fmt)
 {
-   if( !is_valid_bdio("bdio_get_ruinfo", fh) )
-   {
-      return EOF;
-   }
-   if( fh->state == BDIO_R_STATE )
-      return fh->ruinfo;
-   bdio_error(0, "Error in bdio_get_ruinfo. Currently not in a data record.",fh);
-   return EOF;
+   return (fmt==BDIO_BIN_F16BE  || fmt==BDIO_BIN_F16LE ||
+           fmt==BDIO_BIN_BF16BE || fmt==BDIO_BIN_BF16LE);
 }
 
-int bdio_get_rfmt(BDIO *fh)
+static size_t read_half(float *d, size_t n, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_rtype", fh) )
-   {
-      return EOF;
-   }
-   if( fh->state == BDIO_R_STATE )
-      return fh->rfmt;
-   bdio_error(0, "Error in bdio_get_rfmt. Currently not in a data record.",fh);
-   return EOF;
+   /* reads at most BDIO_CVT_CHUNK/4 numbers of a 16 bit format */
+   uint16_t h[BDIO_CVT_CHUNK/4];
+   size_t rd;
+
+   rd = bdio_read(h, 2*n, fh)/2;
+   if( fh->rswap )
+      swap16(h, 2*rd);
+   if( fh->rfmt==BDIO_BIN_F16BE || fh->rfmt==BDIO_BIN_F16LE )
+      HALF_F16ToF32(h, d, rd);
+   else
+      HALF_BF16ToF32(h, d, rd);
+   return rd;
 }
 
-uint64_t bdio_get_rlen(BDIO *fh)
+static size_t read_as(void *buf, int size, size_t n, const char *caller,
+                      BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_rlen", fh) )
+   /* reads n numbers of any numeric format in pieces that stay in the
+    * cache and converts them to double (size 8) or float (size 4) */
+   unsigned char tmp[BDIO_CVT_CHUNK];
+   float f[BDIO_CVT_CHUNK/4];
+   uint64_t left=0;
+   size_t nc, rd, i, done=0;
+   int rs;
+
+   if( !is_valid_bdio(caller, fh) )
    {
-      return EOF;
+      return 0;
    }
-   if( fh->state == BDIO_R_STATE )
+   if(   fh->rfmt!=BDIO_BIN_INT32BE && fh->rfmt!=BDIO_BIN_INT32LE
+      && fh->rfmt!=BDIO_BIN_INT64BE && fh->rfmt!=BDIO_BIN_INT64LE
+      && fh->rfmt!=BDIO_BIN_F32BE   && fh->rfmt!=BDIO_BIN_F32LE
+      && fh->rfmt!=BDIO_BIN_F64BE   && fh->rfmt!=BDIO_BIN_F64LE
+      && !is_half_fmt(fh->rfmt) )
+   {
+      bdio_error(0, (size==8) ?
+                 "Error in bdio_read_as_f64. Record is not numeric." :
+                 "Error in bdio_read_as_f32. Record is not numeric.",fh);
+      return 0;
+   }
+   rs = fh->rdsize;
+   /* the end of the record limits n */
+   if( fh->state==BDIO_R_STATE && fh->renc )
+      left = fh->enc->llen-fh->enc->lidx;
+   else if( fh->state==BDIO_R_STATE )
+      left = fh->rlen-fh->ridx;
+   if( n>left/rs )
+      n = left/rs;
+   while( done<n && rs==2 )
+   {
+      nc = (n-done < BDIO_CVT_CHUNK/4) ? n-done : BDIO_CVT_CHUNK/4;
+      if( size==8 )
+      {
+         rd = read_half(f, nc, fh);
+         for( i=0; i<rd; i++ )
+            ((double*) buf)[done+i] = f[i];
+      }else
+         rd = read_half((float*) buf+done, nc, fh);
+      done += rd;
+      if( rd<nc )
+         break;
+   }
+   while( done<n && rs!=2 )
    {
-      if ( fh->rlongrec )
-         return fh->rlen-8;
+      nc = (n-done < BDIO_CVT_CHUNK/rs) ? n-done : BDIO_CVT_CHUNK/rs;
+      rd = bdio_read(tmp, nc*rs, fh)/rs;
+      if( size==8 )
+         cvt_to_f64((double*) buf+done, tmp, rd, fh->rfmt, fh->rswap);
       else
-         return fh->rlen-4;
+         cvt_to_f32((float*) buf+done, tmp, rd, fh->rfmt, fh->rswap);
+      done += rd;
+      if( rd<nc )
+         break;
    }
-   return 0;
+   return done;
 }
-   
-int bdio_get_rcnt(BDIO *fh)
+
+size_t bdio_read_as_f64(double *buf, size_t n, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_get_rcnt", fh) )
-   {
-      return EOF;
-   }
-   return fh->rcnt;
+   return read_as(buf, 8, n, "bdio_read_as_f64", fh);
 }
 
-int bdio_is_in_record(BDIO *fh)
+size_t bdio_read_as_f32(float *buf, size_t n, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_is_in_record", fh) )
-   {
-      return 0;
-   }
-   if( fh->state == BDIO_R_STATE )
-      return 1;
-   else
-      return 0;
+   return read_as(buf, 4, n, "bdio_read_as_f32", fh);
 }
 
-int bdio_is_in_header(BDIO *fh)
+size_t bdio_read_f16_as_f32(float *buf, size_t n, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_is_in_header", fh) )
+   if( !is_valid_bdio("bdio_read_f16_as_f32", fh) )
    {
       return 0;
    }
-   if( fh->state == BDIO_H_STATE )
-      return 1;
-   else
+   if( !is_half_fmt(fh->rfmt) )
+   {
+      bdio_error(0,"Error in bdio_read_f16_as_f32. Record has incompatible "
+                   "format",fh);
       return 0;
+   }
+   return read_as(buf, 4, n, "bdio_read_f16_as_f32", fh);
 }
 
-
-
-
-int bdio_append_record(int fmt, int uinfo, BDIO *fh)
+static size_t read_strided(void *dst, int size, uint64_t first, size_t count,
+                           size_t stride, const char *caller, BDIO *fh)
 {
-   if( !is_valid_bdio("bdio_append_record", fh) )
-   {
-      return EOF;
-   }
+   /* gathers count numbers, every stride-th from number first on. Spans of
+    * up to BDIO_CVT_CHUNK bytes are read at once and the numbers picked from
+    * them; larger gaps are skipped with bdio_seek_in_record. */
+   unsigned char tmp[BDIO_CVT_CHUNK];
+   unsigned char *p = (unsigned char*) dst;
+   size_t done=0, k, i, step;
+   char msg[80];
 
-   if( (fh->mode != BDIO_W_MODE)  && (fh->mode != BDIO_A_MODE) )
-   {
-      bdio_error(0,
-                "Error in bdio_append_record. Not in write or append mode.",fh);
-      return EOF;
-   }
-   
-   if( fh->state != BDIO_N_STATE )
+   if( !is_valid_bdio(caller, fh) )
    {
-      bdio_error(0,"Error in bdio_append_record. Not at the end of file.",fh);
-      return EOF;
+      return 0;
    }
-
-   if( fh->rstart == fh->hstart )
+   if( fh->state!=BDIO_R_STATE || fh->rdsize!=size || fh->rcplx )
    {
-      bdio_error(0,"Error in bdio_append_record. Last entry in file is not a"
-                   " record.",fh);
-      return EOF;
+      sprintf(msg, "Error in %s. Record has incompatible format", caller);
+      bdio_error(0, msg, fh);
+      return 0;
    }
-
-   /* assume that meta-data of last record are still up to date despite of
-    * being in N-state
-    */
-   if( fh->ruinfo != uinfo )
+   if( count==0 )
+      return 0;
+   if( stride==0 || first+(uint64_t) (count-1)*stride >= bdio_get_rlen(fh)/size )
    {
-      bdio_error(0,"Error in bdio_append_record. uinfo does not "
-                   "match previous record's.",fh);
-      return EOF;
+      sprintf(msg, "Error in %s. Numbers beyond the end of the record.",
+              caller);
+      bdio_error(0, msg, fh);
+      return 0;
    }
-   /* TODO: typen ohne endianness: check ob sie zur maschine passen */
-   if( fmt != fh->rfmt )
-   {
-      if( ! (  (fmt==BDIO_BIN_INT32 &&
-               ((fh->rfmt==BDIO_BIN_INT32BE)||(fh->rfmt==BDIO_BIN_INT32LE)) )
-             ||(fmt==BDIO_BIN_INT64 &&
-               ((fh->rfmt==BDIO_BIN_INT64BE)||(fh->rfmt==BDIO_BIN_INT64LE)) )
-             ||(fmt==BDIO_BIN_F32 &&
-               ((fh->rfmt==BDIO_BIN_F32BE)||(fh->rfmt==BDIO_BIN_F32LE)) )
-             ||(fmt==BDIO_BIN_F64 &&
-               ((fh->rfmt==BDIO_BIN_F64BE)||(fh->rfmt==BDIO_BIN_F64LE)) ) )
-        )
-      {
-         bdio_error(0,"Error in bdio_append_record. fmt does not match"
-                      " previous record's.",fh);
-         return EOF;
-      }
+   if( bdio_seek_in_record((int64_t) (first*size), SEEK_SET, fh)!=0 )
+      return 0;
+   step = stride*size;
+   while( done<count )
+   {
+      if( done>0 &&
+          bdio_seek_in_record((int64_t) (step-size), SEEK_CUR, fh)!=0 )
+         break;
+      /* numbers in the next span, the last one is read up to its end */
+      k = (step<=BDIO_CVT_CHUNK-size) ? (BDIO_CVT_CHUNK-size)/step+1 : 1;
+      if( k>count-done )
+         k = count-done;
+      if( bdio_read(tmp, (k-1)*step+size, fh)!=(k-1)*step+size )
+         break;
+      if( size==8 )
+         for( i=0; i<k; i++ )
+            memcpy(p+8*(done+i), tmp+i*step, 8);
+      else
+         for( i=0; i<k; i++ )
+            memcpy(p+4*(done+i), tmp+i*step, 4);
+      if( fh->rswap )
+         swap_data(p+size*done, k*size, size);
+      done += k;
    }
-   fh->state = BDIO_R_STATE;
-   fh->bufstart = fh->rlen;
-   fh->bufidx = 0;
-   return 0;
+   return done;
 }
 
+size_t bdio_read_strided_f64(double *dst, uint64_t first, size_t count,
+                             size_t stride, BDIO *fh)
+{
+   return read_strided(dst, 8, first, count, stride, "bdio_read_strided_f64",
+                       fh);
+}
 
-int bdio_seek_record(BDIO *fh)
+size_t bdio_read_strided_f32(float *dst, uint64_t first, size_t count,
+                             size_t stride, BDIO *fh)
 {
-   int rd;
-   uint32_t hdr;
-   uint64_t lhdr;
-   if( !is_valid_bdio("bdio_seek_record", fh) )
-   {
-      return EOF;
-   }
+   return read_strided(dst, 4, first, count, stride, "bdio_read_strided_f32",
+                       fh);
+}
 
-   if( fh->mode != BDIO_R_MODE )
-   {
-      bdio_error(0, "Error in bdio_seek_record. Not in read mode.",fh);
-      return EOF;
-   }
-   
-   if( (fh->state == BDIO_R_STATE) || (fh->state == BDIO_H_STATE))
-   {
-      if( fseek(fh->fp, fh->rlen-fh->ridx, SEEK_CUR)==-1 )
-      {
-         bdio_error(1,"Error in bdio_seek_record. fseek fails with",fh);
-         fh->state = BDIO_E_STATE;
-         return EOF;
-      }
-      fh->ridx = fh->rlen;
-   }
+size_t bdio_read_strided_int64(int64_t *dst, uint64_t first, size_t count,
+                               size_t stride, BDIO *fh)
+{
+   return read_strided(dst, 8, first, count, stride,
+                       "bdio_read_strided_int64", fh);
+}
 
-   
-   /* read the header of the following record*/
-   rd = fread( fh->buf, 1, 4, fh->fp);
-   if ( feof( fh->fp ) )
-   {
-      /* clean EOF reached */
-      clearerr( fh->fp );
-      fh->state = BDIO_N_STATE;
-      return EOF;
-   }
-   if ( rd != 4 )
-   {
-      bdio_error(1,"Error in bdio_seek_record. fread fails with.",fh);
-      fh->state = BDIO_E_STATE;
-      return EOF;
-   }
-   fh->rstart = fh->rstart+fh->rlen;
-   fh->ridx=4;
-   memcpy(&hdr,fh->buf,4);
-   if (fh->endian == BDIO_BEND)
-         swap32(&hdr,4);
-   while( !(hdr & 0x00000001) )
-   {
-      /* must be a header */
-      if( read_header(fh) != 0 )
-      {
-         fh->state = BDIO_E_STATE;
-         return EOF;
-      }
-      /* seek next record */
-      if( fseek(fh->fp, fh->rlen-fh->ridx, SEEK_CUR)==-1 )
-      {
-         bdio_error(1,"Error in bdio_seek_record. fseek failed with",fh);
-         fh->state = BDIO_E_STATE;
-         return EOF;
-      }
-      fh->ridx=fh->rlen;
-      /* read the header of the following record (version 2 in the notes) */
-      rd = fread( fh->buf, 1, 4, fh->fp);
-      if ( feof( fh->fp ) )
-      {
-         /* clean EOF reached */
-         clearerr( fh->fp );
-         fh->state = BDIO_N_STATE;
-         return 0;
-      }
-      if ( rd != 4 )
-      {
-         bdio_error(1,"Error in bdio_seek_record. fread fails with",fh);
-         fh->state = BDIO_E_STATE;
-         return EOF;
-      }
-      memcpy(&hdr,fh->buf,4);
-      if (fh->endian == BDIO_BEND)
-         swap32(&hdr,4);
-      fh->rstart = fh->rstart+fh->rlen;
-      fh->ridx = 4;
-   }
-   /* can only be a data record */
-   fh->rcnt++;
-   fh->rlongrec = (hdr & 0x00000008)>>3;
-   if (fh->rlongrec )
-   {
-      /* need next 4 bytes to determine length */
-      rd = fread( &(fh->buf[4]), 1, 4, fh->fp);
-      if ( feof( fh->fp ) )
+size_t bdio_read_strided_int32(int32_t *dst, uint64_t first, size_t count,
+                               size_t stride, BDIO *fh)
+{
+   return read_strided(dst, 4, first, count, stride,
+                       "bdio_read_strided_int32", fh);
+}
+
+static void cplx_from_file(const unsigned char *s, unsigned char *re,
+                           unsigned char *im, int size, size_t step, size_t n,
+                           int swap)
+{
+   /* distributes n complex numbers to re and im, which advance by step
+    * bytes per number */
+   size_t i;
+   uint64_t x;
+   uint32_t y;
+
+   if( size==8 )
+      for( i=0; i<n; i++ )
       {
-         bdio_error(1,"Error in bdio_seek_record. Unexpected EOF.",fh);
-         fh->state = BDIO_E_STATE;
-         return EOF;
+         x = load64(s+16*i, swap);
+         memcpy(re+i*step, &x, 8);
+         x = load64(s+16*i+8, swap);
+         memcpy(im+i*step, &x, 8);
       }
-      if ( rd != 4 )
+   else
+      for( i=0; i<n; i++ )
       {
-         bdio_error(1,"Error in bdio_seek_record. fread fails with",fh);
-         fh->state = BDIO_E_STATE;
-         return EOF;
+         y = load32(s+8*i, swap);
+         memcpy(re+i*step, &y, 4);
+         y = load32(s+8*i+4, swap);
+         memcpy(im+i*step, &y, 4);
       }
-      memcpy(&lhdr, fh->buf, 8);
-      if (fh->endian == BDIO_BEND)
-         swap64(&lhdr,8);
-      fh->rfmt     =  (int) ((lhdr & 0x00000000000000f0)>>4);
-      fh->ruinfo   =  (int) ((lhdr & 0x0000000000000f00)>>8);
-      fh->rlen     = ((lhdr & 0xfffffffffffff000)>>12) + 8;
-      fh->ridx     = 8;
-   }else
-   {
-      fh->rfmt     =  (hdr & 0x000000f0)>>4;
-      fh->ruinfo   =  (hdr & 0x00000f00)>>8;
-      fh->rlen     = ((hdr & 0xfffff000)>>12) + 4;
-   }
+}
 
-   /* find out whether on this machine swapping of the byte order will be
-    * necessary after reading from disk
-    */
-   fh->rswap=0;
-   if(  ((fh->rfmt==BDIO_BIN_INT32LE) && (fh->endian==BDIO_BEND))
-      ||((fh->rfmt==BDIO_BIN_INT32BE) && (fh->endian==BDIO_LEND))
-      ||((fh->rfmt==BDIO_BIN_F32LE)   && (fh->endian==BDIO_BEND))
-      ||((fh->rfmt==BDIO_BIN_F32BE)   && (fh->endian==BDIO_LEND))
-      ||((fh->rfmt==BDIO_BIN_INT64LE) && (fh->endian==BDIO_BEND))
-      ||((fh->rfmt==BDIO_BIN_INT64BE) && (fh->endian==BDIO_LEND))
-      ||((fh->rfmt==BDIO_BIN_F64LE)   && (fh->endian==BDIO_BEND))
-      ||((fh->rfmt==BDIO_BIN_F64BE)   && (fh->endian==BDIO_LEND)) )
+static size_t read_complex(void *re, void *im, int size, size_t step,
+                           size_t n, const char *caller, BDIO *fh)
+{
+   unsigned char tmp[BDIO_CVT_CHUNK];
+   uint64_t left=0;
+   size_t nc, rd, done=0;
+
+   if( !is_valid_bdio(caller, fh) )
    {
-      fh->rswap=1;
+      return 0;
    }
-   /* find out whether data items will have 1, 4 or 8 bytes */
-   fh->rdsize=1;
-   if(  (fh->rfmt==BDIO_BIN_INT32LE) || (fh->rfmt==BDIO_BIN_INT32BE)
-      ||(fh->rfmt==BDIO_BIN_F32LE)   || (fh->rfmt==BDIO_BIN_F32BE) )
+   if( fh->state!=BDIO_R_STATE || !fh->rcplx || fh->rdsize!=size )
    {
-      fh->rdsize=4;
+      bdio_error(0,(size==8) ?
+                 "Error in bdio_read_c128. Record has incompatible format" :
+                 "Error in bdio_read_c64. Record has incompatible format",fh);
+      return 0;
    }
-   if(  (fh->rfmt==BDIO_BIN_INT64LE) || (fh->rfmt==BDIO_BIN_INT64BE)
-      ||(fh->rfmt==BDIO_BIN_F64LE)   || (fh->rfmt==BDIO_BIN_F64BE) )
-   {
-      fh->rdsize=8;
+   left = fh->renc ? fh->enc->llen-fh->enc->lidx : fh->rlen-fh->ridx;
+   if( n>left/(2*size) )
+      n = left/(2*size);
+   while( done<n )
+   {
+      nc = (n-done < BDIO_CVT_CHUNK/(2*size)) ? n-done
+                                               : BDIO_CVT_CHUNK/(2*size);
+      rd = bdio_read(tmp, 2*size*nc, fh)/(2*size);
+      cplx_from_file(tmp, (unsigned char*) re+done*step,
+                     (unsigned char*) im+done*step, size, step, rd,
+                     fh->rswap);
+      done += rd;
+      if( rd<nc )
+         break;
    }
-   fh->state  = BDIO_R_STATE;
-   return 0;
+   return done;
 }
 
+size_t bdio_read_c64(float *buf, size_t n, BDIO *fh)
+{
+   return read_complex(buf, buf+1, 4, 8, n, "bdio_read_c64", fh);
+}
 
-size_t bdio_read(void *buf, size_t nb, BDIO *fh)
+size_t bdio_read_c128(double *buf, size_t n, BDIO *fh)
 {
-   size_t rd=0;
-   
-   if( !is_valid_bdio("bdio_read", fh) )
+   return read_complex(buf, buf+1, 8, 16, n, "bdio_read_c128", fh);
+}
+
+size_t bdio_read_c64_split(float *re, float *im, size_t n, BDIO *fh)
+{
+   return read_complex(re, im, 4, 4, n, "bdio_read_c64_split", fh);
+}
+
+size_t bdio_read_c128_split(double *re, double *im, size_t n, BDIO *fh)
+{
+   return read_complex(re, im, 8, 8, n, "bdio_read_c128_split", fh);
+}
+
+static int peek_meta(unsigned char *h, int size, uint32_t magic,
+                     BDIO *fh)
+{
+   /* reads the payload of the current record without consuming it, if it is
+    * an unread generic record with user info 7 of at most size bytes that
+    * starts with magic. Returns the length of the payload, 0 otherwise. */
+   int hl = fh->rlongrec ? 8 : 4;
+   long n;
+
+   if( fh->state!=BDIO_R_STATE || fh->mode!=BDIO_R_MODE || fh->renc ||
+       fh->rfmt!=BDIO_BIN_GENERIC || fh->ruinfo!=7 || fh->ridx!=hl ||
+       fh->rlen-hl<4 || fh->rlen-hl>size )
+      return 0;
+   n = (long) (fh->rlen-hl);
+   if( fread(h, 1, n, fh->fp)!=n )
    {
+      fseek(fh->fp, (long) (fh->rstart+hl), SEEK_SET);
       return 0;
    }
-   if( fh->state != BDIO_R_STATE )
+   if( fseek(fh->fp, -n, SEEK_CUR)!=0 )
    {
-      bdio_error(0, "Error in bdio_read. No record seeked.",fh);
+      bdio_error(1,"Error in peek_meta. fseek fails with",fh);
+      fh->state = BDIO_E_STATE;
       return 0;
    }
-   if( fh->mode != BDIO_R_MODE )
+   return (get_uint32(h)==magic) ? (int) n : 0;
+}
+
+static int peek_large(unsigned char h[BDIO_LARGE_LEN], BDIO *fh)
+{
+   /* returns 1 if the current record describes a large object, 0 otherwise.
+    *
+    * payload of a large-object record (little endian):
+    *
+    *  bytes  0..3   BDIO_LARGE_MAGIC
+    *  bytes  4..7   format of the chunks
+    *  bytes  8..11  user info of the chunks
+    *  bytes 12..19  length of the object in bytes
+    *  bytes 20..27  length of a chunk in bytes (the last one may be shorter)
+    */
+   return peek_meta(h, BDIO_LARGE_LEN, BDIO_LARGE_MAGIC, fh)==BDIO_LARGE_LEN
+          && get_uint64(h+20)>0;
+}
+
+uint64_t bdio_get_large_len(BDIO *fh)
+{
+   unsigned char h[BDIO_LARGE_LEN];
+
+   if( !is_valid_bdio("bdio_get_large_len", fh) )
    {
-      bdio_error(0, "Error in bdio_read. Not in read mode.",fh);
       return 0;
    }
+   if( !peek_large(h, fh) )
+      return 0;
+   return get_uint64(h+12);
+}
 
-   if(nb%fh->rdsize!=0)
+size_t bdio_read_large(void *ptr, size_t nmax, BDIO *fh)
+{
+   unsigned char h[BDIO_LARGE_LEN];
+   unsigned char *p = (unsigned char*) ptr;
+   uint64_t len, chunk;
+   size_t done=0, n;
+   int fmt, uinfo;
+
+   if( !is_valid_bdio("bdio_read_large", fh) )
    {
-      bdio_error(0, "Error in bdio_read. nb is not multiple of data size.",fh);
       return 0;
    }
-
-   if( nb > (fh->rlen-fh->ridx) )
+   if( !peek_large(h, fh) )
    {
-      bdio_error(0,"Error in bdio_read. nb is larger than remaining data in"
-                   " the record.",fh);
+      bdio_error(0,"Error in bdio_read_large. The current record does not "
+                   "describe a large object.",fh);
       return 0;
-      /* TODO: maybe better: read as much as possible? */
    }
-   
-   rd =  fread(buf, 1, nb, fh->fp);
-   if( rd<nb )
+   fmt   = (int) get_uint32(h+4);
+   uinfo = (int) get_uint32(h+8);
+   len   = get_uint64(h+12);
+   chunk = get_uint64(h+20);
+   if( len>nmax )
+   {
+      bdio_error(0,"Error in bdio_read_large. The object is larger than "
+                   "nmax.",fh);
+      return 0;
+   }
+   while( done<len )
    {
-      if ( feof( fh->fp ) )
-         bdio_error(0, "Error in bdio_read. Unexpected EOF.",fh);
-      else
-         bdio_error(1, "Error in bdio_read. fread fails with",fh);
-      /*TODO set error state? */
+      /* hash records may follow every chunk */
+      do
+      {
+         if( bdio_seek_record(fh)==EOF )
+         {
+            bdio_error(0,"Error in bdio_read_large. Chunk is missing.",fh);
+            return done;
+         }
+      }while( fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7 );
+      n = (len-done < chunk) ? (size_t) (len-done) : (size_t) chunk;
+      if( fh->rfmt!=fmt || fh->ruinfo!=uinfo || fh->rcplx ||
+          bdio_get_rlen(fh)!=n )
+      {
+         bdio_error(0,"Error in bdio_read_large. Chunk does not match the "
+                      "object.",fh);
+         return done;
+      }
+      if( bdio_read(p+done, n, fh)!=n )
+         return done;
+      if( fh->rswap )
+         swap_data(p+done, n, fh->rdsize);
+      done += n;
    }
-   /* update fh */
-   fh->ridx += rd;
-   return( rd );
+   return done;
 }
 
-size_t bdio_read_f32(float *buf, size_t nb, BDIO *fh)
+static int peek_array(uint64_t *dims, int *fmt, BDIO *fh)
 {
-   size_t rd;
-   if(   (fh->rfmt != BDIO_BIN_F32BE) && (fh->rfmt != BDIO_BIN_F32LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
-   {
-      bdio_error(0,"Error in bdio_read_f32. Record has incompatible format",fh);
-      return(0);
-   }
-   rd=bdio_read((void*) buf, nb, fh);
-   if( fh->rswap )
-      swap32(buf, rd);
-   return rd;
+   /* returns the number of dimensions if the current record describes an
+    * array, 0 otherwise.
+    *
+    * payload of an array record (little endian):
+    *
+    *  bytes  0..3   BDIO_ARRAY_MAGIC
+    *  bytes  4..7   format of the data record
+    *  bytes  8..11  number of dimensions nd
+    *  bytes 12..    nd extents, 8 bytes each, the last one varies fastest
+    */
+   unsigned char h[12+8*BDIO_MAX_NDIM];
+   int n, nd, k;
+
+   n = peek_meta(h, sizeof(h), BDIO_ARRAY_MAGIC, fh);
+   if( n<12 )
+      return 0;
+   nd = (int) get_uint32(h+8);
+   if( nd<1 || nd>BDIO_MAX_NDIM || n!=12+8*nd )
+      return 0;
+   *fmt = (int) get_uint32(h+4);
+   for( k=0; k<nd; k++ )
+      dims[k] = get_uint64(h+12+8*k);
+   return nd;
 }
 
-size_t bdio_read_f64(double *buf, size_t nb, BDIO *fh)
+int bdio_get_array_shape(uint64_t *dims, BDIO *fh)
 {
-   size_t rd;
-   if(   (fh->rfmt != BDIO_BIN_F64BE) && (fh->rfmt != BDIO_BIN_F64LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   int fmt, nd;
+
+   if( !is_valid_bdio("bdio_get_array_shape", fh) )
    {
-      bdio_error(0,"Error in bdio_read_f64. Record has incompatible format",fh);
-      return(0);
+      return 0;
    }
-   rd=bdio_read((void*) buf, nb, fh);
-   if( fh->rswap )
-      swap64(buf, rd);
-   return rd;
+   if( (nd = peek_array(dims, &fmt, fh))>0 )
+      return nd;
+   if( fh->state==BDIO_R_STATE && fh->arcnt==fh->rcnt )
+   {
+      memcpy(dims, fh->adims, sizeof(uint64_t)*fh->andim);
+      return fh->andim;
+   }
+   return 0;
 }
 
-size_t bdio_read_int32(int32_t *buf, size_t nb, BDIO *fh)
+size_t bdio_read_hyperslab(const uint64_t *start, const uint64_t *count,
+                           const uint64_t *stride, void *dst, BDIO *fh)
 {
-   size_t rd;
-   if(   (fh->rfmt != BDIO_BIN_INT32BE) && (fh->rfmt != BDIO_BIN_INT32LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   unsigned char *p = (unsigned char*) dst;
+   uint64_t dims[BDIO_MAX_NDIM], idx[BDIO_MAX_NDIM], pitch[BDIO_MAX_NDIM];
+   uint64_t len, st, off, run;
+   size_t done=0, nb;
+   int nd, fmt, k, l, es;
+
+   if( !is_valid_bdio("bdio_read_hyperslab", fh) )
    {
-      bdio_error(0,"Error in bdio_read_i32. Record has incompatible format",fh);
-      return(0);
+      return 0;
+   }
+   if( (nd = peek_array(dims, &fmt, fh))>0 )
+   {
+      /* hash records may follow the description */
+      do
+      {
+         if( bdio_seek_record(fh)==EOF )
+         {
+            bdio_error(0,"Error in bdio_read_hyperslab. Data record is "
+                         "missing.",fh);
+            return 0;
+         }
+      }while( fh->rfmt==BDIO_BIN_GENERIC && fh->ruinfo==7 );
+      /* complex records have the format of their parts */
+      if( fh->rfmt!=(fmt & 0xf) || fh->rcplx!=is_complex_fmt(fmt) )
+      {
+         bdio_error(0,"Error in bdio_read_hyperslab. Data record does not "
+                      "match the array.",fh);
+         return 0;
+      }
+      fh->andim = nd;
+      fh->arcnt = fh->rcnt;
+      memcpy(fh->adims, dims, sizeof(dims));
+   }else if( fh->state==BDIO_R_STATE && fh->arcnt==fh->rcnt )
+   {
+      nd = fh->andim;
+      memcpy(dims, fh->adims, sizeof(dims));
+   }else
+   {
+      bdio_error(0,"Error in bdio_read_hyperslab. Not in an array record.",
+                 fh);
+      return 0;
    }
-   rd=bdio_read((void*) buf, nb, fh);
-   if( fh->rswap )
-      swap32(buf, rd);
-   return rd;
-}
 
-size_t bdio_read_int64(int64_t *buf, size_t nb, BDIO *fh)
-{
-   size_t rd;
-   if(   (fh->rfmt != BDIO_BIN_INT64BE) && (fh->rfmt != BDIO_BIN_INT64LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   es = fh->rcplx ? 2*fh->rdsize : fh->rdsize;
+   len = (uint64_t) es;
+   for( k=nd-1; k>=0; k-- )
    {
-      bdio_error(0,"Error in bdio_read_i64. Record has incompatible format",fh);
-      return(0);
+      pitch[k] = len;
+      len *= dims[k];
+      st = (stride==NULL) ? 1 : stride[k];
+      if( count[k]==0 )
+         return 0;
+      if( st==0 || start[k]+(count[k]-1)*st >= dims[k] )
+      {
+         bdio_error(0,"Error in bdio_read_hyperslab. Hyperslab exceeds the "
+                      "array.",fh);
+         return 0;
+      }
    }
-   rd=bdio_read((void*) buf, nb, fh);
-   if( fh->rswap )
-      swap64(buf, rd);
-   return rd;
+   if( len!=bdio_get_rlen(fh) )
+   {
+      bdio_error(0,"Error in bdio_read_hyperslab. Record length does not "
+                   "match the array.",fh);
+      return 0;
+   }
+
+   /* the innermost dimensions read in one piece: all with stride 1, up to
+    * and including the first which is not read completely */
+   run = 1;
+   for( l=nd; l>0; l-- )
+   {
+      st = (stride==NULL) ? 1 : stride[l-1];
+      if( st!=1 && count[l-1]!=1 )
+         break;
+      run *= count[l-1];
+      if( count[l-1]!=dims[l-1] )
+      {
+         l--;
+         break;
+      }
+   }
+   nb = (size_t) (run*es);
+   memset(idx, 0, sizeof(idx));
+   for(;;)
+   {
+      off = 0;
+      for( k=0; k<nd; k++ )
+      {
+         st = (stride==NULL) ? 1 : stride[k];
+         off += (start[k]+((k<l) ? idx[k]*st : 0))*pitch[k];
+      }
+      if( bdio_seek_in_record((int64_t) off, SEEK_SET, fh)!=0 ||
+          bdio_read(p+done, nb, fh)!=nb )
+         break;
+      if( fh->rswap )
+         swap_data(p+done, nb, fh->rdsize);
+      done += nb;
+      for( k=l-1; k>=0; k-- )
+      {
+         if( ++idx[k]<count[k] )
+            break;
+         idx[k] = 0;
+      }
+      if( k<0 )
+         break;
+   }
+   return done;
 }
 
-int bdio_start_record(int fmt, int uinfo, BDIO *fh)
+static int start_record(int fmt, int uinfo, int hash, BDIO *fh)
 {
+   /* bdio_start_record, which computes the checksum of the record while
+    * it is written if hash is 1 and automatic hashing is on */
    uint32_t hdr;
+   uint64_t lhdr;
+   unsigned char w[4];
+   struct bdio_index *ix;
    if( !is_valid_bdio("bdio_start_record", fh) )
    {
       return EOF;
@@ -1802,12 +6808,19 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
        fmt != BDIO_BIN_F32LE   &&
        fmt != BDIO_BIN_F64BE   &&
        fmt != BDIO_BIN_F64LE   &&
+       fmt != BDIO_BIN_F16BE   &&
+       fmt != BDIO_BIN_F16LE   &&
+       fmt != BDIO_BIN_BF16BE  &&
+       fmt != BDIO_BIN_BF16LE  &&
        fmt != BDIO_ASC_GENERIC &&
        fmt != BDIO_ASC_XML     &&
        fmt != BDIO_BIN_INT32   &&
        fmt != BDIO_BIN_INT64   &&
        fmt != BDIO_BIN_F32     &&
-       fmt != BDIO_BIN_F64)
+       fmt != BDIO_BIN_F64     &&
+       fmt != BDIO_BIN_F16     &&
+       fmt != BDIO_BIN_BF16    &&
+       !is_complex_fmt(fmt) )
    {
       bdio_error(0,"Error in bdio_start_record. Unknown format.",fh);
       return EOF;
@@ -1819,6 +6832,15 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
       return EOF;
    }
 
+   /* complex records are stored as generic records with the encoded bit,
+    * those with uinfo 7 are padding */
+   if( is_complex_fmt(fmt) && uinfo==7 )
+   {
+      bdio_error(0,"Error in bdio_start_record. Complex records can not "
+                   "have info 7.",fh);
+      return EOF;
+   }
+
    if( (fh->mode != BDIO_W_MODE)  && (fh->mode != BDIO_A_MODE) )
    {
       bdio_error(0,
@@ -1833,23 +6855,27 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
       return EOF;
    }
 
+   /* the record table is written in blocks while it grows, so that readers
+    * find it before bdio_close, see load_last_block. Not in front of
+    * generic records with uinfo 7, hash records must follow their record. */
+   ix = fh->index;
+   if( ix!=NULL && ix->records && ix->nr>ix->nblk &&
+       (fmt!=BDIO_BIN_GENERIC || uinfo!=7) &&
+       (ix->nr-ix->nblk>=BDIO_TABLE_BLOCK ||
+        fh->rstart+fh->rlen-ix->r[ix->nblk].off>=BDIO_TABLE_BYTES) &&
+       write_table(fh)!=0 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+
    /* include endiannes in format, if not specified by user */
-   if( (fmt==BDIO_BIN_INT32) && (fh->endian==BDIO_LEND))
-      fmt=BDIO_BIN_INT32LE;
-   if( (fmt==BDIO_BIN_INT32) && (fh->endian==BDIO_BEND))
-      fmt=BDIO_BIN_INT32BE;
-   if( (fmt==BDIO_BIN_INT64) && (fh->endian==BDIO_LEND))
-      fmt=BDIO_BIN_INT64LE;
-   if( (fmt==BDIO_BIN_INT64) && (fh->endian==BDIO_BEND))
-      fmt=BDIO_BIN_INT64BE;
-   if( (fmt==BDIO_BIN_F32) && (fh->endian==BDIO_LEND))
-      fmt=BDIO_BIN_F32LE;
-   if( (fmt==BDIO_BIN_F32) && (fh->endian==BDIO_BEND))
-      fmt=BDIO_BIN_F32BE;
-   if( (fmt==BDIO_BIN_F64) && (fh->endian==BDIO_LEND))
-      fmt=BDIO_BIN_F64LE;
-   if( (fmt==BDIO_BIN_F64) && (fh->endian==BDIO_BEND))
-      fmt=BDIO_BIN_F64BE;
+   fmt = resolve_fmt(fmt, fh->endian);
+
+   /* complex records are stored with the format of their parts */
+   fh->rcplx = is_complex_fmt(fmt);
+   if( fh->rcplx )
+      fmt &= 0xf;
 
    /* find out whether on this machine swapping of the byte order will be
     * necessary before writing to disk
@@ -1862,12 +6888,21 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
       ||((fmt==BDIO_BIN_INT64LE) && (fh->endian==BDIO_BEND))
       ||((fmt==BDIO_BIN_INT64BE) && (fh->endian==BDIO_LEND))
       ||((fmt==BDIO_BIN_F64LE)   && (fh->endian==BDIO_BEND))
-      ||((fmt==BDIO_BIN_F64BE)   && (fh->endian==BDIO_LEND)) )
+      ||((fmt==BDIO_BIN_F64BE)   && (fh->endian==BDIO_LEND))
+      ||((fmt==BDIO_BIN_F16LE)   && (fh->endian==BDIO_BEND))
+      ||((fmt==BDIO_BIN_F16BE)   && (fh->endian==BDIO_LEND))
+      ||((fmt==BDIO_BIN_BF16LE)  && (fh->endian==BDIO_BEND))
+      ||((fmt==BDIO_BIN_BF16BE)  && (fh->endian==BDIO_LEND)) )
    {
       fh->rswap=1;
    }
-   /* find out whether data items will have 1, 4 or 8 bytes */
+   /* find out whether data items will have 1, 2, 4 or 8 bytes */
    fh->rdsize=1;
+   if(  (fmt==BDIO_BIN_F16LE)   || (fmt==BDIO_BIN_F16BE)
+      ||(fmt==BDIO_BIN_BF16LE)  || (fmt==BDIO_BIN_BF16BE) )
+   {
+      fh->rdsize=2;
+   }
    if(  (fmt==BDIO_BIN_INT32LE) || (fmt==BDIO_BIN_INT32BE)
       ||(fmt==BDIO_BIN_F32LE)   || (fmt==BDIO_BIN_F32BE) )
    {
@@ -1886,14 +6921,15 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
     *        bit7                        bit0
     *         |                           |
     *         v                           v
-    *byte0: [f3  f2  f1  f0  rt  sp  sp  m  ]
+    *byte0: [f3  f2  f1  f0  rt  op  en  m  ]
     *byte1: [l3  l2  l1  l0  u3  u2  u1  u0 ]
     *byte2: [l11 l10 l9  l8  l7  l6  l5  l4 ]
     *byte3: [l19 l18 l17 l16 l15 l14 l13 l12]
     *
     * with:
     * m:   magic bit must be 1
-    * sp:  spare bit
+    * en:  1=payload is encoded (see enc_start)
+    * op:  1=record is still being written (see bdio_follow)
     * rt:  0=short record (always=0 at creation)
     * f:   format, If bp==0
     *               0x0: generic binary
@@ -1908,10 +6944,10 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
     *               0x9: float64, little endian
     *               0xA: generic ascii
     *               0xB: XML
-    *               0xC: spare
-    *               0xD: spare
-    *               0xE: spare
-    *               0xF: spare
+    *               0xC: float16, big endian
+    *               0xD: float16, little endian
+    *               0xE: bfloat16, big endian
+    *               0xF: bfloat16, little endian
     *              If bp==1: used for additional bits of record length
     *               f0=l24
     *               f1=l25
@@ -1922,37 +6958,91 @@ int bdio_start_record(int fmt, int uinfo, BDIO *fh)
     * 
     */
 
-   fh->rlongrec = 0;
+   /* integer packing does not apply to other formats. Complex numbers
+    * without codec are stored as they are, after a marker. */
+   fh->renc = (fh->codec!=BDIO_CODEC_NONE) &&
+              (fh->codec!=BDIO_CODEC_PACK || is_int_fmt(fmt));
+   /* encoded records are stored as generic records, see head_fmt, and
+    * encoded generic records with uinfo 7 are reserved for padding */
+   if( uinfo==7 )
+      fh->renc = 0;
+   /* aligned payloads follow a long header, which stays in place when the
+    * record grows */
+   if( fh->align>0 &&
+       write_padding((fh->rcplx && !fh->renc) ? 12 : 8, fh)!=0 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   fh->rlongrec = (fh->align>0);
    fh->rfmt = fmt;
    fh->ruinfo = uinfo;
    fh->rstart = fh->rstart+fh->rlen;
    fh->state  = BDIO_R_STATE;
-   fh->rcnt++;
-
-   fh->rlen = 4;
-   fh->ridx = 4;
+   /* hidden records are not counted, see head_bits */
+   if( !fh->rhide )
+   {
+      fh->rcnt++;
+      if( fh->index!=NULL && fh->index->records && index_record(fh)!=0 )
+      {
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+   }
 
-   hdr = HEADER_INT(fh->rfmt, fh->ruinfo, fh->rlen);
-   if (fh->endian == BDIO_BEND)
+   if( fh->rlongrec )
+   {
+      fh->rlen = 8;
+      lhdr = HEADER_INT_LONG(head_fmt(fh), fh->ruinfo, fh->rlen)
+             | head_bits(fh) | HEADER_OPEN;
+      if (fh->endian == BDIO_BEND)
+         swap64(&lhdr,8);
+      memcpy(fh->buf,&lhdr, 8);
+   }else
+   {
+      fh->rlen = 4;
+      hdr = HEADER_INT(head_fmt(fh), fh->ruinfo, fh->rlen)
+            | head_bits(fh) | HEADER_OPEN;
+      if (fh->endian == BDIO_BEND)
          swap32(&hdr,4);
-   memcpy(fh->buf,&hdr, 4);
+      memcpy(fh->buf,&hdr, 4);
+   }
+   fh->ridx = fh->rlen;
    fh->bufstart = 0;
-   fh->bufidx = 4;
+   fh->bufidx = (int) fh->rlen;
    
-   if (fh->hash_auto) MD5_Init(fh->hash);
-   if (fh->hash_mode==BDIO_HASH_CHAIN)
-      MD5_Update(fh->hash, fh->prev_digest, 16);
+   fh->rhash = hash && (fh->hash_auto==BDIO_AUTO_HASH);
+   if (fh->rhash)
+      hash_start(fh);
+
+   if( fh->renc && enc_start(fh)!=0 )
+   {
+      fh->state = BDIO_E_STATE;
+      return EOF;
+   }
+   if( fh->rcplx && !fh->renc )
+   {
+      put_uint32(w, ENC_COMPLEX|ENC_PLAIN|
+                    ((uint32_t) fh->rfmt << ENC_FMT_SHIFT));
+      if( raw_write(w, 4, fh)!=4 )
+      {
+         fh->state = BDIO_E_STATE;
+         return EOF;
+      }
+   }
    
    return 0;
 }
 
 
-size_t bdio_write(void *ptr, size_t nb, BDIO *fh)
+int bdio_start_record(int fmt, int uinfo, BDIO *fh)
 {
-   size_t nw=0;
-   size_t nr;
-   uint64_t lhdr;
+   return start_record(fmt, uinfo, 1, fh);
+}
+
 
+size_t bdio_write(void *ptr, size_t nb, BDIO *fh)
+{
    if( !is_valid_bdio("bdio_write", fh) )
    {
       return 0;
@@ -1976,248 +7066,339 @@ size_t bdio_write(void *ptr, size_t nb, BDIO *fh)
       return 0;
    }
    
-   if (fh->hash_auto)
-      MD5_Update(fh->hash, ptr, nb);
+   if( fh->renc )
+      return enc_write(ptr, nb, fh);
+   return raw_write(ptr, nb, fh);
+}
 
-   if( !(fh->rlongrec) && (fh->ridx+nb)>(BDIO_MAX_RECORD_LENGTH+4) )
+size_t bdio_write_f32(float *ptr, size_t nb, BDIO *fh)
+{
+   /*TODO: come up with something to avoid double-swaps*/
+   size_t nw;
+   if(   (fh->rfmt != BDIO_BIN_F32BE) && (fh->rfmt != BDIO_BIN_F32LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
    {
-      /* a short record must be turned into a long record */
-      if( fh->ridx==4 )
-      {
-         /* case 1: No data in the record yet. Enlarge header by 4 bytes */
-         fh->rlongrec = 1;
-         fh->ridx += 4;
-         fh->rlen += 4;
-         if( fh->bufstart==0 )
-            fh->bufidx += 4;
-         else
-         {
-            /* this happens if one appends to an empty record */
-            if( fseek(fh->fp, -4, SEEK_CUR) == -1)
-            {
-               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            fh->bufstart = 0;
-            fh->bufidx = 8;
-         }
-      } else
-      if( fh->bufstart == 0 )
+      bdio_error(0,"Error in bdio_write_f32. Record has incompatible format",fh);
+      return(0);
+   }
+   if( fh->rswap )
+      swap32(ptr, nb);
+   nw = bdio_write((void *) ptr, nb, fh);
+   if( fh->rswap )
+      swap32(ptr, nb);
+   return nw;
+}
+
+size_t bdio_write_f64(double *ptr, size_t nb, BDIO *fh)
+{
+   /*TODO: come up with something to avoid double-swaps*/
+   size_t nw;
+   if(   (fh->rfmt != BDIO_BIN_F64BE) && (fh->rfmt != BDIO_BIN_F64LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
+   {
+      bdio_error(0,"Error in bdio_write_f64. Record has incompatible format",fh);
+      return(0);
+   }
+   if( fh->rswap )
+      swap64(ptr, nb);
+   nw = bdio_write((void *) ptr, nb, fh);
+   if( fh->rswap )
+      swap64(ptr, nb);
+   return nw;
+}
+
+size_t bdio_write_int32(int32_t *ptr, size_t nb, BDIO *fh)
+{
+   /*TODO: come up with something to avoid double-swaps*/
+   size_t nw;
+   if(   (fh->rfmt != BDIO_BIN_INT32BE) && (fh->rfmt != BDIO_BIN_INT32LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
+   {
+      bdio_error(0,"Error in bdio_write_i32. Record has incompatible format",fh);
+      return(0);
+   }
+   
+   if( fh->rswap )
+      swap32(ptr, nb);
+   nw = bdio_write((void *) ptr, nb, fh);
+   if( fh->rswap )
+      swap32(ptr, nb);
+   return nw;
+}
+
+size_t bdio_write_int64(int64_t *ptr, size_t nb, BDIO *fh)
+{
+   /*TODO: come up with something to avoid double-swaps*/
+   size_t nw;
+   if(   (fh->rfmt != BDIO_BIN_INT64BE) && (fh->rfmt != BDIO_BIN_INT64LE)
+      && (fh->rfmt != BDIO_BIN_GENERIC))
+   {
+      bdio_error(0,"Error in bdio_write_i64. Record has incompatible format",fh);
+      return(0);
+   }
+   
+   if( fh->rswap )
+      swap64(ptr, nb);
+   nw = bdio_write((void *) ptr, nb, fh);
+   if( fh->rswap )
+      swap64(ptr, nb);
+   return nw;
+}
+
+
+size_t bdio_write_f32_as_f16(float *ptr, size_t n, BDIO *fh)
+{
+   /* converts and writes in pieces that stay in the cache */
+   uint16_t h[BDIO_CVT_CHUNK/2];
+   size_t nc, wr, done=0;
+
+   if( !is_valid_bdio("bdio_write_f32_as_f16", fh) )
+   {
+      return 0;
+   }
+   if( !is_half_fmt(fh->rfmt) )
+   {
+      bdio_error(0,"Error in bdio_write_f32_as_f16. Record has incompatible "
+                   "format",fh);
+      return 0;
+   }
+   while( done<n )
+   {
+      nc = (n-done < BDIO_CVT_CHUNK/2) ? n-done : BDIO_CVT_CHUNK/2;
+      if( fh->rfmt==BDIO_BIN_F16BE || fh->rfmt==BDIO_BIN_F16LE )
+         HALF_F32ToF16(ptr+done, h, nc);
+      else
+         HALF_F32ToBF16(ptr+done, h, nc);
+      if( fh->rswap )
+         swap16(h, 2*nc);
+      wr = bdio_write(h, 2*nc, fh)/2;
+      done += wr;
+      if( wr<nc )
+         break;
+   }
+   return done;
+}
+
+static void cplx_to_file(unsigned char *d, const unsigned char *re,
+                         const unsigned char *im, int size, size_t step,
+                         size_t n, int swap)
+{
+   /* interleaves n complex numbers from re and im, which advance by step
+    * bytes per number */
+   size_t i;
+   uint64_t x;
+   uint32_t y;
+
+   if( size==8 )
+      for( i=0; i<n; i++ )
       {
-         if( fh->bufidx < BDIO_BUF_SIZE-4 )
-         {
-            /* case 2: All data is still buffered. Shift buffer by 4 bytes */
-            memmove(&(fh->buf[8]),&(fh->buf[4]),fh->bufidx-4);
-            fh->rlongrec = 1;
-            fh->bufidx += 4;
-            fh->rlen += 4;
-            fh->ridx += 4;
-         }else
-         {
-            /* case 3: All data is still buffered. Shift buffer-start by 4 */
-            /* write a header that is up-to-date after this write */
-            lhdr = HEADER_INT_LONG(fh->rfmt, fh->ruinfo, fh->ridx+nb+4);
-            if (fh->endian == BDIO_BEND)
-               swap64(&lhdr,8);
-            if( fwrite(&lhdr,1,8,fh->fp) != 8 )
-            {
-               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            if( fwrite(&(fh->buf[4]),1,fh->bufidx-4,fh->fp) != (fh->bufidx-4) )
-            {
-               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            fh->rlongrec = 1;
-            fh->bufstart = fh->bufidx+4;
-            fh->bufidx = 0;
-            fh->ridx += 4;
-            fh->rlen += 4;
-         }
-      } else
+         x = load64(re+i*step, swap);
+         memcpy(d+16*i, &x, 8);
+         x = load64(im+i*step, swap);
+         memcpy(d+16*i+8, &x, 8);
+      }
+   else
+      for( i=0; i<n; i++ )
       {
-         /* case 3: move record-content in the file by 4 bytes */
-         /* write dummy 4 bytes followed by contents of the buffer */
-         if( fwrite(fh->buf,1,4,fh->fp) != 4 )
-         {
-               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-         }
-         if( fwrite(fh->buf,1,fh->bufidx,fh->fp) != fh->bufidx )
-         {
-               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-         }
-
-         /* shift blocks of data 4 bytes down */
-         while( BDIO_BUF_SIZE < fh->bufstart )
-         {
-            nr = BDIO_BUF_SIZE;
-            if( (fh->bufstart-nr) < 4 )
-               nr-=4;
-            if( fseek(fh->fp, -(nr+4+fh->bufidx), SEEK_CUR) == -1)
-            {
-               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            if( fread(fh->buf, 1, nr, fh->fp) != nr )
-            {
-               bdio_error(1, "Error in bdio_write. fread failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            if( fseek(fh->fp, -nr+4, SEEK_CUR) == -1)
-            {
-               bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            if( fwrite(fh->buf, 1, nr, fh->fp) != nr )
-            {
-               bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-               fh->state=BDIO_E_STATE;
-               return 0;
-            }
-            fh->bufstart -= nr;
-            fh->bufidx = nr;
-         }
-         /* shift last block 4 bytes down, write new header */
-         nr = fh->bufstart-4;
-         if( fseek(fh->fp, fh->rstart+4, SEEK_SET) == -1)
-         {
-            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         if( fread(fh->buf, 1, nr, fh->fp) != nr )
-         {
-            bdio_error(1, "Error in bdio_write. fread failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         if( fseek(fh->fp, fh->rstart, SEEK_SET) == -1)
-         {
-            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         /* write header that is up-to-date after this write */
-         lhdr = HEADER_INT_LONG(fh->rfmt, fh->ruinfo, fh->ridx+nb+4);
-         if (fh->endian == BDIO_BEND)
-            swap64(&lhdr,8);
-         if( fwrite(&lhdr,1,8,fh->fp) != 8 )
-         {
-            bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         if( fwrite(fh->buf, 1, nr, fh->fp) != nr )
-         {
-            bdio_error(1, "Error in bdio_write. fwrite failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         if( fseek(fh->fp, 0, SEEK_END) == -1)
-         {
-            bdio_error(1, "Error in bdio_write. fseek failed with",fh);
-            fh->state=BDIO_E_STATE;
-            return 0;
-         }
-         fh->rlongrec = 1;
-         fh->ridx    += 4;
-         fh->rlen    += 4;
-         fh->bufidx   = 0;
-         fh->bufstart = fh->ridx;
+         y = load32(re+i*step, swap);
+         memcpy(d+8*i, &y, 4);
+         y = load32(im+i*step, swap);
+         memcpy(d+8*i+4, &y, 4);
       }
+}
+
+static size_t write_complex(const void *re, const void *im, int size,
+                            size_t step, size_t n, const char *caller,
+                            BDIO *fh)
+{
+   /* the user's data is copied in pieces, so it is never swapped in place */
+   unsigned char tmp[BDIO_CVT_CHUNK];
+   size_t nc, wr, done=0;
+
+   if( !is_valid_bdio(caller, fh) )
+   {
+      return 0;
    }
-   nw = buf_write(ptr,nb,fh);
-   return nw;
+   if( !fh->rcplx || fh->rdsize!=size )
+   {
+      bdio_error(0,(size==8) ?
+                 "Error in bdio_write_c128. Record has incompatible format" :
+                 "Error in bdio_write_c64. Record has incompatible format",fh);
+      return 0;
+   }
+   while( done<n )
+   {
+      nc = (n-done < BDIO_CVT_CHUNK/(2*size)) ? n-done
+                                               : BDIO_CVT_CHUNK/(2*size);
+      cplx_to_file(tmp, (const unsigned char*) re+done*step,
+                   (const unsigned char*) im+done*step, size, step, nc,
+                   fh->rswap);
+      wr = bdio_write(tmp, 2*size*nc, fh)/(2*size);
+      done += wr;
+      if( wr<nc )
+         break;
+   }
+   return done;
 }
 
-size_t bdio_write_f32(float *ptr, size_t nb, BDIO *fh)
+size_t bdio_write_c64(float *ptr, size_t n, BDIO *fh)
 {
-   /*TODO: come up with something to avoid double-swaps*/
-   size_t nw;
-   if(   (fh->rfmt != BDIO_BIN_F32BE) && (fh->rfmt != BDIO_BIN_F32LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   return write_complex(ptr, ptr+1, 4, 8, n, "bdio_write_c64", fh);
+}
+
+size_t bdio_write_c128(double *ptr, size_t n, BDIO *fh)
+{
+   return write_complex(ptr, ptr+1, 8, 16, n, "bdio_write_c128", fh);
+}
+
+size_t bdio_write_c64_split(float *re, float *im, size_t n, BDIO *fh)
+{
+   return write_complex(re, im, 4, 4, n, "bdio_write_c64_split", fh);
+}
+
+size_t bdio_write_c128_split(double *re, double *im, size_t n, BDIO *fh)
+{
+   return write_complex(re, im, 8, 8, n, "bdio_write_c128_split", fh);
+}
+
+int bdio_set_large_chunk(uint64_t chunk, BDIO *fh)
+{
+   if( !is_valid_bdio("bdio_set_large_chunk", fh) )
    {
-      bdio_error(0,"Error in bdio_write_f32. Record has incompatible format",fh);
-      return(0);
+      return EOF;
    }
-   if( fh->rswap )
-      swap32(ptr, nb);
-   nw = bdio_write((void *) ptr, nb, fh);
-   if( fh->rswap )
-      swap32(ptr, nb);
-   return nw;
+   if( chunk==0 || chunk%16!=0 || chunk>BDIO_MAX_LONG_RECORD_LENGTH )
+   {
+      bdio_error(0,"Error in bdio_set_large_chunk. chunk must be a positive "
+                   "multiple of 16 not larger than 2^28-1.",fh);
+      return EOF;
+   }
+   fh->lchunk = chunk;
+   return 0;
 }
 
-size_t bdio_write_f64(double *ptr, size_t nb, BDIO *fh)
+size_t bdio_write_large(void *ptr, size_t nb, int fmt, int uinfo, BDIO *fh)
 {
-   /*TODO: come up with something to avoid double-swaps*/
-   size_t nw;
-   if(   (fh->rfmt != BDIO_BIN_F64BE) && (fh->rfmt != BDIO_BIN_F64LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   unsigned char h[BDIO_LARGE_LEN];
+   unsigned char *p = (unsigned char*) ptr;
+   size_t done=0, n, wr;
+
+   if( !is_valid_bdio("bdio_write_large", fh) )
    {
-      bdio_error(0,"Error in bdio_write_f64. Record has incompatible format",fh);
-      return(0);
+      return 0;
    }
-   if( fh->rswap )
-      swap64(ptr, nb);
-   nw = bdio_write((void *) ptr, nb, fh);
-   if( fh->rswap )
-      swap64(ptr, nb);
-   return nw;
+   fmt = resolve_fmt(fmt, fh->endian);
+   if( is_complex_fmt(fmt) || (fmt==BDIO_BIN_GENERIC && uinfo==7) )
+   {
+      bdio_error(0,"Error in bdio_write_large. Format not supported.",fh);
+      return 0;
+   }
+   put_uint32(h, BDIO_LARGE_MAGIC);
+   put_uint32(h+4, (uint32_t) fmt);
+   put_uint32(h+8, (uint32_t) uinfo);
+   put_uint64(h+12, (uint64_t) nb);
+   put_uint64(h+20, fh->lchunk);
+   if( bdio_start_record(BDIO_BIN_GENERIC, 7, fh)!=0 ||
+       bdio_write(h, BDIO_LARGE_LEN, fh)!=BDIO_LARGE_LEN )
+      return 0;
+   while( done<nb )
+   {
+      n = (nb-done < fh->lchunk) ? nb-done : (size_t) fh->lchunk;
+      if( bdio_start_record(fmt, uinfo, fh)!=0 )
+         break;
+      if( fh->rswap )
+         swap_data(p+done, n, fh->rdsize);
+      wr = bdio_write(p+done, n, fh);
+      if( fh->rswap )
+         swap_data(p+done, n, fh->rdsize);
+      done += wr;
+      if( wr<n )
+         break;
+   }
+   bdio_flush_record(fh);
+   return done;
 }
 
-size_t bdio_write_int32(int32_t *ptr, size_t nb, BDIO *fh)
+size_t bdio_write_named(const char *name, int fmt, int uinfo, void *ptr,
+                        size_t nb, BDIO *fh)
 {
-   /*TODO: come up with something to avoid double-swaps*/
-   size_t nw;
-   if(   (fh->rfmt != BDIO_BIN_INT32BE) && (fh->rfmt != BDIO_BIN_INT32LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   struct bdio_iname e;
+   unsigned char *p = (unsigned char*) ptr;
+   size_t len, wr;
+
+   if( !is_valid_bdio("bdio_write_named", fh) )
    {
-      bdio_error(0,"Error in bdio_write_i32. Record has incompatible format",fh);
-      return(0);
+      return 0;
    }
-   
+   fmt = resolve_fmt(fmt, fh->endian);
+   if( name==NULL || name[0]=='\0' )
+   {
+      bdio_error(0,"Error in bdio_write_named. Empty name.",fh);
+      return 0;
+   }
+   if( is_complex_fmt(fmt) || (fmt==BDIO_BIN_GENERIC && uinfo==7) )
+   {
+      bdio_error(0,"Error in bdio_write_named. Format not supported.",fh);
+      return 0;
+   }
+   len = strlen(name);
+   if( bdio_start_record(BDIO_ASC_GENERIC, uinfo, fh)!=0 )
+      return 0;
+   e.off = fh->rstart;
+   e.hoff = fh->hstart;
+   e.rcnt = fh->rcnt;
+   e.hrcnt = fh->hrcnt;
+   e.hcnt = fh->hcnt;
+   e.info = 0;
+   if( bdio_write((void*) name, len, fh)!=len || index_new(fh)!=0 ||
+       index_add(name, &e, fh)!=0 )
+      return 0;
+   fh->index->dirty = 1;
+
+   if( bdio_start_record(fmt, uinfo, fh)!=0 )
+      return 0;
    if( fh->rswap )
-      swap32(ptr, nb);
-   nw = bdio_write((void *) ptr, nb, fh);
+      swap_data(p, nb, fh->rdsize);
+   wr = bdio_write(p, nb, fh);
    if( fh->rswap )
-      swap32(ptr, nb);
-   return nw;
+      swap_data(p, nb, fh->rdsize);
+   bdio_flush_record(fh);
+   return wr;
 }
 
-size_t bdio_write_int64(int64_t *ptr, size_t nb, BDIO *fh)
+int bdio_start_array(int fmt, int uinfo, int ndim, const uint64_t *dims,
+                     BDIO *fh)
 {
-   /*TODO: come up with something to avoid double-swaps*/
-   size_t nw;
-   if(   (fh->rfmt != BDIO_BIN_INT64BE) && (fh->rfmt != BDIO_BIN_INT64LE)
-      && (fh->rfmt != BDIO_BIN_GENERIC))
+   unsigned char h[12+8*BDIO_MAX_NDIM];
+   int k;
+
+   if( !is_valid_bdio("bdio_start_array", fh) )
    {
-      bdio_error(0,"Error in bdio_write_i64. Record has incompatible format",fh);
-      return(0);
+      return EOF;
    }
-   
-   if( fh->rswap )
-      swap64(ptr, nb);
-   nw = bdio_write((void *) ptr, nb, fh);
-   if( fh->rswap )
-      swap64(ptr, nb);
-   return nw;
+   fmt = resolve_fmt(fmt, fh->endian);
+   if( ndim<1 || ndim>BDIO_MAX_NDIM || (fmt==BDIO_BIN_GENERIC && uinfo==7) )
+   {
+      bdio_error(0,"Error in bdio_start_array. Invalid number of dimensions "
+                   "or format.",fh);
+      return EOF;
+   }
+   put_uint32(h, BDIO_ARRAY_MAGIC);
+   put_uint32(h+4, (uint32_t) fmt);
+   put_uint32(h+8, (uint32_t) ndim);
+   for( k=0; k<ndim; k++ )
+      put_uint64(h+12+8*k, dims[k]);
+   if( bdio_start_record(BDIO_BIN_GENERIC, 7, fh)!=0 ||
+       bdio_write(h, 12+8*ndim, fh)!=12+8*ndim )
+      return EOF;
+   return bdio_start_record(fmt, uinfo, fh);
 }
 
 
-int bdio_flush_record( BDIO *fh)
+static int flush_record(const unsigned char *digest, BDIO *fh)
 {
+   /* bdio_flush_record, which stores digest as the checksum of the record
+    * if it is not NULL */
    size_t wr;
    uint32_t hdr;
    uint64_t lhdr;
@@ -2235,9 +7416,16 @@ int bdio_flush_record( BDIO *fh)
    if( fh->state == BDIO_R_STATE )
    {
       /* finish last record */
+      if( fh->renc && enc_finish(fh)!=0 )
+      {
+         bdio_error(0,"Error in bdio_flush_record. Could not encode.",fh);
+         fh->state=BDIO_E_STATE;
+         return EOF;
+      }
       if(fh->rlongrec)
       {
-         lhdr = HEADER_INT_LONG(fh->rfmt, fh->ruinfo, fh->rlen);
+         lhdr = HEADER_INT_LONG(head_fmt(fh), fh->ruinfo, fh->rlen)
+              | head_bits(fh);
          if (fh->endian == BDIO_BEND)
             swap64(&lhdr,8);
          /* update record header in file */
@@ -2270,7 +7458,8 @@ int bdio_flush_record( BDIO *fh)
          }
       }else
       {
-         hdr  = HEADER_INT(fh->rfmt, fh->ruinfo, fh->rlen);
+         hdr  = HEADER_INT(head_fmt(fh), fh->ruinfo, fh->rlen)
+              | head_bits(fh);
          if (fh->endian == BDIO_BEND)
             swap32(&hdr,4);
          /* update record header in file */
@@ -2315,9 +7504,9 @@ int bdio_flush_record( BDIO *fh)
       fh->bufstart=0;
       fh->bufidx=0;
       fh->state = BDIO_N_STATE;
-      if( fh->hash_auto==BDIO_AUTO_HASH )
+      if( fh->hash_auto==BDIO_AUTO_HASH && (fh->rhash || digest!=NULL) )
       {
-         if( bdio_write_hash(fh) != 20)
+         if( bdio_write_hash(digest, fh)==EOF )
          {
             bdio_error(1,"Error in bdio_flush_record. Could not write hash record.",fh);
             fh->state=BDIO_E_STATE;
@@ -2334,3 +7523,364 @@ int bdio_flush_record( BDIO *fh)
    
    return 0;
 }
+
+
+
+int bdio_flush_record( BDIO *fh)
+{
+   return flush_record(NULL, fh);
+}
+
+
+int bdio_write_records(int n, int fmt, int uinfo, void **ptr, size_t *nb,
+                       BDIO *fh)
+{
+   MD5_MB_JOB mb[BDIO_VERIFY_BATCH];
+   unsigned char digest[BDIO_VERIFY_BATCH][16];
+   int i, j, nj, batch;
+
+   if( !is_valid_bdio("bdio_write_records", fh) )
+   {
+      return 0;
+   }
+   if( bdio_flush_record(fh)==EOF )
+   {
+      return 0;
+   }
+
+   /* single-mode MD5 checksums of independent records are computed by the
+    * multi-buffer engine before the records are written, which are then
+    * not hashed again */
+   batch = (fh->hash_auto==BDIO_AUTO_HASH) && (fh->hash_type==BDIO_HASH_MD5)
+         &&(fh->hash_mode==BDIO_HASH_SINGL) && (fh->codec==BDIO_CODEC_NONE)
+         &&!is_complex_fmt(fmt);
+
+   for( i=0; i<n; i+=nj )
+   {
+      nj = (n-i<BDIO_VERIFY_BATCH) ? n-i : BDIO_VERIFY_BATCH;
+      if( batch )
+      {
+         for( j=0; j<nj; j++ )
+         {
+            mb[j].prefix = NULL;
+            mb[j].plen   = 0;
+            mb[j].data   = (const unsigned char*) ptr[i+j];
+            mb[j].size   = nb[i+j];
+            mb[j].digest = digest[j];
+         }
+         MD5_MB_Hash(mb, nj);
+      }
+      for( j=0; j<nj; j++ )
+      {
+         if( (start_record(fmt, uinfo, !batch, fh)==EOF)
+           ||(bdio_write(ptr[i+j], nb[i+j], fh)!=nb[i+j])
+           ||(flush_record(batch ? digest[j] : NULL, fh)==EOF) )
+            return i+j;
+      }
+   }
+   return n;
+}
+
+
+static void dset_error(int syserr, char *errmsg)
+{
+   /* a dataset has no error state, errors of its files are recorded by the
+    * files' handles */
+   if( default_verbosity )
+   {
+      if( syserr!=0 )
+         fprintf(default_msg, "%s\n  %.128s\n", errmsg, strerror(errno));
+      else
+         fprintf(default_msg, "%s\n", errmsg);
+   }
+}
+
+static BDIO *dset_open_file(BDIO_DSET *ds, int k, int lazy)
+{
+   BDIO *fh;
+
+   if( (fh = bdio_open(ds->files[k].path, "r", NULL))==NULL )
+      return NULL;
+   if( (lazy || (ds->flags & BDIO_DSET_LAZY)) && bdio_lazy_headers(1, fh)!=0 )
+   {
+      bdio_close(fh);
+      return NULL;
+   }
+   if( (ds->flags & BDIO_DSET_VERIFY) && bdio_verify_on_read(1, fh)!=0 )
+   {
+      bdio_close(fh);
+      return NULL;
+   }
+   return fh;
+}
+
+static int dset_work(dpool *p, int k)
+{
+   /* scans file k for bdio_dataset_open or passes its records to p->fn */
+   BDIO_DSET_FILE *f = &(p->ds->files[k]);
+   BDIO *fh;
+   int ret=0;
+
+   if( (fh = dset_open_file(p->ds, k, p->fn==NULL))==NULL )
+      return EOF;
+   if( p->fn==NULL )
+   {
+      while( bdio_seek_header(fh)!=EOF );
+      f->hcnt = fh->hcnt;
+      f->nrec = fh->rcnt;
+      f->size = fh->rstart+fh->rlen;
+   }else
+   {
+      while( bdio_seek_record(fh)!=EOF )
+         if( fh->state==BDIO_R_STATE && p->fn(fh, f->first+fh->rcnt, p->arg)!=0 )
+         {
+            ret = EOF;
+            break;
+         }
+      if( fh->nerror>0 )
+         ret = EOF;
+   }
+   if( fh->state==BDIO_E_STATE )
+      ret = EOF;
+   if( bdio_close(fh)!=0 )
+      ret = EOF;
+   return ret;
+}
+
+#ifndef _NO_POSIX_LIBS
+static void *dset_thread(void *arg)
+{
+   dpool *p = (dpool*) arg;
+   int k;
+
+   for(;;)
+   {
+      pthread_mutex_lock(&(p->lock));
+      k = p->err ? p->ds->n : p->next++;
+      pthread_mutex_unlock(&(p->lock));
+      if( k>=p->ds->n )
+         break;
+      if( dset_work(p, k)!=0 )
+      {
+         pthread_mutex_lock(&(p->lock));
+         p->err = 1;
+         pthread_mutex_unlock(&(p->lock));
+      }
+   }
+   return NULL;
+}
+#endif
+
+static int dset_run(dpool *p, int nthreads)
+{
+   /* distributes the files of p->ds over nthreads threads, each file is
+    * handled by a single thread */
+   int k;
+#ifndef _NO_POSIX_LIBS
+   pthread_t *threads=NULL;
+   int i;
+
+   if( nthreads>p->ds->n )
+      nthreads = p->ds->n;
+   if( nthreads>1 &&
+       (threads = (pthread_t*) malloc(nthreads*sizeof(pthread_t)))!=NULL )
+   {
+      pthread_mutex_init(&(p->lock), NULL);
+      for( i=0; i<nthreads; i++ )
+         if( pthread_create(&(threads[i]), NULL, dset_thread, p)!=0 )
+            break;
+      if( i>0 )
+      {
+         nthreads = i;
+         for( i=0; i<nthreads; i++ )
+            pthread_join(threads[i], NULL);
+      }
+      pthread_mutex_destroy(&(p->lock));
+      free(threads);
+   }
+#endif
+   /* without threads, or if none could be started */
+   for( k=p->next; k<p->ds->n && !p->err; k++ )
+      if( dset_work(p, k)!=0 )
+         p->err = 1;
+   return p->err ? EOF : 0;
+}
+
+BDIO_DSET *bdio_dataset_open(char *const *paths, int n, int flags)
+{
+   BDIO_DSET *ds;
+   dpool p;
+   int k;
+
+   if( paths==NULL || n<=0 )
+   {
+      dset_error(0, "Error in bdio_dataset_open. No files given.");
+      return NULL;
+   }
+   if( (flags & ~(BDIO_DSET_VERIFY|BDIO_DSET_LAZY))!=0 )
+   {
+      dset_error(0, "Error in bdio_dataset_open. Unknown flags.");
+      return NULL;
+   }
+   if( (ds = (BDIO_DSET*) malloc(sizeof(BDIO_DSET)))==NULL ||
+       (ds->files = (BDIO_DSET_FILE*) calloc(n, sizeof(BDIO_DSET_FILE)))==NULL )
+   {
+      dset_error(1, "Error in bdio_dataset_open. malloc fails with");
+      free(ds);
+      return NULL;
+   }
+   ds->n = n;
+   ds->flags = flags;
+   ds->cur = -1;
+   ds->fh = NULL;
+   for( k=0; k<n; k++ )
+   {
+      ds->files[k].path = (char*) malloc(strlen(paths[k])+1);
+      if( ds->files[k].path==NULL )
+      {
+         dset_error(1, "Error in bdio_dataset_open. malloc fails with");
+         bdio_dataset_close(ds);
+         return NULL;
+      }
+      strcpy(ds->files[k].path, paths[k]);
+   }
+
+   /* the files are scanned in parallel, each by a handle of its own that is
+    * closed again right away */
+   if( default_msg==NULL )
+      default_msg = stderr;
+   p.ds = ds;
+   p.fn = NULL;
+   p.arg = NULL;
+   p.next = 0;
+   p.err = 0;
+   if( dset_run(&p, BDIO_DSET_THREADS)!=0 )
+   {
+      dset_error(0, "Error in bdio_dataset_open. Could not scan all files.");
+      bdio_dataset_close(ds);
+      return NULL;
+   }
+   ds->nrec = 0;
+   for( k=0; k<n; k++ )
+   {
+      ds->files[k].first = ds->nrec;
+      ds->nrec += ds->files[k].nrec;
+   }
+   return ds;
+}
+
+int bdio_dataset_close(BDIO_DSET *ds)
+{
+   int k, ret=0;
+
+   if( ds==NULL )
+      return EOF;
+   if( ds->fh!=NULL )
+      ret = bdio_close(ds->fh);
+   for( k=0; k<ds->n; k++ )
+      free(ds->files[k].path);
+   free(ds->files);
+   free(ds);
+   return ret;
+}
+
+static int dset_goto_file(int k, BDIO_DSET *ds)
+{
+   /* only one file of a dataset is open at a time */
+   if( ds->fh!=NULL )
+      bdio_close(ds->fh);
+   ds->cur = k;
+   if( (ds->fh = dset_open_file(ds, k, 0))==NULL )
+      return EOF;
+   return 0;
+}
+
+int bdio_dataset_seek_record(BDIO_DSET *ds)
+{
+   if( ds==NULL )
+      return EOF;
+   for(;;)
+   {
+      if( ds->fh==NULL )
+      {
+         if( ds->cur+1>=ds->n || dset_goto_file(ds->cur+1, ds)!=0 )
+            return EOF;
+      }
+      if( bdio_seek_record(ds->fh)!=EOF )
+      {
+         if( ds->fh->state==BDIO_R_STATE )
+            return 0;
+         continue;
+      }
+      if( ds->fh->state==BDIO_E_STATE )
+         return EOF;
+      bdio_close(ds->fh);
+      ds->fh = NULL;
+   }
+}
+
+int bdio_dataset_goto_record(int grec, BDIO_DSET *ds)
+{
+   int lo, hi, k, rec;
+
+   if( ds==NULL )
+      return EOF;
+   if( grec<1 || grec>ds->nrec )
+   {
+      dset_error(0, "Error in bdio_dataset_goto_record. No such record.");
+      return EOF;
+   }
+   /* the last file with first<grec */
+   lo = 0;
+   hi = ds->n-1;
+   while( lo<hi )
+   {
+      k = (lo+hi+1)/2;
+      if( ds->files[k].first<grec )
+         lo = k;
+      else
+         hi = k-1;
+   }
+   k = lo;
+   rec = grec-ds->files[k].first;
+
+   if( ds->fh!=NULL && ds->cur==k && ds->fh->rcnt==rec &&
+       ds->fh->state==BDIO_R_STATE )
+      return bdio_seek_in_record(0, SEEK_SET, ds->fh);
+   if( ds->fh==NULL || ds->cur!=k || ds->fh->rcnt>=rec )
+      if( dset_goto_file(k, ds)!=0 )
+         return EOF;
+   while( ds->fh->rcnt<rec )
+      if( bdio_seek_record(ds->fh)==EOF )
+         return EOF;
+   return 0;
+}
+
+BDIO *bdio_dataset_member(BDIO_DSET *ds)
+{
+   if( ds==NULL )
+      return NULL;
+   return ds->fh;
+}
+
+int bdio_dataset_rcnt(BDIO_DSET *ds)
+{
+   if( ds==NULL || ds->fh==NULL )
+      return EOF;
+   return ds->files[ds->cur].first+ds->fh->rcnt;
+}
+
+int bdio_dataset_for_each(int (*fn)(BDIO *fh, int grec, void *arg), void *arg,
+                          int nthreads, BDIO_DSET *ds)
+{
+   dpool p;
+
+   if( ds==NULL || fn==NULL )
+      return EOF;
+   p.ds = ds;
+   p.fn = fn;
+   p.arg = arg;
+   p.next = 0;
+   p.err = 0;
+   return dset_run(&p, nthreads);
+}
@@ -0,0 +1,184 @@
+/** @file crc32c.c
+ *  @brief CRC32C (Castagnoli) checksums for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <crc32c.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+   /* SSE4.2 crc32 instruction, selected at run time */
+   #include <nmmintrin.h>
+   #define CRC32C_HW 1
+#endif
+
+/* reflected Castagnoli polynomial */
+#define CRC32C_POLY 0x82f63b78
+
+/* lookup tables for the portable slicing-by-8 implementation */
+static uint32_t crc_tab[8][256];
+static volatile int crc_tab_ready = 0;
+
+/* 1 if the crc32 instruction can be used, 0 if not, -1 if not yet known */
+static volatile int crc_hw = -1;
+
+
+static void crc_tab_init(void)
+{
+   uint32_t c;
+   int i, j;
+
+   for( i=0; i<256; i++ )
+   {
+      c = i;
+      for( j=0; j<8; j++ )
+         c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : (c >> 1);
+      crc_tab[0][i] = c;
+   }
+   for( i=0; i<256; i++ )
+   {
+      c = crc_tab[0][i];
+      for( j=1; j<8; j++ )
+      {
+         c = crc_tab[0][c & 0xff] ^ (c >> 8);
+         crc_tab[j][i] = c;
+      }
+   }
+   crc_tab_ready = 1;
+}
+
+
+static uint32_t crc_sw(uint32_t crc, const unsigned char *p, unsigned long n)
+{
+   uint32_t lo, hi;
+
+   while( n>0 && ((uintptr_t) p & 7) )
+   {
+      crc = crc_tab[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+      n--;
+   }
+   while( n>=8 )
+   {
+      /* assemble words byte by byte, so that the result does not depend
+       * on the endianness of the machine */
+      lo = crc ^ ( (uint32_t) p[0]        | ((uint32_t) p[1] << 8)
+                 |((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24) );
+      hi =         (uint32_t) p[4]        | ((uint32_t) p[5] << 8)
+                 |((uint32_t) p[6] << 16) | ((uint32_t) p[7] << 24);
+      crc =  crc_tab[7][ lo        & 0xff] ^ crc_tab[6][(lo >>  8) & 0xff]
+           ^ crc_tab[5][(lo >> 16) & 0xff] ^ crc_tab[4][ lo >> 24        ]
+           ^ crc_tab[3][ hi        & 0xff] ^ crc_tab[2][(hi >>  8) & 0xff]
+           ^ crc_tab[1][(hi >> 16) & 0xff] ^ crc_tab[0][ hi >> 24        ];
+      p += 8;
+      n -= 8;
+   }
+   while( n>0 )
+   {
+      crc = crc_tab[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+      n--;
+   }
+   return crc;
+}
+
+
+#ifdef CRC32C_HW
+__attribute__((target("sse4.2")))
+static uint32_t crc_hw_sse42(uint32_t crc, const unsigned char *p,
+                             unsigned long n)
+{
+   uint64_t c, w;
+
+   while( n>0 && ((uintptr_t) p & 7) )
+   {
+      crc = _mm_crc32_u8(crc, *p++);
+      n--;
+   }
+   c = crc;
+   while( n>=32 )
+   {
+      memcpy(&w, p,    8); c = _mm_crc32_u64(c, w);
+      memcpy(&w, p+8,  8); c = _mm_crc32_u64(c, w);
+      memcpy(&w, p+16, 8); c = _mm_crc32_u64(c, w);
+      memcpy(&w, p+24, 8); c = _mm_crc32_u64(c, w);
+      p += 32;
+      n -= 32;
+   }
+   while( n>=8 )
+   {
+      memcpy(&w, p, 8);
+      c = _mm_crc32_u64(c, w);
+      p += 8;
+      n -= 8;
+   }
+   crc = (uint32_t) c;
+   while( n>0 )
+   {
+      crc = _mm_crc32_u8(crc, *p++);
+      n--;
+   }
+   return crc;
+}
+#endif
+
+
+void CRC32C_Init(CRC32C_CTX *ctx)
+{
+   if( crc_hw<0 )
+   {
+#ifdef CRC32C_HW
+      __builtin_cpu_init();
+      crc_hw = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+#else
+      crc_hw = 0;
+#endif
+   }
+   if( !crc_hw && !crc_tab_ready )
+      crc_tab_init();
+   ctx->crc = 0xffffffff;
+}
+
+
+void CRC32C_Update(CRC32C_CTX *ctx, const void *data, unsigned long size)
+{
+#ifdef CRC32C_HW
+   if( crc_hw )
+   {
+      ctx->crc = crc_hw_sse42(ctx->crc, (const unsigned char*) data, size);
+      return;
+   }
+#endif
+   ctx->crc = crc_sw(ctx->crc, (const unsigned char*) data, size);
+}
+
+
+void CRC32C_Final(unsigned char *result, CRC32C_CTX *ctx)
+{
+   uint32_t crc;
+
+   /* the checksum is stored in little endian byte order */
+   crc = ctx->crc ^ 0xffffffff;
+   result[0] = crc & 0xff;
+   result[1] = (crc >> 8) & 0xff;
+   result[2] = (crc >> 16) & 0xff;
+   result[3] = (crc >> 24) & 0xff;
+   memset(ctx, 0, sizeof(*ctx));
+}
@@ -0,0 +1,140 @@
+/** @file half.c
+ *  @brief Half precision conversions for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <half.h>
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+static uint16_t f32_to_f16(float f)
+{
+   uint32_t x, m, rem, half;
+   uint16_t s, h;
+   int e;
+
+   memcpy(&x, &f, 4);
+   s = (uint16_t) ((x >> 16) & 0x8000);
+   e = (int) ((x >> 23) & 0xff) - 127 + 15;
+   m = x & 0x7fffff;
+   if( e==255-127+15 )
+      /* infinity, or NaN with its upper payload bits and kept quiet */
+      return (uint16_t) (s | 0x7c00 | (m ? 0x200 | (m >> 13) : 0));
+   if( e>=31 )
+      return (uint16_t) (s | 0x7c00);
+   if( e<=0 )
+   {
+      /* subnormal, or 0 below half the smallest subnormal */
+      if( e < -10 )
+         return s;
+      m |= 0x800000;
+      h = (uint16_t) (m >> (14-e));
+      rem  = m & ((1U << (14-e)) - 1);
+      half = 1U << (13-e);
+   }else
+   {
+      h = (uint16_t) ((e << 10) | (m >> 13));
+      rem  = m & 0x1fff;
+      half = 0x1000;
+   }
+   /* a carry into the exponent is the correct rounding */
+   if( rem>half || (rem==half && (h & 1)) )
+      h++;
+   return (uint16_t) (s | h);
+}
+
+static float f16_to_f32(uint16_t h)
+{
+   uint32_t x, s=(uint32_t) (h & 0x8000) << 16, m=h & 0x3ff;
+   int e = (h >> 10) & 0x1f;
+   float f;
+
+   if( e==0 )
+   {
+      /* subnormals are m*2^-24 */
+      f = (float) m * (1.0f/16777216.0f);
+      return (s ? -f : f);
+   }
+   if( e==31 )
+      x = s | 0x7f800000 | (m << 13);
+   else
+      x = s | ((uint32_t) (e+112) << 23) | (m << 13);
+   memcpy(&f, &x, 4);
+   return f;
+}
+
+void HALF_F32ToF16(const float *src, uint16_t *dst, size_t n)
+{
+   size_t i=0;
+
+#ifdef __F16C__
+   for( ; i+8<=n; i+=8 )
+      _mm_storeu_si128((__m128i*) (dst+i),
+                       _mm256_cvtps_ph(_mm256_loadu_ps(src+i),
+                                       _MM_FROUND_TO_NEAREST_INT));
+#endif
+   for( ; i<n; i++ )
+      dst[i] = f32_to_f16(src[i]);
+}
+
+void HALF_F16ToF32(const uint16_t *src, float *dst, size_t n)
+{
+   size_t i=0;
+
+#ifdef __F16C__
+   for( ; i+8<=n; i+=8 )
+      _mm256_storeu_ps(dst+i, _mm256_cvtph_ps(
+                       _mm_loadu_si128((const __m128i*) (src+i))));
+#endif
+   for( ; i<n; i++ )
+      dst[i] = f16_to_f32(src[i]);
+}
+
+void HALF_F32ToBF16(const float *src, uint16_t *dst, size_t n)
+{
+   uint32_t x;
+   size_t i;
+
+   for( i=0; i<n; i++ )
+   {
+      memcpy(&x, src+i, 4);
+      if( (x & 0x7fffffff) > 0x7f800000 )
+         dst[i] = (uint16_t) ((x >> 16) | 0x40);
+      else
+         dst[i] = (uint16_t) ((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+   }
+}
+
+void HALF_BF16ToF32(const uint16_t *src, float *dst, size_t n)
+{
+   uint32_t x;
+   size_t i;
+
+   for( i=0; i<n; i++ )
+   {
+      x = (uint32_t) src[i] << 16;
+      memcpy(dst+i, &x, 4);
+   }
+}
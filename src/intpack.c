@@ -0,0 +1,196 @@
+/** @file intpack.c
+ *  @brief Integer packing for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <intpack.h>
+
+/* a group is
+ *
+ *   width(1)  cnt*width bits, least significant bit first
+ *
+ * with cnt=128 except for the last group of a block. The first element of
+ * a block is coded as difference to 0. */
+#define GROUP 128
+
+static uint64_t get_elem(const unsigned char *p, int size, int bigend)
+{
+   uint64_t x=0;
+   int k;
+
+   if( bigend )
+      for( k=0; k<size; k++ )
+         x = (x << 8) | p[k];
+   else
+      for( k=size-1; k>=0; k-- )
+         x = (x << 8) | p[k];
+   return x;
+}
+
+static void put_elem(unsigned char *p, uint64_t x, int size, int bigend)
+{
+   int k;
+
+   if( !bigend && size==8 )
+   {
+      p[0] = (unsigned char) x;         p[1] = (unsigned char) (x >> 8);
+      p[2] = (unsigned char) (x >> 16); p[3] = (unsigned char) (x >> 24);
+      p[4] = (unsigned char) (x >> 32); p[5] = (unsigned char) (x >> 40);
+      p[6] = (unsigned char) (x >> 48); p[7] = (unsigned char) (x >> 56);
+   }else if( bigend )
+      for( k=size-1; k>=0; k--, x>>=8 )
+         p[k] = (unsigned char) x;
+   else
+      for( k=0; k<size; k++, x>>=8 )
+         p[k] = (unsigned char) x;
+}
+
+static uint64_t zigzag(uint64_t d, int size)
+{
+   /* d is a difference modulo 2^(8*size), the result is small for small
+    * positive and negative differences */
+   uint64_t sign;
+
+   if( size==4 )
+   {
+      d &= 0xffffffffU;
+      sign = (d >> 31) ? 0xffffffffU : 0;
+   }else
+      sign = (d >> 63) ? ~(uint64_t)0 : 0;
+   return ((d << 1) ^ sign) & (size==4 ? 0xffffffffU : ~(uint64_t)0);
+}
+
+static uint64_t unzigzag(uint64_t z)
+{
+   return (z >> 1) ^ (~(z & 1) + 1);
+}
+
+static uint64_t load64(const unsigned char *p, const unsigned char *end)
+{
+   /* 8 little endian bytes, the ones beyond end are 0 */
+   uint64_t x=0;
+   int k;
+
+   if( end-p>=8 )
+      /* compilers turn this into a single load on little endian machines */
+      return  (uint64_t) p[0]        | ((uint64_t) p[1] << 8)
+           | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24)
+           | ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40)
+           | ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+   for( k=(int) (end-p)-1; k>=0; k-- )
+      x = (x << 8) | p[k];
+   return x;
+}
+
+static uint64_t get_bits(const unsigned char *p, const unsigned char *end,
+                         uint64_t pos, int w)
+{
+   /* w<=32 bits starting at bit pos of p */
+   uint64_t x = load64(p+(pos >> 3), end) >> (pos & 7);
+
+   return x & ((((uint64_t) 1) << w) - 1);
+}
+
+int IPK_Pack(const unsigned char *src, int n, int size, int bigend,
+             unsigned char *dst, int cap)
+{
+   uint64_t z[GROUP], prev=0, x, acc, m;
+   int ne, g, cnt, i, w, wl, nbits, op=0;
+
+   if( (size!=4 && size!=8) || n%size!=0 )
+      return 0;
+   ne = n/size;
+   for( g=0; g<ne; g+=GROUP )
+   {
+      cnt = (ne-g < GROUP) ? ne-g : GROUP;
+      m = 0;
+      for( i=0; i<cnt; i++ )
+      {
+         x = get_elem(src+(size_t)(g+i)*size, size, bigend);
+         z[i] = zigzag(x-prev, size);
+         prev = x;
+         m |= z[i];
+      }
+      for( w=0; w<64 && (m >> w)!=0; w++ );
+      if( cap-op < 1+(cnt*w+7)/8 )
+         return 0;
+      dst[op++] = (unsigned char) w;
+      /* bits are collected in acc, at most 32 at a time, and written in
+       * whole bytes */
+      wl = (w>32) ? 32 : w;
+      acc = 0;
+      nbits = 0;
+      for( i=0; i<cnt && w>0; i++ )
+      {
+         acc |= (z[i] & ((((uint64_t) 1) << wl) - 1)) << nbits;
+         nbits += wl;
+         if( w>32 )
+         {
+            for( ; nbits>=8; nbits-=8, acc>>=8 )
+               dst[op++] = (unsigned char) acc;
+            acc |= (z[i] >> 32) << nbits;
+            nbits += w-32;
+         }
+         for( ; nbits>=8; nbits-=8, acc>>=8 )
+            dst[op++] = (unsigned char) acc;
+      }
+      if( nbits>0 )
+         dst[op++] = (unsigned char) acc;
+   }
+   return op;
+}
+
+int IPK_Unpack(const unsigned char *src, int m, unsigned char *dst,
+               int n, int size, int bigend)
+{
+   const unsigned char *end=src+m;
+   uint64_t prev=0, z, pos;
+   int ne, g, cnt, i, w, ip=0;
+
+   if( (size!=4 && size!=8) || n%size!=0 )
+      return -1;
+   ne = n/size;
+   for( g=0; g<ne; g+=GROUP )
+   {
+      cnt = (ne-g < GROUP) ? ne-g : GROUP;
+      if( ip>=m )
+         return -1;
+      w = src[ip++];
+      if( w>8*size || (cnt*w+7)/8 > m-ip )
+         return -1;
+      pos = 0;
+      for( i=0; i<cnt; i++ )
+      {
+         if( w<=32 )
+            z = get_bits(src+ip, end, pos, w);
+         else
+            z = get_bits(src+ip, end, pos, 32)
+                | (get_bits(src+ip, end, pos+32, w-32) << 32);
+         pos += w;
+         prev += unzigzag(z);
+         put_elem(dst+(size_t)(g+i)*size, prev, size, bigend);
+      }
+      ip += (cnt*w+7)/8;
+   }
+   return (ip==m) ? 0 : -1;
+}
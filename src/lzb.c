@@ -0,0 +1,206 @@
+/** @file lzb.c
+ *  @brief Block compression for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <lzb.h>
+
+/* a sequence is
+ *
+ *   token  [literal length bytes]  literals  offset(2, LE)  [match bytes]
+ *
+ * the upper 4 bits of the token hold the number of literals, the lower 4
+ * bits the match length minus 4. The value 15 is continued by bytes that
+ * are added up until one is smaller than 255. The last sequence of a block
+ * consists of literals only. As in LZ4, the last 5 bytes are always
+ * literals and no match starts within the last 12 bytes. */
+#define MINMATCH     4
+#define LASTLITERALS 5
+#define MFLIMIT      12
+#define MAXOFFSET    65535
+#define HASH_LOG     12
+
+static uint32_t read32(const unsigned char *p)
+{
+   /* byte order does not matter, words are only hashed and compared */
+   uint32_t x;
+   memcpy(&x, p, 4);
+   return x;
+}
+
+static int hash4(uint32_t x)
+{
+   return (int) ((x * 2654435761U) >> (32-HASH_LOG));
+}
+
+static unsigned char *put_length(unsigned char *op, int len)
+{
+   /* continuation bytes of a length >= 15 */
+   len -= 15;
+   while( len>=255 )
+   {
+      *op++ = 255;
+      len -= 255;
+   }
+   *op++ = (unsigned char) len;
+   return op;
+}
+
+static unsigned char *put_sequence(unsigned char *op, unsigned char *oend,
+                                   const unsigned char *lit, int nlit,
+                                   int offset, int mlen)
+{
+   /* appends a sequence, mlen=0 for the last one. Returns NULL if it does
+    * not fit. */
+   unsigned char *token;
+
+   if( (oend-op) < 1+nlit+nlit/255+1+2+mlen/255+1 )
+      return NULL;
+   token = op++;
+   *token = (unsigned char) ((nlit>=15 ? 15 : nlit) << 4);
+   if( nlit>=15 )
+      op = put_length(op, nlit);
+   memcpy(op, lit, nlit);
+   op += nlit;
+   if( mlen==0 )
+      return op;
+   *op++ = (unsigned char) (offset & 0xff);
+   *op++ = (unsigned char) (offset >> 8);
+   mlen -= MINMATCH;
+   *token |= (unsigned char) (mlen>=15 ? 15 : mlen);
+   if( mlen>=15 )
+      op = put_length(op, mlen);
+   return op;
+}
+
+int LZB_Compress(const unsigned char *src, int n, unsigned char *dst, int cap)
+{
+   /* compresses n bytes from src into at most cap bytes at dst. Returns the
+    * compressed size, or 0 if it exceeds cap. */
+   int table[1<<HASH_LOG];
+   unsigned char *op=dst, *oend=dst+cap;
+   int ip, ref, anchor=0, mlen, h;
+
+   if( n>=MFLIMIT+1 )
+   {
+      memset(table, 0xff, sizeof(table));
+      ip = 0;
+      while( ip <= n-MFLIMIT )
+      {
+         h = hash4(read32(src+ip));
+         ref = table[h];
+         table[h] = ip;
+         if( ref<0 || ip-ref>MAXOFFSET || read32(src+ref)!=read32(src+ip) )
+         {
+            /* skip faster through data that does not compress */
+            ip += 1 + ((ip-anchor) >> 6);
+            continue;
+         }
+         while( ip>anchor && ref>0 && src[ip-1]==src[ref-1] )
+         {
+            ip--;
+            ref--;
+         }
+         mlen = MINMATCH;
+         while( ip+mlen < n-LASTLITERALS && src[ip+mlen]==src[ref+mlen] )
+            mlen++;
+         op = put_sequence(op, oend, src+anchor, ip-anchor, ip-ref, mlen);
+         if( op==NULL )
+            return 0;
+         ip += mlen;
+         anchor = ip;
+         if( ip <= n-MFLIMIT )
+            table[hash4(read32(src+ip-2))] = ip-2;
+      }
+   }
+   op = put_sequence(op, oend, src+anchor, n-anchor, 0, 0);
+   if( op==NULL )
+      return 0;
+   return (int) (op-dst);
+}
+
+static int get_length(const unsigned char **ip, const unsigned char *iend,
+                      int len, int max)
+{
+   /* adds the continuation bytes of a length, returns -1 on overrun or if
+    * the length exceeds max */
+   unsigned char b;
+
+   if( len!=15 )
+      return (len>max) ? -1 : len;
+   do
+   {
+      if( *ip>=iend )
+         return -1;
+      b = *(*ip)++;
+      len += b;
+      if( len>max )
+         return -1;
+   }while( b==255 );
+   return len;
+}
+
+int LZB_Decompress(const unsigned char *src, int n, unsigned char *dst, int cap)
+{
+   /* decompresses n bytes from src into at most cap bytes at dst. Returns
+    * the decompressed size, or -1 if src is malformed or does not fit. */
+   const unsigned char *ip=src, *iend=src+n;
+   int op=0, len, offset;
+   unsigned char token;
+
+   for(;;)
+   {
+      if( ip>=iend )
+         return -1;
+      token = *ip++;
+      if( (len=get_length(&ip, iend, token >> 4, cap-op))<0 )
+         return -1;
+      if( len > iend-ip )
+         return -1;
+      memcpy(dst+op, ip, len);
+      ip += len;
+      op += len;
+      if( ip==iend )
+         return op;
+
+      if( iend-ip<2 )
+         return -1;
+      offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if( offset==0 || offset>op )
+         return -1;
+      if( (len=get_length(&ip, iend, token & 0xf, cap-op-MINMATCH))<0 )
+         return -1;
+      len += MINMATCH;
+      if( offset>=len )
+      {
+         memcpy(dst+op, dst+op-offset, len);
+         op += len;
+      }else
+      {
+         /* overlapping copy repeats the last offset bytes */
+         for( ; len>0; len--, op++ )
+            dst[op] = dst[op-offset];
+      }
+   }
+}
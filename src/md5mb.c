@@ -0,0 +1,313 @@
+/** @file md5mb.c
+ *  @brief Multi-buffer MD5 checksums for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <md5mb.h>
+
+#if defined(__GNUC__)
+   /* lanes are elements of GCC vector types */
+   #define MD5MB_VEC 1
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+   /* AVX2 and AVX-512 kernels, selected at run time */
+   #define MD5MB_X86 1
+#endif
+
+#define MD5MB_MAX_LANES 16
+
+/* the basic MD5 functions, as in md5.c */
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define H(x, y, z) ((x) ^ (y) ^ (z))
+#define I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+#define STEP(f, a, b, c, d, x, t, s) \
+   (a) += f((b), (c), (d)) + (x) + (uint32_t) (t); \
+   (a) = ((a) << (s)) | ((a) >> (32 - (s))); \
+   (a) += (b);
+
+/* the 64 steps of the MD5 transformation, applied to the variables
+ * a, b, c, d and the message words x[0..15] of the calling kernel */
+#define MD5MB_ROUNDS \
+   STEP(F, a, b, c, d, x[0],  0xd76aa478, 7)  \
+   STEP(F, d, a, b, c, x[1],  0xe8c7b756, 12) \
+   STEP(F, c, d, a, b, x[2],  0x242070db, 17) \
+   STEP(F, b, c, d, a, x[3],  0xc1bdceee, 22) \
+   STEP(F, a, b, c, d, x[4],  0xf57c0faf, 7)  \
+   STEP(F, d, a, b, c, x[5],  0x4787c62a, 12) \
+   STEP(F, c, d, a, b, x[6],  0xa8304613, 17) \
+   STEP(F, b, c, d, a, x[7],  0xfd469501, 22) \
+   STEP(F, a, b, c, d, x[8],  0x698098d8, 7)  \
+   STEP(F, d, a, b, c, x[9],  0x8b44f7af, 12) \
+   STEP(F, c, d, a, b, x[10], 0xffff5bb1, 17) \
+   STEP(F, b, c, d, a, x[11], 0x895cd7be, 22) \
+   STEP(F, a, b, c, d, x[12], 0x6b901122, 7)  \
+   STEP(F, d, a, b, c, x[13], 0xfd987193, 12) \
+   STEP(F, c, d, a, b, x[14], 0xa679438e, 17) \
+   STEP(F, b, c, d, a, x[15], 0x49b40821, 22) \
+   STEP(G, a, b, c, d, x[1],  0xf61e2562, 5)  \
+   STEP(G, d, a, b, c, x[6],  0xc040b340, 9)  \
+   STEP(G, c, d, a, b, x[11], 0x265e5a51, 14) \
+   STEP(G, b, c, d, a, x[0],  0xe9b6c7aa, 20) \
+   STEP(G, a, b, c, d, x[5],  0xd62f105d, 5)  \
+   STEP(G, d, a, b, c, x[10], 0x02441453, 9)  \
+   STEP(G, c, d, a, b, x[15], 0xd8a1e681, 14) \
+   STEP(G, b, c, d, a, x[4],  0xe7d3fbc8, 20) \
+   STEP(G, a, b, c, d, x[9],  0x21e1cde6, 5)  \
+   STEP(G, d, a, b, c, x[14], 0xc33707d6, 9)  \
+   STEP(G, c, d, a, b, x[3],  0xf4d50d87, 14) \
+   STEP(G, b, c, d, a, x[8],  0x455a14ed, 20) \
+   STEP(G, a, b, c, d, x[13], 0xa9e3e905, 5)  \
+   STEP(G, d, a, b, c, x[2],  0xfcefa3f8, 9)  \
+   STEP(G, c, d, a, b, x[7],  0x676f02d9, 14) \
+   STEP(G, b, c, d, a, x[12], 0x8d2a4c8a, 20) \
+   STEP(H, a, b, c, d, x[5],  0xfffa3942, 4)  \
+   STEP(H, d, a, b, c, x[8],  0x8771f681, 11) \
+   STEP(H, c, d, a, b, x[11], 0x6d9d6122, 16) \
+   STEP(H, b, c, d, a, x[14], 0xfde5380c, 23) \
+   STEP(H, a, b, c, d, x[1],  0xa4beea44, 4)  \
+   STEP(H, d, a, b, c, x[4],  0x4bdecfa9, 11) \
+   STEP(H, c, d, a, b, x[7],  0xf6bb4b60, 16) \
+   STEP(H, b, c, d, a, x[10], 0xbebfbc70, 23) \
+   STEP(H, a, b, c, d, x[13], 0x289b7ec6, 4)  \
+   STEP(H, d, a, b, c, x[0],  0xeaa127fa, 11) \
+   STEP(H, c, d, a, b, x[3],  0xd4ef3085, 16) \
+   STEP(H, b, c, d, a, x[6],  0x04881d05, 23) \
+   STEP(H, a, b, c, d, x[9],  0xd9d4d039, 4)  \
+   STEP(H, d, a, b, c, x[12], 0xe6db99e5, 11) \
+   STEP(H, c, d, a, b, x[15], 0x1fa27cf8, 16) \
+   STEP(H, b, c, d, a, x[2],  0xc4ac5665, 23) \
+   STEP(I, a, b, c, d, x[0],  0xf4292244, 6)  \
+   STEP(I, d, a, b, c, x[7],  0x432aff97, 10) \
+   STEP(I, c, d, a, b, x[14], 0xab9423a7, 15) \
+   STEP(I, b, c, d, a, x[5],  0xfc93a039, 21) \
+   STEP(I, a, b, c, d, x[12], 0x655b59c3, 6)  \
+   STEP(I, d, a, b, c, x[3],  0x8f0ccc92, 10) \
+   STEP(I, c, d, a, b, x[10], 0xffeff47d, 15) \
+   STEP(I, b, c, d, a, x[1],  0x85845dd1, 21) \
+   STEP(I, a, b, c, d, x[8],  0x6fa87e4f, 6)  \
+   STEP(I, d, a, b, c, x[15], 0xfe2ce6e0, 10) \
+   STEP(I, c, d, a, b, x[6],  0xa3014314, 15) \
+   STEP(I, b, c, d, a, x[13], 0x4e0811a1, 21) \
+   STEP(I, a, b, c, d, x[4],  0xf7537e82, 6)  \
+   STEP(I, d, a, b, c, x[11], 0xbd3af235, 10) \
+   STEP(I, c, d, a, b, x[2],  0x2ad7d2bb, 15) \
+   STEP(I, b, c, d, a, x[9],  0xeb86d391, 21)
+
+/* a kernel processes one 64 byte block for each of its lanes. The state
+ * st and the message words w are stored lane-contiguous, i.e. st[k*n+l] is
+ * word k of lane l, where n is the number of lanes of the kernel. */
+#define MD5MB_KERNEL_BODY(vec, n) \
+   vec a, b, c, d, sa, sb, sc, sd, x[16]; \
+   int k; \
+   for( k=0; k<16; k++ ) \
+      memcpy(&x[k], w+k*(n), sizeof(vec)); \
+   memcpy(&a, st,       sizeof(vec)); \
+   memcpy(&b, st+(n),   sizeof(vec)); \
+   memcpy(&c, st+2*(n), sizeof(vec)); \
+   memcpy(&d, st+3*(n), sizeof(vec)); \
+   sa=a; sb=b; sc=c; sd=d; \
+   MD5MB_ROUNDS \
+   a+=sa; b+=sb; c+=sc; d+=sd; \
+   memcpy(st,       &a, sizeof(vec)); \
+   memcpy(st+(n),   &b, sizeof(vec)); \
+   memcpy(st+2*(n), &c, sizeof(vec)); \
+   memcpy(st+3*(n), &d, sizeof(vec));
+
+typedef void (*md5mb_kernel)(uint32_t *st, const uint32_t *w);
+
+static void md5mb_x1(uint32_t *st, const uint32_t *w)
+{
+   MD5MB_KERNEL_BODY(uint32_t, 1)
+}
+
+#ifdef MD5MB_VEC
+typedef uint32_t md5mb_v4 __attribute__((vector_size(16)));
+
+static void md5mb_x4(uint32_t *st, const uint32_t *w)
+{
+   MD5MB_KERNEL_BODY(md5mb_v4, 4)
+}
+#endif
+
+#ifdef MD5MB_X86
+typedef uint32_t md5mb_v8 __attribute__((vector_size(32)));
+typedef uint32_t md5mb_v16 __attribute__((vector_size(64)));
+
+__attribute__((target("avx2")))
+static void md5mb_x8(uint32_t *st, const uint32_t *w)
+{
+   MD5MB_KERNEL_BODY(md5mb_v8, 8)
+}
+
+__attribute__((target("avx512f")))
+static void md5mb_x16(uint32_t *st, const uint32_t *w)
+{
+   MD5MB_KERNEL_BODY(md5mb_v16, 16)
+}
+#endif
+
+/* widest kernel supported by the CPU, 0 if not yet known */
+static volatile int md5mb_lanes = 0;
+
+
+int MD5_MB_Lanes(void)
+{
+   if( md5mb_lanes==0 )
+   {
+#if defined(MD5MB_X86)
+      __builtin_cpu_init();
+      if( __builtin_cpu_supports("avx512f") )
+         md5mb_lanes = 16;
+      else if( __builtin_cpu_supports("avx2") )
+         md5mb_lanes = 8;
+      else
+         md5mb_lanes = 4;
+#elif defined(MD5MB_VEC)
+      md5mb_lanes = 4;
+#else
+      md5mb_lanes = 1;
+#endif
+   }
+   return md5mb_lanes;
+}
+
+
+static void get_block(const MD5_MB_JOB *job, unsigned long blk,
+                      unsigned long nblk, uint32_t *w, int stride)
+{
+   /* store the message words of block blk of job in w[0], w[stride], ... */
+   unsigned char tmp[64];
+   const unsigned char *p;
+   unsigned long pos, len, i;
+   uint64_t bits;
+   int k;
+
+   pos = blk*64;
+   len = job->plen + job->size;
+   if( (pos>=job->plen) && (pos+64<=len) )
+   {
+      p = job->data + (pos-job->plen);
+   }else
+   {
+      /* block overlaps the prefix or the padding */
+      memset(tmp, 0, 64);
+      for( i=0; (i<64) && (pos+i<len); i++ )
+         tmp[i] = (pos+i<job->plen) ? job->prefix[pos+i]
+                                    : job->data[pos+i-job->plen];
+      if( (pos+i==len) && (i<64) )
+         tmp[i] = 0x80;
+      if( blk==nblk-1 )
+      {
+         bits = (uint64_t) len << 3;
+         for( k=0; k<8; k++ )
+            tmp[56+k] = (bits >> (8*k)) & 0xff;
+      }
+      p = tmp;
+   }
+
+   /* message words are little endian, independent of the machine */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__)
+   for( k=0; k<16; k++ )
+      memcpy(&w[k*stride], p+4*k, 4);
+#else
+   for( k=0; k<16; k++ )
+      w[k*stride] =  (uint32_t) p[4*k]         | ((uint32_t) p[4*k+1] << 8)
+                  | ((uint32_t) p[4*k+2] << 16) | ((uint32_t) p[4*k+3] << 24);
+#endif
+}
+
+
+void MD5_MB_Hash(MD5_MB_JOB *jobs, int n)
+{
+   uint32_t st[4*MD5MB_MAX_LANES], w[16*MD5MB_MAX_LANES];
+   unsigned long blk[MD5MB_MAX_LANES], nblk[MD5MB_MAX_LANES];
+   int job[MD5MB_MAX_LANES];
+   int nl, l, k, next, active;
+   md5mb_kernel kernel;
+
+   /* narrowest kernel that keeps all messages busy */
+   nl = MD5_MB_Lanes();
+   while( (nl>1) && (nl/2>=n) )
+      nl /= 2;
+   switch( nl )
+   {
+#ifdef MD5MB_X86
+      case 16: kernel = md5mb_x16;
+               break;
+      case 8:  kernel = md5mb_x8;
+               break;
+#endif
+#ifdef MD5MB_VEC
+      case 4:  kernel = md5mb_x4;
+               break;
+#endif
+      default: kernel = md5mb_x1;
+               nl = 1;
+   }
+
+   memset(st, 0, sizeof(st));
+   memset(w, 0, sizeof(w));
+   for( l=0; l<nl; l++ )
+      job[l] = -1;
+
+   /* whenever a lane finishes its message it is refilled with the next */
+   next = 0;
+   for(;;)
+   {
+      active = 0;
+      for( l=0; l<nl; l++ )
+      {
+         if( (job[l]<0) && (next<n) )
+         {
+            job[l] = next++;
+            blk[l] = 0;
+            nblk[l] = (jobs[job[l]].plen + jobs[job[l]].size + 8)/64 + 1;
+            st[l]      = 0x67452301;
+            st[nl+l]   = 0xefcdab89;
+            st[2*nl+l] = 0x98badcfe;
+            st[3*nl+l] = 0x10325476;
+         }
+         if( job[l]>=0 )
+         {
+            get_block(&jobs[job[l]], blk[l], nblk[l], &w[l], nl);
+            active++;
+         }
+      }
+      if( active==0 )
+         break;
+
+      kernel(st, w);
+
+      for( l=0; l<nl; l++ )
+      {
+         if( (job[l]>=0) && (++blk[l]==nblk[l]) )
+         {
+            for( k=0; k<16; k++ )
+               jobs[job[l]].digest[k] = (st[(k/4)*nl+l] >> (8*(k%4))) & 0xff;
+            job[l] = -1;
+         }
+      }
+   }
+}
@@ -0,0 +1,183 @@
+/** @file shuffle.c
+ *  @brief Byte-shuffle and XOR-delta filters for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <shuffle.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+/* groups of 16 elements are transposed in registers. With r registers of
+ * 16 lanes, the byte at register i, lane l moves by
+ *
+ *    x[2i]   = unpacklo_epi8(x[i], x[i+r/2])
+ *    x[2i+1] = unpackhi_epi8(x[i], x[i+r/2])
+ *
+ * to the position whose bits (register, lane) are rotated left by one.
+ * The byte k of element e starts at bits (e, k) and has to end up at
+ * (k, e), i.e. 4 rotations shuffle and log2(16*size)-4 more undo it. */
+static void unpack_rounds(__m128i *x, int r, int rounds)
+{
+   __m128i y[8];
+   int i, k;
+
+   for( k=0; k<rounds; k++ )
+   {
+      for( i=0; i<r/2; i++ )
+      {
+         y[2*i]   = _mm_unpacklo_epi8(x[i], x[i+r/2]);
+         y[2*i+1] = _mm_unpackhi_epi8(x[i], x[i+r/2]);
+      }
+      for( i=0; i<r; i++ )
+         x[i] = y[i];
+   }
+}
+
+static int shuffle_sse2(const unsigned char *src, unsigned char *dst,
+                        int n, int size)
+{
+   /* returns the number of elements done */
+   __m128i x[8];
+   int g, i;
+
+   if( size!=4 && size!=8 )
+      return 0;
+   for( g=0; g+16<=n; g+=16 )
+   {
+      for( i=0; i<size; i++ )
+         x[i] = _mm_loadu_si128((const __m128i*) (src+g*size+16*i));
+      /* constant arguments let the compiler unroll the rounds */
+      if( size==8 )
+         unpack_rounds(x, 8, 4);
+      else
+         unpack_rounds(x, 4, 4);
+      for( i=0; i<size; i++ )
+         _mm_storeu_si128((__m128i*) (dst+(size_t)i*n+g), x[i]);
+   }
+   return g;
+}
+
+static int unshuffle_sse2(const unsigned char *src, unsigned char *dst,
+                          int n, int size)
+{
+   __m128i x[8];
+   int g, i;
+
+   if( size!=4 && size!=8 )
+      return 0;
+   for( g=0; g+16<=n; g+=16 )
+   {
+      for( i=0; i<size; i++ )
+         x[i] = _mm_loadu_si128((const __m128i*) (src+(size_t)i*n+g));
+      if( size==8 )
+         unpack_rounds(x, 8, 3);
+      else
+         unpack_rounds(x, 4, 2);
+      for( i=0; i<size; i++ )
+         _mm_storeu_si128((__m128i*) (dst+g*size+16*i), x[i]);
+   }
+   return g;
+}
+#endif
+
+void SHUF_Shuffle(const unsigned char *src, unsigned char *dst,
+                  int n, int size)
+{
+   /* byte k of element e is moved to position k*n+e */
+   int e=0, k;
+
+#ifdef __SSE2__
+   e = shuffle_sse2(src, dst, n, size);
+#endif
+   for( ; e<n; e++ )
+      for( k=0; k<size; k++ )
+         dst[(size_t)k*n+e] = src[(size_t)e*size+k];
+}
+
+void SHUF_Unshuffle(const unsigned char *src, unsigned char *dst,
+                    int n, int size)
+{
+   int e=0, k;
+
+#ifdef __SSE2__
+   e = unshuffle_sse2(src, dst, n, size);
+#endif
+   for( ; e<n; e++ )
+      for( k=0; k<size; k++ )
+         dst[(size_t)e*size+k] = src[(size_t)k*n+e];
+}
+
+void SHUF_XorDelta(unsigned char *p, int n, int size)
+{
+   uint64_t a, b;
+   uint32_t c, d;
+   int e;
+
+   if( size==8 )
+   {
+      for( e=n-1; e>0; e-- )
+      {
+         memcpy(&a, p+8*e, 8);
+         memcpy(&b, p+8*(e-1), 8);
+         a ^= b;
+         memcpy(p+8*e, &a, 8);
+      }
+   }else if( size==4 )
+   {
+      for( e=n-1; e>0; e-- )
+      {
+         memcpy(&c, p+4*e, 4);
+         memcpy(&d, p+4*(e-1), 4);
+         c ^= d;
+         memcpy(p+4*e, &c, 4);
+      }
+   }
+}
+
+void SHUF_XorUndelta(unsigned char *p, int n, int size)
+{
+   uint64_t a, b;
+   uint32_t c, d;
+   int e;
+
+   if( size==8 )
+   {
+      for( e=1; e<n; e++ )
+      {
+         memcpy(&a, p+8*e, 8);
+         memcpy(&b, p+8*(e-1), 8);
+         a ^= b;
+         memcpy(p+8*e, &a, 8);
+      }
+   }else if( size==4 )
+   {
+      for( e=1; e<n; e++ )
+      {
+         memcpy(&c, p+4*e, 4);
+         memcpy(&d, p+4*(e-1), 4);
+         c ^= d;
+         memcpy(p+4*e, &c, 4);
+      }
+   }
+}
@@ -0,0 +1,178 @@
+/** @file xxhash.c
+ *  @brief XXH64 checksums for the bdio-library
+ *  @details Details & license
+ *  @version 1.0
+ *  @copyright GNU Lesser General Public License v3.
+ */
+
+/*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include <xxhash.h>
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* input words are little endian, independent of the machine */
+static uint64_t read64(const unsigned char *p)
+{
+   return  (uint64_t) p[0]        | ((uint64_t) p[1] << 8)
+         |((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24)
+         |((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40)
+         |((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+static uint32_t read32(const unsigned char *p)
+{
+   return  (uint32_t) p[0]        | ((uint32_t) p[1] << 8)
+         |((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+   acc += input * PRIME64_2;
+   acc  = ROTL64(acc, 31);
+   acc *= PRIME64_1;
+   return acc;
+}
+
+static uint64_t xxh_merge(uint64_t acc, uint64_t val)
+{
+   acc ^= xxh_round(0, val);
+   acc  = acc * PRIME64_1 + PRIME64_4;
+   return acc;
+}
+
+static const unsigned char *xxh_body(uint64_t v[4], const unsigned char *p,
+                                     const unsigned char *end)
+{
+   uint64_t v1=v[0], v2=v[1], v3=v[2], v4=v[3];
+
+   do
+   {
+      v1 = xxh_round(v1, read64(p));
+      v2 = xxh_round(v2, read64(p+8));
+      v3 = xxh_round(v3, read64(p+16));
+      v4 = xxh_round(v4, read64(p+24));
+      p += 32;
+   }while( p+32<=end );
+
+   v[0]=v1; v[1]=v2; v[2]=v3; v[3]=v4;
+   return p;
+}
+
+
+void XXH64_Init(XXH64_CTX *ctx)
+{
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->v[0] = PRIME64_1 + PRIME64_2;
+   ctx->v[1] = PRIME64_2;
+   ctx->v[2] = 0;
+   ctx->v[3] = -PRIME64_1;
+}
+
+
+void XXH64_Update(XXH64_CTX *ctx, const void *data, unsigned long size)
+{
+   const unsigned char *p = (const unsigned char*) data;
+   const unsigned char *end = p + size;
+
+   ctx->total += size;
+
+   if( ctx->memsize+size < 32 )
+   {
+      memcpy(ctx->mem+ctx->memsize, p, size);
+      ctx->memsize += size;
+      return;
+   }
+
+   if( ctx->memsize>0 )
+   {
+      memcpy(ctx->mem+ctx->memsize, p, 32-ctx->memsize);
+      xxh_body(ctx->v, ctx->mem, ctx->mem+32);
+      p += 32-ctx->memsize;
+      ctx->memsize = 0;
+   }
+
+   if( p+32<=end )
+      p = xxh_body(ctx->v, p, end);
+
+   if( p<end )
+   {
+      memcpy(ctx->mem, p, end-p);
+      ctx->memsize = end-p;
+   }
+}
+
+
+void XXH64_Final(unsigned char *result, XXH64_CTX *ctx)
+{
+   const unsigned char *p = ctx->mem;
+   const unsigned char *end = ctx->mem + ctx->memsize;
+   uint64_t h;
+   int i;
+
+   if( ctx->total>=32 )
+   {
+      h =  ROTL64(ctx->v[0], 1)  + ROTL64(ctx->v[1], 7)
+         + ROTL64(ctx->v[2], 12) + ROTL64(ctx->v[3], 18);
+      h = xxh_merge(h, ctx->v[0]);
+      h = xxh_merge(h, ctx->v[1]);
+      h = xxh_merge(h, ctx->v[2]);
+      h = xxh_merge(h, ctx->v[3]);
+   }else
+   {
+      h = PRIME64_5;
+   }
+   h += ctx->total;
+
+   while( p+8<=end )
+   {
+      h ^= xxh_round(0, read64(p));
+      h  = ROTL64(h, 27) * PRIME64_1 + PRIME64_4;
+      p += 8;
+   }
+   if( p+4<=end )
+   {
+      h ^= (uint64_t) read32(p) * PRIME64_1;
+      h  = ROTL64(h, 23) * PRIME64_2 + PRIME64_3;
+      p += 4;
+   }
+   while( p<end )
+   {
+      h ^= (*p) * PRIME64_5;
+      h  = ROTL64(h, 11) * PRIME64_1;
+      p++;
+   }
+
+   h ^= h >> 33;
+   h *= PRIME64_2;
+   h ^= h >> 29;
+   h *= PRIME64_3;
+   h ^= h >> 32;
+
+   /* canonical (big endian) representation */
+   for( i=0; i<8; i++ )
+      result[i] = (h >> (56-8*i)) & 0xff;
+   memset(ctx, 0, sizeof(*ctx));
+}
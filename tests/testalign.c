@@ -0,0 +1,132 @@
+/* testalign.c
+ *
+ * tests the alignment of record payloads
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NREC 6
+
+static size_t rlen[NREC] = {0, 3, 8000, 13, 1100000, 24};
+
+
+void fill(unsigned char *d, int i)
+{
+   size_t j;
+
+   for( j=0; j<rlen[i]; j++ )
+      d[j] = (unsigned char) (j*7+i);
+}
+
+
+int write_file(char *file, int align, int hash)
+{
+   BDIO *fh;
+   unsigned char *d;
+   int i;
+
+   d = malloc(rlen[4]);
+   fh = bdio_open(file, "w", "Test file for aligned records");
+   if( fh==NULL || d==NULL || bdio_set_alignment(align, fh)!=0 )
+      return 1;
+   if( hash )
+      bdio_hash_auto(fh);
+   for( i=0; i<NREC; i++ )
+   {
+      fill(d, i);
+      if( bdio_start_record(BDIO_BIN_GENERIC, 2, fh)!=0 ||
+          bdio_write(d, rlen[i], fh)!=rlen[i] )
+         return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   return 0;
+}
+
+
+int read_file(char *file, int align)
+{
+   BDIO *fh;
+   unsigned char *d, *e;
+   int i=0;
+
+   d = malloc(rlen[4]);
+   e = malloc(rlen[4]);
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || d==NULL || e==NULL )
+      return 1;
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)!=2 )
+         continue;
+      if( i>=NREC || bdio_get_rlen(fh)!=rlen[i] )
+      {
+         printf("record %i has the wrong length\n", i);
+         return 1;
+      }
+      if( bdio_get_rstart(fh)%align!=0 )
+      {
+         printf("record %i starts at %lu, not aligned to %i\n", i,
+                (unsigned long) bdio_get_rstart(fh), align);
+         return 1;
+      }
+      fill(e, i);
+      if( bdio_read(d, rlen[i], fh)!=rlen[i] || memcmp(d, e, rlen[i])!=0 )
+      {
+         printf("record %i is corrupted\n", i);
+         return 1;
+      }
+      i++;
+   }
+   if( i!=NREC || fh->nerror!=0 )
+   {
+      printf("found %i records and %i errors\n", i, fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   free(e);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   int align[3] = {8, 64, 4096};
+   int i, hash;
+
+   bdio_set_dflt_verbose(1);
+   for( hash=0; hash<2; hash++ )
+      for( i=0; i<3; i++ )
+      {
+         if( write_file("align.dat", align[i], hash)!=0 )
+         {
+            printf("Could not write test file\n");
+            return 1;
+         }
+         if( read_file("align.dat", align[i])!=0 )
+            return 1;
+      }
+   fh = bdio_open("align.dat", "r", NULL);
+   if( bdio_verify(2, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails for aligned records\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   fh = bdio_open("align.dat", "w", "Test file for aligned records");
+   bdio_set_verbose(0, fh);
+   if( bdio_set_alignment(48, fh)!=EOF || bdio_set_alignment(4, fh)!=EOF )
+   {
+      printf("bdio_set_alignment accepts invalid alignments\n");
+      return 1;
+   }
+   bdio_close(fh);
+   printf("aligned records passed\n");
+   return 0;
+}
@@ -0,0 +1,147 @@
+/* testarray.c
+ *
+ * tests array records and hyperslab reads
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSLAB 4
+
+static uint64_t dims[4] = {6, 5, 4, 8};
+static uint64_t start[NSLAB][4] = {{3,0,0,0}, {1,1,0,2}, {0,0,0,0}, {5,4,3,7}};
+static uint64_t count[NSLAB][4] = {{1,5,4,8}, {3,2,4,3}, {6,5,4,8}, {1,1,1,1}};
+static uint64_t stride[NSLAB][4] = {{1,1,1,1}, {2,3,1,2}, {1,1,1,1},
+                                    {1,1,1,1}};
+
+
+int write_file(char *file)
+{
+   BDIO *fh;
+   double d[6*5*4*8], z[2*6*5*4*8];
+   int j, codec;
+
+   for( j=0; j<6*5*4*8; j++ )
+   {
+      d[j] = (double) j;
+      z[2*j] = (double) j;
+      z[2*j+1] = (double) -j;
+   }
+   fh = bdio_open(file, "w", "Test file for array records");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   for( codec=0; codec<2; codec++ )
+   {
+      bdio_set_codec(codec ? BDIO_CODEC_LZ : BDIO_CODEC_NONE, fh);
+      if( bdio_start_array(BDIO_BIN_F64, 3, 4, dims, fh)!=0 ||
+          bdio_write_f64(d, sizeof(d), fh)!=sizeof(d) )
+         return 1;
+      /* complex numbers are elements of 16 bytes */
+      if( bdio_start_array(BDIO_BIN_C128, 3, 4, dims, fh)!=0 ||
+          bdio_write_c128(z, 6*5*4*8, fh)!=6*5*4*8 )
+         return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check_slab(int s, int cplx, double *d, size_t nb)
+{
+   /* complex elements are followed by their negative imaginary part */
+   uint64_t i[4];
+   size_t n=0, es=cplx ? 16 : 8;
+   double v;
+
+   for( i[0]=0; i[0]<count[s][0]; i[0]++ )
+   for( i[1]=0; i[1]<count[s][1]; i[1]++ )
+   for( i[2]=0; i[2]<count[s][2]; i[2]++ )
+   for( i[3]=0; i[3]<count[s][3]; i[3]++ )
+   {
+      v = (double) ((((start[s][0]+i[0]*stride[s][0])*dims[1]
+                       +start[s][1]+i[1]*stride[s][1])*dims[2]
+                       +start[s][2]+i[2]*stride[s][2])*dims[3]
+                       +start[s][3]+i[3]*stride[s][3]);
+      if( es*n>=nb || (!cplx && d[n]!=v) ||
+          (cplx && (d[2*n]!=v || d[2*n+1]!=-v)) )
+      {
+         printf("hyperslab %i is wrong at element %lu\n", s,
+                (unsigned long) n);
+         return 1;
+      }
+      n++;
+   }
+   return (es*n!=nb);
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   double d[2*6*5*4*8];
+   uint64_t sdims[BDIO_MAX_NDIM], one[4]={0,0,0,1};
+   size_t nb;
+   int s, narr=0;
+
+   bdio_set_dflt_verbose(1);
+   if( write_file("array.dat")!=0 )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+   fh = bdio_open("array.dat", "r", NULL);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_array_shape(sdims, fh)==0 )
+         continue;
+      if( bdio_get_array_shape(sdims, fh)!=4 ||
+          memcmp(sdims, dims, sizeof(dims))!=0 )
+      {
+         printf("bdio_get_array_shape returns the wrong shape\n");
+         return 1;
+      }
+      for( s=0; s<NSLAB; s++ )
+      {
+         memset(d, 0, sizeof(d));
+         nb = bdio_read_hyperslab(start[s], count[s], (s==1) ? stride[s] :
+                                  NULL, d, fh);
+         if( check_slab(s, narr%2, d, nb)!=0 )
+         {
+            printf("hyperslab %i of array %i is wrong\n", s, narr);
+            return 1;
+         }
+      }
+      if( bdio_get_array_shape(sdims, fh)!=4 )
+      {
+         printf("shape of the data record is lost\n");
+         return 1;
+      }
+      bdio_set_verbose(0, fh);
+      if( bdio_is_complex_record(fh)!=narr%2 )
+      {
+         printf("array %i has the wrong kind of numbers\n", narr);
+         return 1;
+      }
+      if( bdio_read_hyperslab(start[3], count[3], stride[1], d, fh)
+          !=((narr%2) ? 16 : 8) ||
+          bdio_read_hyperslab(start[0], one, NULL, d, fh)!=0 ||
+          bdio_read_hyperslab(start[3], count[2], NULL, d, fh)!=0 )
+      {
+         printf("bdio_read_hyperslab accepts invalid hyperslabs\n");
+         return 1;
+      }
+      bdio_set_verbose(1, fh);
+      narr++;
+   }
+   bdio_close(fh);
+   if( narr!=4 )
+   {
+      printf("found %i instead of 4 arrays\n", narr);
+      return 1;
+   }
+   printf("array records passed\n");
+   return 0;
+}
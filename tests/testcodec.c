@@ -0,0 +1,365 @@
+/* testcodec.c
+ *
+ * tests the transparent compression and filtering of records
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include "testutil.h"
+
+#define NREC 8
+#define MAXLEN 3000000
+
+/* record lengths in bytes: empty, tiny, one block, a few blocks, long
+ * records that compress (stored as short record) and that do not (stored
+ * as long record). Every other record is compressed. */
+static size_t rlen[NREC] = {0, 8, 65536, 200008, 7, 1500000, 1048576, MAXLEN};
+static int rfmt[NREC] = {BDIO_BIN_F64, BDIO_BIN_F64, BDIO_BIN_F64,
+                         BDIO_BIN_INT32, BDIO_BIN_GENERIC, BDIO_BIN_F64,
+                         BDIO_BIN_GENERIC, BDIO_BIN_GENERIC};
+
+
+void fill(unsigned char *d, int i)
+{
+   size_t j;
+   double *f=(double*) d;
+   int32_t *n=(int32_t*) d;
+
+   if( rfmt[i]==BDIO_BIN_F64 )
+      for( j=0; j<rlen[i]/8; j++ )
+         f[j] = 0.25*(j%1000);
+   else if( rfmt[i]==BDIO_BIN_INT32 )
+      for( j=0; j<rlen[i]/4; j++ )
+         n[j] = (int32_t) (j/16);
+   else if( i==7 )
+      for( j=0; j<rlen[i]; j++ )
+         d[j] = (unsigned char) ((j*2654435761U) >> 13);
+   else
+      for( j=0; j<rlen[i]; j++ )
+         d[j] = (unsigned char) (j%251 < 100 ? 0 : j);
+}
+
+
+int write_file(char *file, int codec, int filter, int hash)
+{
+   BDIO *fh;
+   unsigned char *d;
+   size_t j, n;
+   int i;
+
+   d = malloc(MAXLEN);
+   fh = bdio_open(file, "w", "Test file for compressed records");
+   if( fh==NULL || d==NULL )
+      return 1;
+   if( hash )
+      bdio_hash_auto(fh);
+   if( bdio_set_filter(filter, fh)!=0 )
+      return 1;
+   for( i=0; i<NREC; i++ )
+   {
+      if( bdio_set_codec((i%2) ? codec : BDIO_CODEC_NONE, fh)!=0 )
+         return 1;
+      fill(d, i);
+      if( bdio_start_record(rfmt[i], 3, fh)!=0 )
+         return 1;
+      for( j=0; j<rlen[i]; j+=n )
+      {
+         n = (rlen[i]-j < 40008) ? rlen[i]-j : 40008;
+         if( bdio_write(d+j, n, fh)!=n )
+            return 1;
+      }
+      if( bdio_get_rlen(fh)!=rlen[i] )
+      {
+         printf("bdio_get_rlen returns %lu instead of %lu while writing\n",
+                (unsigned long) bdio_get_rlen(fh), (unsigned long) rlen[i]);
+         return 1;
+      }
+   }
+   bdio_close(fh);
+   free(d);
+   return 0;
+}
+
+
+int read_file(char *file, int verify)
+{
+   BDIO *fh;
+   unsigned char *d, *e;
+   size_t j, n;
+   int i=0;
+
+   d = malloc(MAXLEN);
+   e = malloc(MAXLEN);
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || d==NULL || e==NULL )
+      return 1;
+   if( verify )
+      bdio_verify_on_read(1, fh);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)!=3 )
+         continue;
+      if( bdio_get_rlen(fh)!=rlen[i] )
+      {
+         printf("record %i has length %lu instead of %lu\n", i,
+                (unsigned long) bdio_get_rlen(fh), (unsigned long) rlen[i]);
+         return 1;
+      }
+      /* read in pieces that do not match the blocks */
+      for( j=0; j<rlen[i]; j+=n )
+      {
+         n = (rlen[i]-j < 24000) ? rlen[i]-j : 24000;
+         if( bdio_read(d+j, n, fh)!=n )
+         {
+            printf("could not read record %i\n", i);
+            return 1;
+         }
+      }
+      fill(e, i);
+      if( memcmp(d, e, rlen[i])!=0 )
+      {
+         printf("record %i is corrupted\n", i);
+         return 1;
+      }
+      i++;
+   }
+   if( i!=NREC || fh->nerror!=0 )
+   {
+      printf("found %i records and %i errors\n", i, fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   free(e);
+   return 0;
+}
+
+
+int pack_file(char *file)
+{
+   /* monotonic int64 and int32 records in both byte orders, and a double
+    * record which is not packed */
+   int fmt[5] = {BDIO_BIN_INT64LE, BDIO_BIN_INT64BE, BDIO_BIN_INT32LE,
+                 BDIO_BIN_INT32BE, BDIO_BIN_F64LE};
+   int64_t *a, *b;
+   int32_t *c, *d;
+   size_t j, n=200000;
+   BDIO *fh;
+   int i;
+
+   a = malloc(n*8);
+   b = malloc(n*8);
+   c = (int32_t*) b;
+   d = (int32_t*) a;
+   fh = bdio_open(file, "w", "Test file for packed integers");
+   if( fh==NULL || a==NULL || b==NULL || bdio_set_codec(BDIO_CODEC_PACK, fh) )
+      return 1;
+   for( i=0; i<5; i++ )
+   {
+      bdio_start_record(fmt[i], 4, fh);
+      if( i<2 )
+      {
+         for( j=0; j<n; j++ )
+            a[j] = 5000000000LL + 3*j - (j%7);
+         bdio_write_int64(a, 8*n, fh);
+      }else if( i<4 )
+      {
+         for( j=0; j<n; j++ )
+            d[j] = -1000 - (int32_t) j;
+         bdio_write_int32(d, 4*n, fh);
+      }else
+         bdio_write_f64((double*) a, 8*n, fh);
+   }
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   bdio_verify_on_read(1, fh);
+   for( i=0; i<5; i++ )
+   {
+      if( bdio_seek_record(fh)==EOF || bdio_get_rfmt(fh)!=fmt[i] ||
+          bdio_get_rlen(fh)!=((i<2 || i==4) ? 8 : 4)*n )
+      {
+         printf("packed record %i has wrong format or length\n", i);
+         return 1;
+      }
+      if( i<2 )
+      {
+         bdio_read_int64(b, 8*n, fh);
+         for( j=0; j<n; j++ )
+            a[j] = 5000000000LL + 3*j - (j%7);
+      }else if( i<4 )
+      {
+         bdio_read_int32(c, 4*n, fh);
+         for( j=0; j<n; j++ )
+            d[j] = -1000 - (int32_t) j;
+      }else
+         bdio_read_f64((double*) b, 8*n, fh);
+      if( memcmp(a, b, (i==2 || i==3) ? 4*n : 8*n)!=0 )
+      {
+         printf("packed record %i is corrupted\n", i);
+         return 1;
+      }
+   }
+   if( fh->nerror!=0 )
+      return 1;
+   bdio_close(fh);
+   free(a);
+   free(b);
+   return 0;
+}
+
+
+int generic_file(char *file)
+{
+   /* the header of an encoded record has the generic binary format and the
+    * user info, its format is restored from the method word. The records
+    * are read through bdio_read_as_f64, which depends on the format. */
+   int fmt[3] = {BDIO_BIN_F32LE, BDIO_BIN_INT64BE, BDIO_BIN_F64LE};
+   int codec[3] = {BDIO_CODEC_LZ, BDIO_CODEC_PACK, BDIO_CODEC_LZ};
+   float f[1000];
+   int64_t k[1000];
+   double d[1000], e[1000];
+   unsigned char *buf;
+   uint32_t hdr;
+   long pos, size;
+   BDIO *fh;
+   int i, j;
+
+   for( j=0; j<1000; j++ )
+   {
+      f[j] = 0.5f*(j%100);
+      k[j] = j/3;
+      d[j] = 0.25*(j%40);
+   }
+   fh = bdio_open(file, "w", "Test file for encoded records");
+   if( fh==NULL )
+      return 1;
+   bdio_set_filter(BDIO_FILTER_SHUFFLE, fh);
+   for( i=0; i<3; i++ )
+   {
+      bdio_set_codec(codec[i], fh);
+      bdio_start_record(fmt[i], 5, fh);
+      if( i==0 )
+         bdio_write_f32(f, sizeof(f), fh);
+      else if( i==1 )
+         bdio_write_int64(k, sizeof(k), fh);
+      else
+         bdio_write_f64(d, sizeof(d), fh);
+   }
+   bdio_close(fh);
+
+   if( (buf = load_file(file, &size))==NULL )
+      return 1;
+   for( i=0; i<3; i++ )
+   {
+      if( (pos = record_header(file, i+1))==0 || pos+4>size )
+         return 1;
+      memcpy(&hdr, buf+pos, 4);
+      /* generic binary, user info 5, encoded bit */
+      if( (hdr & 0xff2)!=0x502 )
+      {
+         printf("encoded record %i has header %x\n", i+1, hdr);
+         return 1;
+      }
+   }
+   free(buf);
+
+   fh = bdio_open(file, "r", NULL);
+   for( i=0; i<3; i++ )
+   {
+      if( bdio_seek_record(fh)==EOF || bdio_get_rfmt(fh)!=fmt[i] ||
+          bdio_get_ruinfo(fh)!=5 || bdio_read_as_f64(e, 1000, fh)!=1000 )
+      {
+         printf("encoded record %i has wrong format or length\n", i+1);
+         return 1;
+      }
+      for( j=0; j<1000; j++ )
+         if( e[j]!=((i==0) ? f[j] : (i==1) ? (double) k[j] : d[j]) )
+         {
+            printf("encoded record %i is wrong at %i\n", i+1, j);
+            return 1;
+         }
+   }
+   if( fh->nerror!=0 )
+      return 1;
+   bdio_close(fh);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   int hash;
+
+   bdio_set_dflt_verbose(1);
+   for( hash=0; hash<2; hash++ )
+   {
+      if( write_file("codec0.dat", BDIO_CODEC_NONE, BDIO_FILTER_NONE, hash)!=0
+       || write_file("codec1.dat", BDIO_CODEC_LZ, BDIO_FILTER_NONE, hash)!=0
+       || write_file("codec2.dat", BDIO_CODEC_LZ,
+                     BDIO_FILTER_SHUFFLE|BDIO_FILTER_XOR, hash)!=0 )
+      {
+         printf("Could not write test files\n");
+         return 1;
+      }
+      if( read_file("codec0.dat", hash)!=0 || read_file("codec1.dat", hash)!=0
+       || read_file("codec2.dat", hash)!=0 )
+         return 1;
+      /* records 3 and 5 shrink by more than 500 kB */
+      if( file_size("codec1.dat") > file_size("codec0.dat")-500000 )
+      {
+         printf("Compressed file has %li instead of less than %li bytes\n",
+                file_size("codec1.dat"), file_size("codec0.dat")-500000);
+         return 1;
+      }
+      /* the filters help with the numbers in records 3 and 5 */
+      if( file_size("codec2.dat") >= file_size("codec1.dat") )
+      {
+         printf("Filtered file has %li instead of less than %li bytes\n",
+                file_size("codec2.dat"), file_size("codec1.dat"));
+         return 1;
+      }
+   }
+   /* 2.4 MB of integers shrink to less than 400 kB, 1.6 MB of doubles stay */
+   if( pack_file("codec3.dat")!=0 || file_size("codec3.dat") > 2000000 )
+   {
+      printf("packed integers fail or take %li bytes\n",
+             file_size("codec3.dat"));
+      return 1;
+   }
+   if( generic_file("codec4.dat")!=0 )
+      return 1;
+   fh = bdio_open("codec2.dat", "r", NULL);
+   if( bdio_verify(2, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails for filtered records\n");
+      return 1;
+   }
+   bdio_close(fh);
+   fh = bdio_open("codec1.dat", "r", NULL);
+   if( bdio_verify(2, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails for compressed records\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   fh = bdio_open("codec1.dat", "w", "Test file for compressed records");
+   bdio_set_codec(BDIO_CODEC_LZ, fh);
+   bdio_start_record(BDIO_BIN_GENERIC, 3, fh);
+   bdio_write(argv[0], 4, fh);
+   bdio_flush_record(fh);
+   bdio_set_verbose(0, fh);
+   if( bdio_append_record(BDIO_BIN_GENERIC, 3, fh)!=EOF )
+   {
+      printf("bdio_append_record continues a compressed record\n");
+      return 1;
+   }
+   bdio_close(fh);
+   printf("compressed records passed\n");
+   return 0;
+}
@@ -0,0 +1,204 @@
+/* testcomplex.c
+ *
+ * tests records of complex numbers
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 3001
+
+static int cfmt[4] = {BDIO_BIN_C128, BDIO_BIN_C128BE, BDIO_BIN_C64LE,
+                      BDIO_BIN_C64BE};
+
+
+int write_file(char *file, int codec)
+{
+   BDIO *fh;
+   double z[2*N], re[N], im[N];
+   float w[2*N], fre[N], fim[N];
+   size_t j;
+
+   for( j=0; j<N; j++ )
+   {
+      z[2*j] = re[j] = 0.5*j;
+      z[2*j+1] = im[j] = -0.25*j;
+      w[2*j] = fre[j] = 0.5f*j;
+      w[2*j+1] = fim[j] = -0.25f*j;
+   }
+   fh = bdio_open(file, "w", "Test file for complex records");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_set_codec(codec, fh);
+   bdio_start_record(cfmt[0], 5, fh);
+   if( bdio_write_c128(z, N, fh)!=N )
+      return 1;
+   bdio_start_record(cfmt[1], 5, fh);
+   if( bdio_write_c128_split(re, im, 1000, fh)!=1000 ||
+       bdio_write_c128_split(re+1000, im+1000, N-1000, fh)!=N-1000 )
+      return 1;
+   bdio_start_record(cfmt[2], 5, fh);
+   if( bdio_write_c64(w, N, fh)!=N )
+      return 1;
+   bdio_start_record(cfmt[3], 5, fh);
+   if( bdio_write_c64_split(fre, fim, N, fh)!=N )
+      return 1;
+   /* a real record does not take complex numbers, and uinfo 7 marks
+    * padding */
+   bdio_start_record(BDIO_BIN_F64, 5, fh);
+   bdio_set_verbose(0, fh);
+   if( bdio_write_c128(z, N, fh)!=0 ||
+       bdio_start_record(BDIO_BIN_C128, 7, fh)!=EOF )
+      return 1;
+   bdio_set_verbose(1, fh);
+   bdio_write_f64(z, 16, fh);
+   bdio_close(fh);
+   return 0;
+}
+
+
+int next_record(BDIO *fh)
+{
+   /* skips the hash records */
+   while( bdio_seek_record(fh)!=EOF )
+      if( bdio_get_ruinfo(fh)==5 )
+         return 0;
+   return EOF;
+}
+
+
+int read_file(char *file)
+{
+   BDIO *fh;
+   double z[2*N], re[N], im[N];
+   float w[2*N], fre[N], fim[N];
+   size_t j;
+   int i;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   bdio_verify_on_read(1, fh);
+   for( i=0; i<4; i++ )
+   {
+      memset(z, 0, sizeof(z));
+      memset(w, 0, sizeof(w));
+      if( next_record(fh)==EOF || bdio_is_complex_record(fh)!=1 ||
+          bdio_get_rlen(fh)!=((i<2) ? 16 : 8)*N )
+      {
+         printf("record %i is not a complex record of the right length\n", i);
+         return 1;
+      }
+      if( i==0 && bdio_read_c128_split(re, im, N+5, fh)!=N )
+         return 1;
+      if( i==1 && (bdio_read_c128(z, 1, fh)!=1 ||
+                   bdio_read_c128(z+2, N, fh)!=N-1) )
+         return 1;
+      if( i==2 && bdio_read_c64_split(fre, fim, N, fh)!=N )
+         return 1;
+      if( i==3 && bdio_read_f32(w, 8*N, fh)!=8*N )
+         return 1;
+      for( j=0; j<N; j++ )
+      {
+         if( i==1 )
+         {
+            re[j] = z[2*j];
+            im[j] = z[2*j+1];
+         }else if( i==3 )
+         {
+            fre[j] = w[2*j];
+            fim[j] = w[2*j+1];
+         }
+         if( (i<2 && (re[j]!=0.5*j || im[j]!=-0.25*j)) ||
+             (i>=2 && (fre[j]!=0.5f*j || fim[j]!=-0.25f*j)) )
+         {
+            printf("record %i: complex number %lu is wrong\n", i,
+                   (unsigned long) j);
+            return 1;
+         }
+      }
+   }
+   next_record(fh);
+   if( bdio_is_complex_record(fh)!=0 || bdio_get_rlen(fh)!=16 )
+   {
+      printf("real record is taken for a complex record\n");
+      return 1;
+   }
+   if( fh->nerror!=0 )
+      return 1;
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   if( bdio_verify(1, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails for complex records\n");
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check_plain(char *file)
+{
+   /* without codec the numbers of the first record are stored as they
+    * are, at the position reported by bdio_get_rstart, after a generic
+    * header with the encoded bit and the marker. Their parts are read
+    * through bdio_read_as_f64, which depends on the format. */
+   BDIO *fh;
+   FILE *fp;
+   double z[4], exp[4] = {0.5, -0.25, 1.0, -0.5};
+   uint64_t pos;
+   unsigned char h[4];
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || next_record(fh)==EOF )
+      return 1;
+   pos = bdio_get_rstart(fh);
+   if( bdio_get_rfmt(fh)!=BDIO_BIN_F64BE && bdio_get_rfmt(fh)!=BDIO_BIN_F64LE )
+   {
+      printf("complex record has format %i\n", bdio_get_rfmt(fh));
+      return 1;
+   }
+   if( bdio_read_as_f64(z, 4, fh)!=4 || memcmp(z+2, exp, 2*8)!=0 )
+   {
+      printf("complex record is not read by bdio_read_as_f64\n");
+      return 1;
+   }
+   bdio_close(fh);
+   fp = fopen(file, "rb");
+   if( fp==NULL || fseek(fp, (long) pos-8, SEEK_SET)!=0 ||
+       fread(h, 1, 4, fp)!=4 || fseek(fp, (long) pos+16, SEEK_SET)!=0 ||
+       fread(z, 8, 4, fp)!=4 )
+      return 1;
+   fclose(fp);
+   /* generic binary, user info 5, encoded bit, in either byte order */
+   if( ((h[0] | (h[1] << 8)) & 0xff2)!=0x502 &&
+       ((h[3] | (h[2] << 8)) & 0xff2)!=0x502 )
+   {
+      printf("complex record has a header of another format\n");
+      return 1;
+   }
+   if( memcmp(z, exp, sizeof(z))!=0 )
+   {
+      printf("complex record without codec is not stored as it is\n");
+      return 1;
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   bdio_set_dflt_verbose(1);
+   if( write_file("complex.dat", BDIO_CODEC_NONE)!=0 ||
+       read_file("complex.dat")!=0 || check_plain("complex.dat")!=0 ||
+       write_file("complex.dat", BDIO_CODEC_LZ)!=0 ||
+       read_file("complex.dat")!=0 )
+      return 1;
+   printf("complex records passed\n");
+   return 0;
+}
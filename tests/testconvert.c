@@ -0,0 +1,204 @@
+/* testconvert.c
+ *
+ * tests reading numeric records of any format as doubles and floats, and
+ * the half precision formats
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NFMT 8
+#define N 5003
+
+static int fmt[NFMT] = {BDIO_BIN_INT32LE, BDIO_BIN_INT32BE, BDIO_BIN_INT64LE,
+                        BDIO_BIN_INT64BE, BDIO_BIN_F32LE, BDIO_BIN_F32BE,
+                        BDIO_BIN_F64LE, BDIO_BIN_F64BE};
+
+
+/* values that all formats represent exactly */
+double value(size_t j)
+{
+   return (double) j - 2000.0;
+}
+
+
+int write_file(char *file, int codec)
+{
+   BDIO *fh;
+   int32_t i4[N];
+   int64_t i8[N];
+   float f4[N];
+   double f8[N];
+   size_t j;
+   int i;
+
+   fh = bdio_open(file, "w", "Test file for converting readers");
+   if( fh==NULL || bdio_set_codec(codec, fh)!=0 )
+      return 1;
+   for( j=0; j<N; j++ )
+   {
+      i4[j] = (int32_t) value(j);
+      i8[j] = (int64_t) value(j);
+      f4[j] = (float) value(j);
+      f8[j] = value(j);
+   }
+   for( i=0; i<NFMT; i++ )
+   {
+      bdio_start_record(fmt[i], 1, fh);
+      if( i<2 )
+         bdio_write_int32(i4, sizeof(i4), fh);
+      else if( i<4 )
+         bdio_write_int64(i8, sizeof(i8), fh);
+      else if( i<6 )
+         bdio_write_f32(f4, sizeof(f4), fh);
+      else
+         bdio_write_f64(f8, sizeof(f8), fh);
+   }
+   bdio_start_record(BDIO_BIN_GENERIC, 1, fh);
+   bdio_write(f8, 16, fh);
+   bdio_close(fh);
+   return 0;
+}
+
+
+int read_file(char *file)
+{
+   BDIO *fh;
+   double d[N];
+   float f[N];
+   size_t j;
+   int i;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   for( i=0; i<NFMT; i++ )
+   {
+      if( bdio_seek_record(fh)==EOF )
+         return 1;
+      /* doubles in two pieces, the second one asks for too many */
+      if( bdio_read_as_f64(d, 1000, fh)!=1000 ||
+          bdio_read_as_f64(d+1000, N, fh)!=N-1000 )
+      {
+         printf("could not read record %i as doubles\n", i);
+         return 1;
+      }
+      for( j=0; j<N; j++ )
+         if( d[j]!=value(j) )
+         {
+            printf("record %i: element %lu is %g instead of %g\n", i,
+                   (unsigned long) j, d[j], value(j));
+            return 1;
+         }
+   }
+   bdio_set_verbose(0, fh);
+   if( bdio_seek_record(fh)==EOF || bdio_read_as_f64(d, 2, fh)!=0 )
+   {
+      printf("bdio_read_as_f64 accepts a generic record\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   for( i=0; i<NFMT; i++ )
+   {
+      bdio_seek_record(fh);
+      if( bdio_read_as_f32(f, N, fh)!=N )
+         return 1;
+      for( j=0; j<N; j++ )
+         if( f[j]!=(float) value(j) )
+         {
+            printf("record %i: element %lu is %g instead of %g as float\n",
+                   i, (unsigned long) j, f[j], value(j));
+            return 1;
+         }
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+/* values that f16 and bf16 represent exactly */
+float hvalue(size_t j)
+{
+   return 0.5f*(float) (j%256) - 64.0f;
+}
+
+
+int half_file(char *file, int codec)
+{
+   int hfmt[4] = {BDIO_BIN_F16LE, BDIO_BIN_F16BE, BDIO_BIN_BF16LE,
+                  BDIO_BIN_BF16BE};
+   float f[N], g[N];
+   double d[N];
+   BDIO *fh;
+   size_t j;
+   int i;
+
+   for( j=0; j<N; j++ )
+      f[j] = hvalue(j);
+   fh = bdio_open(file, "w", "Test file for half precision records");
+   bdio_set_codec(codec, fh);
+   for( i=0; i<4; i++ )
+   {
+      bdio_start_record(hfmt[i], 2, fh);
+      if( bdio_write_f32_as_f16(f, N, fh)!=N )
+         return 1;
+   }
+   /* rounding to nearest even, and overflow of f16 */
+   bdio_start_record(BDIO_BIN_F16, 2, fh);
+   g[0] = 1.0f + 1.0f/4096.0f;
+   g[1] = 1.0f + 3.0f/4096.0f;
+   g[2] = 70000.0f;
+   bdio_write_f32_as_f16(g, 3, fh);
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   for( i=0; i<4; i++ )
+   {
+      if( bdio_seek_record(fh)==EOF || bdio_get_rfmt(fh)!=hfmt[i] ||
+          bdio_get_rlen(fh)!=2*N )
+      {
+         printf("half record %i has wrong format or length\n", i);
+         return 1;
+      }
+      if( (i%2==0 && bdio_read_f16_as_f32(g, N, fh)!=N) ||
+          (i%2==1 && bdio_read_as_f64(d, N, fh)!=N) )
+         return 1;
+      for( j=0; j<N; j++ )
+         if( (i%2==0 && g[j]!=f[j]) || (i%2==1 && d[j]!=(double) f[j]) )
+         {
+            printf("half record %i: element %lu is wrong\n", i,
+                   (unsigned long) j);
+            return 1;
+         }
+   }
+   bdio_seek_record(fh);
+   if( bdio_read_f16_as_f32(g, 3, fh)!=3 || g[0]!=1.0f ||
+       g[1]!=1.0f+1.0f/1024.0f || g[2]!=g[2]*2.0f )
+   {
+      printf("f16 rounding gives %g %g %g\n", g[0], g[1], g[2]);
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   bdio_set_dflt_verbose(1);
+   if( write_file("convert.dat", BDIO_CODEC_NONE)!=0 ||
+       read_file("convert.dat")!=0 )
+      return 1;
+   if( write_file("convert.dat", BDIO_CODEC_LZ)!=0 ||
+       read_file("convert.dat")!=0 )
+      return 1;
+   if( half_file("convert.dat", BDIO_CODEC_NONE)!=0 ||
+       half_file("convert.dat", BDIO_CODEC_LZ)!=0 )
+      return 1;
+   printf("converting readers passed\n");
+   return 0;
+}
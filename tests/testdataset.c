@@ -0,0 +1,174 @@
+/* testdataset.c
+ *
+ * tests reading several files as one dataset
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NF 6
+
+static int nrec[NF] = {3, 0, 7, 1, 12, 5};
+static int seen[60];
+
+
+int write_file(char *file, int first, int n)
+{
+   BDIO *fh;
+   int64_t d[100];
+   int i, j;
+
+   fh = bdio_open(file, "w", "Test file for datasets");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   for( i=0; i<n; i++ )
+   {
+      /* data records hold their global number, hash records follow them */
+      for( j=0; j<100; j++ )
+         d[j] = first+2*i+1;
+      bdio_start_record(BDIO_BIN_INT64, 1, fh);
+      bdio_write_int64(d, 8*100, fh);
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check(BDIO *fh, int grec)
+{
+   int64_t d[100];
+   int j;
+
+   if( bdio_read_int64(d, 8*100, fh)!=800 )
+      return 1;
+   for( j=0; j<100; j++ )
+      if( d[j]!=grec )
+         return 1;
+   return 0;
+}
+
+
+int each(BDIO *fh, int grec, void *arg)
+{
+   if( bdio_get_ruinfo(fh)!=1 )
+      return 0;
+   seen[grec] += (check(fh, grec)==0) ? 1 : 100;
+   return 0;
+}
+
+
+int stop(BDIO *fh, int grec, void *arg)
+{
+   return (grec==*(int*) arg);
+}
+
+
+int main(int argc, char *argv[])
+{
+   char *files[NF+1] = {"dset0.dat", "dset1.dat", "dset2.dat", "dset3.dat",
+                        "dset4.dat", "dset5.dat", "nonexistent.dat"};
+   int grec[5] = {17, 3, 17, 39, 1};
+   BDIO_DSET *ds;
+   int k, n=0, nthreads;
+
+   bdio_set_dflt_verbose(1);
+   for( k=0; k<NF; k++ )
+   {
+      if( write_file(files[k], n, nrec[k])!=0 )
+      {
+         printf("Could not write test file\n");
+         return 1;
+      }
+      n += 2*nrec[k];
+   }
+   ds = bdio_dataset_open(files, NF, BDIO_DSET_VERIFY);
+   if( ds==NULL || ds->nrec!=n )
+   {
+      printf("dataset has the wrong number of records\n");
+      return 1;
+   }
+   for( k=0; k<NF; k++ )
+      if( ds->files[k].nrec!=2*nrec[k] || ds->files[k].hcnt!=1 ||
+          (k>0 && ds->files[k].first!=ds->files[k-1].first+2*nrec[k-1]) )
+      {
+         printf("wrong entry for file %i\n", k);
+         return 1;
+      }
+
+   /* sequential reads across files, including an empty one */
+   n = 0;
+   while( bdio_dataset_seek_record(ds)!=EOF )
+   {
+      n++;
+      if( bdio_dataset_rcnt(ds)!=n )
+      {
+         printf("record %i has global number %i\n", n, bdio_dataset_rcnt(ds));
+         return 1;
+      }
+      if( bdio_get_ruinfo(bdio_dataset_member(ds))==1 &&
+          check(bdio_dataset_member(ds), n)!=0 )
+      {
+         printf("record %i is wrong\n", n);
+         return 1;
+      }
+   }
+   if( n!=ds->nrec )
+   {
+      printf("found %i of %i records\n", n, ds->nrec);
+      return 1;
+   }
+
+   /* forwards, backwards and to the same record */
+   for( k=0; k<5; k++ )
+      if( bdio_dataset_goto_record(grec[k], ds)!=0 ||
+          bdio_dataset_rcnt(ds)!=grec[k] ||
+          check(bdio_dataset_member(ds), grec[k])!=0 )
+      {
+         printf("bdio_dataset_goto_record fails for record %i\n", grec[k]);
+         return 1;
+      }
+   bdio_set_dflt_verbose(0);
+   if( bdio_dataset_goto_record(0, ds)!=EOF ||
+       bdio_dataset_goto_record(ds->nrec+1, ds)!=EOF )
+   {
+      printf("bdio_dataset_goto_record accepts invalid records\n");
+      return 1;
+   }
+   bdio_set_dflt_verbose(1);
+
+   for( nthreads=1; nthreads<=4; nthreads+=3 )
+   {
+      memset(seen, 0, sizeof(seen));
+      if( bdio_dataset_for_each(each, NULL, nthreads, ds)!=0 )
+      {
+         printf("bdio_dataset_for_each fails with %i threads\n", nthreads);
+         return 1;
+      }
+      for( k=1; k<=ds->nrec; k++ )
+         if( seen[k]!=k%2 )
+         {
+            printf("record %i was seen %i times\n", k, seen[k]);
+            return 1;
+         }
+   }
+   k = 9;
+   if( bdio_dataset_for_each(stop, &k, 2, ds)!=EOF )
+   {
+      printf("bdio_dataset_for_each ignores the return value\n");
+      return 1;
+   }
+   bdio_dataset_close(ds);
+
+   bdio_set_dflt_verbose(0);
+   if( bdio_dataset_open(files, NF+1, 0)!=NULL ||
+       bdio_dataset_open(files, 0, 0)!=NULL )
+   {
+      printf("bdio_dataset_open accepts invalid files\n");
+      return 1;
+   }
+   printf("datasets passed\n");
+   return 0;
+}
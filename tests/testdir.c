@@ -0,0 +1,198 @@
+/* testdir.c
+ *
+ * tests the directory fields of headers, skipping of header sections and
+ * the header catalogue
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSEC 3
+#define N 1000
+
+/* the last section is too long for the directory fields */
+static int nrec[NSEC] = {5, 0, 3};
+static int rlen[NSEC] = {N, N, 200000};
+
+
+int write_file(char *file, int sec)
+{
+   BDIO *fh;
+   double d[N];
+   int i, j;
+
+   fh = bdio_open(file, "w", "Test file for header directories");
+   if( fh==NULL )
+      return 1;
+   memset(d, 0, sizeof(d));
+   if( sec==0 )
+      bdio_hash_auto(fh);
+   for( i=0; i<nrec[sec]; i++ )
+   {
+      bdio_start_record(BDIO_BIN_F64, sec, fh);
+      for( j=0; j<rlen[sec]; j+=N )
+      {
+         d[0] = 100.0*sec+i;
+         bdio_write_f64(d, 8*N, fh);
+      }
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int cat_files(char *out, char **in, int n)
+{
+   /* concatenates bdio files into one with several headers */
+   FILE *fo, *fi;
+   char buf[4096];
+   size_t rd;
+   int i;
+
+   if( (fo = fopen(out, "wb"))==NULL )
+      return 1;
+   for( i=0; i<n; i++ )
+   {
+      if( (fi = fopen(in[i], "rb"))==NULL )
+         return 1;
+      while( (rd = fread(buf, 1, sizeof(buf), fi))>0 )
+         fwrite(buf, 1, rd, fo);
+      fclose(fi);
+   }
+   fclose(fo);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   char *files[NSEC] = {"dir0.dat", "dir1.dat", "dir2.dat"};
+   BDIO *fh;
+   BDIO_HCAT cat[NSEC];
+   double d;
+   int sec, n, rcnt;
+
+   bdio_set_dflt_verbose(1);
+   for( sec=0; sec<NSEC; sec++ )
+      if( write_file(files[sec], sec)!=0 )
+      {
+         printf("Could not write test file\n");
+         return 1;
+      }
+
+   /* the fields count all records including checksums */
+   fh = bdio_open(files[0], "r", NULL);
+   n = 0;
+   while( bdio_seek_record(fh)!=EOF )
+      n++;
+   if( bdio_get_hdirinfo1(fh)!=n || n!=2*nrec[0] ||
+       bdio_get_hdirinfo2(fh)!=nrec[0]*(8*N+4+20+4) )
+   {
+      printf("wrong directory %i %i of a file with %i records\n",
+             bdio_get_hdirinfo1(fh), bdio_get_hdirinfo2(fh), n);
+      return 1;
+   }
+   bdio_close(fh);
+
+   /* appended records are added */
+   fh = bdio_open(files[1], "a", NULL);
+   d = 100.0;
+   bdio_start_record(BDIO_BIN_F64, 1, fh);
+   bdio_write_f64(&d, 8, fh);
+   bdio_close(fh);
+   nrec[1] = 1;
+   fh = bdio_open(files[1], "r", NULL);
+   if( bdio_get_hdirinfo1(fh)!=1 || bdio_get_hdirinfo2(fh)!=12 )
+   {
+      printf("wrong directory %i %i after appending\n",
+             bdio_get_hdirinfo1(fh), bdio_get_hdirinfo2(fh));
+      return 1;
+   }
+   bdio_close(fh);
+   fh = bdio_open(files[2], "r", NULL);
+   if( bdio_get_hdirinfo1(fh)!=nrec[2] || bdio_get_hdirinfo2(fh)!=0x3fffff )
+   {
+      printf("directory of a long section is not saturated\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   /* skipped records are counted */
+   if( cat_files("dir.dat", files, NSEC)!=0 )
+      return 1;
+   fh = bdio_open("dir.dat", "r", NULL);
+   bdio_verify_on_read(1, fh);
+   bdio_seek_record(fh);
+   rcnt = 2*nrec[0];
+   for( sec=1; sec<NSEC; sec++ )
+   {
+      if( bdio_seek_header(fh)!=0 || bdio_get_hcnt(fh)!=sec+1 ||
+          bdio_get_rcnt(fh)!=rcnt+1 )
+      {
+         printf("bdio_seek_header fails to reach header %i\n", sec+1);
+         return 1;
+      }
+      bdio_read_f64(&d, 8, fh);
+      if( d!=100.0*sec || bdio_get_ruinfo(fh)!=sec )
+      {
+         printf("wrong record after header %i\n", sec+1);
+         return 1;
+      }
+      rcnt += nrec[sec];
+   }
+   if( bdio_seek_header(fh)!=EOF || bdio_get_rcnt(fh)!=rcnt ||
+       fh->nerror!=0 )
+   {
+      printf("bdio_seek_header fails at the last header\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   /* header catalogue with lazily read headers */
+   fh = bdio_open("dir.dat", "r", NULL);
+   bdio_lazy_headers(1, fh);
+   if( bdio_header_catalogue(NULL, 0, fh)!=NSEC ||
+       bdio_header_catalogue(cat, NSEC, fh)!=NSEC )
+   {
+      printf("bdio_header_catalogue does not find %i headers\n", NSEC);
+      return 1;
+   }
+   rcnt = 0;
+   for( sec=0; sec<NSEC; sec++ )
+   {
+      if( cat[sec].rcnt!=rcnt || cat[sec].nrec!=(sec ? 1 : 2)*nrec[sec] ||
+          (sec>0 && cat[sec].hstart!=cat[sec-1].end) ||
+          cat[sec].rstart<=cat[sec].hstart )
+      {
+         printf("wrong catalogue entry for header %i\n", sec+1);
+         return 1;
+      }
+      rcnt += cat[sec].nrec;
+   }
+   for( sec=NSEC-1; sec>=0; sec-- )
+   {
+      if( bdio_goto_header(cat, sec, fh)!=0 || bdio_seek_record(fh)!=0 ||
+          bdio_get_hcnt(fh)!=sec+1 || bdio_get_rcnt(fh)!=cat[sec].rcnt+1 ||
+          strcmp(bdio_get_hpinfo(fh), "Test file for header directories")!=0 )
+      {
+         printf("bdio_goto_header fails to reach header %i\n", sec+1);
+         return 1;
+      }
+      bdio_read_f64(&d, 8, fh);
+      if( d!=100.0*sec )
+      {
+         printf("wrong record after header %i\n", sec+1);
+         return 1;
+      }
+   }
+   if( fh->nerror!=0 )
+   {
+      printf("found %i errors\n", fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   printf("header directories passed\n");
+   return 0;
+}
@@ -0,0 +1,179 @@
+/* testfollow.c
+ *
+ * tests reading a file while it is being written
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define NREC 20
+#define N 200000
+
+
+static double d[N];
+
+
+void fill(int i)
+{
+   int j;
+
+   for( j=0; j<N; j++ )
+      d[j] = i+0.25*j;
+}
+
+
+int check(BDIO *fh, int i, int n)
+{
+   /* the record holds the first n numbers of fill(i) */
+   static double r[N];
+   int j;
+
+   if( bdio_get_rlen(fh)!=8*n || bdio_read_f64(r, 8*n, fh)!=8*n )
+      return 1;
+   for( j=0; j<n; j++ )
+      if( r[j]!=i+0.25*j )
+         return 1;
+   return 0;
+}
+
+
+void *writer(void *arg)
+{
+   /* records of growing length, the long ones exceed the write buffer and
+    * reach the file before they are complete */
+   BDIO *fh = (BDIO*) arg;
+   struct timespec ts = {0, 5000000};
+   int i;
+
+   for( i=1; i<NREC; i++ )
+   {
+      fill(i);
+      bdio_start_record(BDIO_BIN_F64, 1, fh);
+      bdio_write_f64(d, 8*(N/2), fh);
+      fflush(fh->fp);
+      nanosleep(&ts, NULL);
+      bdio_write_f64(d+N/2, 8*(N/2*(i%2)), fh);
+      bdio_flush_record(fh);
+      fflush(fh->fp);
+      nanosleep(&ts, NULL);
+   }
+   bdio_close(fh);
+   return NULL;
+}
+
+
+int crash_append(void)
+{
+   /* a writer that stops inside a record leaves its start in the file,
+    * which must not remain behind the records appended later */
+   BDIO *fh;
+   int i;
+
+   fh = bdio_open("follow2.dat", "w", "Test file for followed files");
+   if( fh==NULL )
+      return 1;
+   fill(1);
+   bdio_start_record(BDIO_BIN_F64, 1, fh);
+   bdio_write_f64(d, 8*N/2, fh);
+   bdio_start_record(BDIO_BIN_F64, 1, fh);
+   bdio_write_f64(d, sizeof(d), fh);
+   fclose(fh->fp);
+   free(fh->buf);
+
+   fh = bdio_open("follow2.dat", "a", "Test file for followed files");
+   if( fh==NULL )
+      return 1;
+   for( i=2; i<4; i++ )
+   {
+      fill(i);
+      bdio_start_record(BDIO_BIN_F64, 1, fh);
+      bdio_write_f64(d, 8*100, fh);
+   }
+   bdio_close(fh);
+
+   fh = bdio_open("follow2.dat", "r", NULL);
+   if( fh==NULL || bdio_seek_record(fh)!=0 || check(fh, 1, N/2)!=0 )
+      return 1;
+   for( i=2; i<4; i++ )
+      if( bdio_seek_record(fh)!=0 || check(fh, i, 100)!=0 )
+         return 1;
+   if( bdio_seek_record(fh)!=EOF || fh->nerror!=0 )
+      return 1;
+   bdio_close(fh);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fw, *fr;
+   pthread_t thread;
+   int i=0;
+
+   bdio_set_dflt_verbose(1);
+   fw = bdio_open("follow.dat", "w", "Test file for followed files");
+   if( fw==NULL )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+
+   /* an incomplete record is not seen without follow mode */
+   fill(0);
+   bdio_start_record(BDIO_BIN_F64, 1, fw);
+   bdio_write_f64(d, sizeof(d), fw);
+   fflush(fw->fp);
+   fr = bdio_open("follow.dat", "r", NULL);
+   if( fr==NULL || bdio_seek_record(fr)!=EOF || fr->nerror!=0 )
+   {
+      printf("an incomplete record is visible\n");
+      return 1;
+   }
+   if( bdio_follow(50, fr)!=0 || bdio_seek_record(fr)!=EOF ||
+       fr->nerror!=0 )
+   {
+      printf("bdio_follow does not time out\n");
+      return 1;
+   }
+   bdio_flush_record(fw);
+   fflush(fw->fp);
+   if( bdio_seek_record(fr)!=0 || check(fr, 0, N)!=0 )
+   {
+      printf("the completed record can not be read\n");
+      return 1;
+   }
+
+   /* the reader waits for the writer */
+   if( pthread_create(&thread, NULL, writer, fw)!=0 )
+      return 1;
+   bdio_follow(500, fr);
+   while( bdio_seek_record(fr)!=EOF )
+   {
+      i++;
+      if( bdio_get_rcnt(fr)!=i+1 || check(fr, i, N/2*(1+i%2))!=0 )
+      {
+         printf("record %i is wrong\n", i+1);
+         return 1;
+      }
+   }
+   pthread_join(thread, NULL);
+   if( i!=NREC-1 || fr->nerror!=0 )
+   {
+      printf("found %i of %i records and %i errors\n", i+1, NREC,
+             fr->nerror);
+      return 1;
+   }
+   bdio_close(fr);
+
+   if( crash_append()!=0 )
+   {
+      printf("appending after an incomplete record fails\n");
+      return 1;
+   }
+   printf("followed files passed\n");
+   return 0;
+}
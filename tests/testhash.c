@@ -12,6 +12,72 @@
 #include <string.h>
 
 
+int write_and_check(char *file, int type, const char *str)
+{
+   BDIO *fh;
+   unsigned char digest[16], ref[16];
+   CRC32C_CTX crc;
+   XXH64_CTX xxh;
+   int nh=0;
+
+   /* write two records with hashes of the given type */
+   fh = bdio_open(file,"w","Test file with fast hashes");
+   bdio_hash_auto(fh);
+   if(bdio_hash_type(type, fh)!=0)
+      return 1;
+   if(bdio_start_record(BDIO_ASC_GENERIC, 1, fh)!=0)
+      return 1;
+   if(bdio_write((void*) str, strlen(str)+1, fh)!=strlen(str)+1)
+      return 1;
+   if(bdio_start_record(BDIO_ASC_GENERIC, 1, fh)!=0)
+      return 1;
+   if(bdio_write((void*) str, strlen(str)+1, fh)!=strlen(str)+1)
+      return 1;
+   bdio_close(fh);
+
+   /* reference checksum */
+   memset(ref,0,16);
+   if( type==BDIO_HASH_CRC32C )
+   {
+      CRC32C_Init(&crc);
+      CRC32C_Update(&crc, str, strlen(str)+1);
+      CRC32C_Final(ref, &crc);
+   }else
+   {
+      XXH64_Init(&xxh);
+      XXH64_Update(&xxh, str, strlen(str)+1);
+      XXH64_Final(ref, &xxh);
+   }
+
+   /* read back and compare */
+   fh = bdio_open(file,"r",NULL);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_is_hash_record(digest, fh) )
+      {
+         if( bdio_is_hash_record(digest, fh)!=type )
+         {
+            printf("Wrong hash type in %s\n", file);
+            return 1;
+         }
+         if( memcmp(digest, ref, 16)!=0 )
+         {
+            printf("Wrong checksum in %s\n", file);
+            return 1;
+         }
+         nh++;
+      }
+   }
+   bdio_close(fh);
+   if( nh!=2 )
+   {
+      printf("Expected 2 hash records in %s, found %i\n", file, nh);
+      return 1;
+   }
+   return 0;
+}
+
+
 int main(int argc, char *argv[])
 {
    BDIO *fh;
@@ -32,8 +98,12 @@ int main(int argc, char *argv[])
    if(bdio_write((void*) str, strlen(str)+1, fh)!=strlen(str)+1)
       exit(1);
    bdio_close(fh);
-  
 
+   /* the same with the fast checksums */
+   if( write_and_check("hash_crc.dat", BDIO_HASH_CRC32C, str)!=0 )
+      exit(1);
+   if( write_and_check("hash_xxh.dat", BDIO_HASH_XXH64, str)!=0 )
+      exit(1);
 
    exit(0);
 }
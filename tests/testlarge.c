@@ -0,0 +1,155 @@
+/* testlarge.c
+ *
+ * tests objects split into several records
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 1000003
+#define CHUNK 1048576
+
+
+int write_file(char *file, double *d, int hash)
+{
+   BDIO *fh;
+   size_t j;
+
+   for( j=0; j<N; j++ )
+      d[j] = 0.5*j-1000.0;
+   fh = bdio_open(file, "w", "Test file for large objects");
+   if( fh==NULL || bdio_set_large_chunk(CHUNK, fh)!=0 )
+      return 1;
+   if( hash )
+      bdio_hash_auto(fh);
+   bdio_start_record(BDIO_BIN_GENERIC, 1, fh);
+   bdio_write("before", 6, fh);
+   if( bdio_write_large(d, 8*N, BDIO_BIN_F64, 2, fh)!=8*N )
+      return 1;
+   bdio_start_record(BDIO_BIN_GENERIC, 1, fh);
+   bdio_write("after", 5, fh);
+   bdio_close(fh);
+   for( j=0; j<N; j++ )
+      if( d[j]!=0.5*j-1000.0 )
+      {
+         printf("bdio_write_large modifies the data\n");
+         return 1;
+      }
+   return 0;
+}
+
+
+int read_file(char *file, double *d)
+{
+   BDIO *fh;
+   size_t j;
+   int nchunk=0, nlarge=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   bdio_verify_on_read(1, fh);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)==2 )
+      {
+         nchunk++;
+         continue;
+      }
+      if( bdio_get_large_len(fh)==0 )
+         continue;
+      if( bdio_get_large_len(fh)!=8*N )
+      {
+         printf("bdio_get_large_len returns %lu\n",
+                (unsigned long) bdio_get_large_len(fh));
+         return 1;
+      }
+      memset(d, 0, 8*N);
+      if( bdio_read_large(d, 8*N, fh)!=8*N )
+      {
+         printf("could not read the large object\n");
+         return 1;
+      }
+      for( j=0; j<N; j++ )
+         if( d[j]!=0.5*j-1000.0 )
+         {
+            printf("large object is corrupted at %lu\n", (unsigned long) j);
+            return 1;
+         }
+      nlarge++;
+   }
+   if( nlarge!=1 || nchunk!=0 || fh->nerror!=0 )
+   {
+      printf("found %i objects, %i stray chunks and %i errors\n", nlarge,
+             nchunk, fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+
+   /* the chunks are ordinary records */
+   fh = bdio_open(file, "r", NULL);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)!=2 )
+         continue;
+      if( bdio_get_rlen(fh)!=((nchunk<7) ? CHUNK : 8*N-7*CHUNK) )
+      {
+         printf("chunk %i has length %lu\n", nchunk,
+                (unsigned long) bdio_get_rlen(fh));
+         return 1;
+      }
+      if( nchunk==3 )
+      {
+         bdio_read_f64(d, 16, fh);
+         if( d[0]!=0.5*(3*CHUNK/8)-1000.0 || d[1]!=d[0]+0.5 )
+         {
+            printf("chunk 3 is corrupted\n");
+            return 1;
+         }
+      }
+      nchunk++;
+   }
+   bdio_close(fh);
+   if( nchunk!=8 )
+   {
+      printf("found %i instead of 8 chunks\n", nchunk);
+      return 1;
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   double *d;
+   int hash;
+
+   bdio_set_dflt_verbose(1);
+   if( (d = malloc(8*N))==NULL )
+      return 1;
+   for( hash=0; hash<2; hash++ )
+   {
+      if( write_file("large.dat", d, hash)!=0 )
+      {
+         printf("Could not write test file\n");
+         return 1;
+      }
+      if( read_file("large.dat", d)!=0 )
+         return 1;
+   }
+   fh = bdio_open("large.dat", "w", "Test file for large objects");
+   bdio_set_verbose(0, fh);
+   if( bdio_set_large_chunk(1000, fh)!=EOF ||
+       bdio_set_large_chunk(1<<28, fh)!=EOF )
+   {
+      printf("bdio_set_large_chunk accepts invalid lengths\n");
+      return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   printf("large objects passed\n");
+   return 0;
+}
@@ -0,0 +1,135 @@
+/* testmatch.c
+ *
+ * tests seeking records by format and user info
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "testutil.h"
+
+#define NREC 60
+#define N 500
+
+static int fmt[3] = {BDIO_BIN_F64, BDIO_BIN_INT32, BDIO_BIN_GENERIC};
+
+
+int write_file(char *file, int table)
+{
+   BDIO *fh;
+   double d[N];
+   int32_t n[N];
+   int i, j;
+
+   fh = bdio_open(file, "w", "Test file for record queries");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_chain(fh);
+   if( table )
+      bdio_index_records(fh);
+   for( i=0; i<NREC; i++ )
+   {
+      for( j=0; j<N; j++ )
+      {
+         d[j] = i+0.25*j;
+         n[j] = i;
+      }
+      bdio_set_codec((i%4==1) ? BDIO_CODEC_LZ : BDIO_CODEC_NONE, fh);
+      bdio_start_record(fmt[i%3], i%5, fh);
+      if( i%3==0 )
+         bdio_write_f64(d, sizeof(d), fh);
+      else if( i%3==1 )
+         bdio_write_int32(n, sizeof(n), fh);
+      else
+         bdio_write(n, sizeof(n), fh);
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int query(char *file, int fmt_mask, int uinfo_mask, int ifmt, int iuinfo,
+          int verify)
+{
+   /* ifmt<0 and iuinfo<0 match all formats and user infos */
+   BDIO *fh;
+   double d[N];
+   int i=0, j, nfound=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   if( verify )
+      bdio_verify_on_read(1, fh);
+   while( bdio_seek_next_matching(fmt_mask, uinfo_mask, fh)!=EOF )
+   {
+      /* the data records are numbered 1, 3, 5, ... */
+      while( i<NREC && ((ifmt>=0 && i%3!=ifmt) || (iuinfo>=0 && i%5!=iuinfo)) )
+         i++;
+      if( i>=NREC || bdio_get_rcnt(fh)!=2*i+1 || bdio_get_ruinfo(fh)!=i%5 )
+      {
+         printf("found record %i instead of %i\n", bdio_get_rcnt(fh), 2*i+1);
+         return 1;
+      }
+      if( ifmt==0 )
+      {
+         bdio_read_f64(d, sizeof(d), fh);
+         for( j=0; j<N; j++ )
+            if( d[j]!=i+0.25*j )
+            {
+               printf("record %i is wrong at %i\n", 2*i+1, j);
+               return 1;
+            }
+      }
+      nfound++;
+      i++;
+   }
+   if( fh->nerror!=0 )
+   {
+      printf("found %i errors\n", fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   return nfound;
+}
+
+
+int queries(char *file, int verify)
+{
+   int f64=(1<<BDIO_BIN_F64BE)|(1<<BDIO_BIN_F64LE);
+   int i32=(1<<BDIO_BIN_INT32BE)|(1<<BDIO_BIN_INT32LE);
+
+   if( query(file, f64, 1<<3, 0, 3, verify)!=4 ||
+       query(file, f64, BDIO_MATCH_ALL, 0, -1, verify)!=NREC/3 ||
+       query(file, i32, 1<<1, 1, 1, verify)!=4 ||
+       query(file, BDIO_MATCH_ALL, (1<<4)|(1<<6), -1, 4, verify)!=NREC/5 ||
+       query(file, 1<<BDIO_BIN_F32LE, BDIO_MATCH_ALL, -1, -1, verify)!=0 )
+   {
+      printf("wrong number of matching records in %s\n", file);
+      return 1;
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   bdio_set_dflt_verbose(1);
+   if( write_file("match.dat", 0)!=0 || write_file("match2.dat", 1)!=0 )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+   if( queries("match.dat", 1)!=0 || queries("match.dat", 0)!=0 ||
+       queries("match2.dat", 1)!=0 )
+      return 1;
+
+   /* record 5 is a generic record with user info 2, which matches none of
+    * the queries */
+   if( break_record("match2.dat", 5)!=0 || queries("match2.dat", 0)!=0 )
+      return 1;
+   printf("record queries passed\n");
+   return 0;
+}
@@ -0,0 +1,203 @@
+/* testnamed.c
+ *
+ * tests writing records with names and finding them through the index
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "testutil.h"
+
+#define NREC 200
+#define N 100
+
+
+int write_file(char *file, char *mode, int first, int last, int named)
+{
+   /* writes records first..last-1, named ones every other */
+   BDIO *fh;
+   double d[N];
+   char name[32];
+   int i, j;
+
+   fh = bdio_open(file, mode, "Test file for named records");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_chain(fh);
+   for( i=first; i<last; i++ )
+   {
+      for( j=0; j<N; j++ )
+         d[j] = i+0.5*j;
+      sprintf(name, "corr_pp_t0=%i", i);
+      if( i%2==0 )
+      {
+         if( named )
+         {
+            if( bdio_write_named(name, BDIO_BIN_F64, 2, d, sizeof(d), fh)
+                !=sizeof(d) )
+               return 1;
+         }
+         else
+         {
+            bdio_start_record(BDIO_ASC_GENERIC, 2, fh);
+            bdio_write(name, strlen(name), fh);
+            bdio_start_record(BDIO_BIN_F64, 2, fh);
+            bdio_write_f64(d, sizeof(d), fh);
+         }
+      }
+      else
+      {
+         bdio_start_record(BDIO_BIN_F64, 1, fh);
+         bdio_write_f64(d, sizeof(d), fh);
+      }
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int lookup(char *file, int n)
+{
+   /* finds the named records among the first n in reverse order */
+   BDIO *fh;
+   double d[N];
+   char name[32];
+   int i, j;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   bdio_verify_on_read(1, fh);
+   for( i=n-2; i>=0; i-=2 )
+   {
+      sprintf(name, "corr_pp_t0=%i", i);
+      if( bdio_seek_named(name, fh)!=0 || bdio_get_ruinfo(fh)!=2 ||
+          bdio_read_f64(d, sizeof(d), fh)!=sizeof(d) )
+      {
+         printf("bdio_seek_named does not find %s\n", name);
+         return 1;
+      }
+      for( j=0; j<N; j++ )
+         if( d[j]!=i+0.5*j )
+         {
+            printf("record %s is wrong at %i\n", name, j);
+            return 1;
+         }
+   }
+   if( bdio_seek_named("corr_pp_t0=1", fh)!=EOF ||
+       bdio_seek_named("corr_pp", fh)!=EOF ||
+       bdio_seek_named("zzz", fh)!=EOF )
+   {
+      printf("bdio_seek_named finds records that have no name\n");
+      return 1;
+   }
+
+   /* reading continues after the named record */
+   if( bdio_seek_named("corr_pp_t0=10", fh)!=0 ||
+       bdio_seek_record(fh)!=0 || bdio_seek_record(fh)!=0 ||
+       bdio_read_f64(d, sizeof(d), fh)!=sizeof(d) || d[0]!=11.0 ||
+       bdio_get_rcnt(fh)!=35 )
+   {
+      printf("wrong record after a named record\n");
+      return 1;
+   }
+   if( fh->nerror!=0 )
+   {
+      printf("found %i errors\n", fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int count_records(char *file)
+{
+   /* counts the records of file seen by bdio_seek_record */
+   BDIO *fh;
+   int n=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return -1;
+   while( bdio_seek_record(fh)!=EOF )
+      n++;
+   if( n!=bdio_get_rcnt(fh) )
+      n = -1;
+   bdio_close(fh);
+   return n;
+}
+
+
+int old_layout(char *file)
+{
+   /* rewrites the index record at the end of file in the layout of index
+    * records without record table, which lack the number of records.
+    * The header of the unnamed record 5 is overwritten, so that the named
+    * records can only be found through the index. */
+   unsigned char *buf;
+   uint64_t len;
+   uint32_t hdr;
+   long size;
+   int k;
+
+   if( break_record(file, 5)!=0 || (buf = load_file(file, &size))==NULL ||
+       size<12 || (len = trailer_length(buf, size))>(uint64_t) size )
+      return 1;
+
+   /* the index record has a short header in the byte order of the machine */
+   memcpy(&hdr, buf+size-len, 4);
+   hdr -= 4 << 12;
+   memcpy(buf+size-len, &hdr, 4);
+   memmove(buf+size-len+12, buf+size-len+16, len-16);
+   size -= 4;
+   len -= 4;
+   for( k=0; k<8; k++ )
+      buf[size-12+k] = (unsigned char) (len >> (8*k));
+   if( save_file(file, buf, size)!=0 )
+      return 1;
+   free(buf);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   bdio_set_dflt_verbose(1);
+   if( write_file("named.dat", "w", 0, NREC/2, 1)!=0 ||
+       write_file("named.dat", "a", NREC/2, NREC, 1)!=0 )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+   if( lookup("named.dat", NREC)!=0 )
+      return 1;
+
+   /* the index records are hidden, also the one left by the first write:
+    * NREC/2 names and NREC data records, each followed by its hash record */
+   if( write_file("named3.dat", "w", 0, NREC, 1)!=0 ||
+       count_records("named.dat")!=3*NREC ||
+       count_records("named3.dat")!=3*NREC )
+   {
+      printf("index records are seen as records\n");
+      return 1;
+   }
+   if( old_layout("named.dat")!=0 || lookup("named.dat", NREC)!=0 )
+   {
+      printf("index without record table is not read\n");
+      return 1;
+   }
+
+   /* files without an index are searched */
+   if( write_file("named2.dat", "w", 0, NREC/4, 0)!=0 )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+   if( lookup("named2.dat", NREC/4)!=0 )
+      return 1;
+   printf("named records passed\n");
+   return 0;
+}
@@ -0,0 +1,197 @@
+/* testseek.c
+ *
+ * tests moving the read position within records and strided reads
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 200000
+#define NREC 3
+
+static int codec[NREC] = {BDIO_CODEC_NONE, BDIO_CODEC_LZ, BDIO_CODEC_PACK};
+static int fmt[NREC] = {BDIO_BIN_F64, BDIO_BIN_F64, BDIO_BIN_INT64};
+
+
+int64_t value(int i, size_t j)
+{
+   return (i==2) ? (int64_t) (3*j) : (int64_t) (j%1000);
+}
+
+
+int write_file(char *file)
+{
+   BDIO *fh;
+   double *d;
+   int64_t *n;
+   size_t j;
+   int i;
+
+   d = malloc(8*N);
+   n = (int64_t*) d;
+   fh = bdio_open(file, "w", "Test file for seeks within records");
+   if( fh==NULL || d==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   for( i=0; i<NREC; i++ )
+   {
+      bdio_set_codec(codec[i], fh);
+      bdio_start_record(fmt[i], 1, fh);
+      if( i==2 )
+      {
+         for( j=0; j<N; j++ )
+            n[j] = value(i, j);
+         bdio_write_int64(n, 8*N, fh);
+      }else
+      {
+         for( j=0; j<N; j++ )
+            d[j] = (double) value(i, j);
+         bdio_write_f64(d, 8*N, fh);
+      }
+   }
+   bdio_close(fh);
+   free(d);
+   return 0;
+}
+
+
+int check(int i, int64_t pos, BDIO *fh)
+{
+   /* reads 100 numbers at byte offset pos of record i */
+   int64_t n[100];
+   double d[100];
+   size_t j;
+
+   if( i==2 )
+      bdio_read_int64(n, 800, fh);
+   else
+   {
+      bdio_read_f64(d, 800, fh);
+      for( j=0; j<100; j++ )
+         n[j] = (int64_t) d[j];
+   }
+   for( j=0; j<100; j++ )
+      if( n[j]!=value(i, pos/8+j) )
+      {
+         printf("record %i is wrong at %li\n", i, (long) (pos/8+j));
+         return 1;
+      }
+   return 0;
+}
+
+
+int check_strided(int i, BDIO *fh)
+{
+   /* small strides are picked from spans, large ones are seeked */
+   size_t first[2] = {5, 17}, count[2] = {1000, 60}, stride[2] = {3, 3001};
+   int64_t n[1000];
+   double d[1000];
+   size_t j, nr;
+   int k;
+
+   for( k=0; k<2; k++ )
+   {
+      if( i==2 )
+         nr = bdio_read_strided_int64(n, first[k], count[k], stride[k], fh);
+      else
+      {
+         nr = bdio_read_strided_f64(d, first[k], count[k], stride[k], fh);
+         for( j=0; j<nr; j++ )
+            n[j] = (int64_t) d[j];
+      }
+      if( nr!=count[k] )
+      {
+         printf("strided read of record %i returns %lu numbers\n", i,
+                (unsigned long) nr);
+         return 1;
+      }
+      for( j=0; j<count[k]; j++ )
+         if( n[j]!=value(i, first[k]+j*stride[k]) )
+         {
+            printf("strided read of record %i is wrong at %lu\n", i,
+                   (unsigned long) j);
+            return 1;
+         }
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   /* forwards within a block, across blocks, backwards, to the end */
+   int64_t pos[6] = {8000, 16000, 800000, 80000, 0, 8*N-800};
+   BDIO *fh;
+   int i, k;
+   double d[100];
+
+   bdio_set_dflt_verbose(1);
+   if( write_file("seek.dat")!=0 )
+   {
+      printf("Could not write test file\n");
+      return 1;
+   }
+   fh = bdio_open("seek.dat", "r", NULL);
+   bdio_verify_on_read(1, fh);
+   for( i=0; i<NREC; i++ )
+   {
+      while( bdio_seek_record(fh)!=EOF && bdio_get_ruinfo(fh)!=1 );
+      for( k=0; k<6; k++ )
+         if( bdio_seek_in_record(pos[k], SEEK_SET, fh)!=0 ||
+             check(i, pos[k], fh)!=0 )
+            return 1;
+      if( bdio_seek_in_record(-1600, SEEK_CUR, fh)!=0 ||
+          check(i, 8*N-1600, fh)!=0 ||
+          bdio_seek_in_record(-800*4, SEEK_END, fh)!=0 ||
+          check(i, 8*N-3200, fh)!=0 )
+         return 1;
+      if( check_strided(i, fh)!=0 ||
+          bdio_seek_in_record(0, SEEK_END, fh)!=0 )
+         return 1;
+   }
+   if( fh->nerror!=0 )
+   {
+      printf("found %i errors\n", fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+
+   /* without seeks the checksums are still verified */
+   fh = bdio_open("seek.dat", "r", NULL);
+   bdio_verify_on_read(1, fh);
+   while( bdio_seek_record(fh)!=EOF )
+      if( bdio_get_ruinfo(fh)==1 )
+      {
+         bdio_seek_in_record(0, SEEK_SET, fh);
+         for( k=0; k<N/100; k++ )
+            bdio_read(d, 800, fh);
+      }
+   if( fh->nerror!=0 )
+   {
+      printf("found %i errors after sequential reads\n", fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+
+   fh = bdio_open("seek.dat", "r", NULL);
+   bdio_set_verbose(0, fh);
+   bdio_seek_record(fh);
+   if( bdio_seek_in_record(4, SEEK_SET, fh)!=EOF ||
+       bdio_seek_in_record(8, SEEK_END, fh)!=EOF ||
+       bdio_seek_in_record(-8, SEEK_SET, fh)!=EOF )
+   {
+      printf("bdio_seek_in_record accepts invalid offsets\n");
+      return 1;
+   }
+   if( bdio_read_strided_f64(d, 1, 2, N, fh)!=0 ||
+       bdio_read_strided_f32((float*) d, 0, 2, 1, fh)!=0 )
+   {
+      printf("bdio_read_strided_f64 reads beyond the record\n");
+      return 1;
+   }
+   bdio_close(fh);
+   printf("seeks within records passed\n");
+   return 0;
+}
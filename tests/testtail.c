@@ -0,0 +1,340 @@
+/* testtail.c
+ *
+ * tests reading records backwards and from the end of files
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "testutil.h"
+
+#define NREC 40
+#define N 200
+#define NBLK 3000
+
+
+int write_file(char *file, char *mode, int first, int last, int table)
+{
+   /* data record i holds i+0.5*j and is followed by a checksum record */
+   BDIO *fh;
+   double d[N];
+   int i, j;
+
+   fh = bdio_open(file, mode, "Test file for tail reads");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_chain(fh);
+   if( table && bdio_index_records(fh)!=0 )
+      return 1;
+   for( i=first; i<last; i++ )
+   {
+      for( j=0; j<N; j++ )
+         d[j] = i+0.5*j;
+      bdio_set_codec((i%3==0) ? BDIO_CODEC_LZ : BDIO_CODEC_NONE, fh);
+      bdio_start_record(BDIO_BIN_F64, 1, fh);
+      bdio_write_f64(d, 8*(N-i%5), fh);
+   }
+   if( table==2 )
+      bdio_write_named("last", BDIO_BIN_F64, 2, d, 8, fh);
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check(BDIO *fh, int n)
+{
+   /* checks record n, which counts from 1 like bdio_get_rcnt */
+   double d[N];
+   int i=(n-1)/2, j;
+
+   if( bdio_get_rcnt(fh)!=n )
+   {
+      printf("found record %i instead of %i\n", bdio_get_rcnt(fh), n);
+      return 1;
+   }
+   if( n%2==0 || n>2*NREC )
+      return 0;
+   if( bdio_get_ruinfo(fh)!=1 || bdio_read_f64(d, 8*(N-i%5), fh)!=8*(N-i%5) )
+   {
+      printf("record %i can not be read\n", n);
+      return 1;
+   }
+   for( j=0; j<N-i%5; j++ )
+      if( d[j]!=i+0.5*j )
+      {
+         printf("record %i is wrong at %i\n", n, j);
+         return 1;
+      }
+   return 0;
+}
+
+
+int read_back(char *file, int nrec)
+{
+   BDIO *fh;
+   int n, k;
+
+   for( k=1; k<=nrec+3; k+=7 )
+   {
+      fh = bdio_open_tail(file, k);
+      if( fh==NULL )
+      {
+         printf("bdio_open_tail fails for %s\n", file);
+         return 1;
+      }
+      bdio_verify_on_read(1, fh);
+      n = (k<nrec) ? nrec-k+1 : 1;
+      while( bdio_seek_record(fh)!=EOF )
+         if( check(fh, n++)!=0 )
+            return 1;
+      if( n!=nrec+1 || fh->nerror!=0 )
+      {
+         printf("bdio_open_tail(%s, %i) reads %i records\n", file, k,
+                n-((k<nrec) ? nrec-k+1 : 1));
+         return 1;
+      }
+      bdio_close(fh);
+   }
+
+   /* from the end to the start */
+   fh = bdio_open(file, "r", NULL);
+   bdio_verify_on_read(1, fh);
+   while( bdio_seek_record(fh)!=EOF && bdio_get_rcnt(fh)<=nrec );
+   for( n=nrec; n>0; n-- )
+      if( bdio_seek_prev_record(fh)!=0 || check(fh, n)!=0 )
+      {
+         printf("bdio_seek_prev_record fails for record %i of %s\n", n,
+                file);
+         return 1;
+      }
+   if( bdio_seek_prev_record(fh)!=EOF || fh->nerror!=0 )
+   {
+      printf("bdio_seek_prev_record passes the first record of %s\n", file);
+      return 1;
+   }
+
+   /* forwards again from the first record, with backward steps */
+   for( n=2; n<=nrec; n++ )
+   {
+      if( bdio_seek_record(fh)!=0 || check(fh, n)!=0 ||
+          (n%4==0 && (bdio_seek_prev_record(fh)!=0 ||
+                      check(fh, n-1)!=0 || bdio_seek_record(fh)!=0)) )
+      {
+         printf("bdio_seek_record fails after going back in %s\n", file);
+         return 1;
+      }
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int write_ints(char *file, int table)
+{
+   /* record i holds i, for i=1..NBLK */
+   BDIO *fh;
+   int32_t i;
+
+   fh = bdio_open(file, "w", "Test file for tail reads");
+   if( fh==NULL || (table && bdio_index_records(fh)!=0) )
+      return 1;
+   for( i=1; i<=NBLK; i++ )
+   {
+      bdio_start_record(BDIO_BIN_INT32, 3, fh);
+      bdio_write_int32(&i, 4, fh);
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int count_records(char *file, int k)
+{
+   /* counts the records of file, after bdio_open_tail if k>0. The blocks
+    * of the table are not among them. Returns -1 if bdio_get_rcnt does
+    * not match. */
+   BDIO *fh;
+   int32_t i;
+   int n=0;
+
+   fh = (k>0) ? bdio_open_tail(file, k) : bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return -1;
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_read_int32(&i, 4, fh)!=4 || i!=bdio_get_rcnt(fh) )
+      {
+         bdio_close(fh);
+         return -1;
+      }
+      n++;
+   }
+   bdio_close(fh);
+   return n;
+}
+
+
+int hash_follows(char *file)
+{
+   /* with checksums, the blocks of the table are not written between a
+    * record and its hash record */
+   BDIO *fh;
+   FILE *fp;
+   unsigned char h[4];
+   uint32_t hdr;
+   int32_t i;
+
+   fh = bdio_open(file, "w", "Test file for tail reads");
+   if( fh==NULL || bdio_index_records(fh)!=0 )
+      return 1;
+   for( i=1; i<=NBLK; i++ )
+   {
+      /* the first record has no hash record, so that a block is due when
+       * one is started */
+      if( i==2 )
+         bdio_hash_auto(fh);
+      bdio_start_record(BDIO_BIN_INT32, 3, fh);
+      bdio_write_int32(&i, 4, fh);
+   }
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   fp = fopen(file, "rb");
+   if( fh==NULL || fp==NULL )
+      return 1;
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)!=3 || bdio_get_rcnt(fh)==1 )
+         continue;
+      if( fseek(fp, (long) (bdio_get_rstart(fh)+bdio_get_rlen(fh)),
+                SEEK_SET)!=0 || fread(h, 1, 4, fp)!=4 )
+         return 1;
+      /* a generic record with uinfo 7 and 20 bytes, in the byte order of
+       * the machine */
+      memcpy(&hdr, h, 4);
+      if( (hdr & 0xff3)!=0x701 || (hdr >> 12)!=20 )
+      {
+         printf("record %i is not followed by its hash record\n",
+                bdio_get_rcnt(fh));
+         return 1;
+      }
+   }
+   fclose(fp);
+   bdio_close(fh);
+   return 0;
+}
+
+
+int write_blocks(char *file)
+{
+   /* the index record is cut off as if the writer had not closed the file,
+    * and the header of record 10 is overwritten, so that the records can
+    * only be found with the blocks of the table */
+   unsigned char *buf;
+   long size;
+
+   if( write_ints(file, 1)!=0 || break_record(file, 10)!=0 ||
+       (buf = load_file(file, &size))==NULL || size<12 ||
+       save_file(file, buf, size-trailer_length(buf, size))!=0 )
+      return 1;
+   free(buf);
+   return 0;
+}
+
+
+int next_int(BDIO *fh, int32_t *i)
+{
+   /* reads the next record written by write_ints */
+   if( bdio_seek_record(fh)==EOF )
+      return EOF;
+   if( bdio_read_int32(i, 4, fh)!=4 || *i!=bdio_get_rcnt(fh) )
+      return 1;
+   return 0;
+}
+
+
+int read_blocks(char *file)
+{
+   BDIO *fh;
+   int32_t i, j;
+   int k;
+
+   for( k=1; k<=30; k+=7 )
+   {
+      fh = bdio_open_tail(file, k);
+      if( fh==NULL )
+      {
+         printf("bdio_open_tail fails without index record\n");
+         return 1;
+      }
+      for( j=NBLK-k+1; next_int(fh, &i)==0; j++ )
+         if( i!=j )
+         {
+            printf("bdio_open_tail(%s, %i) reads %i\n", file, k, i);
+            return 1;
+         }
+      if( j!=NBLK+1 || i!=NBLK || fh->nerror!=0 )
+      {
+         printf("bdio_open_tail(%s, %i) ends at %i\n", file, k, i);
+         return 1;
+      }
+
+      /* back to record 11, in the older blocks of the table */
+      for( j=NBLK; j>10; j-- )
+      {
+         if( bdio_seek_prev_record(fh)!=0 )
+         {
+            printf("bdio_seek_prev_record fails before %i\n", j);
+            return 1;
+         }
+         if( bdio_read_int32(&i, 4, fh)!=4 || i!=j )
+         {
+            printf("bdio_seek_prev_record reads %i instead of %i\n", i, j);
+            return 1;
+         }
+      }
+      if( fh->nerror!=0 )
+         return 1;
+      bdio_close(fh);
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   bdio_set_dflt_verbose(1);
+
+   /* with a record table, also after appending */
+   if( write_file("tail.dat", "w", 0, NREC/2, 1)!=0 ||
+       write_file("tail.dat", "a", NREC/2, NREC, 0)!=0 ||
+       read_back("tail.dat", 2*NREC)!=0 )
+      return 1;
+
+   /* without, and with an index of names only */
+   if( write_file("tail2.dat", "w", 0, NREC, 0)!=0 ||
+       read_back("tail2.dat", 2*NREC)!=0 ||
+       write_file("tail3.dat", "w", 0, NREC, 2)!=0 ||
+       read_back("tail3.dat", 2*NREC+4)!=0 )
+      return 1;
+
+   /* the blocks of the table are not counted as records */
+   if( write_ints("tail5.dat", 1)!=0 || write_ints("tail6.dat", 0)!=0 ||
+       count_records("tail5.dat", 0)!=NBLK ||
+       count_records("tail6.dat", 0)!=NBLK ||
+       count_records("tail5.dat", 3)!=3 || count_records("tail6.dat", 3)!=3 )
+   {
+      printf("blocks of the record table are read as records\n");
+      return 1;
+   }
+   if( hash_follows("tail7.dat")!=0 )
+      return 1;
+
+   /* from the blocks of the table, before bdio_close */
+   if( write_blocks("tail4.dat")!=0 || read_blocks("tail4.dat")!=0 )
+      return 1;
+   printf("tail reads passed\n");
+   return 0;
+}
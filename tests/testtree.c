@@ -0,0 +1,298 @@
+/* testtree.c
+ *
+ * tests tree-hash records and the verification of parts of records
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <md5.h>
+#include <md5mb.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include "testutil.h"
+
+#define CHUNK 4096
+#define NREC 6
+
+/* record lengths: empty, shorter than a chunk, one chunk, a few chunks,
+ * many chunks and a long record */
+static size_t rlen[NREC] = {0, 1, CHUNK, 3*CHUNK+17, 200*CHUNK+5, 1200000};
+
+/* number of calls of the multi-buffer MD5 with more than one message */
+static int nmb=0;
+
+
+/* the multi-buffer MD5 of the library is replaced by the plain one, which
+ * counts how often several chunks are hashed at once */
+int MD5_MB_Lanes(void)
+{
+   return 4;
+}
+
+
+void MD5_MB_Hash(MD5_MB_JOB *jobs, int n)
+{
+   MD5_CTX ctx;
+   int i;
+
+   if( n>1 )
+      nmb++;
+   for( i=0; i<n; i++ )
+   {
+      MD5_Init(&ctx);
+      if( jobs[i].plen>0 )
+         MD5_Update(&ctx, (void*) jobs[i].prefix, jobs[i].plen);
+      MD5_Update(&ctx, (void*) jobs[i].data, jobs[i].size);
+      MD5_Final(jobs[i].digest, &ctx);
+   }
+}
+
+
+int write_file(char *file, int type)
+{
+   BDIO *fh;
+   unsigned char *d;
+   size_t i, j;
+
+   d = malloc(rlen[NREC-1]);
+   fh = bdio_open(file, "w", "Test file for tree-hash records");
+   if( fh==NULL || d==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_type(type, fh);
+
+   /* one record in single mode, then switch while it is still open */
+   bdio_start_record(BDIO_BIN_GENERIC, 1, fh);
+   bdio_write(d, 100, fh);
+   if( bdio_hash_tree(CHUNK, fh)!=0 )
+      return 1;
+
+   for( i=0; i<NREC; i++ )
+   {
+      for( j=0; j<rlen[i]; j++ )
+         d[j] = (unsigned char) (i*7+j*13+(j>>12));
+      if( bdio_start_record(BDIO_BIN_GENERIC, 2, fh)!=0 )
+         return 1;
+      /* written in pieces that do not match the chunk size */
+      for( j=0; j<rlen[i]; j+=10007 )
+         if( bdio_write(d+j, (rlen[i]-j<10007) ? rlen[i]-j : 10007, fh)
+             != ((rlen[i]-j<10007) ? rlen[i]-j : 10007) )
+            return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   return 0;
+}
+
+
+int read_file(char *file)
+{
+   /* reads every record completely with checksums verified on the fly
+    * and returns the number of errors */
+   BDIO *fh;
+   unsigned char *d;
+   int nerr;
+
+   d = malloc(rlen[NREC-1]);
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || d==NULL || bdio_verify_on_read(1, fh)!=0 )
+      return EOF;
+   bdio_set_verbose(0, fh);
+   while( bdio_seek_record(fh)!=EOF )
+      bdio_read(d, bdio_get_rlen(fh), fh);
+   nerr = fh->nerror;
+   bdio_close(fh);
+   free(d);
+   return nerr;
+}
+
+
+int count_trees(char *file, int type)
+{
+   /* number of tree-hash records of algorithm type */
+   BDIO *fh;
+   unsigned char digest[16];
+   int n=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return EOF;
+   while( bdio_seek_record(fh)!=EOF )
+      if( bdio_is_hash_record(digest, fh)==type && bdio_get_rlen(fh)!=20 )
+         n++;
+   bdio_close(fh);
+   return n;
+}
+
+
+long last_record(char *file, BDIO **fh)
+{
+   /* positions *fh at the start of the longest record and returns the
+    * position of its payload in the file */
+   *fh = bdio_open(file, "r", NULL);
+   if( *fh==NULL )
+      return -1;
+   while( bdio_seek_record(*fh)!=EOF )
+      if( bdio_get_rlen(*fh)==rlen[NREC-1] )
+         return ftell((*fh)->fp);
+   bdio_close(*fh);
+   return -1;
+}
+
+
+int check_ranges(char *file, uint64_t bad)
+{
+   /* the ranges touching the chunk of byte bad must fail, all others
+    * pass. Without a corrupted byte, bad is ~0. */
+   BDIO *fh;
+   uint64_t off[5] = {0, CHUNK-1, CHUNK, 5*CHUNK+3, 292*CHUNK};
+   uint64_t nb[5]  = {CHUNK, 2, 1, 10*CHUNK, rlen[NREC-1]-292*CHUNK};
+   int i, exp, ret;
+   long pos;
+
+   if( last_record(file, &fh)<0 )
+      return 1;
+   pos = ftell(fh->fp);
+   for( i=0; i<5; i++ )
+   {
+      exp = (bad/CHUNK >= off[i]/CHUNK) && (bad/CHUNK <= (off[i]+nb[i]-1)/CHUNK);
+      if( (ret=bdio_verify_range(off[i], nb[i], fh))!=exp )
+      {
+         printf("bdio_verify_range(%lu,%lu) returns %i instead of %i\n",
+                (unsigned long) off[i], (unsigned long) nb[i], ret, exp);
+         return 1;
+      }
+   }
+   if( ftell(fh->fp)!=pos || bdio_verify_range(0, rlen[NREC-1]+1, fh)!=EOF )
+   {
+      printf("bdio_verify_range does not leave the record untouched\n");
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check(char *file, int type)
+{
+   BDIO *fh;
+   long pos;
+   int nbad;
+
+   if( write_file(file, type)!=0 )
+   {
+      printf("Could not write %s\n",file);
+      return 1;
+   }
+   if( count_trees(file, type)!=NREC )
+   {
+      printf("Expected %i tree-hash records of type %i\n", NREC, type);
+      return 1;
+   }
+   if( (nbad=verify_file(file, 1))!=0 || (nbad=verify_file(file, 3))!=0 )
+   {
+      printf("bdio_verify finds %i mismatches (type %i)\n", nbad, type);
+      return 1;
+   }
+   if( check_ranges(file, ~(uint64_t) 0)!=0 )
+      return 1;
+   if( (nbad=read_file(file))!=0 )
+   {
+      printf("bdio_verify_on_read reports %i errors (type %i)\n", nbad, type);
+      return 1;
+   }
+
+   /* flip a bit in chunk 7 of the longest record */
+   if( (pos=last_record(file, &fh))<0 )
+      return 1;
+   bdio_close(fh);
+   flip_bits(file, pos+7*CHUNK+100, SEEK_SET, 0x04);
+
+   if( (nbad=verify_file(file, 1))!=1 || (nbad=verify_file(file, 3))!=1 )
+   {
+      printf("bdio_verify finds %i instead of 1 mismatches (type %i)\n",
+             nbad, type);
+      return 1;
+   }
+   if( (nbad=read_file(file))!=1 )
+   {
+      printf("bdio_verify_on_read reports %i instead of 1 errors (type %i)\n",
+             nbad, type);
+      return 1;
+   }
+   return check_ranges(file, 7*CHUNK+100);
+}
+
+
+int check_batched(char *file)
+{
+   /* a record of the default chunk size written in pieces of one chunk,
+    * as they reach the checksum, has its chunks hashed several at once */
+   BDIO *fh;
+   unsigned char *d;
+   size_t j, n=BDIO_HASH_TREE_CHUNK;
+   int nbad;
+
+   d = malloc(n);
+   fh = bdio_open(file, "w", "Test file for tree-hash records");
+   if( fh==NULL || d==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   if( bdio_hash_tree(0, fh)!=0 ||
+       bdio_start_record(BDIO_BIN_GENERIC, 3, fh)!=0 )
+      return 1;
+   nmb = 0;
+   for( j=0; j<9; j++ )
+   {
+      memset(d, (int) j, n);
+      if( bdio_write(d, (j<8) ? n : n/3, fh)!=((j<8) ? n : n/3) )
+         return 1;
+   }
+   bdio_close(fh);
+   if( nmb==0 )
+   {
+      printf("chunks of a tree-hash record are hashed one by one\n");
+      return 1;
+   }
+   if( (nbad=verify_file(file, 1))!=0 )
+   {
+      printf("bdio_verify finds %i mismatches in a record hashed in "
+             "batches\n", nbad);
+      return 1;
+   }
+
+   /* read back in pieces of one chunk with checksums verified on the fly */
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || bdio_verify_on_read(1, fh)!=0 ||
+       bdio_seek_record(fh)==EOF )
+      return 1;
+   nmb = 0;
+   for( j=0; j<9; j++ )
+      bdio_read(d, (j<8) ? n : n/3, fh);
+   bdio_seek_record(fh);
+   nbad = fh->nerror;
+   bdio_close(fh);
+   free(d);
+   if( nbad!=0 || nmb==0 )
+   {
+      printf("bdio_verify_on_read reports %i errors, %i batches\n", nbad, nmb);
+      return 1;
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   int type;
+
+   bdio_set_dflt_verbose(1);
+   for( type=BDIO_HASH_MD5; type<=BDIO_HASH_XXH64; type++ )
+      if( check("tree.dat", type)!=0 )
+         return 1;
+   if( check_batched("tree.dat")!=0 )
+      return 1;
+   printf("tree-hash records passed\n");
+   return 0;
+}
@@ -0,0 +1,219 @@
+/* testupdate.c
+ *
+ * tests changing records in place in update mode
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NREC 4
+#define N 3000
+
+/* no checksums, single, chain and tree mode */
+#define NMODE 4
+
+/* records of the file with record table */
+#define NTAB 3000
+
+
+int write_file(char *file, int mode)
+{
+   BDIO *fh;
+   double d[N];
+   int i, j;
+
+   fh = bdio_open(file, "w", "Test file for updated records");
+   if( fh==NULL )
+      return 1;
+   if( mode>0 )
+      bdio_hash_auto(fh);
+   if( mode==2 )
+      bdio_hash_chain(fh);
+   if( mode==3 )
+      bdio_hash_tree(1000, fh);
+   for( i=0; i<NREC; i++ )
+   {
+      for( j=0; j<N; j++ )
+         d[j] = i+0.5*j;
+      bdio_start_record(BDIO_BIN_F64, 1, fh);
+      bdio_write_f64(d, 8*(N-i), fh);
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int check_file(char *file, int recno, int first)
+{
+   /* record recno holds -1 at the numbers first..first+9 */
+   BDIO *fh;
+   double d[N];
+   int i=0, j;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 1;
+   bdio_verify_on_read(1, fh);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_ruinfo(fh)!=1 )
+         continue;
+      bdio_read_f64(d, 8*(N-i), fh);
+      for( j=0; j<N-i; j++ )
+         if( d[j] != ((bdio_get_rcnt(fh)==recno && j>=first && j<first+10) ?
+                      -1.0 : i+0.5*j) )
+         {
+            printf("record %i is wrong at %i\n", bdio_get_rcnt(fh), j);
+            return 1;
+         }
+      i++;
+   }
+   if( i!=NREC || fh->nerror!=0 )
+   {
+      printf("found %i records and %i errors\n", i, fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   fh = bdio_open(file, "r", NULL);
+   if( bdio_verify(1, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails after the update\n");
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int table_file(char *file)
+{
+   /* record i of a file with record table and a chain of checksums holds
+    * i, the data records are updated in an order that is not the one of
+    * the file */
+   int32_t i, j, k, upd[4] = {NTAB, 1500, NTAB-1, 2};
+   BDIO *fh;
+
+   fh = bdio_open(file, "w", "Test file for updated records");
+   if( fh==NULL || bdio_index_records(fh)!=0 )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_chain(fh);
+   for( i=1; i<=NTAB; i++ )
+   {
+      bdio_start_record(BDIO_BIN_INT32, 3, fh);
+      bdio_write_int32(&i, 4, fh);
+   }
+   bdio_close(fh);
+
+   /* data record i is record 2*i-1, followed by its hash record */
+   fh = bdio_open(file, "u", NULL);
+   for( k=0; k<4; k++ )
+   {
+      j = -upd[k];
+      if( bdio_update_record(2*upd[k]-1, 0, &j, 4, fh)!=0 )
+      {
+         printf("bdio_update_record fails for data record %i\n", upd[k]);
+         return 1;
+      }
+   }
+   bdio_close(fh);
+
+   fh = bdio_open(file, "r", NULL);
+   bdio_verify_on_read(1, fh);
+   for( i=1; bdio_seek_record(fh)!=EOF; )
+   {
+      if( bdio_get_ruinfo(fh)!=3 )
+         continue;
+      if( bdio_read_int32(&j, 4, fh)!=4 ||
+          j!=((i==upd[0] || i==upd[1] || i==upd[2] || i==upd[3]) ? -i : i) )
+      {
+         printf("data record %i holds %i\n", i, j);
+         return 1;
+      }
+      i++;
+   }
+   if( i!=NTAB+1 || fh->nerror!=0 )
+   {
+      printf("found %i data records and %i errors\n", i-1, fh->nerror);
+      return 1;
+   }
+   bdio_close(fh);
+   fh = bdio_open(file, "r", NULL);
+   if( bdio_verify(1, NULL, fh)!=0 )
+   {
+      printf("bdio_verify fails after updates through the record table\n");
+      return 1;
+   }
+   bdio_close(fh);
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   double d[10];
+   int j, k, mode, recno;
+
+   bdio_set_dflt_verbose(1);
+   for( j=0; j<10; j++ )
+      d[j] = -1.0;
+   for( mode=0; mode<NMODE; mode++ )
+   {
+      /* in chain mode an update of the first data record changes all
+       * following checksums */
+      for( k=0; k<2; k++ )
+      {
+         recno = (k==0) ? 1 : ((mode==0) ? 3 : 5);
+         if( write_file("update.dat", mode)!=0 )
+         {
+            printf("Could not write test file\n");
+            return 1;
+         }
+         fh = bdio_open("update.dat", "u", NULL);
+         if( fh==NULL || bdio_update_record(recno, 8*1995, d, 80, fh)!=0 )
+         {
+            printf("bdio_update_record fails in mode %i\n", mode);
+            return 1;
+         }
+         if( bdio_get_rcnt(fh)<recno )
+         {
+            printf("bdio_update_record leaves fh at record %i\n",
+                   bdio_get_rcnt(fh));
+            return 1;
+         }
+         bdio_close(fh);
+         if( check_file("update.dat", recno, 1995)!=0 )
+         {
+            printf("wrong update in mode %i\n", mode);
+            return 1;
+         }
+      }
+   }
+
+   if( table_file("update2.dat")!=0 )
+      return 1;
+
+   fh = bdio_open("update.dat", "u", NULL);
+   bdio_set_verbose(0, fh);
+   if( bdio_update_record(2, 0, d, 8, fh)!=EOF ||
+       bdio_update_record(5, 8*(N-2)-8, d, 16, fh)!=EOF ||
+       bdio_update_record(100, 0, d, 8, fh)!=EOF )
+   {
+      printf("bdio_update_record accepts invalid updates\n");
+      return 1;
+   }
+   bdio_close(fh);
+   fh = bdio_open("update.dat", "r", NULL);
+   bdio_set_verbose(0, fh);
+   if( bdio_update_record(1, 0, d, 8, fh)!=EOF )
+   {
+      printf("bdio_update_record works in read mode\n");
+      return 1;
+   }
+   bdio_close(fh);
+   printf("updated records passed\n");
+   return 0;
+}
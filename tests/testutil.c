@@ -0,0 +1,137 @@
+/* testutil.c
+ *
+ * helpers shared by the tests that inspect or damage the files they wrote
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "testutil.h"
+
+
+long file_size(const char *file)
+{
+   FILE *fp;
+   long n;
+
+   if( (fp=fopen(file,"rb"))==NULL )
+      return -1;
+   fseek(fp, 0, SEEK_END);
+   n = ftell(fp);
+   fclose(fp);
+   return n;
+}
+
+
+unsigned char *load_file(const char *file, long *size)
+{
+   /* the whole file in a buffer of *size bytes, to be freed */
+   FILE *fp;
+   unsigned char *buf;
+
+   if( (*size = file_size(file))<0 || (buf = malloc(*size+1))==NULL )
+      return NULL;
+   if( (fp=fopen(file,"rb"))==NULL ||
+       fread(buf, 1, *size, fp)!=(size_t) *size )
+   {
+      free(buf);
+      return NULL;
+   }
+   fclose(fp);
+   return buf;
+}
+
+
+int save_file(const char *file, const unsigned char *buf, long size)
+{
+   FILE *fp;
+
+   if( (fp=fopen(file,"wb"))==NULL ||
+       fwrite(buf, 1, size, fp)!=(size_t) size )
+      return 1;
+   fclose(fp);
+   return 0;
+}
+
+
+uint64_t trailer_length(const unsigned char *buf, long size)
+{
+   /* the length stored in front of the magic number at the end of an index
+    * record or table block ending at size */
+   uint64_t len=0;
+   int k;
+
+   for( k=7; k>=0; k-- )
+      len = (len << 8) | buf[size-12+k];
+   return len;
+}
+
+
+long record_header(const char *file, int rcnt)
+{
+   /* position of the short header of record rcnt, 0 if there is none */
+   BDIO *fh;
+   long pos=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return 0;
+   while( bdio_seek_record(fh)!=EOF )
+      if( bdio_get_rcnt(fh)==rcnt )
+         pos = (long) bdio_get_rstart(fh)-4;
+   bdio_close(fh);
+   return pos;
+}
+
+
+int break_record(const char *file, int rcnt)
+{
+   /* overwrites the header of record rcnt, which can then only be skipped
+    * with the record table */
+   FILE *fp;
+   unsigned char junk[4] = {0xff, 0xff, 0xff, 0xff};
+   long pos;
+
+   pos = record_header(file, rcnt);
+   fp = fopen(file, "r+b");
+   if( pos==0 || fp==NULL || fseek(fp, pos, SEEK_SET)!=0 ||
+       fwrite(junk, 1, 4, fp)!=4 )
+      return 1;
+   fclose(fp);
+   return 0;
+}
+
+
+int flip_bits(const char *file, long offset, int whence, int mask)
+{
+   /* flips the bits of mask in the byte at offset from whence */
+   FILE *fp;
+   int c;
+
+   if( (fp=fopen(file,"r+b"))==NULL )
+      return 1;
+   fseek(fp, offset, whence);
+   c = fgetc(fp);
+   fseek(fp, offset, whence);
+   fputc(c ^ mask, fp);
+   fclose(fp);
+   return 0;
+}
+
+
+int verify_file(const char *file, int nthreads)
+{
+   /* the number of bad records found by bdio_verify */
+   BDIO *fh;
+   int nbad;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return EOF;
+   nbad = bdio_verify(nthreads, NULL, fh);
+   bdio_close(fh);
+   return nbad;
+}
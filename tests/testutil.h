@@ -0,0 +1,21 @@
+/* testutil.h
+ *
+ * helpers shared by the tests that inspect or damage the files they wrote,
+ * see testutil.c
+ ******************************************************************************/
+
+#ifndef H_TESTUTIL
+#define H_TESTUTIL 1
+
+#include <stdint.h>
+
+extern long file_size(const char *file);
+extern unsigned char *load_file(const char *file, long *size);
+extern int save_file(const char *file, const unsigned char *buf, long size);
+extern uint64_t trailer_length(const unsigned char *buf, long size);
+extern long record_header(const char *file, int rcnt);
+extern int break_record(const char *file, int rcnt);
+extern int flip_bits(const char *file, long offset, int whence, int mask);
+extern int verify_file(const char *file, int nthreads);
+
+#endif
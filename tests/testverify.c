@@ -0,0 +1,281 @@
+/* testverify.c
+ *
+ * tests the parallel checksum verification of the bdio library
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include "testutil.h"
+
+#define NREC 20
+#define RLEN 100000
+
+
+int write_file(char *file, int type, int chain, const char *mode)
+{
+   BDIO *fh;
+   int i, j;
+   double *d;
+
+   d = malloc(RLEN*sizeof(double));
+   fh = bdio_open(file, mode, "Test file for bdio_verify");
+   if( fh==NULL || d==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   if( chain )
+      bdio_hash_chain(fh);
+   bdio_hash_type(type, fh);
+   for( i=0; i<NREC; i++ )
+   {
+      for( j=0; j<RLEN; j++ )
+         d[j] = i*RLEN+j;
+      /* every 5th record is an empty one, every 3rd spans more than one
+       * buffer of the checksum pipeline */
+      if( bdio_start_record(BDIO_BIN_F64LE, 3, fh)!=0 )
+         return 1;
+      if( (i%5)!=0 && bdio_write_f64(d, RLEN*sizeof(double), fh)!=
+                                        RLEN*sizeof(double) )
+         return 1;
+      if( (i%3)==0 && bdio_write_f64(d, RLEN*sizeof(double), fh)!=
+                                        RLEN*sizeof(double) )
+         return 1;
+   }
+   bdio_close(fh);
+   free(d);
+   return 0;
+}
+
+
+int read_file(char *file)
+{
+   /* reads every data record completely with checksums verified on the
+    * fly and returns the number of errors */
+   BDIO *fh;
+   double *d;
+   int nerr;
+
+   d = malloc(2*RLEN*sizeof(double));
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL || d==NULL || bdio_verify_on_read(1, fh)!=0 )
+      return EOF;
+   bdio_set_verbose(0, fh);
+   while( bdio_seek_record(fh)!=EOF )
+      if( bdio_get_rfmt(fh)==BDIO_BIN_F64LE )
+         bdio_read_f64(d, bdio_get_rlen(fh), fh);
+   nerr = fh->nerror;
+   bdio_close(fh);
+   free(d);
+   return nerr;
+}
+
+
+int check(char *file, int type, int chain)
+{
+   int nt[3]={1,2,7};
+   int i, nbad;
+
+   if( write_file(file, type, chain, "w")!=0 )
+   {
+      printf("Could not write %s\n",file);
+      return 1;
+   }
+   /* a second session continues the file, chains are restarted */
+   if( write_file(file, type, chain, "a")!=0 )
+   {
+      printf("Could not append to %s\n",file);
+      return 1;
+   }
+   for( i=0; i<3; i++ )
+   {
+      if( (nbad=verify_file(file, nt[i]))!=0 )
+      {
+         printf("bdio_verify finds %i mismatches in %s (type %i, chain %i, "
+                "%i threads)\n", nbad, file, type, chain, nt[i]);
+         return 1;
+      }
+   }
+   if( (nbad=read_file(file))!=0 )
+   {
+      printf("bdio_verify_on_read reports %i errors in %s (type %i, chain "
+             "%i)\n", nbad, file, type, chain);
+      return 1;
+   }
+
+   /* flip a bit in the payload of the last data record */
+   flip_bits(file, -30, SEEK_END, 0x10);
+   for( i=0; i<3; i++ )
+   {
+      if( (nbad=verify_file(file, nt[i]))!=1 )
+      {
+         printf("bdio_verify finds %i instead of 1 mismatches in corrupted "
+                "%s (type %i, chain %i, %i threads)\n", nbad, file, type,
+                chain, nt[i]);
+         return 1;
+      }
+   }
+   if( (nbad=read_file(file))!=1 )
+   {
+      printf("bdio_verify_on_read reports %i instead of 1 errors in "
+             "corrupted %s (type %i, chain %i)\n", nbad, file, type, chain);
+      return 1;
+   }
+   return 0;
+}
+
+
+int read_digests(char *file, unsigned char digests[][16], int max)
+{
+   BDIO *fh;
+   int nh=0;
+
+   fh = bdio_open(file, "r", NULL);
+   if( fh==NULL )
+      return EOF;
+   while( bdio_seek_record(fh)!=EOF && nh<max )
+      if( bdio_is_hash_record(digests[nh], fh) )
+         nh++;
+   bdio_close(fh);
+   return nh;
+}
+
+
+int check_batch(char *file1, char *file2)
+{
+   BDIO *fh;
+   unsigned char *data[37];
+   unsigned char d1[37][16], d2[37][16];
+   size_t nb[37];
+   int i, j;
+
+   /* records of different lengths, written by the batch writer and one
+    * by one, must have identical MD5 hash records */
+   for( i=0; i<37; i++ )
+   {
+      nb[i] = (i%7==0) ? 0 : 1+(i*7919)%(3*RLEN);
+      data[i] = malloc(nb[i]+1);
+      for( j=0; j<nb[i]; j++ )
+         data[i][j] = (unsigned char) (i+j*31);
+   }
+
+   fh = bdio_open(file1, "w", "Test file for bdio_write_records");
+   bdio_hash_auto(fh);
+   if( bdio_write_records(37, BDIO_BIN_GENERIC, 5, (void**) data, nb, fh)!=37 )
+   {
+      printf("bdio_write_records fails\n");
+      return 1;
+   }
+   bdio_close(fh);
+
+   fh = bdio_open(file2, "w", "Test file for bdio_write_records");
+   bdio_hash_auto(fh);
+   for( i=0; i<37; i++ )
+   {
+      bdio_start_record(BDIO_BIN_GENERIC, 5, fh);
+      bdio_write(data[i], nb[i], fh);
+   }
+   bdio_close(fh);
+
+   if( read_digests(file1, d1, 37)!=37 || read_digests(file2, d2, 37)!=37 )
+   {
+      printf("Expected 37 hash records\n");
+      return 1;
+   }
+   if( memcmp(d1, d2, 37*16)!=0 )
+   {
+      printf("bdio_write_records writes wrong checksums\n");
+      return 1;
+   }
+   if( verify_file(file1, 1)!=0 || verify_file(file1, 3)!=0 )
+   {
+      printf("bdio_verify fails on %s\n",file1);
+      return 1;
+   }
+   for( i=0; i<37; i++ )
+      free(data[i]);
+   return 0;
+}
+
+
+int check_chain(char *file)
+{
+   /* a chain restarted in the middle of the file verifies, records of a
+    * chain that are swapped do not */
+   BDIO *fh;
+   double d[1000];
+   long pos[2];
+   size_t len;
+   char *buf;
+   FILE *fp;
+   int i, j, nbad;
+
+   fh = bdio_open(file, "w", "Test file for restarted chains");
+   if( fh==NULL )
+      return 1;
+   bdio_hash_auto(fh);
+   bdio_hash_chain(fh);
+   for( i=0; i<12; i++ )
+   {
+      for( j=0; j<1000; j++ )
+         d[j] = i+0.5*j;
+      if( i==6 )
+         bdio_hash_chain(fh);
+      bdio_start_record(BDIO_BIN_F64LE, 3, fh);
+      bdio_write_f64(d, sizeof(d), fh);
+   }
+   bdio_close(fh);
+   if( (nbad=verify_file(file, 1))!=0 || (nbad=read_file(file))!=0 )
+   {
+      printf("restarted chain has %i mismatches\n", nbad);
+      return 1;
+   }
+
+   /* records 2 and 3 change places together with their hash records */
+   fh = bdio_open(file, "r", NULL);
+   while( bdio_seek_record(fh)!=EOF )
+   {
+      if( bdio_get_rcnt(fh)==5 )
+         pos[0] = (long) fh->rstart;
+      if( bdio_get_rcnt(fh)==7 )
+         pos[1] = (long) fh->rstart;
+   }
+   bdio_close(fh);
+   len = (size_t) (pos[1]-pos[0]);
+   buf = malloc(2*len);
+   fp = fopen(file, "r+b");
+   fseek(fp, pos[0], SEEK_SET);
+   if( buf==NULL || fread(buf, 1, 2*len, fp)!=2*len )
+      return 1;
+   fseek(fp, pos[0], SEEK_SET);
+   fwrite(buf+len, 1, len, fp);
+   fwrite(buf, 1, len, fp);
+   fclose(fp);
+   free(buf);
+   if( (nbad=verify_file(file, 1))!=3 || (nbad=verify_file(file, 3))!=3 ||
+       (nbad=read_file(file))!=3 )
+   {
+      printf("swapped records of a chain give %i instead of 3 mismatches\n",
+             nbad);
+      return 1;
+   }
+   return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+   int type, chain;
+
+   bdio_set_dflt_verbose(1);
+   for( type=BDIO_HASH_MD5; type<=BDIO_HASH_XXH64; type++ )
+      for( chain=0; chain<2; chain++ )
+         if( check("verify.dat", type, chain)!=0 )
+            return 1;
+   if( check_batch("verify.dat", "verify2.dat")!=0 ||
+       check_chain("verify.dat")!=0 )
+      return 1;
+   printf("bdio_verify passed\n");
+   return 0;
+}
@@ -0,0 +1,118 @@
+/* bdioverify.c
+ *
+ * verifies the checksums of the records of a bdio file
+ ******************************************************************************/
+
+
+#include <bdio.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <errno.h>
+
+#define BDIOVERIFY_VERSION "1.0"
+
+void printhelp()
+{
+   printf("\nusage:\n");
+   printf("   bdioverify [options] file\n\n");
+   printf("   recomputes the checksum of every record that is followed by\n");
+   printf("   a hash record and compares it with the stored one. The exit\n");
+   printf("   status is 0 if all checksums match, 1 if at least one\n");
+   printf("   does not, and 2 if file could not be read.\n\n");
+   printf("   -h, --help       print this help message\n");
+   printf("   -v, --version    print the program version\n");
+   printf("   -j n, --jobs=n   compute checksums with n threads\n");
+   printf("                    (default: number of online processors)\n");
+   printf("   -q, --quiet      do not print a report\n");
+}
+
+void printversion()
+{
+   printf("\nbdioverify version %s\n\n",BDIOVERIFY_VERSION);
+}
+
+int main(int argc, char *argv[])
+{
+   BDIO *fh;
+   int c, nbad;
+   int quiet=0;
+   long nthreads;
+   char *endptr;
+
+   int option_index = 0;
+   static struct option long_options[] =
+   {
+      {"jobs",    1, NULL, 'j'},
+      {"quiet",   0, NULL, 'q'},
+      {"help",    0, NULL, 'h'},
+      {"version", 0, NULL, 'v'},
+      {NULL,      0, NULL, 0}
+   };
+
+   nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+   if( nthreads<1 )
+      nthreads=1;
+
+   /* parse options */
+   do
+   {
+      /* getopt_long stores the option index here.   */
+      c = getopt_long (argc, argv, "j:qhv",
+             long_options, &option_index);
+
+      switch (c)
+      {
+         case 'v':
+            printversion();
+            exit(EXIT_SUCCESS);
+         case 'h':
+            printhelp();
+            exit(EXIT_SUCCESS);
+         case 'j':
+            errno=0;
+            nthreads = strtol(optarg,&endptr,10);
+            if( (errno != 0) || (endptr == optarg) || (nthreads<1) )
+            {
+               fprintf(stderr,"Could not convert %s into a positive integer.\n",
+                       optarg);
+               exit(2);
+            }
+            break;
+         case 'q':
+            quiet=1;
+            break;
+         case '?':
+            printhelp();
+            exit(2);
+            break;
+         case -1: break;
+         default:
+            exit(2);
+      }
+   }while(c != -1 );
+
+   /* set error stream to stderr and turn on verbose mode */
+   bdio_set_dflt_msg(stderr);
+   bdio_set_dflt_verbose(1);
+
+   if( optind >= argc)
+   {
+      fprintf(stderr,"BDIO file-name missing.");
+      printhelp();
+      exit(2);
+   }
+
+   if((fh = bdio_open( argv[optind], "r", NULL ))==NULL)
+   {
+      exit(2);
+   }
+
+   nbad = bdio_verify((int) nthreads, quiet ? NULL : stdout, fh);
+   bdio_close(fh);
+
+   if( nbad==EOF )
+      exit(2);
+   exit( nbad>0 ? 1 : EXIT_SUCCESS );
+}
@@ -28,17 +28,27 @@
 #define BDIO_BIN_F64LE   0x09
 #define BDIO_ASC_GENERIC 0x0A
 #define BDIO_ASC_XML     0x0B
+#define BDIO_BIN_F16BE   0x0C
+#define BDIO_BIN_F16LE   0x0D
+#define BDIO_BIN_BF16BE  0x0E
+#define BDIO_BIN_BF16LE  0x0F
 
 #define LSBDIO_VERSION "1.0"
 
 char RSET[16], FREC[16], IREC[16], AREC[16], BREC[16], EREC[16];
 char XREC[16], HDR[16], METC[16], CREC[16];
 
-static char fmt[12][7] ={"bin   \0","exe   \0","i32 be\0","i32 le\0","i64 be\0",
+static char fmt[16][7] ={"bin   \0","exe   \0","i32 be\0","i32 le\0","i64 be\0",
                          "i64 le\0","f32 be\0","f32 le\0","f64 be\0","f64 le\0",
-                         "ASCII \0","XML   \0"};
+                         "ASCII \0","XML   \0","f16 be\0","f16 le\0","bf16be\0",
+                         "bf16le\0"};
 static char lrec[2][3] = {" -"," x"};
 
+/* labels and digest lengths of hash records, indexed by BDIO_HASH_* */
+static char hfmt[4][7] ={"      \0","MD5-h \0","CRC-h \0","XXH-h \0"};
+static char tfmt[4][7] ={"      \0","MD5-t \0","CRC-t \0","XXH-t \0"};
+static int hlen[4] = {0, 16, 4, 8};
+
 static char lenstr[8];
 
 int data_flag=0, meta_flag=0, raw_flag=0;
@@ -396,6 +406,70 @@ void print_record_f32(long id, BDIO *fh)
    }
 }
 
+void print_record_f16(long id, BDIO *fh)
+{
+   /* half precision numbers are shown as floats, raw data is unconverted */
+   float d[6];
+   char str[6*21+1];
+   char tmpstr[21+1];
+   int i, rd;
+   float *dat=NULL;
+   int rd2=0;
+
+   if( data_flag && dindex==id )
+   {
+      rd2 = bdio_get_rlen(fh);
+      dat = (float*) malloc(2*rd2);
+      if( raw_flag )
+         bdio_read(dat,rd2,fh);
+      else
+         rd2 = 2*bdio_read_f16_as_f32(dat,rd2/2,fh);
+   }
+   if( meta_flag && mindex==id )
+      printf("%s-------------------------------------------------------------------------------%s\n",METC,RSET);
+   if( (meta_flag && mindex==id) || ((!meta_flag) && (!data_flag)) )
+   {
+      if( data_flag && dindex==id )
+      {
+         rd = (rd2/2<6) ? rd2/2 : 6;
+         if( !raw_flag )
+            memcpy(d,dat,4*rd);
+         else
+            rd = 0;
+      }else
+         rd = bdio_read_f16_as_f32(d,6,fh);
+      str[0]='\0';
+      for( i=0; i<rd; i++)
+      {
+         sprintf(tmpstr,"%e ",d[i]);
+         if( strlen(tmpstr)+strlen(str)<=40 )
+            strcat(str,tmpstr);
+      }
+      printf("%s%-6li record %s %s byte %2i %-40.40s%s%s\n"
+      ,FREC,id,fmt[bdio_get_rfmt(fh)],printlen(bdio_get_rlen(fh)),bdio_get_ruinfo(fh),str,
+      lrec[(int)fh->rlongrec],RSET);
+   }
+   if( meta_flag && mindex==id )
+   {
+      print_record_meta(id, fh);
+      printf("%s-------------------------------------------------------------------------------%s\n",METC,RSET);
+   }
+   if( data_flag && dindex==id )
+   {
+      if(!raw_flag)
+      {
+         for( i=0; i<rd2/2; i++)
+         {
+            printf("%e\n",dat[i]);
+         }
+      }else
+      {
+         fwrite(dat,1,rd2,stdout);
+      }
+      free(dat);
+   }
+}
+
 void print_record_f64(long id, BDIO *fh)
 {
    double d[6];
@@ -711,12 +785,13 @@ void print_record_bin(long id, BDIO *fh)
          for (i=0; i<40; i++)
             str[i] = ' ';
          str[0]='\0';
-         for( i=0; i<16; i++)
+         for( i=0; i<hlen[is_hash]; i++)
          {
             sprintf(tmpstr,"%02hX",digest[i]);
             strcat(str,tmpstr);
          }
-         printf("%s%-6li record MD5-h  %s byte %2i %-40.40s%s%s\n",CREC,id,printlen(bdio_get_rlen(fh)),bdio_get_ruinfo(fh),str,
+         printf("%s%-6li record %s %s byte %2i %-40.40s%s%s\n",CREC,id,
+         (bdio_get_rlen(fh)==20) ? hfmt[is_hash] : tfmt[is_hash],printlen(bdio_get_rlen(fh)),bdio_get_ruinfo(fh),str,
          lrec[(int)fh->rlongrec],RSET);
       }
    }
@@ -880,6 +955,11 @@ int main(int argc, char *argv[])
             print_record_f32(id,fh);
             id++;
          }
+         if( bdio_get_rfmt(fh)>=BDIO_BIN_F16BE && bdio_get_rfmt(fh)<=BDIO_BIN_BF16LE )
+         {
+            print_record_f16(id,fh);
+            id++;
+         }
          if( bdio_get_rfmt(fh)==BDIO_BIN_INT32BE || bdio_get_rfmt(fh)==BDIO_BIN_INT32LE )
          {
             print_record_int32(id,fh);